@@ -10,6 +10,9 @@
 #include <stdlib.h>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -24,12 +27,50 @@ constexpr int START_FD = 3;
 
 void SetMaxOpenInstanceNum(uint32_t num);
 
+struct ReadDirFetchResult
+{
+    std::string ipPort;
+    std::shared_ptr<Connection> conn;
+    int ret;
+    Connection::ReadDirResponse readDirResponse;
+};
+
+/*
+ * Completed per-worker readdir batches, filled by background fetches and drained by FalconReadDir in arrival
+ * order. Shared with the fetches so that a directory closed with requests in flight is freed safely.
+ */
+struct ReadDirFetchQueue
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<ReadDirFetchResult> results;
+
+    void Push(ReadDirFetchResult &&result)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(result));
+        }
+        cv.notify_one();
+    }
+
+    ReadDirFetchResult Pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return !results.empty(); });
+        ReadDirFetchResult result = std::move(results.front());
+        results.pop_front();
+        return result;
+    }
+};
+
 struct DirOpenInstance
 {
     uint64_t fd;
     std::unordered_map<std::string, std::shared_ptr<Connection>> workers;
     std::vector<std::string> partialEntryVec;
-    std::vector<unsigned int> fileModes;
+    // attributes of partialEntryVec, from readdirplus
+    std::vector<struct stat> fileStats;
     std::unordered_map<std::string, int> readFileCount;
     std::unordered_map<std::string, int> readFileCountIndex;
     std::unordered_map<std::string, std::string> lastFileNames;
@@ -37,11 +78,21 @@ struct DirOpenInstance
     std::set<std::string> allWorkerIPAndPorts;
     uint32_t offset;
     std::unordered_map<std::string, std::shared_ptr<Connection>> workingWorkers;
+    // at most one outstanding request per worker, its result is consumed before the next one is issued
+    std::shared_ptr<ReadDirFetchQueue> fetchQueue;
+    uint32_t inflightFetches;
+    uint32_t fileNumberPerWorker;
+    // error of a failed fetch, kept until the listing is restarted so that later calls report it as well
+    int fetchError;
 
     DirOpenInstance(uint64_t obtainedFd)
     {
         fd = obtainedFd;
         offset = 0;
+        fetchQueue = std::make_shared<ReadDirFetchQueue>();
+        inflightFetches = 0;
+        fileNumberPerWorker = 0;
+        fetchError = 0;
     }
 
     void SetAllWorkerInfo(std::unordered_map<std::string, std::shared_ptr<Connection>> tmpWorkers)
@@ -61,13 +112,19 @@ struct DirOpenInstance
     {
         workers.clear();
         partialEntryVec.clear();
-        fileModes.clear();
+        fileStats.clear();
         readFileCount.clear();
         readFileCountIndex.clear();
         lastFileNames.clear();
+        lastShardIndexes.clear();
         workingWorkers.clear();
         allWorkerIPAndPorts.clear();
         offset = 0;
+        // results of fetches still in flight go to the old queue and are dropped with it
+        fetchQueue = std::make_shared<ReadDirFetchQueue>();
+        inflightFetches = 0;
+        fileNumberPerWorker = 0;
+        fetchError = 0;
     }
 };
 
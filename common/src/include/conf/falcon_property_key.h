@@ -81,4 +81,16 @@ class FalconPropertyKey : public PropertyKey {
 
     inline static const auto FALCON_PROMETHEUS_PORT =
         PropertyKey::Builder("main", "falcon_prometheus_port", FALCON, FALCON_STRING).build();
+
+    inline static const auto FALCON_NEGATIVE_CACHE_TIMEOUT_MS =
+        PropertyKey::Builder("main", "falcon_negative_cache_timeout_ms", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_ATTR_CACHE_TIMEOUT_MS =
+        PropertyKey::Builder("main", "falcon_attr_cache_timeout_ms", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_PREFETCH_HINT_WINDOW =
+        PropertyKey::Builder("main", "falcon_prefetch_hint_window", FALCON, FALCON_UINT).build();
+
+    inline static const auto FALCON_PREFETCH_HINT_MEMORY_MB =
+        PropertyKey::Builder("main", "falcon_prefetch_hint_memory_mb", FALCON, FALCON_UINT).build();
 };
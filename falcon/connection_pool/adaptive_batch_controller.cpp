@@ -0,0 +1,63 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "connection_pool/adaptive_batch_controller.h"
+
+#include <algorithm>
+
+// weight of the newest sample in the moving averages
+static constexpr double EWMA_ALPHA = 0.2;
+// arrival rate is resampled at most this often, shorter intervals are too noisy
+static constexpr std::chrono::microseconds ARRIVAL_SAMPLE_INTERVAL{1000};
+
+AdaptiveBatchController::AdaptiveBatchController(size_t maxBatchSize,
+                                                 std::chrono::microseconds maxWait,
+                                                 Clock::time_point startTime)
+    : maxBatchSize(maxBatchSize),
+      maxWait(maxWait),
+      lastSampleTime(startTime)
+{
+}
+
+void AdaptiveBatchController::RecordExecution(size_t jobCount, std::chrono::microseconds execTime)
+{
+    if (jobCount == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    batchExecTime = batchExecTime == 0 ? execTime.count()
+                                       : EWMA_ALPHA * execTime.count() + (1 - EWMA_ALPHA) * batchExecTime;
+}
+
+void AdaptiveBatchController::SampleArrivalRate(Clock::time_point now)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - lastSampleTime);
+    if (elapsed < ARRIVAL_SAMPLE_INTERVAL) {
+        return;
+    }
+    uint64_t jobs = arrivedJobs.load(std::memory_order_relaxed);
+    double rate = (double)(jobs - lastSampledJobs) / elapsed.count();
+    arrivalRate = EWMA_ALPHA * rate + (1 - EWMA_ALPHA) * arrivalRate;
+    lastSampledJobs = jobs;
+    lastSampleTime = now;
+}
+
+std::chrono::microseconds AdaptiveBatchController::GetBatchWait(size_t currentSize,
+                                                                size_t idleConnections,
+                                                                size_t pendingTasks,
+                                                                size_t &targetSize,
+                                                                Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    SampleArrivalRate(now);
+
+    double expected = arrivalRate * batchExecTime;
+    targetSize = std::clamp<size_t>((size_t)expected, 1, maxBatchSize);
+    if (maxWait.count() == 0 || idleConnections != 0 || pendingTasks != 0 || currentSize >= targetSize ||
+        arrivalRate <= 0) {
+        return std::chrono::microseconds(0);
+    }
+    auto fillTime = std::chrono::microseconds((int64_t)((targetSize - currentSize) / arrivalRate));
+    return std::min(fillTime, maxWait);
+}
@@ -29,7 +29,15 @@ class ConnectionPoolBrpcServer {
     {
         char *userName = getenv("USER");
         std::shared_ptr<PGConnectionPool> pgConnectionPool =
-            std::make_shared<PGConnectionPool>(FalconPGPort, userName, poolSize, 20, 400);
+            std::make_shared<PGConnectionPool>(FalconPGPort,
+                                               userName,
+                                               poolSize,
+                                               FalconConnectionPoolDispatcherNum,
+                                               FalconConnectionPoolLookupReservedConn,
+                                               FalconConnectionPoolScanMaxConn,
+                                               20,
+                                               400,
+                                               std::chrono::microseconds(FalconConnectionPoolBatchMaxWaitUs));
 
         falcon::meta_proto::MetaServiceImpl metaServiceImpl(pgConnectionPool);
         if (server.AddService(&metaServiceImpl, brpc::SERVER_DOESNT_OWN_SERVICE) != 0)
@@ -10,6 +10,8 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
+#include "funcapi.h"
 #include "postmaster/bgworker.h"
 #include "postmaster/postmaster.h"
 #include "storage/shmem.h"
@@ -26,7 +28,11 @@
 int FalconPGPort = 0;
 int FalconConnectionPoolPort = FALCON_CONNECTION_POOL_PORT_DEFAULT;
 int FalconConnectionPoolSize = FALCON_CONNECTION_POOL_SIZE_DEFAULT;
+int FalconConnectionPoolDispatcherNum = FALCON_CONNECTION_POOL_DISPATCHER_NUM_DEFAULT;
+int FalconConnectionPoolLookupReservedConn = FALCON_CONNECTION_POOL_LOOKUP_RESERVED_CONN_DEFAULT;
+int FalconConnectionPoolScanMaxConn = FALCON_CONNECTION_POOL_SCAN_MAX_CONN_DEFAULT;
 uint64_t FalconConnectionPoolShmemSize = FALCON_CONNECTION_POOL_SHMEM_SIZE_DEFAULT;
+int FalconConnectionPoolBatchMaxWaitUs = FALCON_CONNECTION_POOL_BATCH_MAX_WAIT_US_DEFAULT;
 static char *FalconConnectionPoolShmemBuffer = NULL;
 FalconShmemAllocator FalconConnectionPoolShmemAllocator;
 
@@ -98,6 +104,35 @@ void FalconConnectionPoolShmemInit()
         memset(FalconConnectionPoolShmemAllocator.signatureCounter,
                0,
                sizeof(PaddedAtomic64) *
-                   (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT + FalconConnectionPoolShmemAllocator.pageCount));
+                   (FALCON_SHMEM_ALLOCATOR_HEADER_COUNT + FalconConnectionPoolShmemAllocator.pageCount));
     }
 }
+
+PG_FUNCTION_INFO_V1(falcon_connection_pool_shmem_stats);
+
+Datum falcon_connection_pool_shmem_stats(PG_FUNCTION_ARGS)
+{
+    TupleDesc tupleDescriptor;
+    if (get_call_result_type(fcinfo, NULL, &tupleDescriptor) != TYPEFUNC_COMPOSITE)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "return type must be a row type.");
+    tupleDescriptor = BlessTupleDesc(tupleDescriptor);
+
+    FalconShmemAllocatorStats stats;
+    FalconShmemAllocatorGetStats(&FalconConnectionPoolShmemAllocator, &stats);
+    uint64_t freeSize = stats.totalSize - stats.usedSize;
+    // share of the free space which cannot be used by an allocation as large as the free space
+    double fragmentation = freeSize == 0 ? 0 : 1.0 - (double)stats.largestFreeBlock / freeSize;
+
+    Datum values[8];
+    bool nulls[8];
+    memset(nulls, false, sizeof(nulls));
+    values[0] = Int64GetDatum(stats.totalSize);
+    values[1] = Int64GetDatum(stats.usedSize);
+    values[2] = Int64GetDatum(stats.freePageCount);
+    values[3] = Int64GetDatum(stats.largestFreeBlock);
+    values[4] = Float8GetDatum(fragmentation < 0 ? 0 : fragmentation);
+    values[5] = Int64GetDatum(stats.counter[FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_FAIL]);
+    values[6] = Int64GetDatum(stats.counter[FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_WAIT]);
+    values[7] = Int64GetDatum(stats.counter[FALCON_SHMEM_ALLOCATOR_COUNTER_MULTI_PAGE_ALLOC]);
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupleDescriptor, values, nulls)));
+}
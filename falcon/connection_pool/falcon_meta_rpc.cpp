@@ -4,12 +4,82 @@
 
 #include "connection_pool/falcon_meta_rpc.h"
 
+#include <vector>
+
 #include <brpc/server.h>
+#include <bthread/bthread.h>
 #include <butil/iobuf.h>
+#include <butil/time.h>
+
+#include "falcon_meta_response_generated.h"
+
+extern "C" {
+#include "metadb/directory_log_standalone.h"
+#include "metadb/shard_table_standalone.h"
+#include "remote_connection_utils/error_code_def.h"
+#include "remote_connection_utils/serialized_data.h"
+#include "remote_connection_utils/shard_table_epoch.h"
+}
+
+#define DIRECTORY_LOG_WAIT_INTERVAL_US 200
 
 namespace falcon::meta_proto
 {
 
+/*
+ * Requests are handled in bthreads, sleeping in them hands the worker pthread over to other requests, so requests
+ * which have to wait for the applier never hold up others. After the timeout the request is handled anyway and
+ * fails on the directories it misses.
+ */
+static void WaitForDirectoryLogApplied(uint64_t position)
+{
+    if (DirectoryLogRequestLockFree(position))
+        return;
+    int64_t deadline = butil::gettimeofday_us() + (int64_t)DirectoryLogWaitTimeoutMs() * 1000;
+    while (!DirectoryLogAppliedLockFree(position) && butil::gettimeofday_us() < deadline)
+        bthread_usleep(DIRECTORY_LOG_WAIT_INTERVAL_US);
+}
+
+// reply OBSOLETE_SHARD with the shard table of this server, so the client can route again without another call
+static bool ReplyObsoleteShard(brpc::Controller *cntl, const MetaRequest *request)
+{
+    std::vector<int32_t> rangePoints;
+    std::vector<int32_t> serverIds;
+    uint64_t epoch = SHARD_TABLE_EPOCH_UNKNOWN;
+    int32_t count = 0;
+    do {
+        rangePoints.resize(count);
+        serverIds.resize(count);
+        count = ShardTableCopyLockFree(rangePoints.data(), serverIds.data(), rangePoints.size(), &epoch);
+    } while (count > (int32_t)rangePoints.size());
+    if (count < 0 || epoch == request->shard_table_epoch())
+        return false;
+    rangePoints.resize(count);
+    serverIds.resize(count);
+
+    flatbuffers::FlatBufferBuilder builder;
+    auto shardTableResponse = falcon::meta_fbs::CreateShardTableResponse(builder,
+                                                                         epoch,
+                                                                         builder.CreateVector(rangePoints),
+                                                                         builder.CreateVector(serverIds));
+    auto metaResponse =
+        falcon::meta_fbs::CreateMetaResponse(builder,
+                                             OBSOLETE_SHARD,
+                                             falcon::meta_fbs::AnyMetaResponse::AnyMetaResponse_ShardTableResponse,
+                                             shardTableResponse.Union());
+    builder.Finish(metaResponse);
+
+    SerializedData reply;
+    SerializedDataInit(&reply, NULL, 0, 0, NULL);
+    char *buf = SerializedDataApplyForSegment(&reply, builder.GetSize());
+    memcpy(buf, builder.GetBufferPointer(), builder.GetSize());
+    // one reply per operation of the request, like replies of the backends
+    for (int i = 0; i < request->type_size(); ++i)
+        cntl->response_attachment().append(reply.buffer, reply.size);
+    SerializedDataDestroy(&reply);
+    return true;
+}
+
 void MetaServiceImpl::MetaCall(google::protobuf::RpcController *cntlBase,
                                const MetaRequest *request,
                                Empty *response,
@@ -18,6 +88,20 @@ void MetaServiceImpl::MetaCall(google::protobuf::RpcController *cntlBase,
     brpc::ClosureGuard doneGuard(done);
     brpc::Controller *cntl = static_cast<brpc::Controller *>(cntlBase);
 
+    // requests routed by another shard table are rejected before they take a connection
+    uint64_t shardTableEpoch = request->shard_table_epoch();
+    if (shardTableEpoch != SHARD_TABLE_EPOCH_UNKNOWN) {
+        uint64_t localShardTableEpoch = GetShardTableEpoch();
+        if (localShardTableEpoch != SHARD_TABLE_EPOCH_UNKNOWN && localShardTableEpoch != shardTableEpoch &&
+            ReplyObsoleteShard(cntl, request))
+            return;
+    }
+
+    // the request may depend on directories which haven't been applied here yet
+    uint64_t directoryLogPosition = request->directory_log_position();
+    if (directoryLogPosition != 0)
+        WaitForDirectoryLogApplied(directoryLogPosition);
+
     AsyncMetaServiceJob *job = new AsyncMetaServiceJob(cntl, request, response, done);
     pgConnectionPool->DispatchAsyncMetaServiceJob(job);
     doneGuard.release();
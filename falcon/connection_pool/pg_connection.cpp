@@ -4,18 +4,88 @@
 
 #include "connection_pool/pg_connection.h"
 
+#include <endian.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 
 #include "falcon_meta_param_generated.h"
 #include "falcon_meta_response_generated.h"
 
 extern "C" {
+#include "catalog/pg_type_d.h"
 #include "connection_pool/connection_pool.h"
 #include "utils/error_code.h"
 #include "utils/utils_standalone.h"
 }
 
+// prepared once per connection, so batches skip parsing and planning. params and result are binary
+static const char *META_CALL_STATEMENT_NAME = "falcon_meta_call";
+static const char *META_CALL_STATEMENT =
+    "select falcon_meta_call_by_serialized_shmem_internal($1, $2, $3, $4);";
+static const Oid META_CALL_PARAM_TYPES[] = {INT4OID, INT4OID, INT8OID, INT8OID};
+static constexpr int META_CALL_PARAM_COUNT = sizeof(META_CALL_PARAM_TYPES) / sizeof(Oid);
+
+// replies at least this large are handed to brpc in place, smaller ones are cheaper to copy into IOBuf blocks
+// than to pin a shmem block and a user data block for them
+static constexpr uint32_t ZERO_COPY_REPLY_MIN_SIZE = 4096;
+
+// a worker waiting for shmem keeps its connection busy, so the dispatchers run out of idle connections, their
+// queues fill up and producers block. that is the backpressure, failing is left to requests which can never fit
+static constexpr auto SHMEM_ALLOC_WAIT_INTERVAL = std::chrono::milliseconds(100);
+static constexpr auto SHMEM_ALLOC_WAIT_TIMEOUT = std::chrono::seconds(30);
+static std::mutex shmemFreedMutex;
+static std::condition_variable cvShmemFreed;
+static std::atomic<int> shmemWaiterCount{0};
+
+static void ShmemFree(FalconShmemAllocator *allocator, uint64_t shift)
+{
+    FalconShmemAllocatorFree(allocator, shift);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shmemWaiterCount.load(std::memory_order_relaxed) != 0) {
+        std::lock_guard<std::mutex> lk(shmemFreedMutex);
+        cvShmemFreed.notify_all();
+    }
+}
+
+// return 0 if size can never be allocated or shmem isn't freed in time
+static uint64_t ShmemMallocWait(FalconShmemAllocator *allocator, uint64_t size)
+{
+    uint64_t shift = FalconShmemAllocatorMalloc(allocator, size);
+    if (shift != 0 || !FalconShmemAllocatorCanFit(allocator, size))
+        return shift;
+
+    FalconShmemAllocatorCount(allocator, FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_WAIT);
+    auto deadline = std::chrono::steady_clock::now() + SHMEM_ALLOC_WAIT_TIMEOUT;
+    std::unique_lock<std::mutex> lk(shmemFreedMutex);
+    shmemWaiterCount.fetch_add(1);
+    // frees by backends aren't notified, so the wait is also bounded by an interval
+    while ((shift = FalconShmemAllocatorMalloc(allocator, size)) == 0 && std::chrono::steady_clock::now() < deadline)
+        cvShmemFreed.wait_for(lk, SHMEM_ALLOC_WAIT_INTERVAL);
+    shmemWaiterCount.fetch_sub(1);
+    return shift;
+}
+
+// the reply is freed when brpc has released every slice of it
+static std::shared_ptr<char> ShareShmemReply(FalconShmemAllocator *allocator, uint64_t replyShift)
+{
+    return std::shared_ptr<char>(FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, replyShift),
+                                 [allocator, replyShift](char *) { ShmemFree(allocator, replyShift); });
+}
+
+static void
+AppendShmemReply(butil::IOBuf &attachment, const std::shared_ptr<char> &reply, uint32_t offset, uint32_t size)
+{
+    if (size < ZERO_COPY_REPLY_MIN_SIZE)
+        attachment.append(reply.get() + offset, size);
+    else
+        attachment.append_user_data(reply.get() + offset, size, [reply](void *) {});
+}
+
 PGConnection::PGConnection(PGConnectionPool *parent, const char *ip, const int port, const char *userName)
 {
     this->parent = parent;
@@ -33,11 +103,106 @@ PGConnection::PGConnection(PGConnectionPool *parent, const char *ip, const int p
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         throw std::runtime_error(std::string("pg connection error: ") + PQresultErrorMessage(res));
     }
+    PQclear(res);
+    res = PQprepare(conn, META_CALL_STATEMENT_NAME, META_CALL_STATEMENT, META_CALL_PARAM_COUNT, META_CALL_PARAM_TYPES);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        throw std::runtime_error(std::string("pg connection error: ") + PQresultErrorMessage(res));
+    }
+    PQclear(res);
+    // all commands of a task are sent at once and their results read back in order
+    if (PQenterPipelineMode(conn) != 1) {
+        throw std::runtime_error(std::string("pg connection error: ") + PQerrorMessage(conn));
+    }
 
     SerializedDataInit(&replyBuilder, NULL, 0, 0, NULL);
     this->thread = std::thread(&PGConnection::BackgroundWorker, this);
 }
 
+bool PGConnection::SendMetaCall(int32_t type, int32_t count, uint64_t paramShift, int64_t signature)
+{
+    uint32_t typeValue = htobe32((uint32_t)type);
+    uint32_t countValue = htobe32((uint32_t)count);
+    uint64_t paramShiftValue = htobe64(paramShift);
+    uint64_t signatureValue = htobe64((uint64_t)signature);
+    const char *values[META_CALL_PARAM_COUNT] = {(const char *)&typeValue,
+                                                 (const char *)&countValue,
+                                                 (const char *)&paramShiftValue,
+                                                 (const char *)&signatureValue};
+    const int lengths[META_CALL_PARAM_COUNT] = {sizeof(typeValue),
+                                                sizeof(countValue),
+                                                sizeof(paramShiftValue),
+                                                sizeof(signatureValue)};
+    const int formats[META_CALL_PARAM_COUNT] = {1, 1, 1, 1};
+    return PQsendQueryPrepared(conn, META_CALL_STATEMENT_NAME, META_CALL_PARAM_COUNT, values, lengths, formats, 1) == 1;
+}
+
+uint64_t PGConnection::GetMetaCallReplyShift(const PGresult *res)
+{
+    if (PQntuples(res) != 1 || PQnfields(res) != 1 || PQfformat(res, 0) != 1 || PQgetlength(res, 0, 0) != 8)
+        throw std::runtime_error("returned reply is corrupt.");
+    uint64_t value;
+    memcpy(&value, PQgetvalue(res, 0, 0), sizeof(value));
+    return be64toh(value);
+}
+
+void PGConnection::CollectPipelineResults(size_t queryCount, std::vector<PGresult *> &results)
+{
+    if (PQpipelineSync(conn) != 1)
+        throw std::runtime_error(PQerrorMessage(conn));
+    // each query yields its result followed by NULL, queries after a failed one yield PGRES_PIPELINE_ABORTED
+    for (size_t i = 0; i < queryCount; ++i) {
+        PGresult *res = PQgetResult(conn);
+        if (res == NULL)
+            throw std::runtime_error(PQerrorMessage(conn));
+        results.push_back(res);
+        res = PQgetResult(conn);
+        if (res != NULL) {
+            PQclear(res);
+            throw std::runtime_error(
+                "reply count cannot match request. maybe there is a request containing several plain commands.");
+        }
+    }
+    PGresult *res = PQgetResult(conn);
+    if (res == NULL || PQresultStatus(res) != PGRES_PIPELINE_SYNC) {
+        PQclear(res);
+        throw std::runtime_error(PQerrorMessage(conn));
+    }
+    PQclear(res);
+}
+
+void PGConnection::ReplyTaskError(FalconErrorCode errorCode)
+{
+    SerializedDataClear(&replyBuilder);
+    flatBufferBuilder.Clear();
+    auto metaResponse = falcon::meta_fbs::CreateMetaResponse(flatBufferBuilder, errorCode);
+    flatBufferBuilder.Finish(metaResponse);
+    char *buf = SerializedDataApplyForSegment(&replyBuilder, flatBufferBuilder.GetSize());
+    memcpy(buf, flatBufferBuilder.GetBufferPointer(), flatBufferBuilder.GetSize());
+
+    for (size_t i = 0; i < taskToExec->jobList.size(); ++i) {
+        brpc::Controller *cntl = taskToExec->jobList[i]->GetCntl();
+        cntl->response_attachment().append(replyBuilder.buffer, replyBuilder.size);
+        taskToExec->jobList[i]->Done();
+    }
+}
+
+void PGConnection::FinishTask(std::chrono::steady_clock::time_point execStart)
+{
+    this->parent->ReportTaskExecution(
+        taskToExec,
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - execStart));
+    this->parent->ReaddWorkingPGConnection(this);
+
+    for (size_t i = 0; i < taskToExec->jobList.size(); ++i)
+        delete taskToExec->jobList[i];
+    delete this->taskToExec;
+    {
+        std::unique_lock<std::mutex> lk(this->execMutex);
+        this->taskToExec = nullptr;
+    }
+    cvExecing.notify_one();
+}
+
 void PGConnection::BackgroundWorker()
 {
     while (working) {
@@ -53,6 +218,7 @@ void PGConnection::BackgroundWorker()
         while ((res = PQgetResult(conn)) != NULL)
             PQclear(res);
         flatBufferBuilder.Clear();
+        auto execStart = std::chrono::steady_clock::now();
 
         if (taskToExec->jobList.size() == 0)
             throw std::runtime_error("pgconnection: taskToExec is empty");
@@ -76,14 +242,11 @@ void PGConnection::BackgroundWorker()
             }
 
             int64_t signature = FalconShmemAllocatorGetUniqueSignature(allocator);
-            uint64_t totalParamShift = FalconShmemAllocatorMalloc(allocator, totalParamSize);
+            uint64_t totalParamShift = ShmemMallocWait(allocator, totalParamSize);
             if (totalParamShift == 0) {
-                printf("Shmem of connection pool is exhausted, totalParamSize: %u. There may be "
-                       "several reasons, 1) shmem size is too small, 2) allocate too much memory "
-                       "once exceed FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE.",
-                       totalParamSize);
-                fflush(stdout);
-                throw std::runtime_error("memory exceed limit.");
+                ReplyTaskError(OUT_OF_MEMORY);
+                FinishTask(execStart);
+                continue;
             }
             uint64_t p = totalParamShift;
             for (size_t i = 0; i < taskToExec->jobList.size(); ++i) {
@@ -100,23 +263,14 @@ void PGConnection::BackgroundWorker()
             // barch operation can not be plain command
             uint64_t replyShift = 0;
 
-            char command[128];
-            sprintf(command,
-                    "select falcon_meta_call_by_serialized_shmem_internal(%d, %u, %ld, %ld);",
-                    serviceType,
-                    totalParamCount,
-                    (int64_t)totalParamShift,
-                    signature);
-            int sendQuerySucceed = PQsendQuery(conn, command);
-            if (sendQuerySucceed != 1)
+            if (!SendMetaCall(serviceType, totalParamCount, totalParamShift, signature))
                 throw std::runtime_error(PQerrorMessage(conn));
 
-            PGresult *res = NULL;
-            res = PQgetResult(conn);
-            if (res == NULL)
-                throw std::runtime_error(PQerrorMessage(conn));
+            std::vector<PGresult *> result;
+            CollectPipelineResults(1, result);
+            PGresult *res = result[0];
             // param is useless now
-            FalconShmemAllocatorFree(allocator, totalParamShift);
+            ShmemFree(allocator, totalParamShift);
             if (PQresultStatus(res) != PGRES_TUPLES_OK) {
                 char *totalErrorMsg = PQresultErrorMessage(res);
                 const char *validErrorMsg = NULL;
@@ -127,27 +281,12 @@ void PGConnection::BackgroundWorker()
 
             // 2.1.3 Process result
             if (errorCode != SUCCESS) {
-                SerializedDataClear(&replyBuilder);
-                flatBufferBuilder.Clear();
-                auto metaResponse = falcon::meta_fbs::CreateMetaResponse(flatBufferBuilder, errorCode);
-                flatBufferBuilder.Finish(metaResponse);
-                char *buf = SerializedDataApplyForSegment(&replyBuilder, flatBufferBuilder.GetSize());
-                memcpy(buf, flatBufferBuilder.GetBufferPointer(), flatBufferBuilder.GetSize());
-
-                for (size_t i = 0; i < taskToExec->jobList.size(); ++i) {
-                    brpc::Controller *cntl = taskToExec->jobList[i]->GetCntl();
-                    char *data = (char *)malloc(replyBuilder.size);
-                    memcpy(data, replyBuilder.buffer, replyBuilder.size);
-                    cntl->response_attachment().append_user_data(data, replyBuilder.size, NULL);
-                    taskToExec->jobList[i]->Done();
-                }
+                ReplyTaskError(errorCode);
             } else {
-                if (PQntuples(res) != 1 || PQnfields(res) != 1) {
-                    throw std::runtime_error("returned reply is corrupt.");
-                }
-                replyShift = (uint64_t)StringToInt64(PQgetvalue(res, 0, 0));
+                replyShift = GetMetaCallReplyShift(res);
                 if (replyShift != 0) {
-                    char *replyBuffer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, replyShift);
+                    std::shared_ptr<char> reply = ShareShmemReply(allocator, replyShift);
+                    char *replyBuffer = reply.get();
                     uint64_t replyBufferSize = FALCON_SHMEM_ALLOCATOR_POINTER_GET_SIZE(replyBuffer);
                     SerializedData replyData;
                     if (!SerializedDataInit(&replyData, replyBuffer, replyBufferSize, replyBufferSize, NULL))
@@ -161,14 +300,11 @@ void PGConnection::BackgroundWorker()
                         uint32_t size = SerializedDataNextSeveralItemSize(&replyData, p, count);
                         if (size == (sd_size_t)-1)
                             throw std::runtime_error("response is corrupt.");
-                        char *data = (char *)malloc(size);
-                        memcpy(data, replyBuffer + p, size);
-                        cntl->response_attachment().append_user_data(data, size, NULL);
+                        AppendShmemReply(cntl->response_attachment(), reply, p, size);
 
                         taskToExec->jobList[i]->Done();
                         p += size;
                     }
-                    FalconShmemAllocatorFree(allocator, replyShift);
                 } else {
                     for (size_t i = 0; i < taskToExec->jobList.size(); ++i) {
                         taskToExec->jobList[i]->Done();
@@ -184,14 +320,11 @@ void PGConnection::BackgroundWorker()
             // 2.2.1 Copy data into shmem
             falcon::meta_proto::AsyncMetaServiceJob *job = taskToExec->jobList[0];
             size_t paramSize = job->GetCntl()->request_attachment().size();
-            uint64_t paramShift = FalconShmemAllocatorMalloc(allocator, paramSize);
+            uint64_t paramShift = ShmemMallocWait(allocator, paramSize);
             if (paramShift == 0) {
-                printf("Shmem of connection pool is exhausted, paramSize: %zu. There may be "
-                       "several reasons, 1) shmem size is too small, 2) allocate too much memory "
-                       "once exceed FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE.",
-                       paramSize);
-                fflush(stdout);
-                throw std::runtime_error("memory exceed limit.");
+                ReplyTaskError(OUT_OF_MEMORY);
+                FinishTask(execStart);
+                continue;
             }
             char *paramBuffer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, paramShift);
             job->GetCntl()->request_attachment().cutn(paramBuffer, paramSize);
@@ -200,7 +333,6 @@ void PGConnection::BackgroundWorker()
                 throw std::runtime_error("request attachment is corrupt.");
 
             // 2.2.2
-            std::stringstream toSendCommand;
             std::vector<bool> isPlainCommand;
             std::vector<int64_t> signatureList;
             int i = 0;
@@ -232,15 +364,19 @@ void PGConnection::BackgroundWorker()
                     // split PGresult
                     const char *command = param->param_as_PlainCommandParam()->command()->c_str();
 
-                    toSendCommand << command;
+                    // text result, replied to the client as strings
+                    if (PQsendQueryParams(conn, command, 0, NULL, NULL, NULL, NULL, 0) != 1)
+                        throw std::runtime_error(PQerrorMessage(conn));
 
                     isPlainCommand.push_back(true);
                     signatureList.push_back(0);
                 } else {
                     signatureList.push_back(FalconShmemAllocatorGetUniqueSignature(allocator));
-                    toSendCommand << "select falcon_meta_call_by_serialized_shmem_internal(" << serviceType << ", "
-                                  << currentParamSegmentCount << ", " << paramShift + currentParamSegment << ", "
-                                  << signatureList.back() << ");";
+                    if (!SendMetaCall(serviceType,
+                                      currentParamSegmentCount,
+                                      paramShift + currentParamSegment,
+                                      signatureList.back()))
+                        throw std::runtime_error(PQerrorMessage(conn));
 
                     isPlainCommand.push_back(false);
                 }
@@ -250,19 +386,22 @@ void PGConnection::BackgroundWorker()
             }
 
             // 2.2.3
-            PQsendQuery(conn, toSendCommand.str().c_str());
             std::vector<PGresult *> result;
             PGresult *res = NULL;
-            while ((res = PQgetResult(conn)) != NULL)
-                result.push_back(res);
-            FalconShmemAllocatorFree(allocator, paramShift);
-            if (result.size() != isPlainCommand.size()) {
-                throw std::runtime_error(
-                    "reply count cannot match request. maybe there is a request containing several plain commands.");
-            }
+            CollectPipelineResults(isPlainCommand.size(), result);
+            ShmemFree(allocator, paramShift);
             // 2.2.4
+            // replies built here are collected in replyData, shmem replies are appended in place, so replyData is
+            // flushed to the attachment before each of them to keep the order
+            butil::IOBuf &attachment = job->GetCntl()->response_attachment();
             SerializedData replyData;
             SerializedDataInit(&replyData, NULL, 0, 0, NULL);
+            auto flushReplyData = [&attachment, &replyData]() {
+                if (replyData.size == 0)
+                    return;
+                attachment.append_user_data(replyData.buffer, replyData.size, NULL);
+                SerializedDataInit(&replyData, NULL, 0, 0, NULL);
+            };
             for (size_t i = 0; i < result.size(); ++i) {
                 res = result[i];
                 if (PQresultStatus(res) != PGRES_TUPLES_OK) {
@@ -304,8 +443,9 @@ void PGConnection::BackgroundWorker()
                     int64_t signature = signatureList[i];
                     if (PQntuples(res) != 1 || PQnfields(res) != 1)
                         throw std::runtime_error("returned reply is corrupt in non-batch operation. 1");
-                    uint64_t replyShift = (uint64_t)StringToInt64(PQgetvalue(res, 0, 0));
-                    char *replyBuffer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, replyShift);
+                    uint64_t replyShift = GetMetaCallReplyShift(res);
+                    std::shared_ptr<char> reply = ShareShmemReply(allocator, replyShift);
+                    char *replyBuffer = reply.get();
                     if (FALCON_SHMEM_ALLOCATOR_GET_SIGNATURE(replyBuffer) != signature)
                         throw std::runtime_error("returned reply is corrupt in non-batch operation. 2");
                     uint64_t replyBufferSize = FALCON_SHMEM_ALLOCATOR_POINTER_GET_SIZE(replyBuffer);
@@ -313,34 +453,18 @@ void PGConnection::BackgroundWorker()
                     SerializedData oneReply;
                     if (!SerializedDataInit(&oneReply, replyBuffer, replyBufferSize, replyBufferSize, NULL))
                         throw std::runtime_error("reply data is corrupt.");
-                    SerializedDataAppend(&replyData, &oneReply);
-                    FalconShmemAllocatorFree(allocator, replyShift);
+                    flushReplyData();
+                    AppendShmemReply(attachment, reply, 0, replyBufferSize);
                 }
             }
-            //
-            //
-            // SerializedDataDestroy
-            job->GetCntl()->response_attachment().append_user_data(replyData.buffer, replyData.size, NULL);
+            flushReplyData();
             job->Done();
 
             for (size_t i = 0; i < result.size(); ++i)
-                PQclear(res);
+                PQclear(result[i]);
         }
 
-        // TBD
-        //
-        //
-
-        this->parent->ReaddWorkingPGConnection(this);
-
-        for (size_t i = 0; i < taskToExec->jobList.size(); ++i)
-            delete taskToExec->jobList[i];
-        delete this->taskToExec;
-        {
-            std::unique_lock<std::mutex> lk(this->execMutex);
-            this->taskToExec = nullptr;
-        }
-        cvExecing.notify_one();
+        FinishTask(execStart);
     }
 }
 
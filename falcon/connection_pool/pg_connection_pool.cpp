@@ -4,88 +4,257 @@
 
 #include "connection_pool/pg_connection_pool.h"
 
+#include <algorithm>
+
 #include "connection_pool/pg_connection.h"
 
-void PGConnectionPool::BackgroundPoolManager()
+void PGConnectionPool::BackgroundDispatcher(size_t dispatcherIndex)
 {
+    Dispatcher &dispatcher = *dispatchers[dispatcherIndex];
     while (working) {
         // 1. fetch conn
-        PGConnection *conn = GetPGConnection();
+        PGConnection *conn = GetPGConnection(dispatcher);
+        if (conn == nullptr)
+            break;
 
-        // 2. wait for command
-        Task *taskToExec = nullptr;
-        {
-            std::unique_lock<std::mutex> lk(pendingTaskMutex);
-            cvPendingTaskNotEmpty.wait(lk, [this]() -> bool { return !pendingTask.empty() || !working; });
-            if (!working)
-                break;
+        // 2. wait for command, from own queue first and from other dispatchers if it is empty
+        Task *taskToExec = PopPendingTask(dispatcherIndex);
+        if (taskToExec == nullptr)
+            break;
 
-            // fetch command
-            taskToExec = pendingTask.front();
-            pendingTask.pop();
-            for (int i = 0; i < TaskSupportBatchType::NOT_SUPPORT; ++i) {
-                if (taskToExec != supportBatchTaskList[i].task)
-                    continue;
-                {
-                    std::unique_lock<std::mutex> lk(supportBatchTaskList[i].taskMutex);
-                    supportBatchTaskList[i].task = new Task(batchTaskBufferMaxSize);
-                    supportBatchTaskList[i].task->isBatch = true;
-                }
-                supportBatchTaskList[i].cvBatchNotFull.notify_one();
-                break;
-            }
-        }
-        cvPendingTaskNotFull.notify_one();
+        // the popped batch is not empty, so dispatchers keep appending to it without queueing it again until it
+        // is sealed here
+        if (taskToExec->isBatch)
+            SealBatchTask(taskToExec->batchType);
 
         // 3. exec bt backgroundworker of connection
         conn->Exec(taskToExec);
     }
 }
 
+void PGConnectionPool::SealBatchTask(int batchType)
+{
+    size_t idleConnCount = 0;
+    size_t pendingTaskCount = 0;
+    for (auto &dispatcher : dispatchers)
+        idleConnCount += dispatcher->idleConnCount.load(std::memory_order_relaxed);
+    for (int lane = 0; lane < TaskLane::LANE_NUM; ++lane)
+        pendingTaskCount += PendingTaskCount((TaskLane)lane);
+
+    TaskSupportBatch &batch = supportBatchTaskList[batchType];
+    {
+        std::unique_lock<std::mutex> lk(batch.taskMutex);
+        size_t targetSize = 0;
+        std::chrono::microseconds wait =
+            batch.controller->GetBatchWait(batch.task->jobList.size(), idleConnCount, pendingTaskCount, targetSize);
+        if (wait.count() > 0) {
+            batch.cvBatchGrown.wait_for(lk, wait, [this, &batch, targetSize]() -> bool {
+                return batch.task->jobList.size() >= targetSize || !working;
+            });
+        }
+        batch.task = new Task(batchTaskBufferMaxSize);
+        batch.task->isBatch = true;
+        batch.task->batchType = batchType;
+    }
+    batch.cvBatchNotFull.notify_all();
+}
+
+void PGConnectionPool::ReportTaskExecution(Task *task, std::chrono::microseconds execTime)
+{
+    if (task->lane != TaskLane::LOOKUP) {
+        ReleaseLane((TaskLane)task->lane);
+        // a dispatcher may hold an idle connection but sleep because this lane was full
+        NotifyIdleDispatcher();
+    }
+    if (task->isBatch)
+        supportBatchTaskList[task->batchType].controller->RecordExecution(task->jobList.size(), execTime);
+}
+
 PGConnectionPool::PGConnectionPool(const uint16_t port,
                                    const char *userName,
                                    const int connPoolSize,
+                                   const int dispatcherNum,
+                                   const int lookupReservedConn,
+                                   const int scanMaxConn,
                                    const uint16_t pendingTaskBufferMaxSize,
-                                   const uint16_t batchTaskBufferMaxSize)
+                                   const uint16_t batchTaskBufferMaxSize,
+                                   const std::chrono::microseconds maxBatchWait)
 {
+    // every dispatcher owns at least one connection
+    int actualDispatcherNum = std::clamp(dispatcherNum, 1, connPoolSize);
+    for (int i = 0; i < actualDispatcherNum; ++i)
+        dispatchers.emplace_back(std::make_unique<Dispatcher>(pendingTaskBufferMaxSize));
     for (int i = 0; i < connPoolSize; ++i) {
+        Dispatcher *dispatcher = dispatchers[i % actualDispatcherNum].get();
         PGConnection *conn = new PGConnection(this, "127.0.0.1", port, userName);
-        currentManagedConn.insert(conn);
-        connPool.push(conn);
+        currentManagedConn.emplace(conn, dispatcher);
+        dispatcher->connPool.push(conn);
+        dispatcher->idleConnCount.fetch_add(1, std::memory_order_relaxed);
     }
-    this->pendingTaskBufferMaxSize = pendingTaskBufferMaxSize;
+    // keep at least one connection for the other lanes
+    this->nonLookupMaxConn = connPoolSize - std::clamp(lookupReservedConn, 0, connPoolSize - 1);
+    this->scanMaxConn = std::clamp(scanMaxConn, 1, nonLookupMaxConn);
     this->batchTaskBufferMaxSize = batchTaskBufferMaxSize;
     for (int i = 0; i < TaskSupportBatchType::NOT_SUPPORT; ++i) {
         supportBatchTaskList[i].task = new Task(batchTaskBufferMaxSize);
         supportBatchTaskList[i].task->isBatch = true;
+        supportBatchTaskList[i].task->batchType = i;
+        supportBatchTaskList[i].controller =
+            std::make_unique<AdaptiveBatchController>(batchTaskBufferMaxSize, maxBatchWait);
     }
 
     working = true;
-    backgroundPoolManager = std::thread(&PGConnectionPool::BackgroundPoolManager, this);
+    for (size_t i = 0; i < dispatchers.size(); ++i)
+        dispatchers[i]->thread = std::thread(&PGConnectionPool::BackgroundDispatcher, this, i);
 }
 
 void PGConnectionPool::ReaddWorkingPGConnection(PGConnection *conn)
 {
+    Dispatcher *dispatcher = currentManagedConn.at(conn);
     {
-        std::unique_lock<std::mutex> lk(connPoolMutex);
-        connPool.push(conn);
+        std::unique_lock<std::mutex> lk(dispatcher->connPoolMutex);
+        dispatcher->connPool.push(conn);
+        dispatcher->idleConnCount.fetch_add(1, std::memory_order_relaxed);
     }
-    cvPoolNotEmpty.notify_one();
+    dispatcher->cvPoolNotEmpty.notify_one();
 }
 
-PGConnection *PGConnectionPool::GetPGConnection()
+PGConnection *PGConnectionPool::GetPGConnection(Dispatcher &dispatcher)
 {
     PGConnection *result = NULL;
     {
-        std::unique_lock<std::mutex> lk(connPoolMutex);
-        cvPoolNotEmpty.wait(lk, [this]() -> bool { return !this->connPool.empty(); });
+        std::unique_lock<std::mutex> lk(dispatcher.connPoolMutex);
+        dispatcher.cvPoolNotEmpty.wait(lk, [this, &dispatcher]() -> bool {
+            return !dispatcher.connPool.empty() || !working;
+        });
+        if (!working)
+            return NULL;
 
-        result = connPool.front();
-        connPool.pop();
+        result = dispatcher.connPool.front();
+        dispatcher.connPool.pop();
+        dispatcher.idleConnCount.fetch_sub(1, std::memory_order_relaxed);
     }
     return result;
 }
 
+bool PGConnectionPool::TryPushPendingTask(Task *task)
+{
+    size_t start = nextDispatcher.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < dispatchers.size(); ++i) {
+        if (dispatchers[(start + i) % dispatchers.size()]->pendingTask[task->lane]->TryPush(task))
+            return true;
+    }
+    return false;
+}
+
+// the sleep/wake handshakes below pair a counter of sleepers with a fence on both sides, so that either the
+// waker sees the sleeper or the sleeper sees the queue change before it blocks
+void PGConnectionPool::PushPendingTask(Task *task)
+{
+    if (!TryPushPendingTask(task)) {
+        std::unique_lock<std::mutex> lk(blockedProducerMutex);
+        blockedProducerCount.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cvPendingTaskNotFull.wait(lk, [this, task]() -> bool { return TryPushPendingTask(task); });
+        blockedProducerCount.fetch_sub(1);
+    }
+
+    NotifyIdleDispatcher();
+}
+
+void PGConnectionPool::NotifyIdleDispatcher()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idleDispatcherCount.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lk(idleDispatcherMutex);
+        }
+        cvPendingTaskNotEmpty.notify_one();
+    }
+}
+
+size_t PGConnectionPool::PendingTaskCount(TaskLane lane)
+{
+    size_t count = 0;
+    for (auto &dispatcher : dispatchers)
+        count += dispatcher->pendingTask[lane]->SizeApprox();
+    return count;
+}
+
+bool PGConnectionPool::AdmitLane(TaskLane lane)
+{
+    if (lane == TaskLane::LOOKUP)
+        return true;
+    int running = nonLookupRunningCount.load();
+    do {
+        if (running >= nonLookupMaxConn)
+            return false;
+    } while (!nonLookupRunningCount.compare_exchange_weak(running, running + 1));
+    if (lane == TaskLane::SCAN) {
+        running = scanRunningCount.load();
+        do {
+            if (running >= scanMaxConn) {
+                nonLookupRunningCount.fetch_sub(1);
+                return false;
+            }
+        } while (!scanRunningCount.compare_exchange_weak(running, running + 1));
+    }
+    return true;
+}
+
+void PGConnectionPool::ReleaseLane(TaskLane lane)
+{
+    if (lane == TaskLane::LOOKUP)
+        return;
+    if (lane == TaskLane::SCAN)
+        scanRunningCount.fetch_sub(1);
+    nonLookupRunningCount.fetch_sub(1);
+}
+
+Task *PGConnectionPool::TryPopPendingTask(size_t dispatcherIndex)
+{
+    Task *task = nullptr;
+    for (int lane = 0; lane < TaskLane::LANE_NUM; ++lane) {
+        if (PendingTaskCount((TaskLane)lane) != 0 && AdmitLane((TaskLane)lane)) {
+            for (size_t i = 0; i < dispatchers.size(); ++i) {
+                if (dispatchers[(dispatcherIndex + i) % dispatchers.size()]->pendingTask[lane]->TryPop(task)) {
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (blockedProducerCount.load() > 0) {
+                        {
+                            std::lock_guard<std::mutex> lk(blockedProducerMutex);
+                        }
+                        // producers of several lanes may be blocked, and only some of them can proceed now
+                        cvPendingTaskNotFull.notify_all();
+                    }
+                    return task;
+                }
+            }
+            // every queue of the lane was empty when looked at: another dispatcher took the task, or a producer has
+            // not published it yet and wakes an idle dispatcher once it has. give the slot back instead of retrying,
+            // the caller sleeps on cvPendingTaskNotEmpty until then
+            ReleaseLane((TaskLane)lane);
+        }
+    }
+    return nullptr;
+}
+
+Task *PGConnectionPool::PopPendingTask(size_t dispatcherIndex)
+{
+    Task *task = TryPopPendingTask(dispatcherIndex);
+    if (task != nullptr)
+        return task;
+
+    std::unique_lock<std::mutex> lk(idleDispatcherMutex);
+    idleDispatcherCount.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cvPendingTaskNotEmpty.wait(lk, [this, dispatcherIndex, &task]() -> bool {
+        task = TryPopPendingTask(dispatcherIndex);
+        return task != nullptr || !working;
+    });
+    idleDispatcherCount.fetch_sub(1);
+    return task;
+}
+
 // lifetime of job must be longer than this function. it will be freed later
 void PGConnectionPool::DispatchAsyncMetaServiceJob(falcon::meta_proto::AsyncMetaServiceJob *job)
 {
@@ -110,43 +279,56 @@ void PGConnectionPool::DispatchAsyncMetaServiceJob(falcon::meta_proto::AsyncMeta
 
     Task *toInsertTask = NULL;
     if (allowBatchWithOthers) {
-        std::unique_lock<std::mutex> lk(supportBatchTaskList[taskSupportBatchType].taskMutex);
-        supportBatchTaskList[taskSupportBatchType].cvBatchNotFull.wait(lk, [this, taskSupportBatchType]() -> bool {
-            return supportBatchTaskList[taskSupportBatchType].task->jobList.size() < batchTaskBufferMaxSize;
-        });
-        if (supportBatchTaskList[taskSupportBatchType].task->jobList.size() == 0)
-            toInsertTask = supportBatchTaskList[taskSupportBatchType].task;
-        supportBatchTaskList[taskSupportBatchType].task->jobList.emplace_back(job);
+        TaskSupportBatch &batch = supportBatchTaskList[taskSupportBatchType];
+        batch.controller->RecordArrival(1);
+        {
+            std::unique_lock<std::mutex> lk(batch.taskMutex);
+            batch.cvBatchNotFull.wait(lk, [this, &batch]() -> bool {
+                return batch.task->jobList.size() < batchTaskBufferMaxSize;
+            });
+            if (batch.task->jobList.size() == 0) {
+                toInsertTask = batch.task;
+                toInsertTask->lane = ConvertMetaServiceTypeToTaskLane(type);
+            }
+            batch.task->jobList.emplace_back(job);
+        }
+        batch.cvBatchGrown.notify_one();
     } else {
         toInsertTask = new Task();
         toInsertTask->jobList.emplace_back(job);
+        for (int i = 0; i < request->type_size(); ++i)
+            toInsertTask->lane = std::max(toInsertTask->lane, (int)ConvertMetaServiceTypeToTaskLane(request->type(i)));
     }
 
-    if (toInsertTask != NULL) {
-        {
-            std::unique_lock<std::mutex> lk(pendingTaskMutex);
-            cvPendingTaskNotFull.wait(lk, [this]() -> bool { return pendingTask.size() < pendingTaskBufferMaxSize; });
-            pendingTask.push(toInsertTask);
-        }
-        cvPendingTaskNotEmpty.notify_one();
-    }
+    if (toInsertTask != NULL)
+        PushPendingTask(toInsertTask);
 }
 
 void PGConnectionPool::Stop()
 {
     working = false;
-    cvPendingTaskNotEmpty.notify_one();
+    {
+        std::lock_guard<std::mutex> lk(idleDispatcherMutex);
+    }
+    cvPendingTaskNotEmpty.notify_all();
+    for (auto &dispatcher : dispatchers) {
+        {
+            std::lock_guard<std::mutex> lk(dispatcher->connPoolMutex);
+        }
+        dispatcher->cvPoolNotEmpty.notify_all();
+    }
 }
 
 PGConnectionPool::~PGConnectionPool()
 {
     Stop();
     for (auto it = currentManagedConn.begin(); it != currentManagedConn.end(); ++it) {
-        (*it)->Stop();
+        it->first->Stop();
     }
     for (auto it = currentManagedConn.begin(); it != currentManagedConn.end(); ++it) {
-        delete (*it);
+        delete it->first;
     }
-    backgroundPoolManager.join();
+    for (auto &dispatcher : dispatchers)
+        dispatcher->thread.join();
     currentManagedConn.clear();
 }
@@ -8,11 +8,14 @@
 #include "port/atomics.h"
 #include "storage/lwlock.h"
 #include "storage/shmem.h"
+#include "utils/timestamp.h"
 
 #include "utils/shmem_control.h"
 
 static ShmemControlData *FalconControlShmemControl;
 static pg_atomic_uint32 *FalconBackgroundServiceStarted;
+static pg_atomic_uint64 *FalconNamespaceGeneration;
+static bool FalconNamespaceGenerationDirty = false;
 
 PG_FUNCTION_INFO_V1(falcon_start_background_service);
 Datum falcon_start_background_service(PG_FUNCTION_ARGS)
@@ -23,13 +26,17 @@ Datum falcon_start_background_service(PG_FUNCTION_ARGS)
 
 bool CheckFalconBackgroundServiceStarted() { return pg_atomic_read_u32(FalconBackgroundServiceStarted) != 0; }
 
-size_t FalconControlShmemsize() { return sizeof(ShmemControlData) + sizeof(pg_atomic_uint32); }
+size_t FalconControlShmemsize()
+{
+    return sizeof(ShmemControlData) + sizeof(pg_atomic_uint32) + sizeof(pg_atomic_uint64);
+}
 void FalconControlShmemInit()
 {
     bool initialized = false;
 
     FalconControlShmemControl = ShmemInitStruct("Falcon Control", FalconControlShmemsize(), &initialized);
     FalconBackgroundServiceStarted = (pg_atomic_uint32 *)(FalconControlShmemControl + 1);
+    FalconNamespaceGeneration = (pg_atomic_uint64 *)(FalconBackgroundServiceStarted + 1);
     if (!initialized) {
         FalconControlShmemControl->trancheId = LWLockNewTrancheId();
         FalconControlShmemControl->lockTrancheName = "Falcon Control";
@@ -37,9 +44,26 @@ void FalconControlShmemInit()
         LWLockInitialize(&FalconControlShmemControl->lock, FalconControlShmemControl->trancheId);
 
         pg_atomic_init_u32(FalconBackgroundServiceStarted, 0);
+        // start from current time so that generations never go back across restarts
+        pg_atomic_init_u64(FalconNamespaceGeneration, (uint64)GetCurrentTimestamp());
     }
 }
 
+uint64_t GetFalconNamespaceGeneration() { return pg_atomic_read_u64(FalconNamespaceGeneration); }
+
+/*
+ * Generation is advanced only after the transaction which made new entries visible has committed, otherwise
+ * a client could cache a negative lookup under a generation that is already newer than the insertion.
+ */
+void FalconNamespaceGenerationMarkDirty() { FalconNamespaceGenerationDirty = true; }
+void FalconNamespaceGenerationAdvanceIfDirty()
+{
+    if (FalconNamespaceGenerationDirty)
+        pg_atomic_fetch_add_u64(FalconNamespaceGeneration, 1);
+    FalconNamespaceGenerationDirty = false;
+}
+void FalconNamespaceGenerationResetDirty() { FalconNamespaceGenerationDirty = false; }
+
 static bool FalconInAbortProgress = false;
 bool FalconIsInAbortProgress(void) { return FalconInAbortProgress; }
 void FalconEnterAbortProgress(void) { FalconInAbortProgress = true; }
@@ -39,6 +39,8 @@ Datum falcon_clear_user_data_func(PG_FUNCTION_ARGS)
         appendStringInfo(command, "TRUNCATE TABLE falcon_xattr_table_" INT32_PRINT_SYMBOL ";", data->range_point);
     }
     appendStringInfo(command, "TRUNCATE TABLE falcon_directory_table;");
+    appendStringInfo(command, "TRUNCATE TABLE falcon_directory_log;");
+    appendStringInfo(command, "TRUNCATE TABLE falcon_data_delete_queue;");
 
     int spiQueryResult = SPI_execute(command->data, false, 0);
     if (spiQueryResult != SPI_OK_UTILITY) {
@@ -6,8 +6,10 @@
 
 #include "storage/ipc.h"
 
+#include "control/control_flag.h"
 #include "dir_path_shmem/dir_path_hash.h"
 #include "metadb/foreign_server.h"
+#include "metadb/inode_attr_cache.h"
 #include "metadb/shard_table.h"
 #include "transaction/transaction.h"
 #include "utils/rwlock.h"
@@ -15,6 +17,7 @@
 
 static void RegisterFalconPerBackendCallback(void);
 static void ClearCachedDataIfNecessary(PlannedStmt *pstmt);
+static void MarkNamespaceGenerationDirtyIfNecessary(PlannedStmt *pstmt);
 static void SavePreparedTransactionGid(PlannedStmt *pstmt);
 
 ProcessUtility_hook_type pre_ProcessUtility_hook = NULL;
@@ -28,6 +31,7 @@ void falcon_ProcessUtility(PlannedStmt *pstmt,
                            QueryCompletion *qc)
 {
     RegisterFalconPerBackendCallback();
+    MarkNamespaceGenerationDirtyIfNecessary(pstmt);
     standard_ProcessUtility(pstmt, queryString, readOnlyTree, context, params, queryEnv, dest, qc);
 
     ClearCachedDataIfNecessary(pstmt);
@@ -76,11 +80,27 @@ static void ClearCachedDataIfNecessary(PlannedStmt *pstmt)
             ClearDirPathHash();
             InvalidateForeignServerShmemCache();
             InvalidateShardTableShmemCache();
+            InodeAttrCacheInvalidateAll();
             break;
         }
     }
 }
 
+/*
+ * The backend which prepared a 2PC branch can't know when it commits, so COMMIT PREPARED conservatively
+ * advances the namespace generation and drops the inode attribute cache.
+ */
+static void MarkNamespaceGenerationDirtyIfNecessary(PlannedStmt *pstmt)
+{
+    if (pstmt->utilityStmt->type != T_TransactionStmt)
+        return;
+    TransactionStmt *stmt = (TransactionStmt *)pstmt->utilityStmt;
+    if (stmt->kind == TRANS_STMT_COMMIT_PREPARED) {
+        FalconNamespaceGenerationMarkDirty();
+        InodeAttrCacheInvalidateAllAtCommit();
+    }
+}
+
 static void __attribute__((unused)) SavePreparedTransactionGid(PlannedStmt *pstmt)
 {
     PreparedTransactionGid[0] = '\0';
@@ -20,11 +20,13 @@
 #include "catalog/pg_namespace_d.h"
 #include "common/hashfn.h"
 #include "funcapi.h"
+#include "miscadmin.h"
 #include "storage/lock.h"
 #include "utils/builtins.h"
 #include "utils/dynahash.h"
 #include "utils/fmgroids.h"
 #include "utils/hsearch.h"
+#include "utils/memutils.h"
 #include "utils/palloc.h"
 #include "utils/snapmgr.h"
 
@@ -101,48 +103,116 @@ static LWLockPadded *DirPathLWLockArray;
 #define DIR_PATH_HASH_PARTITION_LOCK(hashcode) (&(DirPathLWLockArray[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE].lock))
 static HTAB *PathDirHash[DIR_PATH_HASH_PARTITION_SIZE] = {0};
 #define DIR_PATH_HASH_PARTITION(hashcode) (PathDirHash[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE])
-static pg_atomic_uint32 *PathDirHashEntryCount = NULL;
-#define DIR_PATH_HASH_PARTITION_COUNT(hashcode) (PathDirHashEntryCount + (hashcode) % DIR_PATH_HASH_PARTITION_SIZE)
 
-static char DirPathHashToCommitAction[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
-static DirPathHashItem DirPathHashToCommitActionInfo[MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH];
+int FalconDirPathHashCapacity = FALCON_DIR_PATH_HASH_CAPACITY_DEFAULT;
+#define DIR_PATH_HASH_PARTITION_CAPACITY (FalconDirPathHashCapacity / DIR_PATH_HASH_PARTITION_SIZE)
+#define DIR_PATH_HASH_PARTITION_LRU_CLEAR_BEGIN (DIR_PATH_HASH_PARTITION_CAPACITY / 4 * 3)
+
+/*
+ * Names longer than DIR_PATH_HASH_INLINE_NAME_SIZE continue in a chain of arena chunks. Every partition owns a
+ * slice of the arena whose free list is protected by the partition lock.
+ */
+#define DIR_PATH_NAME_CHUNK_DATA_SIZE 28
+#define DIR_PATH_NAME_NO_CHUNK PG_UINT32_MAX
+#define DIR_PATH_NAME_MAX_CHUNK_COUNT                                                                                 \
+    ((MAX_DIRECTORY_PATH_HASH_SIZE - DIR_PATH_HASH_INLINE_NAME_SIZE + DIR_PATH_NAME_CHUNK_DATA_SIZE - 1) /            \
+     DIR_PATH_NAME_CHUNK_DATA_SIZE)
+#define DIR_PATH_NAME_PARTITION_CHUNK_COUNT (DIR_PATH_HASH_PARTITION_CAPACITY / 2 + DIR_PATH_NAME_MAX_CHUNK_COUNT)
+typedef struct
+{
+    uint32_t next;
+    char data[DIR_PATH_NAME_CHUNK_DATA_SIZE];
+} DirPathNameChunk;
+static DirPathNameChunk *DirPathNameArena = NULL;
+
+typedef struct
+{
+    pg_atomic_uint32 entryCount;
+    // advanced whenever a committed change is applied, preloading gives way to them
+    pg_atomic_uint64 version;
+    uint32_t freeNameChunk;
+    uint32_t freeNameChunkCount;
+    uint64_t nextItemVersion;
+} DirPathHashPartitionState;
+static DirPathHashPartitionState *DirPathPartitionState = NULL;
+#define DIR_PATH_HASH_PARTITION_STATE(hashcode) (&DirPathPartitionState[(hashcode) % DIR_PATH_HASH_PARTITION_SIZE])
+
+/*
+ * Actions applied to the hash once the transaction commits. A single transaction may touch any number of
+ * directories, e.g. a recursive mkdir or rmdir, so the actions and their names live in a context of their own which
+ * grows on demand. It hangs under TopMemoryContext since a prepared transaction commits after its own context is gone.
+ */
+typedef struct
+{
+    char action;
+    uint64_t parentId;
+    char *fileName;
+    uint64_t inodeId;
+} DirPathHashToCommitInfo;
+static MemoryContext DirPathHashToCommitContext = NULL;
+static DirPathHashToCommitInfo *DirPathHashToCommitActionInfo = NULL;
+static int DirPathHashToCommitCapacity = 0;
 static int DirPathHashToCommitSize = 0;
+static void DirPathHashToCommitAppend(char action, uint64_t parentId, const char *fileName, uint64_t inodeId);
 void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName);
 void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uint64_t inodeId);
 void DirPathHashToCommitClear(void);
 
-void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName)
+static void DirPathHashToCommitAppend(char action, uint64_t parentId, const char *fileName, uint64_t inodeId)
 {
-    if (DirPathHashToCommitSize >= MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH)
-        FALCON_ELOG_ERROR(PROGRAM_ERROR,
-                          "concurrency of directory action surpass MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH.");
-    DirPathHashToCommitAction[DirPathHashToCommitSize] = 'A';
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.parentId = parentId;
-    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.fileName, fileName);
+    if (DirPathHashToCommitContext == NULL)
+        DirPathHashToCommitContext =
+            AllocSetContextCreate(TopMemoryContext, "DirPathHashToCommitContext", ALLOCSET_DEFAULT_SIZES);
+    if (DirPathHashToCommitSize >= DirPathHashToCommitCapacity) {
+        int newCapacity = DirPathHashToCommitCapacity == 0 ? DIRECTORY_HASH_TO_COMMIT_INITIAL_ACTION_LENGTH
+                                                           : DirPathHashToCommitCapacity * 2;
+        if (DirPathHashToCommitActionInfo == NULL)
+            DirPathHashToCommitActionInfo = (DirPathHashToCommitInfo *)MemoryContextAlloc(
+                DirPathHashToCommitContext, newCapacity * sizeof(DirPathHashToCommitInfo));
+        else
+            DirPathHashToCommitActionInfo = (DirPathHashToCommitInfo *)repalloc_huge(
+                DirPathHashToCommitActionInfo, (Size)newCapacity * sizeof(DirPathHashToCommitInfo));
+        DirPathHashToCommitCapacity = newCapacity;
+    }
+    DirPathHashToCommitInfo *info = &DirPathHashToCommitActionInfo[DirPathHashToCommitSize];
+    info->action = action;
+    info->parentId = parentId;
+    info->fileName = MemoryContextStrdup(DirPathHashToCommitContext, fileName);
+    info->inodeId = inodeId;
     DirPathHashToCommitSize++;
 }
+void DirPathHashToCommitAddEntry(uint64_t parentId, const char *fileName)
+{
+    DirPathHashToCommitAppend('A', parentId, fileName, 0);
+}
 void DirPathHashToCommitUpdateEntry(uint64_t parentId, const char *fileName, uint64_t inodeId)
 {
-    if (DirPathHashToCommitSize >= MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH)
-        FALCON_ELOG_ERROR(PROGRAM_ERROR,
-                          "concurrency of directory action surpass MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH.");
-    DirPathHashToCommitAction[DirPathHashToCommitSize] = 'U';
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.parentId = parentId;
-    strcpy(DirPathHashToCommitActionInfo[DirPathHashToCommitSize].key.fileName, fileName);
-    DirPathHashToCommitActionInfo[DirPathHashToCommitSize].inodeId = inodeId;
-    DirPathHashToCommitSize++;
+    DirPathHashToCommitAppend('U', parentId, fileName, inodeId);
+}
+// gives back what a large transaction made the context grow to
+void DirPathHashToCommitClear()
+{
+    if (DirPathHashToCommitContext != NULL && DirPathHashToCommitCapacity > 0)
+        MemoryContextReset(DirPathHashToCommitContext);
+    DirPathHashToCommitActionInfo = NULL;
+    DirPathHashToCommitCapacity = 0;
+    DirPathHashToCommitSize = 0;
 }
-void DirPathHashToCommitClear() { DirPathHashToCommitSize = 0; }
-
-DirPathHashKey ClockCountList[DIRECTORY_PATH_HASH_BUCKET_NUM];
 
 RWLock *DirectoryHashTableLastAcquiredLock = NULL;
 
 static uint32 dir_path_hash(const void *key, Size keysize);
-static int dir_path_compare(const void *key1, const void *key2);
-static int dir_path_compare(const void *key1, const void *key2);
 static int dir_path_match(const void *key1, const void *key2, Size keysize);
 static void *dir_path_keycopy(void *dest, const void *src, Size keysize);
+static void DirPathHashKeyInit(DirPathHashKey *key, uint64_t parentId, const char *name);
+static void DirPathHashKeyGetName(const DirPathHashKey *key, char *name);
+static bool DirPathHashKeyNameEqual(const DirPathHashKey *key, const char *name);
+static bool DirPathNameIntern(int partitionIndex, DirPathHashKey *key);
+static void DirPathNameRelease(int partitionIndex, uint32_t chunk);
+static void DirPathNameArenaReset(int partitionIndex);
+static DirPathHashItem *DirPathHashEnter(const DirPathHashKey *key, uint32 hashcode, bool *found);
+static void DirPathHashRemove(DirPathHashItem *item, const DirPathHashKey *key, uint32 hashcode);
+static void AcquireDirPathHashItemLock(DirPathHashItem *item, LWLock *partitionLock, DirPathLockMode lockMode);
 static void ReleaseDirPathHashLock(uint64_t parentId, char *filename);
 static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyableCnt);
 static bool EliminateDirPathHashByLRU(int partitionIndex);
@@ -151,6 +221,14 @@ PG_FUNCTION_INFO_V1(falcon_print_dir_path_hash_elem);
 PG_FUNCTION_INFO_V1(falcon_acquire_hash_lock);
 PG_FUNCTION_INFO_V1(falcon_release_hash_lock);
 
+typedef struct
+{
+    char fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
+    uint64_t parentId;
+    uint64_t inodeId;
+    bool locked;
+} DirPathHashElemInfo;
+
 Datum falcon_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
 {
     FuncCallContext *functionContext = NULL;
@@ -158,6 +236,7 @@ Datum falcon_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
     List *returnInfoList = NIL;
     uint32 d_off;
     DirPathHashItem *entry;
+    DirPathHashElemInfo *elem;
     Datum values[4];
     bool resNulls[4];
     HeapTuple heapTupleRes;
@@ -173,12 +252,17 @@ Datum falcon_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
 
         HASH_SEQ_STATUS status;
         for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
+            LWLockAcquire(&(DirPathLWLockArray[i].lock), LW_SHARED);
             hash_seq_init(&status, PathDirHash[i]);
             while ((entry = hash_seq_search(&status)) != 0) {
-                DirPathHashItem *temp_entry = (DirPathHashItem *)palloc(sizeof(DirPathHashItem));
-                memcpy(temp_entry, entry, sizeof(DirPathHashItem));
-                returnInfoList = lappend(returnInfoList, temp_entry);
+                elem = (DirPathHashElemInfo *)palloc(sizeof(DirPathHashElemInfo));
+                DirPathHashKeyGetName(&entry->key, elem->fileName);
+                elem->parentId = entry->key.parentId;
+                elem->inodeId = entry->inodeId;
+                elem->locked = pg_atomic_read_u64(&entry->lock.state) != 0;
+                returnInfoList = lappend(returnInfoList, elem);
             }
+            LWLockRelease(&(DirPathLWLockArray[i].lock));
         }
 
         functionContext->user_fctx = returnInfoList;
@@ -190,13 +274,12 @@ Datum falcon_print_dir_path_hash_elem(PG_FUNCTION_ARGS)
     d_off = functionContext->call_cntr;
 
     if (d_off < functionContext->max_calls) {
-        entry = (DirPathHashItem *)list_nth(returnInfoList, d_off);
+        elem = (DirPathHashElemInfo *)list_nth(returnInfoList, d_off);
         memset(resNulls, false, sizeof(resNulls));
-        values[0] = CStringGetTextDatum(entry->key.fileName);
-        values[1] = Int32GetDatum(entry->key.parentId);
-        values[2] = Int32GetDatum(entry->inodeId);
-        RWLock *lock = &entry->lock;
-        if (pg_atomic_read_u64(&lock->state) == 0) {
+        values[0] = CStringGetTextDatum(elem->fileName);
+        values[1] = Int64GetDatum(elem->parentId);
+        values[2] = Int64GetDatum(elem->inodeId);
+        if (!elem->locked) {
             values[3] = CStringGetTextDatum("no lock");
         } else {
             values[3] = CStringGetTextDatum("locked");
@@ -250,40 +333,209 @@ Datum falcon_release_hash_lock(PG_FUNCTION_ARGS)
 static uint32 dir_path_hash(const void *key, Size keysize)
 {
     const DirPathHashKey *l = (const DirPathHashKey *)key;
-    return DatumGetUInt32(hash_any_extended((const unsigned char *)l->fileName, strlen(l->fileName), l->parentId));
+    return DatumGetUInt32(hash_any_extended((const unsigned char *)l->fileName, l->nameLength, l->parentId));
 }
 
-static int dir_path_compare(const void *key1, const void *key2)
+static int dir_path_match(const void *key1, const void *key2, Size keysize)
 {
     const DirPathHashKey *d1 = (const DirPathHashKey *)key1;
     const DirPathHashKey *d2 = (const DirPathHashKey *)key2;
 
-    /* First, compare by parentId */
-    if (d1->parentId > d2->parentId) {
+    if (d1->parentId != d2->parentId || d1->nameLength != d2->nameLength)
         return 1;
-    } else if (d1->parentId < d2->parentId) {
-        return -1;
-    }
-    /* parentId are equal, do a byte-by-byte comparison on fileName */
-    return strcmp(d1->fileName, d2->fileName);
+    /* one of both is the key searched by, which still points to its name */
+    if (d2->fileName != NULL)
+        return DirPathHashKeyNameEqual(d1, d2->fileName) ? 0 : 1;
+    return DirPathHashKeyNameEqual(d2, d1->fileName) ? 0 : 1;
 }
 
-static int dir_path_match(const void *key1, const void *key2, Size keysize) { return dir_path_compare(key1, key2); }
-
+/* the name past the inline part has already been interned into src by DirPathHashEnter */
 static void *dir_path_keycopy(void *dest, const void *src, Size keysize)
 {
     const DirPathHashKey *srcVal = (const DirPathHashKey *)src;
     DirPathHashKey *destVal = (DirPathHashKey *)dest;
     destVal->parentId = srcVal->parentId;
-    strcpy(destVal->fileName, srcVal->fileName);
+    destVal->nameLength = srcVal->nameLength;
+    destVal->nameChunk = srcVal->nameChunk;
+    memcpy(destVal->inlineName, srcVal->fileName, Min(srcVal->nameLength, DIR_PATH_HASH_INLINE_NAME_SIZE));
+    destVal->fileName = NULL;
     return NULL;
 }
 
+static void DirPathHashKeyInit(DirPathHashKey *key, uint64_t parentId, const char *name)
+{
+    key->parentId = parentId;
+    key->nameLength = strlen(name);
+    // such a name could never be interned, and callers waiting for room would evict forever
+    if (key->nameLength >= MAX_DIRECTORY_PATH_HASH_SIZE)
+        FALCON_ELOG_ERROR_EXTENDED(NAME_TOO_LONG, "name of %u bytes is too long.", key->nameLength);
+    key->nameChunk = DIR_PATH_NAME_NO_CHUNK;
+    key->fileName = name;
+}
+
+/* name must have room for MAX_DIRECTORY_PATH_HASH_SIZE bytes */
+static void DirPathHashKeyGetName(const DirPathHashKey *key, char *name)
+{
+    uint32_t length = Min(key->nameLength, DIR_PATH_HASH_INLINE_NAME_SIZE);
+    memcpy(name, key->inlineName, length);
+    for (uint32_t chunk = key->nameChunk; chunk != DIR_PATH_NAME_NO_CHUNK; chunk = DirPathNameArena[chunk].next) {
+        uint32_t partLength = Min(key->nameLength - length, DIR_PATH_NAME_CHUNK_DATA_SIZE);
+        memcpy(name + length, DirPathNameArena[chunk].data, partLength);
+        length += partLength;
+    }
+    name[length] = '\0';
+}
+
+/* key is a stored one, whose name length has been compared already */
+static bool DirPathHashKeyNameEqual(const DirPathHashKey *key, const char *name)
+{
+    uint32_t length = Min(key->nameLength, DIR_PATH_HASH_INLINE_NAME_SIZE);
+    if (memcmp(key->inlineName, name, length) != 0)
+        return false;
+    for (uint32_t chunk = key->nameChunk; chunk != DIR_PATH_NAME_NO_CHUNK; chunk = DirPathNameArena[chunk].next) {
+        uint32_t partLength = Min(key->nameLength - length, DIR_PATH_NAME_CHUNK_DATA_SIZE);
+        if (memcmp(DirPathNameArena[chunk].data, name + length, partLength) != 0)
+            return false;
+        length += partLength;
+    }
+    return true;
+}
+
+static bool DirPathNameIntern(int partitionIndex, DirPathHashKey *key)
+{
+    if (key->nameLength >= MAX_DIRECTORY_PATH_HASH_SIZE)
+        return false;
+    DirPathHashPartitionState *state = &DirPathPartitionState[partitionIndex];
+    uint32_t restLength = key->nameLength > DIR_PATH_HASH_INLINE_NAME_SIZE
+                              ? key->nameLength - DIR_PATH_HASH_INLINE_NAME_SIZE
+                              : 0;
+    uint32_t chunkCount = (restLength + DIR_PATH_NAME_CHUNK_DATA_SIZE - 1) / DIR_PATH_NAME_CHUNK_DATA_SIZE;
+    if (chunkCount > state->freeNameChunkCount)
+        return false;
+
+    const char *rest = key->fileName + DIR_PATH_HASH_INLINE_NAME_SIZE;
+    uint32_t *link = &key->nameChunk;
+    for (uint32_t i = 0; i < chunkCount; ++i) {
+        uint32_t chunk = state->freeNameChunk;
+        uint32_t partLength = Min(restLength, DIR_PATH_NAME_CHUNK_DATA_SIZE);
+        state->freeNameChunk = DirPathNameArena[chunk].next;
+        memcpy(DirPathNameArena[chunk].data, rest, partLength);
+        rest += partLength;
+        restLength -= partLength;
+        *link = chunk;
+        link = &DirPathNameArena[chunk].next;
+    }
+    *link = DIR_PATH_NAME_NO_CHUNK;
+    state->freeNameChunkCount -= chunkCount;
+    return true;
+}
+
+static void DirPathNameRelease(int partitionIndex, uint32_t chunk)
+{
+    DirPathHashPartitionState *state = &DirPathPartitionState[partitionIndex];
+    while (chunk != DIR_PATH_NAME_NO_CHUNK) {
+        uint32_t next = DirPathNameArena[chunk].next;
+        DirPathNameArena[chunk].next = state->freeNameChunk;
+        state->freeNameChunk = chunk;
+        state->freeNameChunkCount++;
+        chunk = next;
+    }
+}
+
+static void DirPathNameArenaReset(int partitionIndex)
+{
+    DirPathHashPartitionState *state = &DirPathPartitionState[partitionIndex];
+    uint32_t first = partitionIndex * DIR_PATH_NAME_PARTITION_CHUNK_COUNT;
+    for (uint32_t i = 0; i < DIR_PATH_NAME_PARTITION_CHUNK_COUNT; ++i)
+        DirPathNameArena[first + i].next = i + 1 < DIR_PATH_NAME_PARTITION_CHUNK_COUNT ? first + i + 1
+                                                                                       : DIR_PATH_NAME_NO_CHUNK;
+    state->freeNameChunk = first;
+    state->freeNameChunkCount = DIR_PATH_NAME_PARTITION_CHUNK_COUNT;
+}
+
+/* the partition lock must be held exclusively, returns NULL if there is no space left for the entry */
+static DirPathHashItem *DirPathHashEnter(const DirPathHashKey *key, uint32 hashcode, bool *found)
+{
+    int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
+    DirPathHashItem *item = (DirPathHashItem *)hash_search_with_hash_value(PathDirHash[partitionIndex],
+                                                                           (const void *)key,
+                                                                           hashcode,
+                                                                           HASH_FIND,
+                                                                           found);
+    if (*found)
+        return item;
+
+    DirPathHashKey internedKey = *key;
+    if (!DirPathNameIntern(partitionIndex, &internedKey))
+        return NULL;
+    item = (DirPathHashItem *)hash_search_with_hash_value(PathDirHash[partitionIndex],
+                                                          (const void *)&internedKey,
+                                                          hashcode,
+                                                          HASH_ENTER_NULL,
+                                                          found);
+    if (!item) {
+        DirPathNameRelease(partitionIndex, internedKey.nameChunk);
+    } else {
+        pg_atomic_fetch_add_u32(&DirPathPartitionState[partitionIndex].entryCount, 1);
+        item->partitionIndex = partitionIndex;
+        item->version = DirPathPartitionState[partitionIndex].nextItemVersion++;
+    }
+    return item;
+}
+
+/* the partition lock must be held exclusively */
+static void DirPathHashRemove(DirPathHashItem *item, const DirPathHashKey *key, uint32 hashcode)
+{
+    int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
+    uint32_t nameChunk = item->key.nameChunk;
+    // the memory of the entry may be reused, refs to it must not match anymore
+    item->version = DirPathPartitionState[partitionIndex].nextItemVersion++;
+    bool found;
+    hash_search_with_hash_value(PathDirHash[partitionIndex], (const void *)key, hashcode, HASH_REMOVE, &found);
+    DirPathNameRelease(partitionIndex, nameChunk);
+    pg_atomic_fetch_sub_u32(&DirPathPartitionState[partitionIndex].entryCount, 1);
+}
+
+/*
+ * The partition lock must be held, it is released before waiting for the lock of the entry. Shared locks of
+ * reader biased entries are taken right away, which leaves the reference count of the entry alone.
+ */
+static void AcquireDirPathHashItemLock(DirPathHashItem *item, LWLock *partitionLock, DirPathLockMode lockMode)
+{
+    item->usageCount++;
+    if (lockMode == DIR_LOCK_SHARED && RWLockAcquireBiased(&item->lock)) {
+        LWLockRelease(partitionLock);
+        DirectoryHashTableLastAcquiredLock = &item->lock;
+        return;
+    }
+    if (lockMode != DIR_LOCK_NONE)
+        RWLockDeclare(&item->lock);
+    LWLockRelease(partitionLock);
+
+    switch (lockMode) {
+    case DIR_LOCK_EXCLUSIVE: {
+        RWLockAcquire(&item->lock, RW_EXCLUSIVE);
+        break;
+    }
+    case DIR_LOCK_SHARED: {
+        RWLockAcquire(&item->lock, RW_SHARED);
+        break;
+    }
+    case DIR_LOCK_NONE:
+        break;
+    default:
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong lock Mode");
+    }
+    if (lockMode != DIR_LOCK_NONE) {
+        RWLockUndeclare(&item->lock);
+        DirectoryHashTableLastAcquiredLock = &item->lock;
+    }
+}
+
 static void ReleaseDirPathHashLock(uint64_t parentId, char *filename)
 {
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, filename);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, filename);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash(&dirPathHashKey, sizeof(DirPathHashKey));
@@ -311,8 +563,7 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
                                          DirPathLockMode lockMode)
 {
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
@@ -332,11 +583,7 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
+            item = DirPathHashEnter(&dirPathHashKey, hashcode, &isfound);
             if (!isfound && !item) // no space
             {
                 if (lockMode != DIR_LOCK_NONE) {
@@ -345,8 +592,6 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
                     continue;
                 }
             } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
                 RWLockInitialize(&item->lock);
                 item->usageCount = 0;
                 item->inodeId = tempId;
@@ -363,29 +608,7 @@ void InsertDirectoryByDirectoryHashTable(Relation relation,
         InsertIntoDirectoryTable(relation, indexState, parentId, name, inodeId);
         return;
     }
-    item->usageCount++;
-    if (lockMode != DIR_LOCK_NONE)
-        RWLockDeclare(&item->lock);
-    LWLockRelease(lock);
-
-    switch (lockMode) {
-    case DIR_LOCK_EXCLUSIVE: {
-        RWLockAcquire(&item->lock, RW_EXCLUSIVE);
-        break;
-    }
-    case DIR_LOCK_SHARED: {
-        RWLockAcquire(&item->lock, RW_SHARED);
-        break;
-    }
-    case DIR_LOCK_NONE:
-        break;
-    default:
-        FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong lock Mode");
-    }
-    if (lockMode != DIR_LOCK_NONE) {
-        RWLockUndeclare(&item->lock);
-        DirectoryHashTableLastAcquiredLock = &item->lock;
-    }
+    AcquireDirPathHashItemLock(item, lock, lockMode);
 
     InsertIntoDirectoryTable(relation, indexState, parentId, name, inodeId);
 
@@ -398,8 +621,7 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
     uint64_t inodeId;
 
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
@@ -416,11 +638,7 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
+            item = DirPathHashEnter(&dirPathHashKey, hashcode, &isfound);
             if (!isfound && !item) // no space, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
@@ -429,8 +647,6 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
                     continue;
                 }
             } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
                 RWLockInitialize(&item->lock);
                 item->usageCount = 0;
                 item->inodeId = inodeId;
@@ -446,29 +662,7 @@ SearchDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const
         LWLockRelease(lock);
         return inodeId;
     }
-    item->usageCount++;
-    if (lockMode != DIR_LOCK_NONE)
-        RWLockDeclare(&item->lock);
-    LWLockRelease(lock);
-
-    switch (lockMode) {
-    case DIR_LOCK_EXCLUSIVE: {
-        RWLockAcquire(&item->lock, RW_EXCLUSIVE);
-        break;
-    }
-    case DIR_LOCK_SHARED: {
-        RWLockAcquire(&item->lock, RW_SHARED);
-        break;
-    }
-    case DIR_LOCK_NONE:
-        break;
-    default:
-        FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong lock Mode");
-    }
-    if (lockMode != DIR_LOCK_NONE) {
-        RWLockUndeclare(&item->lock);
-        DirectoryHashTableLastAcquiredLock = &item->lock;
-    }
+    AcquireDirPathHashItemLock(item, lock, lockMode);
 
     return item->inodeId;
 }
@@ -480,8 +674,7 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
     if (lockMode == DIR_LOCK_SHARED)
         FALCON_ELOG_ERROR(PROGRAM_ERROR, "not supported lockmode while deleting.");
     DirPathHashKey dirPathHashKey;
-    strcpy(dirPathHashKey.fileName, name);
-    dirPathHashKey.parentId = parentId;
+    DirPathHashKeyInit(&dirPathHashKey, parentId, name);
 
     bool isfound = false;
     uint32 hashcode = dir_path_hash((const void *)&dirPathHashKey, sizeof(DirPathHashKey));
@@ -497,11 +690,7 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
 
         for (;;) {
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            item = (DirPathHashItem *)hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                  (const void *)&dirPathHashKey,
-                                                                  hashcode,
-                                                                  HASH_ENTER_NULL,
-                                                                  &isfound);
+            item = DirPathHashEnter(&dirPathHashKey, hashcode, &isfound);
             if (!isfound && !item) // no space, and must allocate space for rwlock
             {
                 if (lockMode != DIR_LOCK_NONE) {
@@ -510,8 +699,6 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
                     continue;
                 }
             } else if (!isfound && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
                 RWLockInitialize(&item->lock);
                 item->usageCount = 0;
                 item->inodeId = DIR_HASH_TABLE_PATH_UNKNOWN;
@@ -541,6 +728,43 @@ void DeleteDirectoryByDirectoryHashTable(Relation relation,
     DirPathHashToCommitUpdateEntry(dirPathHashKey.parentId, dirPathHashKey.fileName, DIR_HASH_TABLE_PATH_NOT_EXIST);
 }
 
+void DirPathHashGetLastAcquiredRef(DirPathHashRef *ref)
+{
+    DirPathHashItem *item =
+        (DirPathHashItem *)((char *)DirectoryHashTableLastAcquiredLock - offsetof(DirPathHashItem, lock));
+    LWLock *lock = &(DirPathLWLockArray[item->partitionIndex].lock);
+    LWLockAcquire(lock, LW_SHARED);
+    ref->item = item;
+    ref->version = item->version;
+    ref->inodeId = item->inodeId;
+    ref->partitionIndex = item->partitionIndex;
+    LWLockRelease(lock);
+}
+
+bool AcquireDirectoryByDirPathHashRef(const DirPathHashRef *ref, DirPathLockMode lockMode)
+{
+    // entries are only removed under the exclusive partition lock, after which their version has moved
+    LWLock *lock = &(DirPathLWLockArray[ref->partitionIndex].lock);
+    DirPathHashItem *item = ref->item;
+    if (lockMode == DIR_LOCK_SHARED && RWLockAcquireBiased(&item->lock)) {
+        // a biased holder keeps the entry from being eliminated, so the partition lock can be skipped
+        if (item->version == ref->version && item->inodeId == ref->inodeId) {
+            if (item->usageCount <= 0)
+                item->usageCount = 1;
+            DirectoryHashTableLastAcquiredLock = &item->lock;
+            return true;
+        }
+        RWLockRelease(&item->lock);
+    }
+    LWLockAcquire(lock, LW_SHARED);
+    if (item->version != ref->version || item->inodeId != ref->inodeId) {
+        LWLockRelease(lock);
+        return false;
+    }
+    AcquireDirPathHashItemLock(item, lock, lockMode);
+    return true;
+}
+
 static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyableCnt)
 {
     DirPathHashItem *entry;
@@ -562,14 +786,17 @@ static DirPathHashItem *FindNextItem(HASH_SEQ_STATUS *status, int32_t *destroyab
 
 static bool EliminateDirPathHashByLRU(int partitionIndex)
 {
-    if (pg_atomic_read_u32(&(PathDirHashEntryCount[partitionIndex])) <=
-        MAX_BUCKET_SUM_LRU_CLAER_BEGIN / DIR_PATH_HASH_PARTITION_SIZE)
+    // also begin once the name arena of the partition may not fit the next name
+    if (pg_atomic_read_u32(&(DirPathPartitionState[partitionIndex].entryCount)) <=
+            DIR_PATH_HASH_PARTITION_LRU_CLEAR_BEGIN &&
+        DirPathPartitionState[partitionIndex].freeNameChunkCount >= DIR_PATH_NAME_MAX_CHUNK_COUNT)
         return false;
 
     HASH_SEQ_STATUS status;
     int32_t destroyableCnt = 0;
     DirPathHashItem *entry = NULL;
     DirPathHashKey target;
+    char targetName[MAX_DIRECTORY_PATH_HASH_SIZE];
 
     // eliminate one
     for (;;) {
@@ -586,8 +813,8 @@ static bool EliminateDirPathHashByLRU(int partitionIndex)
             }
         }
         if (entry != NULL) {
-            strcpy(target.fileName, entry->key.fileName);
-            target.parentId = entry->key.parentId;
+            DirPathHashKeyGetName(&entry->key, targetName);
+            DirPathHashKeyInit(&target, entry->key.parentId, targetName);
         }
         LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
 
@@ -606,13 +833,11 @@ static bool EliminateDirPathHashByLRU(int partitionIndex)
             LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
             continue;
         }
-        hash_search_with_hash_value(PathDirHash[partitionIndex], (const void *)&target, hashcode, HASH_REMOVE, &found);
+        DirPathHashRemove(entry, &target, hashcode);
         LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
-        if (found) // succeed in eliminating
-            break;
+        break;
     }
 
-    pg_atomic_fetch_sub_u32(&(PathDirHashEntryCount[partitionIndex]), 1);
     return true;
 }
 
@@ -620,10 +845,11 @@ void CommitForDirPathHash()
 {
     // switch()
     for (int i = 0; i < DirPathHashToCommitSize; ++i) {
-        switch (DirPathHashToCommitAction[i]) {
+        DirPathHashKey key;
+        DirPathHashKeyInit(&key, DirPathHashToCommitActionInfo[i].parentId, DirPathHashToCommitActionInfo[i].fileName);
+        uint32 hashcode = dir_path_hash((const void *)&key, sizeof(DirPathHashKey));
+        switch (DirPathHashToCommitActionInfo[i].action) {
         case 'A': {
-            uint32 hashcode =
-                dir_path_hash((const void *)&(DirPathHashToCommitActionInfo[i].key), sizeof(DirPathHashKey));
             int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
             EliminateDirPathHashByLRU(partitionIndex);
 
@@ -631,23 +857,18 @@ void CommitForDirPathHash()
         }
         case 'U': {
             bool found;
-            uint32 hashcode =
-                dir_path_hash((const void *)&(DirPathHashToCommitActionInfo[i].key), sizeof(DirPathHashKey));
             LWLock *lock = DIR_PATH_HASH_PARTITION_LOCK(hashcode);
             LWLockAcquire(lock, LW_EXCLUSIVE);
-            DirPathHashItem *item = hash_search_with_hash_value(DIR_PATH_HASH_PARTITION(hashcode),
-                                                                (const void *)&(DirPathHashToCommitActionInfo[i].key),
-                                                                hashcode,
-                                                                HASH_ENTER_NULL,
-                                                                &found);
+            DirPathHashItem *item = DirPathHashEnter(&key, hashcode, &found);
             if (!found && item) {
-                pg_atomic_fetch_add_u32(DIR_PATH_HASH_PARTITION_COUNT(hashcode), 1);
-
-                item->key.parentId = DirPathHashToCommitActionInfo[i].key.parentId;
-                strcpy(item->key.fileName, DirPathHashToCommitActionInfo[i].key.fileName);
+                RWLockInitialize(&item->lock);
+                item->usageCount = 0;
             }
-            if (item)
+            if (item) {
                 item->inodeId = DirPathHashToCommitActionInfo[i].inodeId;
+                item->version = DIR_PATH_HASH_PARTITION_STATE(hashcode)->nextItemVersion++;
+            }
+            pg_atomic_fetch_add_u64(&DIR_PATH_HASH_PARTITION_STATE(hashcode)->version, 1);
             LWLockRelease(lock);
             break;
         }
@@ -664,17 +885,82 @@ void AbortForDirPathHash() { DirPathHashToCommitClear(); }
 
 void ClearDirPathHash()
 {
+    HASH_SEQ_STATUS status;
+    DirPathHashItem *entry;
+    DirPathHashKey key;
+    char name[MAX_DIRECTORY_PATH_HASH_SIZE];
     for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
         LWLockAcquire(&(DirPathLWLockArray[i].lock), LW_EXCLUSIVE);
-        hash_clear(PathDirHash[i]);
+        // stored keys can't be hashed, so hash_clear is of no use here
+        hash_seq_init(&status, PathDirHash[i]);
+        while ((entry = hash_seq_search(&status)) != NULL) {
+            DirPathHashKeyGetName(&entry->key, name);
+            DirPathHashKeyInit(&key, entry->key.parentId, name);
+            DirPathHashRemove(entry, &key, dir_path_hash((const void *)&key, sizeof(DirPathHashKey)));
+        }
+        pg_atomic_fetch_add_u64(&DirPathPartitionState[i].version, 1);
         LWLockRelease(&(DirPathLWLockArray[i].lock));
     }
 }
 
+/*
+ * Fill the hash with the directory table, until partitions reach the point where elimination begins. Partitions
+ * which committed changes since the table was read are skipped, because an entry of theirs may have been
+ * eliminated after the change and would come back stale.
+ */
+void PreloadDirPathHash()
+{
+    uint64_t version[DIR_PATH_HASH_PARTITION_SIZE];
+    for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i)
+        version[i] = pg_atomic_read_u64(&DirPathPartitionState[i].version);
+
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    Snapshot snapshot = RegisterSnapshot(GetTransactionSnapshot());
+    TableScanDesc scanDescriptor = table_beginscan(directoryRel, snapshot, 0, NULL);
+    TupleDesc tupleDesc = RelationGetDescr(directoryRel);
+    HeapTuple heapTuple;
+    int64_t loadedCount = 0;
+    while ((heapTuple = heap_getnext(scanDescriptor, ForwardScanDirection)) != NULL) {
+        CHECK_FOR_INTERRUPTS();
+
+        Datum datumArray[Natts_falcon_directory_table];
+        bool isNullArray[Natts_falcon_directory_table];
+        heap_deform_tuple(heapTuple, tupleDesc, datumArray, isNullArray);
+        char *name = TextDatumGetCString(datumArray[Anum_falcon_directory_table_name - 1]);
+        DirPathHashKey key;
+        DirPathHashKeyInit(&key, DatumGetInt64(datumArray[Anum_falcon_directory_table_parent_id - 1]), name);
+        uint32 hashcode = dir_path_hash((const void *)&key, sizeof(DirPathHashKey));
+        int partitionIndex = DIR_PATH_HASH_PARTITION_INDEX(hashcode);
+
+        LWLockAcquire(&(DirPathLWLockArray[partitionIndex].lock), LW_EXCLUSIVE);
+        if (version[partitionIndex] == pg_atomic_read_u64(&DirPathPartitionState[partitionIndex].version) &&
+            pg_atomic_read_u32(&DirPathPartitionState[partitionIndex].entryCount) <
+                DIR_PATH_HASH_PARTITION_LRU_CLEAR_BEGIN) {
+            bool found;
+            DirPathHashItem *item = DirPathHashEnter(&key, hashcode, &found);
+            if (!found && item) {
+                RWLockInitialize(&item->lock);
+                item->usageCount = 0;
+                item->inodeId = DatumGetInt64(datumArray[Anum_falcon_directory_table_inode_id - 1]);
+                loadedCount++;
+            }
+        }
+        LWLockRelease(&(DirPathLWLockArray[partitionIndex].lock));
+        pfree(name);
+    }
+    table_endscan(scanDescriptor);
+    UnregisterSnapshot(snapshot);
+    table_close(directoryRel, AccessShareLock);
+
+    elog(LOG, "PreloadDirPathHash: %ld directories loaded.", loadedCount);
+}
+
 size_t DirPathShmemsize()
 {
-    return (sizeof(LWLockPadded) + sizeof(pg_atomic_uint32)) * DIR_PATH_HASH_PARTITION_SIZE +
-           (sizeof(DirPathHashItem)) * MAX_DIRECTORY_PATH_HASH_CAPACITY;
+    return (sizeof(LWLockPadded) + sizeof(DirPathHashPartitionState)) * DIR_PATH_HASH_PARTITION_SIZE +
+           sizeof(DirPathNameChunk) * DIR_PATH_NAME_PARTITION_CHUNK_COUNT * DIR_PATH_HASH_PARTITION_SIZE +
+           hash_estimate_size(DIR_PATH_HASH_PARTITION_CAPACITY, sizeof(DirPathHashItem)) *
+               DIR_PATH_HASH_PARTITION_SIZE;
 }
 
 void DirPathShmemInit()
@@ -684,15 +970,24 @@ void DirPathShmemInit()
     bool initialized;
     DirPathLWLockArray =
         ShmemInitStruct("Cucuoo path directory walk path resolution LWLock",
-                        (sizeof(LWLockPadded) + sizeof(pg_atomic_uint32)) * DIR_PATH_HASH_PARTITION_SIZE,
+                        (sizeof(LWLockPadded) + sizeof(DirPathHashPartitionState)) * DIR_PATH_HASH_PARTITION_SIZE,
                         &initialized);
-    PathDirHashEntryCount = (pg_atomic_uint32 *)(DirPathLWLockArray + DIR_PATH_HASH_PARTITION_SIZE);
+    DirPathPartitionState = (DirPathHashPartitionState *)(DirPathLWLockArray + DIR_PATH_HASH_PARTITION_SIZE);
+    bool arenaInitialized;
+    DirPathNameArena = (DirPathNameChunk *)ShmemInitStruct("Falcon path directory name arena",
+                                                           sizeof(DirPathNameChunk) *
+                                                               DIR_PATH_NAME_PARTITION_CHUNK_COUNT *
+                                                               DIR_PATH_HASH_PARTITION_SIZE,
+                                                           &arenaInitialized);
     if (!initialized) {
         DirPathLWLockTrancheId = LWLockNewTrancheId();
         LWLockRegisterTranche(DirPathLWLockTrancheId, DirPathLWLockTrancheName);
         for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
             LWLockInitialize(&(DirPathLWLockArray[i].lock), DirPathLWLockTrancheId);
-            pg_atomic_init_u32(PathDirHashEntryCount + i, 0);
+            pg_atomic_init_u32(&DirPathPartitionState[i].entryCount, 0);
+            pg_atomic_init_u64(&DirPathPartitionState[i].version, 0);
+            DirPathPartitionState[i].nextItemVersion = 1;
+            DirPathNameArenaReset(i);
         }
     }
     HASHCTL info;
@@ -706,8 +1001,8 @@ void DirPathShmemInit()
     for (int i = 0; i < DIR_PATH_HASH_PARTITION_SIZE; ++i) {
         sprintf(buf, "Falcon path directory hash %d", i);
         PathDirHash[i] = ShmemInitHash(buf,
-                                       MAX_DIRECTORY_PATH_HASH_CAPACITY / DIR_PATH_HASH_PARTITION_SIZE,
-                                       MAX_DIRECTORY_PATH_HASH_CAPACITY / DIR_PATH_HASH_PARTITION_SIZE,
+                                       DIR_PATH_HASH_PARTITION_CAPACITY,
+                                       DIR_PATH_HASH_PARTITION_CAPACITY,
                                        &info,
                                        HASH_ELEM | HASH_FUNCTION | HASH_KEYCOPY | HASH_COMPARE);
         if (!PathDirHash[i]) {
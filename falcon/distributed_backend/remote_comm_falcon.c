@@ -333,6 +333,37 @@ MultipleServerRemoteCommandResult FalconSendCommandAndWaitForResult()
     return multipleServerRemoteCommandResult;
 }
 
+static void FalconRemoteCommandCommitOnePhase(ForeignServerConnection *foreignServerConn)
+{
+    if (ClearPGresultInPGconn(foreignServerConn->conn))
+        FALCON_ELOG_ERROR(PROGRAM_ERROR,
+                          "Has unfetched PGresult when trying to send commit. "
+                          "There must be something wrong.");
+
+    if (!PQsendQueryParams(foreignServerConn->conn, "COMMIT;", 0, NULL, NULL, NULL, NULL, 0))
+        FALCON_ELOG_ERROR_EXTENDED(REMOTE_QUERY_FAILED,
+                                   "error while trying to send commit command 'COMMIT;', workerId: %d, errMsg: %s.",
+                                   foreignServerConn->serverId,
+                                   PQerrorMessage(foreignServerConn->conn));
+    if (!PQpipelineSync(foreignServerConn->conn))
+        FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "error while trying to sync pipeline.");
+
+    PGresult *res = FetchPGresultAndMark(foreignServerConn->conn);
+    // COMMIT of a failed transaction reports success but rolls back
+    if (PQresultStatus(res) != PGRES_COMMAND_OK || strcmp(PQcmdStatus(res), "COMMIT") != 0)
+        FALCON_ELOG_ERROR_EXTENDED(REMOTE_QUERY_FAILED,
+                                   "workerId: %d, errorMsg: %s, cmdStatus: %s.",
+                                   foreignServerConn->serverId,
+                                   PQresultErrorMessage(res),
+                                   PQcmdStatus(res));
+    res = FetchPGresultAndMark(foreignServerConn->conn);
+    if (res != NULL)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "a NULL is expected.");
+    CheckPQpipelineSyncFinished(foreignServerConn->conn);
+
+    foreignServerConn->transactionState = FALCON_REMOTE_TRANSACTION_NONE;
+}
+
 void FalconRemoteCommandPrepare()
 {
     if (RemoteConnectionCommandCache == NULL) // no command sent
@@ -347,16 +378,23 @@ void FalconRemoteCommandPrepare()
     }
     List *connList = GetForeignServerConnection(workerIdList);
 
-    int writeServerCount = LocalServerWrite ? 1 : 0;
+    // the local part only counts as a participant if it has written anything
+    bool localWrite = LocalServerWrite || TransactionIdIsValid(GetTopTransactionIdIfAny());
+    int writeServerCount = localWrite ? 1 : 0;
+    ForeignServerConnection *remoteWriteConn = NULL;
     for (int i = 0; i < list_length(workerIdList); ++i) {
         ForeignServerConnection *foreignServerConn = list_nth(connList, i);
 
-        if (foreignServerConn->transactionState == FALCON_REMOTE_TRANSACTION_BEGIN_FOR_WRITE)
+        if (foreignServerConn->transactionState == FALCON_REMOTE_TRANSACTION_BEGIN_FOR_WRITE) {
             ++writeServerCount;
+            remoteWriteConn = foreignServerConn;
+        }
     }
     bool need2pc = (writeServerCount >= 2);
     if (!need2pc) {
-        // do nothing if don't need 2pc
+        // the only remote writer decides the outcome, so commit it before the local transaction commits
+        if (remoteWriteConn != NULL)
+            FalconRemoteCommandCommitOnePhase(remoteWriteConn);
         return;
     }
 
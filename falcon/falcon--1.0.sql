@@ -195,6 +195,71 @@ CREATE UNIQUE INDEX falcon_directory_table_index ON falcon.falcon_directory_tabl
 ALTER TABLE falcon.falcon_directory_table SET SCHEMA pg_catalog;
 GRANT SELECT ON pg_catalog.falcon_directory_table TO public;
 
+----------------------------------------------------------------
+-- falcon_directory_log
+----------------------------------------------------------------
+CREATE SEQUENCE falcon.falcon_directory_log_lsn_seq
+    MINVALUE 1
+    MAXVALUE 9223372036854775807;
+ALTER SEQUENCE falcon.falcon_directory_log_lsn_seq SET SCHEMA pg_catalog;
+CREATE TABLE falcon.falcon_directory_log(
+    lsn       bigint NOT NULL,
+    parent_id bigint,
+    name      text,
+    inodeid   bigint
+);
+CREATE UNIQUE INDEX falcon_directory_log_index ON falcon.falcon_directory_log using btree(lsn);
+ALTER TABLE falcon.falcon_directory_log SET SCHEMA pg_catalog;
+GRANT SELECT ON pg_catalog.falcon_directory_log TO public;
+
+CREATE FUNCTION pg_catalog.falcon_directory_log_horizon()
+    RETURNS bigint
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_directory_log_horizon$$;
+COMMENT ON FUNCTION pg_catalog.falcon_directory_log_horizon()
+    IS 'falcon directory log horizon';
+
+CREATE FUNCTION pg_catalog.falcon_directory_log_position()
+    RETURNS bigint
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_directory_log_position$$;
+COMMENT ON FUNCTION pg_catalog.falcon_directory_log_position()
+    IS 'falcon directory log position';
+
+CREATE FUNCTION pg_catalog.falcon_directory_log_wait(position bigint)
+    RETURNS INTEGER
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_directory_log_wait$$;
+COMMENT ON FUNCTION pg_catalog.falcon_directory_log_wait(position bigint)
+    IS 'falcon directory log wait';
+
+----------------------------------------------------------------
+-- falcon_data_delete_queue
+----------------------------------------------------------------
+CREATE TABLE falcon.falcon_data_delete_queue(
+    inodeid    bigint NOT NULL,
+    node_id    int,
+    path       text,
+    lease_time bigint
+);
+CREATE UNIQUE INDEX falcon_data_delete_queue_index ON falcon.falcon_data_delete_queue using btree(inodeid);
+ALTER TABLE falcon.falcon_data_delete_queue SET SCHEMA pg_catalog;
+GRANT SELECT ON pg_catalog.falcon_data_delete_queue TO public;
+
+CREATE FUNCTION pg_catalog.falcon_data_delete_queue_take(count int, lease_ms int)
+    RETURNS TABLE(inodeid bigint, node_id int, path text)
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_data_delete_queue_take$$;
+COMMENT ON FUNCTION pg_catalog.falcon_data_delete_queue_take(count int, lease_ms int)
+    IS 'falcon data delete queue take';
+
+CREATE FUNCTION pg_catalog.falcon_data_delete_queue_remove(inodeids bigint[])
+    RETURNS INTEGER
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_data_delete_queue_remove$$;
+COMMENT ON FUNCTION pg_catalog.falcon_data_delete_queue_remove(inodeids bigint[])
+    IS 'falcon data delete queue remove';
+
 ----------------------------------------------------------------
 -- falcon_control
 ----------------------------------------------------------------
@@ -226,6 +291,16 @@ CREATE FUNCTION pg_catalog.falcon_run_pooler_server_func()
 COMMENT ON FUNCTION pg_catalog.falcon_run_pooler_server_func()
     IS 'falcon run pooler server';
 
+CREATE FUNCTION pg_catalog.falcon_connection_pool_shmem_stats(
+    OUT total_size bigint, OUT used_size bigint, OUT free_page_count bigint, OUT largest_free_block bigint,
+    OUT fragmentation float8, OUT alloc_fail_count bigint, OUT alloc_wait_count bigint,
+    OUT multi_page_alloc_count bigint)
+    RETURNS record
+    LANGUAGE C STRICT
+    AS 'MODULE_PATHNAME', $$falcon_connection_pool_shmem_stats$$;
+COMMENT ON FUNCTION pg_catalog.falcon_connection_pool_shmem_stats()
+    IS 'falcon connection pool shmem occupancy and fragmentation';
+
 
 CREATE SEQUENCE falcon.pg_dfs_inodeid_seq
     MINVALUE 1
@@ -17,7 +17,9 @@
 #include "control/control_flag.h"
 #include "control/hook.h"
 #include "dir_path_shmem/dir_path_hash.h"
+#include "metadb/directory_log.h"
 #include "metadb/foreign_server.h"
+#include "metadb/inode_attr_cache.h"
 #include "metadb/metadata.h"
 #include "metadb/shard_table.h"
 #include "transaction/transaction.h"
@@ -31,6 +33,7 @@ PG_MODULE_MAGIC;
 
 void _PG_init(void);
 static void FalconStart2PCCleanupWorker(void);
+static void FalconStartDirectoryLogApplyWorker(void);
 static void FalconStartConnectionPoolWorker(void);
 static void InitializeFalconShmemStruct(void);
 static void RegisterFalconConfigVariables(void);
@@ -51,6 +54,7 @@ void _PG_init(void)
     object_access_hook = falcon_object_access;
 
     FalconStart2PCCleanupWorker();
+    FalconStartDirectoryLogApplyWorker();
     FalconStartConnectionPoolWorker();
 }
 
@@ -95,6 +99,47 @@ static void FalconStart2PCCleanupWorker(void)
                  errhint("More detials may be available in the server log.")));
 }
 
+/*
+ * Start directory log apply process.
+ */
+static void FalconStartDirectoryLogApplyWorker(void)
+{
+    BackgroundWorker worker;
+    BackgroundWorkerHandle *handle;
+    BgwHandleStatus status;
+    pid_t pid;
+
+    MemSet(&worker, 0, sizeof(BackgroundWorker));
+    strcpy(worker.bgw_name, "falcon_directory_log_apply_process");
+    strcpy(worker.bgw_type, "falcon_daemon_directory_log_apply_process");
+    worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+    worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+    worker.bgw_restart_time = 1;
+    strcpy(worker.bgw_library_name, "falcon");
+    strcpy(worker.bgw_function_name, "FalconDaemonDirectoryLogApplyProcessMain");
+
+    if (process_shared_preload_libraries_in_progress) {
+        RegisterBackgroundWorker(&worker);
+        return;
+    }
+
+    /* must set notify PID to wait for startup */
+    worker.bgw_notify_pid = MyProcPid;
+
+    if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+                 errmsg("could not register falcon background process"),
+                 errhint("You may need to increase max_worker_processes.")));
+
+    status = WaitForBackgroundWorkerStartup(handle, &pid);
+    if (status != BGWH_STARTED)
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+                 errmsg("could not start falcon background process"),
+                 errhint("More detials may be available in the server log.")));
+}
+
 /*
  * Start falcon connection pool process.
  */
@@ -151,6 +196,9 @@ static void FalconShmemRequest(void)
     RequestAddinShmemSpace(ShardTableShmemsize());
     RequestAddinShmemSpace(DirPathShmemsize());
     RequestAddinShmemSpace(FalconConnectionPoolShmemsize());
+    RequestAddinShmemSpace(InodeAttrCacheShmemsize());
+    RequestAddinShmemSpace(DirectoryLogShmemsize());
+    RequestAddinShmemSpace(RWLockShmemsize());
 }
 static void FalconShmemInit(void)
 {
@@ -166,6 +214,9 @@ static void FalconShmemInit(void)
     ShardTableShmemInit();
     DirPathShmemInit();
     FalconConnectionPoolShmemInit();
+    InodeAttrCacheShmemInit();
+    DirectoryLogShmemInit();
+    RWLockShmemInit();
 
     LWLockRelease(AddinShmemInitLock);
 }
@@ -207,6 +258,45 @@ static void RegisterFalconConfigVariables(void)
                             NULL,
                             NULL);
 
+    DefineCustomIntVariable("falcon_connection_pool.dispatcher_num",
+                            gettext_noop("Number of dispatcher threads sharing the connections of the pool manager."),
+                            NULL,
+                            &FalconConnectionPoolDispatcherNum,
+                            FALCON_CONNECTION_POOL_DISPATCHER_NUM_DEFAULT,
+                            1,
+                            64,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon_connection_pool.lookup_reserved_conn",
+                            gettext_noop("Connections of the pool manager reserved for stat and open."),
+                            NULL,
+                            &FalconConnectionPoolLookupReservedConn,
+                            FALCON_CONNECTION_POOL_LOOKUP_RESERVED_CONN_DEFAULT,
+                            0,
+                            256,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon_connection_pool.scan_max_conn",
+                            gettext_noop("Max connections of the pool manager used by directory operations at once."),
+                            NULL,
+                            &FalconConnectionPoolScanMaxConn,
+                            FALCON_CONNECTION_POOL_SCAN_MAX_CONN_DEFAULT,
+                            1,
+                            256,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
     int FalconConnectionPoolShmemSizeInMB = FALCON_CONNECTION_POOL_SHMEM_SIZE_DEFAULT / 1024 / 1024;
     DefineCustomIntVariable(gettext_noop("falcon_connection_pool.shmem_size"),
                             "Shmem size of the pool manager, unit: MB.",
@@ -221,4 +311,82 @@ static void RegisterFalconConfigVariables(void)
                             NULL,
                             NULL);
     FalconConnectionPoolShmemSize = (uint64_t)FalconConnectionPoolShmemSizeInMB * 1024 * 1024;
+
+    DefineCustomIntVariable("falcon_connection_pool.batch_max_wait_us",
+                            gettext_noop("Max time a batch may wait for more jobs when no backend is idle, unit: us."),
+                            NULL,
+                            &FalconConnectionPoolBatchMaxWaitUs,
+                            FALCON_CONNECTION_POOL_BATCH_MAX_WAIT_US_DEFAULT,
+                            0,
+                            100000,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.dir_path_hash_capacity",
+                            gettext_noop("Max count of directories cached in shared memory for path resolution."),
+                            NULL,
+                            &FalconDirPathHashCapacity,
+                            FALCON_DIR_PATH_HASH_CAPACITY_DEFAULT,
+                            2048,
+                            64 * 1024 * 1024,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.inode_attr_cache_capacity",
+                            gettext_noop("Max count of inode attributes cached in shared memory, 0 disables the cache."),
+                            NULL,
+                            &FalconInodeAttrCacheCapacity,
+                            FALCON_INODE_ATTR_CACHE_CAPACITY_DEFAULT,
+                            0,
+                            1024 * 1024,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.directory_log_apply_interval_ms",
+                            gettext_noop("Interval between polls of the directory log of the CN on workers, unit: ms."),
+                            NULL,
+                            &FalconDirectoryLogApplyIntervalMs,
+                            FALCON_DIRECTORY_LOG_APPLY_INTERVAL_MS_DEFAULT,
+                            1,
+                            60 * 1000,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.directory_log_wait_timeout_ms",
+                            gettext_noop("Max time a request waits for the directory log to be applied, unit: ms."),
+                            NULL,
+                            &FalconDirectoryLogWaitTimeoutMs,
+                            FALCON_DIRECTORY_LOG_WAIT_TIMEOUT_MS_DEFAULT,
+                            1,
+                            600 * 1000,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomIntVariable("falcon.directory_log_truncate_interval_ms",
+                            gettext_noop("Interval between truncations of the directory log, unit: ms."),
+                            NULL,
+                            &FalconDirectoryLogTruncateIntervalMs,
+                            FALCON_DIRECTORY_LOG_TRUNCATE_INTERVAL_MS_DEFAULT,
+                            1,
+                            3600 * 1000,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
 }
@@ -0,0 +1,64 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_CONNECTION_POOL_ADAPTIVE_BATCH_CONTROLLER_H
+#define FALCON_CONNECTION_POOL_ADAPTIVE_BATCH_CONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/*
+ * Decides how long a batch picked up by the pool manager may keep collecting jobs before it is sent to its
+ * backend.
+ *
+ * The target size of a batch is the number of jobs expected to arrive while one batch executes, estimated from
+ * the observed arrival rate and batch execution time. A batch below target is only held back when it would take
+ * the last idle backend and nothing else is queued, i.e. when sending it now could not run anything else in
+ * parallel anyway. Then it waits at most until the target is expected to be reached, bounded by maxWait. At low
+ * load the target drops to one job and batches are sent immediately.
+ */
+class AdaptiveBatchController {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    AdaptiveBatchController(size_t maxBatchSize,
+                            std::chrono::microseconds maxWait,
+                            Clock::time_point startTime = Clock::now());
+
+    void RecordArrival(size_t jobCount) { arrivedJobs.fetch_add(jobCount, std::memory_order_relaxed); }
+    void RecordExecution(size_t jobCount, std::chrono::microseconds execTime);
+
+    // how long a batch of currentSize jobs should keep collecting, zero to send it immediately
+    std::chrono::microseconds
+    GetBatchWait(size_t currentSize, size_t idleConnections, size_t pendingTasks, size_t &targetSize)
+    {
+        return GetBatchWait(currentSize, idleConnections, pendingTasks, targetSize, Clock::now());
+    }
+    // same as above at a given time, tests use it to control the arrival rate sampling
+    std::chrono::microseconds GetBatchWait(size_t currentSize,
+                                           size_t idleConnections,
+                                           size_t pendingTasks,
+                                           size_t &targetSize,
+                                           Clock::time_point now);
+
+  private:
+    void SampleArrivalRate(Clock::time_point now);
+
+    const size_t maxBatchSize;
+    const std::chrono::microseconds maxWait;
+
+    std::atomic<uint64_t> arrivedJobs{0};
+
+    std::mutex mutex;
+    uint64_t lastSampledJobs = 0;
+    Clock::time_point lastSampleTime;
+    // exponentially weighted averages, jobs per microsecond and microseconds per batch
+    double arrivalRate = 0;
+    double batchExecTime = 0;
+};
+
+#endif
@@ -19,9 +19,24 @@ extern int FalconConnectionPoolPort;
 #define FALCON_CONNECTION_POOL_SIZE_DEFAULT 32
 extern int FalconConnectionPoolSize;
 
+#define FALCON_CONNECTION_POOL_DISPATCHER_NUM_DEFAULT 4
+extern int FalconConnectionPoolDispatcherNum;
+
+// connections only point lookups (stat/open) may use
+#define FALCON_CONNECTION_POOL_LOOKUP_RESERVED_CONN_DEFAULT 4
+extern int FalconConnectionPoolLookupReservedConn;
+
+// connections readdir/opendir/rmdir/rename and plain commands may use at the same time
+#define FALCON_CONNECTION_POOL_SCAN_MAX_CONN_DEFAULT 16
+extern int FalconConnectionPoolScanMaxConn;
+
 #define FALCON_CONNECTION_POOL_SHMEM_SIZE_DEFAULT (256 * 1024 * 1024)
 extern uint64_t FalconConnectionPoolShmemSize;
 
+// upper bound a batch may be held back to collect more jobs, 0 sends batches as soon as a backend is free
+#define FALCON_CONNECTION_POOL_BATCH_MAX_WAIT_US_DEFAULT 200
+extern int FalconConnectionPoolBatchMaxWaitUs;
+
 #define FALCON_CONNECTION_POOL_MAX_CONCURRENT_SOCKET 4096
 
 int FalconConnectionPoolGotSigTerm(void);
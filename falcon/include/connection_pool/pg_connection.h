@@ -14,6 +14,7 @@
 #include <vector>
 #include "connection_pool/pg_connection_pool.h"
 #include "libpq-fe.h"
+#include "remote_connection_utils/error_code_def.h"
 #include "remote_connection_utils/serialized_data.h"
 
 class PGConnectionPool;
@@ -33,6 +34,15 @@ class PGConnection {
     std::condition_variable cvExecing;
     std::thread thread;
 
+    bool SendMetaCall(int32_t type, int32_t count, uint64_t paramShift, int64_t signature);
+    static uint64_t GetMetaCallReplyShift(const PGresult *res);
+    // sync the pipeline and read the results of the queryCount queries sent since the last sync
+    void CollectPipelineResults(size_t queryCount, std::vector<PGresult *> &results);
+    // reply errorCode to every job of taskToExec
+    void ReplyTaskError(FalconErrorCode errorCode);
+    // hand the connection back to the pool and release taskToExec
+    void FinishTask(std::chrono::steady_clock::time_point execStart);
+
   public:
     PGconn *conn;
 
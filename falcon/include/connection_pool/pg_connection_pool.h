@@ -5,34 +5,93 @@
 #ifndef FALCON_CONNECTION_POOL_PG_CONNECTION_POOL_H
 #define FALCON_CONNECTION_POOL_PG_CONNECTION_POOL_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <queue>
 #include <string>
 #include <thread>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
+#include "connection_pool/adaptive_batch_controller.h"
+#include "connection_pool/mpmc_queue.h"
 #include "connection_pool/task.h"
 
 class PGConnection;
 
 class PGConnectionPool {
   private:
-    std::unordered_set<PGConnection *> currentManagedConn;
+    /*
+     * Jobs are spread over several dispatcher threads, each owning a subset of the PG connections and a lock-free
+     * queue of pending tasks. A dispatcher holding an idle connection serves its own queue first and steals from
+     * the others otherwise, so tasks queued at a dispatcher whose connections are all busy are picked up by the
+     * rest.
+     */
+    /*
+     * Tasks are queued by operation class so that cheap point lookups are not stuck behind listings, rmdir or
+     * rename holding the backends. Lookups are always served first, and lookupReservedConn connections are kept
+     * out of reach of the other lanes. Scans are further limited to scanMaxConn connections so that a burst of
+     * long running listings, rmdir or rename cannot take every backend and starve the mutations queued behind it.
+     */
+    enum TaskLane { LOOKUP = 0, MUTATION, SCAN, LANE_NUM };
+    static TaskLane ConvertMetaServiceTypeToTaskLane(const falcon::meta_proto::MetaServiceType type)
+    {
+        switch (type) {
+        case falcon::meta_proto::MetaServiceType::STAT:
+        case falcon::meta_proto::MetaServiceType::OPEN:
+            return TaskLane::LOOKUP;
+        case falcon::meta_proto::MetaServiceType::PLAIN_COMMAND:
+        case falcon::meta_proto::MetaServiceType::READDIR:
+        case falcon::meta_proto::MetaServiceType::OPENDIR:
+        case falcon::meta_proto::MetaServiceType::RMDIR:
+        case falcon::meta_proto::MetaServiceType::RMDIR_RECURSIVE:
+        case falcon::meta_proto::MetaServiceType::RENAME:
+            return TaskLane::SCAN;
+        default:
+            return TaskLane::MUTATION;
+        }
+    }
 
-    bool working;
+    class Dispatcher {
+      public:
+        explicit Dispatcher(size_t pendingTaskBufferMaxSize)
+        {
+            for (int i = 0; i < TaskLane::LANE_NUM; ++i)
+                pendingTask[i] = std::make_unique<MpmcQueue<Task *>>(pendingTaskBufferMaxSize);
+        }
+        std::unique_ptr<MpmcQueue<Task *>> pendingTask[TaskLane::LANE_NUM];
+
+        std::queue<PGConnection *> connPool;
+        std::mutex connPoolMutex;
+        std::condition_variable cvPoolNotEmpty;
+        std::atomic<size_t> idleConnCount{0};
+
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Dispatcher>> dispatchers;
+    // fixed after construction, tells ReaddWorkingPGConnection where a connection belongs
+    std::unordered_map<PGConnection *, Dispatcher *> currentManagedConn;
+    std::atomic<size_t> nextDispatcher{0};
 
-    std::queue<PGConnection *> connPool;
-    std::mutex connPoolMutex;
-    std::condition_variable cvPoolNotEmpty;
+    std::atomic<bool> working;
 
-    std::queue<Task *> pendingTask;
-    std::mutex pendingTaskMutex;
+    int nonLookupMaxConn;
+    int scanMaxConn;
+    std::atomic<int> nonLookupRunningCount{0};
+    std::atomic<int> scanRunningCount{0};
+
+    // dispatchers holding an idle connection sleep here while no queued task can be admitted
+    std::mutex idleDispatcherMutex;
     std::condition_variable cvPendingTaskNotEmpty;
+    std::atomic<int> idleDispatcherCount{0};
+
+    // producers sleep here while every queue is full
+    std::mutex blockedProducerMutex;
     std::condition_variable cvPendingTaskNotFull;
-    uint16_t pendingTaskBufferMaxSize;
+    std::atomic<int> blockedProducerCount{0};
 
-    enum TaskSupportBatchType { MKDIR = 0, CREATE, STAT, UNLINK, OPEN, CLOSE, NOT_SUPPORT };
+    enum TaskSupportBatchType { MKDIR = 0, CREATE, STAT, UNLINK, OPEN, CLOSE, MKDIR_RECURSIVE, NOT_SUPPORT };
     TaskSupportBatchType ConvertMetaServiceTypeToTaskSupportBatchType(const falcon::meta_proto::MetaServiceType type)
     {
         switch (type) {
@@ -48,6 +107,8 @@ class PGConnectionPool {
             return TaskSupportBatchType::OPEN;
         case falcon::meta_proto::MetaServiceType::CLOSE:
             return TaskSupportBatchType::CLOSE;
+        case falcon::meta_proto::MetaServiceType::MKDIR_RECURSIVE:
+            return TaskSupportBatchType::MKDIR_RECURSIVE;
         default:
             return TaskSupportBatchType::NOT_SUPPORT;
         }
@@ -57,24 +118,40 @@ class PGConnectionPool {
         Task *task;
         std::mutex taskMutex;
         std::condition_variable cvBatchNotFull;
+        // signaled whenever a job is appended, the dispatcher sealing the batch may be waiting for it to grow
+        std::condition_variable cvBatchGrown;
+        std::unique_ptr<AdaptiveBatchController> controller;
     };
     TaskSupportBatch supportBatchTaskList[TaskSupportBatchType::NOT_SUPPORT];
     uint16_t batchTaskBufferMaxSize;
 
-    std::thread backgroundPoolManager;
-
-    PGConnection *GetPGConnection();
-    void BackgroundPoolManager();
+    PGConnection *GetPGConnection(Dispatcher &dispatcher);
+    bool TryPushPendingTask(Task *task);
+    void PushPendingTask(Task *task);
+    bool AdmitLane(TaskLane lane);
+    void ReleaseLane(TaskLane lane);
+    size_t PendingTaskCount(TaskLane lane);
+    void NotifyIdleDispatcher();
+    Task *TryPopPendingTask(size_t dispatcherIndex);
+    Task *PopPendingTask(size_t dispatcherIndex);
+    void BackgroundDispatcher(size_t dispatcherIndex);
+    void SealBatchTask(int batchType);
 
   public:
     PGConnectionPool(const uint16_t port,
                      const char *userName,
                      const int connPoolSize,
+                     const int dispatcherNum,
+                     const int lookupReservedConn,
+                     const int scanMaxConn,
                      const uint16_t pendingTaskBufferMaxSize,
-                     const uint16_t batchTaskBufferMaxSize);
+                     const uint16_t batchTaskBufferMaxSize,
+                     const std::chrono::microseconds maxBatchWait);
     ~PGConnectionPool();
 
     void ReaddWorkingPGConnection(PGConnection *conn);
+    // must be called once for every executed task before its connection is readded
+    void ReportTaskExecution(Task *task, std::chrono::microseconds execTime);
 
     void DispatchAsyncMetaServiceJob(falcon::meta_proto::AsyncMetaServiceJob *job);
 
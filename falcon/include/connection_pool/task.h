@@ -41,13 +41,24 @@ class AsyncMetaServiceJob {
 class Task {
   public:
     bool isBatch;
+    // index of the batch slot in PGConnectionPool this task was collected in, -1 if not a batch
+    int batchType;
+    // scheduling lane in PGConnectionPool, decided by the heaviest operation of the task
+    int lane;
     std::vector<falcon::meta_proto::AsyncMetaServiceJob *> jobList;
     Task(int n)
     {
         isBatch = false;
+        batchType = -1;
+        lane = 0;
         jobList.reserve(n);
     }
-    Task() { isBatch = false; }
+    Task()
+    {
+        isBatch = false;
+        batchType = -1;
+        lane = 0;
+    }
 };
 
 #endif
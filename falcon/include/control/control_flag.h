@@ -12,6 +12,11 @@ void FalconControlShmemInit(void);
 
 bool CheckFalconBackgroundServiceStarted(void);
 
+uint64_t GetFalconNamespaceGeneration(void);
+void FalconNamespaceGenerationMarkDirty(void);
+void FalconNamespaceGenerationAdvanceIfDirty(void);
+void FalconNamespaceGenerationResetDirty(void);
+
 bool FalconIsInAbortProgress(void);
 void FalconEnterAbortProgress(void);
 void FalconQuitAbortProgress(void);
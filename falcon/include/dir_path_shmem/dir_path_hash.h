@@ -18,16 +18,24 @@
 #include "utils/rwlock.h"
 
 #define MAX_DIRECTORY_PATH_HASH_SIZE 256
-#define MAX_DIRECTORY_HASH_TO_COMMIT_ACTION_LENGTH 4096
+#define DIRECTORY_HASH_TO_COMMIT_INITIAL_ACTION_LENGTH 64
 
 #define DIR_HASH_TABLE_PATH_NOT_EXIST -1
 #define DIR_HASH_TABLE_PATH_UNKNOWN -2
 
-/* A hash key for directory path */
+#define DIR_PATH_HASH_INLINE_NAME_SIZE 24
+
+/*
+ * A hash key for directory path. The stored name is interned: its head lives in inlineName and the rest, if any,
+ * in chunks of the name arena of the partition. Keys built for searching only point to the name by fileName.
+ */
 typedef struct
 {
-    char fileName[MAX_DIRECTORY_PATH_HASH_SIZE];
     uint64_t parentId;
+    uint32_t nameLength;
+    uint32_t nameChunk;
+    char inlineName[DIR_PATH_HASH_INLINE_NAME_SIZE];
+    const char *fileName;
 } DirPathHashKey;
 
 /* A hash table entry */
@@ -37,8 +45,20 @@ typedef struct
     uint64_t inodeId;
     RWLock lock;
     int32_t usageCount;
+    int32_t partitionIndex;
+    // changes whenever the entry is updated at commit or removed, never repeats within the partition
+    uint64_t version;
 } DirPathHashItem;
 
+/* Refers to an entry without looking it up again, as long as the entry doesn't change */
+typedef struct
+{
+    DirPathHashItem *item;
+    uint64_t version;
+    uint64_t inodeId;
+    int32_t partitionIndex;
+} DirPathHashRef;
+
 typedef enum { DIR_LOCK_EXCLUSIVE, DIR_LOCK_SHARED, DIR_LOCK_NONE } DirPathLockMode;
 
 extern void AbortForDirPathHash(void);
@@ -46,6 +66,7 @@ extern void CommitForDirPathHash(void);
 extern void ClearDirPathHash(void);
 extern size_t DirPathShmemsize(void);
 extern void DirPathShmemInit(void);
+extern void PreloadDirPathHash(void);
 
 // LastAcquiredLock points to the last lock acquired by following functions
 extern RWLock *DirectoryHashTableLastAcquiredLock;
@@ -60,9 +81,12 @@ extern void InsertDirectoryByDirectoryHashTable(Relation relation,
                                                 DirPathLockMode lockMode);
 extern void
 DeleteDirectoryByDirectoryHashTable(Relation relation, uint64_t parentId, const char *name, DirPathLockMode lockMode);
+// ref of the entry whose lock has been acquired last
+extern void DirPathHashGetLastAcquiredRef(DirPathHashRef *ref);
+// returns false without acquiring anything if the entry has changed
+extern bool AcquireDirectoryByDirPathHashRef(const DirPathHashRef *ref, DirPathLockMode lockMode);
 
-#define DIRECTORY_PATH_HASH_BUCKET_NUM 2048
-#define MAX_DIRECTORY_PATH_HASH_CAPACITY 2048
-#define MAX_BUCKET_SUM_LRU_CLAER_BEGIN (MAX_DIRECTORY_PATH_HASH_CAPACITY / 4 * 3)
+#define FALCON_DIR_PATH_HASH_CAPACITY_DEFAULT (1024 * 1024)
+extern int FalconDirPathHashCapacity;
 
 #endif
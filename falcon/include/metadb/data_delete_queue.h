@@ -0,0 +1,54 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/*
+ * data_delete_queue.h
+ *      definition of the "falcon_data_delete_queue" relation
+ */
+
+#ifndef FALCON_DATA_DELETE_QUEUE_H
+#define FALCON_DATA_DELETE_QUEUE_H
+
+#include "postgres.h"
+
+#include <stdint.h>
+
+#include "catalog/indexing.h"
+#include "utils/relcache.h"
+
+/*
+ * Files whose inode rows were removed on the server, but whose data still has to be deleted from the store.
+ * Operations removing many files at once, i.e. recursive rmdir, queue them in the transaction removing the rows
+ * instead of replying them. Clients take entries with falcon_data_delete_queue_take(), which leases them for a
+ * while, delete the data and remove the entries with falcon_data_delete_queue_remove(). Entries of a client
+ * failing in between are handed out again once their lease expired.
+ */
+
+typedef struct FormData_falcon_data_delete_queue
+{
+    int64_t inodeId;
+    int32_t nodeId;
+    text path;
+    // time the entry was last handed out, 0 if never
+    int64_t leaseTime;
+} FormData_falcon_data_delete_queue;
+
+typedef FormData_falcon_data_delete_queue *Form_falcon_data_delete_queue;
+
+#define Natts_falcon_data_delete_queue 4
+#define Anum_falcon_data_delete_queue_inode_id 1
+#define Anum_falcon_data_delete_queue_node_id 2
+#define Anum_falcon_data_delete_queue_path 3
+#define Anum_falcon_data_delete_queue_lease_time 4
+
+Oid DataDeleteQueueRelationId(void);
+Oid DataDeleteQueueRelationIndexId(void);
+
+void DataDeleteQueueInsert(Relation queueRel,
+                           CatalogIndexState indexState,
+                           uint64_t inodeId,
+                           int32_t nodeId,
+                           const char *path);
+
+#endif
@@ -0,0 +1,82 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/*
+ * directory_log.h
+ *      definition of the "falcon_directory_log" relation
+ */
+
+#ifndef FALCON_DIRECTORY_LOG_H
+#define FALCON_DIRECTORY_LOG_H
+
+#include "postgres.h"
+
+#include <stdint.h>
+
+#include "nodes/pg_list.h"
+#include "utils/relcache.h"
+
+/*
+ * Directories created by the CN are appended to its falcon_directory_log in the same local transaction, instead of
+ * being inserted into the directory table of every server synchronously. An applier process on each worker pulls
+ * the log below the CN's horizon, the position below which no transaction appending to it is still in progress,
+ * and applies it in order, keeping what it has applied in its own copy of the log.
+ *
+ * Replies carry the log position of the replying server and clients send the highest one they have seen along with
+ * their requests, so a worker only waits for its applier when it is behind what the request may depend on. The CN
+ * makes every worker catch up before the operations it still replicates synchronously, i.e. rmdir and renames of
+ * directories. A worker which still misses a directory catches up with the CN's horizon once before giving up.
+ *
+ * The CN periodically truncates its log below the lowest position applied on all workers. Workers behind the
+ * truncation, e.g. ones added later, start from a copy of the CN's directory table and its horizon instead.
+ */
+
+#define FALCON_DIRECTORY_LOG_APPLY_INTERVAL_MS_DEFAULT 20
+#define FALCON_DIRECTORY_LOG_WAIT_TIMEOUT_MS_DEFAULT 10000
+#define FALCON_DIRECTORY_LOG_TRUNCATE_INTERVAL_MS_DEFAULT 10000
+#define DIRECTORY_LOG_APPLY_BATCH_SIZE 1024
+
+extern int FalconDirectoryLogApplyIntervalMs;
+extern int FalconDirectoryLogWaitTimeoutMs;
+extern int FalconDirectoryLogTruncateIntervalMs;
+
+typedef struct FormData_falcon_directory_log
+{
+    int64_t lsn;
+    int64_t parentId;
+    text name;
+    int64_t inodeId;
+} FormData_falcon_directory_log;
+
+typedef FormData_falcon_directory_log *Form_falcon_directory_log;
+
+#define Natts_falcon_directory_log 4
+#define Anum_falcon_directory_log_lsn 1
+#define Anum_falcon_directory_log_parent_id 2
+#define Anum_falcon_directory_log_name 3
+#define Anum_falcon_directory_log_inode_id 4
+
+Oid DirectoryLogRelationId(void);
+Oid DirectoryLogRelationIndexId(void);
+
+size_t DirectoryLogShmemsize(void);
+void DirectoryLogShmemInit(void);
+
+// CN only, the entry becomes visible to workers once the transaction ends
+void DirectoryLogAppend(uint64_t parentId, const char *name, uint64_t inodeId);
+uint64_t DirectoryLogHorizon(void);
+void DirectoryLogAtPrePrepare(void);
+void DirectoryLogAtTransactionEnd(void);
+// CN only, makes the workers apply everything appended so far before operations which are replicated synchronously
+void DirectoryLogWaitForAppliedOnWorkerList(List *workerIdList);
+
+// position reported to clients, the last one assigned on the CN and the last one applied on workers
+uint64_t DirectoryLogPosition(void);
+void DirectoryLogWaitForApplied(uint64_t position);
+// workers only, returns whether a directory found missing may have been applied meanwhile
+bool DirectoryLogCatchUpWithCN(void);
+
+extern void FalconDaemonDirectoryLogApplyProcessMain(Datum main_arg);
+
+#endif
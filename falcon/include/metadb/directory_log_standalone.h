@@ -0,0 +1,21 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_DIRECTORY_LOG_STANDALONE_H
+#define FALCON_DIRECTORY_LOG_STANDALONE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// callable outside of backends, e.g. by threads of the connection pool
+
+/*
+ * Whether the directory log has been applied up to position. If it hasn't, the applier is woken to catch up to it,
+ * and callers poll DirectoryLogAppliedLockFree() for at most DirectoryLogWaitTimeoutMs() in a way which suits them.
+ */
+bool DirectoryLogRequestLockFree(uint64_t position);
+bool DirectoryLogAppliedLockFree(uint64_t position);
+int DirectoryLogWaitTimeoutMs(void);
+
+#endif
@@ -13,6 +13,7 @@
 #include "postgres.h"
 
 #include "catalog/indexing.h"
+#include "nodes/pg_list.h"
 #include "utils/relcache.h"
 
 #include "metadb/metadata.h"
@@ -37,6 +38,15 @@ typedef enum FalconDirectoryTableScankeyType {
     LAST_FALCON_DIRECTORY_TABLE_SCANKEY_TYPE
 } FalconDirectoryTableScankeyType;
 
+typedef struct DirectorySubtreeNode
+{
+    uint64_t parentId;
+    char *name;
+    uint64_t inodeId;
+    // relative to the root of the subtree, i.e. "/a/b", "" for the root itself
+    char *path;
+} DirectorySubtreeNode;
+
 extern const char *DirectoryTableName;
 Oid DirectoryRelationId(void);
 Oid DirectoryRelationIndexId(void);
@@ -47,5 +57,6 @@ void InsertIntoDirectoryTable(Relation directoryRel,
                               const char *name,
                               uint64_t inodeId);
 void DeleteFromDirectoryTable(Relation directoryRel, uint64_t parentId, const char *name);
+List *SearchDirectorySubtree(Relation directoryRel, uint64_t parentId, const char *name, uint64_t inodeId);
 
 #endif
@@ -0,0 +1,71 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_INODE_ATTR_CACHE_H
+#define FALCON_INODE_ATTR_CACHE_H
+
+#include "postgres.h"
+
+#include <stdint.h>
+
+#include "metadb/inode_table.h"
+
+/*
+ * Shared memory cache of inode attributes keyed by (parentid_partid, name), which lets STAT and read only OPEN
+ * of hot files skip the inode shard tables.
+ *
+ * Handlers which modify an inode row invalidate its key right away and again when their transaction ends, and
+ * every invalidation advances the version of the key's partition. A lookup which missed takes a ticket before
+ * it reads the table, and its result is only cached if no version it depends on has moved since. Transactions
+ * which modified inodes bypass the cache, so uncommitted rows are never cached or shadowed by cached ones.
+ */
+
+#define FALCON_INODE_ATTR_CACHE_CAPACITY_DEFAULT 16384
+#define INODE_ATTR_CACHE_PARTITION_NUM 64
+
+extern int FalconInodeAttrCacheCapacity;
+
+typedef struct InodeAttr
+{
+    uint64_t st_ino;
+    uint64_t st_dev;
+    uint32_t st_mode;
+    uint64_t st_nlink;
+    uint32_t st_uid;
+    uint32_t st_gid;
+    uint64_t st_rdev;
+    int64_t st_size;
+    int64_t st_blksize;
+    int64_t st_blocks;
+    int64_t st_atim;
+    int64_t st_mtim;
+    int64_t st_ctim;
+    int32_t primaryNodeId;
+    char etag[128];
+} InodeAttr;
+
+typedef struct InodeAttrCacheTicket
+{
+    uint64_t epoch;
+    uint64_t version[INODE_ATTR_CACHE_PARTITION_NUM];
+} InodeAttrCacheTicket;
+
+size_t InodeAttrCacheShmemsize(void);
+void InodeAttrCacheShmemInit(void);
+
+bool InodeAttrCacheEnabled(void);
+// must be taken before the snapshot used to read the rows which are going to be filled
+void InodeAttrCacheTakeTicket(InodeAttrCacheTicket *ticket);
+bool InodeAttrCacheLookup(uint64_t parentId_partId, const char *name, InodeAttr *attr);
+void InodeAttrCacheFill(const InodeAttrCacheTicket *ticket,
+                        uint64_t parentId_partId,
+                        const char *name,
+                        const InodeAttr *attr);
+void InodeAttrCacheInvalidate(uint64_t parentId_partId, const char *name);
+void InodeAttrCacheInvalidateAll(void);
+// the transaction commits a prepared one whose modifications are unknown
+void InodeAttrCacheInvalidateAllAtCommit(void);
+void InodeAttrCacheAtTransactionEnd(void);
+
+#endif
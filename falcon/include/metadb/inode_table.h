@@ -66,6 +66,18 @@ typedef FormData_dfs_inode_table *Form_dfs_inode_table;
 #define Anum_pg_dfs_file_primary_nodeid 18
 #define Anum_pg_dfs_file_backup_nodeid 19
 
+/*
+ * Inode shard index, (parentid_partid, name) INCLUDE (st_mode). Names use the "C" collation, so keys compare
+ * bytewise, shards created before keep the database default, see InodeShardIndexNameCollation(). Only columns
+ * which are rarely updated are covered, so that CLOSE, which rewrites size and mtime, never touches the index and
+ * its updates stay HOT in the space left free by INODE_TABLE_FILLFACTOR.
+ */
+#define Anum_pg_dfs_file_index_parentid_partid 1
+#define Anum_pg_dfs_file_index_name 2
+#define Anum_pg_dfs_file_index_st_mode 3
+
+#define INODE_TABLE_FILLFACTOR 80
+
 // #define DFS_INODEID_SEQUENCE_NAME "pg_dfs_inodeid_seq"
 
 typedef enum FalconInodeTableScankeyType {
@@ -89,4 +101,10 @@ typedef enum StreamSearchState { SAME_ID_GREATER_NAME = 0, GREATER_ID, NEW_SHARD
 extern const char *InodeTableName;
 void ConstructCreateInodeTableCommand(StringInfo command, const char *name);
 
+// cached per backend and dropped by relcache invalidation, so hot paths skip the catalog lookup by name
+Oid InodeShardRelationId(int shardId);
+Oid InodeShardIndexRelationId(int shardId);
+// name scan keys have to use it, the inode name scan caches carry the database default
+Oid InodeShardIndexNameCollation(int shardId);
+
 #endif
@@ -34,11 +34,15 @@ typedef enum FalconSupportMetaService {
     UTIMENS,
     CHOWN,
     CHMOD,
+    MKDIR_RECURSIVE,
+    RMDIR_RECURSIVE,
+    RMDIR_RECURSIVE_SUB_RMDIR,
     NOT_SUPPORTED
 } FalconSupportMetaService;
 
 // func whose name ends with internal is not supposed to be called by external user
 void FalconMkdirHandle(MetaProcessInfo *infoArray, int count);
+void FalconMkdirRecursiveHandle(MetaProcessInfo *infoArray, int count);
 void FalconMkdirSubMkdirHandle(MetaProcessInfo *infoArray, int count);
 void FalconMkdirSubCreateHandle(MetaProcessInfo *infoArray, int count);
 void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExisted);
@@ -51,6 +55,8 @@ void FalconOpenDirHandle(MetaProcessInfo info);
 void FalconRmdirHandle(MetaProcessInfo info);
 void FalconRmdirSubRmdirHandle(MetaProcessInfo info);
 void FalconRmdirSubUnlinkHandle(MetaProcessInfo info);
+void FalconRmdirRecursiveHandle(MetaProcessInfo info);
+void FalconRmdirRecursiveSubRmdirHandle(MetaProcessInfo info);
 void FalconRenameHandle(MetaProcessInfo info);
 void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info);
 void FalconRenameSubCreateHandle(MetaProcessInfo info);
@@ -13,6 +13,17 @@ typedef struct OneReadDirResult
 {
     const char *fileName;
     uint32_t mode;
+    // only filled for readdirplus
+    uint64_t st_ino;
+    uint64_t st_nlink;
+    uint32_t st_uid;
+    uint32_t st_gid;
+    int64_t st_size;
+    int64_t st_blksize;
+    int64_t st_blocks;
+    int64_t st_atim;
+    int64_t st_mtim;
+    int64_t st_ctim;
 } OneReadDirResult;
 typedef struct MetaProcessInfoData
 {
@@ -44,6 +55,7 @@ typedef struct MetaProcessInfoData
     // input(or output) for readdir
     int32_t readDirLastShardIndex;
     const char *readDirLastFileName;
+    bool readDirPlus;
     OneReadDirResult **readDirResultList;
     int readDirResultCount;
 
@@ -35,6 +35,8 @@ bool SerializedDataMetaResponseDecode(FalconSupportMetaService metaService,
 bool SerializedDataMetaResponseEncodeWithPerProcessFlatBufferBuilder(FalconSupportMetaService metaService,
                                                                      int count,
                                                                      MetaProcessInfoData *infoArray,
+                                                                     uint64_t generation,
+                                                                     uint64_t directoryLogPosition,
                                                                      SerializedData *response);
 
 #ifdef __cplusplus
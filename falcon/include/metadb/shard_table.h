@@ -31,6 +31,8 @@ Oid ShardRelationIndexId(void);
 
 void SearchShardInfoByShardValue(uint64_t shardColValue, int32_t *rangePoint, int32_t *serverId);
 List *GetShardTableData(void);
+// backend local copy of the shard table, valid until the next shard table lookup of the backend
+const FormData_falcon_shard_table *GetShardTableArray(int32_t *count);
 int32_t GetShardTableSize(void);
 
 size_t ShardTableShmemsize(void);
@@ -0,0 +1,20 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_SHARD_TABLE_STANDALONE_H
+#define FALCON_SHARD_TABLE_STANDALONE_H
+
+#include <stdint.h>
+
+// callable outside of backends, e.g. by threads of the connection pool
+
+// epoch of the shard table in shared memory, SHARD_TABLE_EPOCH_UNKNOWN if it is not loaded
+uint64_t GetShardTableEpoch(void);
+/*
+ * Copy the shard table in shared memory if it has at most capacity rows. Returns the row count, or -1 if the
+ * table is not loaded or kept being reloaded while it was read.
+ */
+int32_t ShardTableCopyLockFree(int32_t *rangePoints, int32_t *serverIds, int32_t capacity, uint64_t *epoch);
+
+#endif
@@ -23,6 +23,7 @@ extern "C" {
 // 2^6 = 64 -> 7 kind of size
 #define FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT 7
 
+// largest allocation served from the blocks of a single page, larger ones take several whole contiguous pages
 #define FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE (1024 * 1024)
 #define FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE \
     (FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE / FALCON_SHMEM_ALLOCATOR_STATE_BIT_COUNT)
@@ -36,6 +37,17 @@ typedef union PaddedAtomic64
     char padding[FALCON_SHMEM_ALLOCATOR_PAD_SIZE];
 } PaddedAtomic64;
 
+typedef enum FalconShmemAllocatorCounterType {
+    FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_FAIL = 0,
+    FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_WAIT,
+    FALCON_SHMEM_ALLOCATOR_COUNTER_MULTI_PAGE_ALLOC,
+    FALCON_SHMEM_ALLOCATOR_COUNTER_COUNT
+} FalconShmemAllocatorCounterType;
+
+// signature counter, free list hints and counters in front of the page control array
+#define FALCON_SHMEM_ALLOCATOR_HEADER_COUNT \
+    (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT + FALCON_SHMEM_ALLOCATOR_COUNTER_COUNT)
+
 typedef struct FalconShmemAllocator
 {
     char *shmem;
@@ -45,10 +57,23 @@ typedef struct FalconShmemAllocator
     // located in shmem
     PaddedAtomic64 *signatureCounter;
     PaddedAtomic64 *freeListHint;
+    PaddedAtomic64 *counter;
     PaddedAtomic64 *pageCntlArray;
     char *allocatableSpaceBase;
 } FalconShmemAllocator;
 
+typedef struct FalconShmemAllocatorStats
+{
+    uint64_t totalSize;
+    // capacity of allocated blocks, including headers and rounding
+    uint64_t usedSize;
+    // pages without any allocated block, only they can serve allocations of a whole page or more
+    uint32_t freePageCount;
+    // largest allocation which could be served right now
+    uint64_t largestFreeBlock;
+    uint64_t counter[FALCON_SHMEM_ALLOCATOR_COUNTER_COUNT];
+} FalconShmemAllocatorStats;
+
 #define FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift) ((allocator)->allocatableSpaceBase + (shift))
 #define FALCON_SHMEM_ALLOCATOR_POINTER_GET_SIZE(pointer) (((MemoryHdr *)((char *)(pointer) - sizeof(MemoryHdr)))->size)
 #define FALCON_SHMEM_ALLOCATOR_SET_SIGNATURE(pointer, sign) \
@@ -66,10 +91,19 @@ typedef struct MemoryHdr
     uint64_t size;
     uint64_t capacity;
 } MemoryHdr;
+// returns 0 if no space is free now, callers may wait for frees if FalconShmemAllocatorCanFit
 uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t size);
 
 void FalconShmemAllocatorFree(FalconShmemAllocator *allocator, uint64_t shift);
 
+// whether size could ever be allocated, i.e. waiting for frees makes sense
+bool FalconShmemAllocatorCanFit(FalconShmemAllocator *allocator, uint64_t size);
+
+void FalconShmemAllocatorCount(FalconShmemAllocator *allocator, FalconShmemAllocatorCounterType type);
+
+// a racy snapshot, good enough for monitoring
+void FalconShmemAllocatorGetStats(FalconShmemAllocator *allocator, FalconShmemAllocatorStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -10,6 +10,7 @@
 #include "lib/rbtree.h"
 #include "utils/relcache.h"
 
+#include "dir_path_shmem/dir_path_hash.h"
 #include "utils/error_log.h"
 
 #define PATH_PARSE_FLAG_NOT_ROOT 1
@@ -32,6 +33,8 @@ typedef struct PathParseRBTreeNode
     uint64_t inodeId;
     PPLockMode lockAcquired;
     RBTree *children;
+    // entry of the directory path hash whose lock has been acquired, if any
+    DirPathHashRef ref;
 } PathParseRBTreeNode;
 
 typedef PathParseRBTreeNode *PathParseTree;
@@ -9,9 +9,18 @@
 
 #include "port/atomics.h"
 
+/*
+ * Shared holders of a lock may bypass its state while the lock is reader biased: they publish themselves in a
+ * slot of a shared table of visible readers instead, which is only written by the backend the slot was hashed
+ * to. A lock turns reader biased once a shared holder finds it unbiased and no longer inhibited. Exclusive
+ * holders revoke the bias and wait until the table no longer shows the lock, after which the bias is inhibited
+ * for a multiple of the time the revocation took.
+ */
 typedef struct RWLock
 {
     pg_atomic_uint64 state;
+    pg_atomic_uint32 readerBias;
+    pg_atomic_uint64 biasInhibitUntil;
 } RWLock;
 
 typedef enum RWLockMode {
@@ -21,11 +30,16 @@ typedef enum RWLockMode {
     RW_DECLARE,
 } RWLockMode;
 
+size_t RWLockShmemsize(void);
+void RWLockShmemInit(void);
+
 extern void RWLockInitialize(RWLock *lock);
 void RWLockDeclare(RWLock *lock);
 void RWLockUndeclare(RWLock *lock);
 bool RWLockCheckDestroyable(RWLock *lock);
 void RWLockAcquire(RWLock *lock, RWLockMode mode);
+// acquire in shared mode if the lock is reader biased, never waits and needs no prior RWLockDeclare
+bool RWLockAcquireBiased(RWLock *lock);
 void RWLockRelease(RWLock *lock);
 void RWLockReleaseAll(bool keepInterruptHoldoffCount);
 
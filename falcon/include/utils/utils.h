@@ -48,6 +48,10 @@ typedef enum CachedRelationType {
     CACHED_RELATION_DIRECTORY_TABLE_INDEX,
     CACHED_RELATION_DISTRIBUTED_TRANSACTION_TABLE,
     CACHED_RELATION_DISTRIBUTED_TRANSACTION_TABLE_INDEX,
+    CACHED_RELATION_DIRECTORY_LOG_TABLE,
+    CACHED_RELATION_DIRECTORY_LOG_TABLE_INDEX,
+    CACHED_RELATION_DATA_DELETE_QUEUE_TABLE,
+    CACHED_RELATION_DATA_DELETE_QUEUE_TABLE_INDEX,
     LAST_CACHED_RELATION_TYPE
 } CachedRelationType;
 extern Oid CachedRelationOid[LAST_CACHED_RELATION_TYPE];
@@ -0,0 +1,177 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "metadb/data_delete_queue.h"
+
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "access/table.h"
+#include "access/xact.h"
+#include "catalog/indexing.h"
+#include "funcapi.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/timestamp.h"
+
+#include "utils/error_log.h"
+#include "utils/utils.h"
+
+typedef struct DataDeleteQueueEntry
+{
+    int64_t inodeId;
+    int32_t nodeId;
+    char *path;
+} DataDeleteQueueEntry;
+
+PG_FUNCTION_INFO_V1(falcon_data_delete_queue_take);
+PG_FUNCTION_INFO_V1(falcon_data_delete_queue_remove);
+
+Oid DataDeleteQueueRelationId(void)
+{
+    GetRelationOid("falcon_data_delete_queue", &CachedRelationOid[CACHED_RELATION_DATA_DELETE_QUEUE_TABLE]);
+    return CachedRelationOid[CACHED_RELATION_DATA_DELETE_QUEUE_TABLE];
+}
+
+Oid DataDeleteQueueRelationIndexId(void)
+{
+    GetRelationOid("falcon_data_delete_queue_index",
+                   &CachedRelationOid[CACHED_RELATION_DATA_DELETE_QUEUE_TABLE_INDEX]);
+    return CachedRelationOid[CACHED_RELATION_DATA_DELETE_QUEUE_TABLE_INDEX];
+}
+
+void DataDeleteQueueInsert(Relation queueRel,
+                           CatalogIndexState indexState,
+                           uint64_t inodeId,
+                           int32_t nodeId,
+                           const char *path)
+{
+    Datum values[Natts_falcon_data_delete_queue];
+    bool isNulls[Natts_falcon_data_delete_queue];
+    memset(isNulls, false, sizeof(isNulls));
+    values[Anum_falcon_data_delete_queue_inode_id - 1] = Int64GetDatum(inodeId);
+    values[Anum_falcon_data_delete_queue_node_id - 1] = Int32GetDatum(nodeId);
+    values[Anum_falcon_data_delete_queue_path - 1] = CStringGetTextDatum(path);
+    values[Anum_falcon_data_delete_queue_lease_time - 1] = Int64GetDatum(0);
+
+    HeapTuple heapTuple = heap_form_tuple(RelationGetDescr(queueRel), values, isNulls);
+    CatalogTupleInsertWithInfo(queueRel, heapTuple, indexState);
+    heap_freetuple(heapTuple);
+}
+
+/*
+ * Hands out at most count entries not leased within the last leaseMs milliseconds and leases them. Takers are
+ * serialized by the self conflicting lock, which still lets inserts go on, so an entry is never handed out to two
+ * clients at once.
+ */
+Datum falcon_data_delete_queue_take(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *functionContext = NULL;
+    TupleDesc tupleDescriptor;
+
+    if (SRF_IS_FIRSTCALL()) {
+        int32_t count = PG_GETARG_INT32(0);
+        int32_t leaseMs = PG_GETARG_INT32(1);
+        if (count <= 0 || leaseMs < 0)
+            FALCON_ELOG_ERROR(ARGUMENT_ERROR, "count must be positive and lease_ms must not be negative.");
+
+        functionContext = SRF_FIRSTCALL_INIT();
+        MemoryContext oldContext = MemoryContextSwitchTo(functionContext->multi_call_memory_ctx);
+        if (get_call_result_type(fcinfo, NULL, &tupleDescriptor) != TYPEFUNC_COMPOSITE) {
+            FALCON_ELOG_ERROR(PROGRAM_ERROR, "return type must be a row type");
+        }
+        functionContext->tuple_desc = BlessTupleDesc(tupleDescriptor);
+
+        int64_t now = GetCurrentTimestamp() / 1000;
+        List *entryList = NIL;
+        Relation rel = table_open(DataDeleteQueueRelationId(), ShareUpdateExclusiveLock);
+        CatalogIndexState indexState = CatalogOpenIndexes(rel);
+        TupleDesc tupleDesc = RelationGetDescr(rel);
+        SysScanDesc scanDesc = systable_beginscan(rel, InvalidOid, false, NULL, 0, NULL);
+        HeapTuple heapTuple;
+        while (list_length(entryList) < count && HeapTupleIsValid(heapTuple = systable_getnext(scanDesc))) {
+            Datum values[Natts_falcon_data_delete_queue];
+            bool isNulls[Natts_falcon_data_delete_queue];
+            heap_deform_tuple(heapTuple, tupleDesc, values, isNulls);
+            if (DatumGetInt64(values[Anum_falcon_data_delete_queue_lease_time - 1]) + leaseMs > now)
+                continue;
+
+            DataDeleteQueueEntry *entry = (DataDeleteQueueEntry *)palloc(sizeof(DataDeleteQueueEntry));
+            entry->inodeId = DatumGetInt64(values[Anum_falcon_data_delete_queue_inode_id - 1]);
+            entry->nodeId = DatumGetInt32(values[Anum_falcon_data_delete_queue_node_id - 1]);
+            entry->path = TextDatumGetCString(values[Anum_falcon_data_delete_queue_path - 1]);
+            entryList = lappend(entryList, entry);
+
+            bool doReplace[Natts_falcon_data_delete_queue];
+            memset(doReplace, false, sizeof(doReplace));
+            doReplace[Anum_falcon_data_delete_queue_lease_time - 1] = true;
+            values[Anum_falcon_data_delete_queue_lease_time - 1] = Int64GetDatum(now);
+            HeapTuple newTuple = heap_modify_tuple(heapTuple, tupleDesc, values, isNulls, doReplace);
+            CatalogTupleUpdateWithInfo(rel, &newTuple->t_self, newTuple, indexState);
+            heap_freetuple(newTuple);
+        }
+        systable_endscan(scanDesc);
+        CatalogCloseIndexes(indexState);
+        table_close(rel, ShareUpdateExclusiveLock);
+        CommandCounterIncrement();
+
+        functionContext->user_fctx = entryList;
+        functionContext->max_calls = list_length(entryList);
+        MemoryContextSwitchTo(oldContext);
+    }
+
+    functionContext = SRF_PERCALL_SETUP();
+    List *entryList = functionContext->user_fctx;
+    uint32_t offset = functionContext->call_cntr;
+
+    if (offset < functionContext->max_calls) {
+        DataDeleteQueueEntry *entry = (DataDeleteQueueEntry *)list_nth(entryList, offset);
+        Datum values[3];
+        bool resNulls[3];
+        memset(resNulls, false, sizeof(resNulls));
+        values[0] = Int64GetDatum(entry->inodeId);
+        values[1] = Int32GetDatum(entry->nodeId);
+        values[2] = CStringGetTextDatum(entry->path);
+        HeapTuple heapTupleRes = heap_form_tuple(functionContext->tuple_desc, values, resNulls);
+        SRF_RETURN_NEXT(functionContext, HeapTupleGetDatum(heapTupleRes));
+    }
+
+    SRF_RETURN_DONE(functionContext);
+}
+
+// entries whose data has been deleted, ones already removed are skipped. Returns the number removed.
+Datum falcon_data_delete_queue_remove(PG_FUNCTION_ARGS)
+{
+    ArrayType *inodeIdArrayType = PG_GETARG_ARRAYTYPE_P(0);
+
+    int inodeIdCount;
+    Datum *inodeIdArray;
+    ArrayTypeArrayToDatumArrayAndSize(inodeIdArrayType, &inodeIdArray, &inodeIdCount);
+
+    int removedCount = 0;
+    Relation rel = table_open(DataDeleteQueueRelationId(), RowExclusiveLock);
+    for (int i = 0; i < inodeIdCount; ++i) {
+        ScanKeyData scanKey[1];
+        ScanKeyInit(&scanKey[0],
+                    Anum_falcon_data_delete_queue_inode_id,
+                    BTEqualStrategyNumber,
+                    F_INT8EQ,
+                    inodeIdArray[i]);
+        SysScanDesc scanDesc = systable_beginscan(rel, DataDeleteQueueRelationIndexId(), true, NULL, 1, scanKey);
+        HeapTuple heapTuple = systable_getnext(scanDesc);
+        if (HeapTupleIsValid(heapTuple)) {
+            CatalogTupleDelete(rel, &heapTuple->t_self);
+            ++removedCount;
+        }
+        systable_endscan(scanDesc);
+    }
+    CommandCounterIncrement();
+    table_close(rel, RowExclusiveLock);
+
+    PG_RETURN_INT32(removedCount);
+}
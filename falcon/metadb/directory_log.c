@@ -0,0 +1,753 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "metadb/directory_log.h"
+
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/skey.h"
+#include "access/stratnum.h"
+#include "access/table.h"
+#include "access/xact.h"
+#include "access/xlog.h"
+#include "catalog/indexing.h"
+#include "catalog/namespace.h"
+#include "libpq-fe.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "postmaster/bgworker.h"
+#include "storage/condition_variable.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/resowner.h"
+#include "utils/timestamp.h"
+#include "utils/varlena.h"
+
+#include "control/control_flag.h"
+#include "dir_path_shmem/dir_path_hash.h"
+#include "distributed_backend/remote_comm_falcon.h"
+#include "metadb/directory_log_standalone.h"
+#include "metadb/directory_table.h"
+#include "metadb/foreign_server.h"
+#include "metadb/meta_handle.h"
+#include "utils/error_log.h"
+#include "utils/utils.h"
+#include "utils/utils_standalone.h"
+
+#define DIRECTORY_LOG_SEQUENCE_NAME "falcon_directory_log_lsn_seq"
+#define DIRECTORY_LOG_APPLIED_ALL PG_UINT64_MAX
+#define DIRECTORY_LOG_WAIT_RETRY_INTERVAL_MS 10
+#define DIRECTORY_LOG_APPLY_RETRY_INTERVAL_MS 1
+#define DIRECTORY_LOG_HORIZON_QUERY "SELECT pg_catalog.falcon_directory_log_horizon();"
+// the log keeps the last entry it has been truncated up to, so everything below the first one left is gone
+#define DIRECTORY_LOG_TRUNCATED_QUERY "SELECT coalesce(min(lsn), 1) - 1 FROM pg_catalog.falcon_directory_log;"
+
+int FalconDirectoryLogApplyIntervalMs = FALCON_DIRECTORY_LOG_APPLY_INTERVAL_MS_DEFAULT;
+int FalconDirectoryLogWaitTimeoutMs = FALCON_DIRECTORY_LOG_WAIT_TIMEOUT_MS_DEFAULT;
+int FalconDirectoryLogTruncateIntervalMs = FALCON_DIRECTORY_LOG_TRUNCATE_INTERVAL_MS_DEFAULT;
+
+typedef struct DirectoryLogControl
+{
+    int trancheId;
+    LWLockPadded lock;
+    // CN only, the highest position handed out, loaded from the sequence on first use
+    bool lastAssignedLoaded;
+    pg_atomic_uint64 lastAssigned;
+    // workers only, everything up to it has been committed to the local directory table
+    pg_atomic_uint64 applied;
+    // highest position a waiter is waiting for, the applier polls again right away while it is ahead of applied
+    pg_atomic_uint64 requested;
+    Latch *applierLatch;
+    ConditionVariable appliedCV;
+    // CN only, lower bound of the positions of every transaction still appending, 0 if the slot is free
+    int inflightSlotNum;
+    uint64_t inflight[FLEXIBLE_ARRAY_MEMBER];
+} DirectoryLogControl;
+
+static DirectoryLogControl *DirectoryLogShmemControl = NULL;
+static int DirectoryLogInflightSlot = -1;
+
+static volatile bool got_SIGTERM = false;
+
+static Oid GetDirectoryLogSequenceRelationId(void);
+static uint64_t DirectoryLogNextval(void);
+static void DirectoryLogLoadLastAssigned(void);
+static void DirectoryLogClaimInflightSlot(void);
+static void DirectoryLogInsert(Relation logRel,
+                               CatalogIndexState indexState,
+                               uint64_t lsn,
+                               uint64_t parentId,
+                               const char *name,
+                               uint64_t inodeId);
+static void DirectoryLogRequest(uint64_t position);
+static bool DirectoryLogWaitForAppliedInTime(uint64_t position);
+static uint64_t DirectoryLogLoadLastApplied(void);
+static PGresult *DirectoryLogQueryCN(const char *command);
+static uint64_t DirectoryLogQueryCNPosition(const char *command);
+static bool DirectoryLogApplyDirectory(Relation directoryRel,
+                                       CatalogIndexState indexState,
+                                       uint64_t parentId,
+                                       const char *name,
+                                       uint64_t inodeId);
+static uint64_t DirectoryLogApply(uint64_t applied);
+static uint64_t DirectoryLogBootstrap(uint64_t applied);
+static void DirectoryLogTruncate(uint64_t position);
+static void DirectoryLogTruncateOnCN(void);
+static void DirectoryLogTruncateRound(bool isCN, uint64_t applied, MemoryContext context);
+static void DirectoryLogApplierExit(int code, Datum arg);
+static void FalconDaemonDirectoryLogApplyProcessSigTermHandler(SIGNAL_ARGS);
+
+PG_FUNCTION_INFO_V1(falcon_directory_log_horizon);
+PG_FUNCTION_INFO_V1(falcon_directory_log_position);
+PG_FUNCTION_INFO_V1(falcon_directory_log_wait);
+
+Datum falcon_directory_log_horizon(PG_FUNCTION_ARGS) { PG_RETURN_INT64((int64_t)DirectoryLogHorizon()); }
+
+Datum falcon_directory_log_position(PG_FUNCTION_ARGS) { PG_RETURN_INT64((int64_t)DirectoryLogPosition()); }
+
+Datum falcon_directory_log_wait(PG_FUNCTION_ARGS)
+{
+    int64_t position = PG_GETARG_INT64(0);
+    if (position > 0)
+        DirectoryLogWaitForApplied((uint64_t)position);
+    PG_RETURN_INT32(0);
+}
+
+Oid DirectoryLogRelationId(void)
+{
+    GetRelationOid("falcon_directory_log", &CachedRelationOid[CACHED_RELATION_DIRECTORY_LOG_TABLE]);
+    return CachedRelationOid[CACHED_RELATION_DIRECTORY_LOG_TABLE];
+}
+
+Oid DirectoryLogRelationIndexId(void)
+{
+    GetRelationOid("falcon_directory_log_index", &CachedRelationOid[CACHED_RELATION_DIRECTORY_LOG_TABLE_INDEX]);
+    return CachedRelationOid[CACHED_RELATION_DIRECTORY_LOG_TABLE_INDEX];
+}
+
+size_t DirectoryLogShmemsize(void)
+{
+    return MAXALIGN(offsetof(DirectoryLogControl, inflight) + sizeof(uint64_t) * MaxBackends);
+}
+
+void DirectoryLogShmemInit(void)
+{
+    bool initialized;
+    DirectoryLogShmemControl =
+        ShmemInitStruct("Falcon Directory Log Control", DirectoryLogShmemsize(), &initialized);
+    if (!initialized) {
+        DirectoryLogShmemControl->trancheId = LWLockNewTrancheId();
+        LWLockInitialize(&DirectoryLogShmemControl->lock.lock, DirectoryLogShmemControl->trancheId);
+        DirectoryLogShmemControl->lastAssignedLoaded = false;
+        pg_atomic_init_u64(&DirectoryLogShmemControl->lastAssigned, 0);
+        pg_atomic_init_u64(&DirectoryLogShmemControl->applied, 0);
+        pg_atomic_init_u64(&DirectoryLogShmemControl->requested, 0);
+        DirectoryLogShmemControl->applierLatch = NULL;
+        ConditionVariableInit(&DirectoryLogShmemControl->appliedCV);
+        DirectoryLogShmemControl->inflightSlotNum = MaxBackends;
+        memset(DirectoryLogShmemControl->inflight, 0, sizeof(uint64_t) * MaxBackends);
+    }
+    LWLockRegisterTranche(DirectoryLogShmemControl->trancheId, "Falcon Directory Log");
+}
+
+static Oid GetDirectoryLogSequenceRelationId(void)
+{
+    static Oid sequenceRelationId = InvalidOid;
+    if (sequenceRelationId == InvalidOid) {
+        text *relationName = cstring_to_text(DIRECTORY_LOG_SEQUENCE_NAME);
+
+        List *relationNameList = textToQualifiedNameList(relationName);
+        RangeVar *relation = makeRangeVarFromNameList(relationNameList);
+        sequenceRelationId = RangeVarGetRelid(relation, NoLock, false);
+    }
+    return sequenceRelationId;
+}
+
+// positions come from a sequence, so they are never handed out twice even across restarts of the CN
+static uint64_t DirectoryLogNextval(void)
+{
+    Datum sequenceIdDatum = ObjectIdGetDatum(GetDirectoryLogSequenceRelationId());
+    Oid savedUserId = InvalidOid;
+    int savedSecurityContext = 0;
+
+    GetUserIdAndSecContext(&savedUserId, &savedSecurityContext);
+    SetUserIdAndSecContext(FalconExtensionOwner(), SECURITY_LOCAL_USERID_CHANGE);
+    Datum sequenceNumDatum = DirectFunctionCall1(nextval_oid, sequenceIdDatum);
+    SetUserIdAndSecContext(savedUserId, savedSecurityContext);
+
+    return DatumGetUInt64(sequenceNumDatum);
+}
+
+static void DirectoryLogLoadLastAssigned(void)
+{
+    if (DirectoryLogShmemControl->lastAssignedLoaded)
+        return;
+    // every position handed out before the restart is below it
+    uint64_t position = DirectoryLogNextval();
+    LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_EXCLUSIVE);
+    if (!DirectoryLogShmemControl->lastAssignedLoaded) {
+        if (position > pg_atomic_read_u64(&DirectoryLogShmemControl->lastAssigned))
+            pg_atomic_write_u64(&DirectoryLogShmemControl->lastAssigned, position);
+        DirectoryLogShmemControl->lastAssignedLoaded = true;
+    }
+    LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+}
+
+/*
+ * The slot is claimed before the position is taken from the sequence and holds a lower bound of it, so the
+ * horizon never passes a position whose transaction is still in progress.
+ */
+static void DirectoryLogClaimInflightSlot(void)
+{
+    while (DirectoryLogInflightSlot < 0) {
+        LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_EXCLUSIVE);
+        for (int i = 0; i < DirectoryLogShmemControl->inflightSlotNum; ++i) {
+            if (DirectoryLogShmemControl->inflight[i] == 0) {
+                DirectoryLogShmemControl->inflight[i] =
+                    pg_atomic_read_u64(&DirectoryLogShmemControl->lastAssigned) + 1;
+                DirectoryLogInflightSlot = i;
+                break;
+            }
+        }
+        LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+        if (DirectoryLogInflightSlot < 0) {
+            pg_usleep(DIRECTORY_LOG_WAIT_RETRY_INTERVAL_MS * 1000L);
+            CHECK_FOR_INTERRUPTS();
+        }
+    }
+}
+
+static void DirectoryLogInsert(Relation logRel,
+                               CatalogIndexState indexState,
+                               uint64_t lsn,
+                               uint64_t parentId,
+                               const char *name,
+                               uint64_t inodeId)
+{
+    Datum values[Natts_falcon_directory_log];
+    bool isNulls[Natts_falcon_directory_log];
+    memset(isNulls, false, sizeof(isNulls));
+    values[Anum_falcon_directory_log_lsn - 1] = Int64GetDatum(lsn);
+    values[Anum_falcon_directory_log_parent_id - 1] = Int64GetDatum(parentId);
+    values[Anum_falcon_directory_log_name - 1] = CStringGetTextDatum(name);
+    values[Anum_falcon_directory_log_inode_id - 1] = Int64GetDatum(inodeId);
+
+    HeapTuple heapTuple = heap_form_tuple(RelationGetDescr(logRel), values, isNulls);
+    CatalogTupleInsertWithInfo(logRel, heapTuple, indexState);
+    heap_freetuple(heapTuple);
+}
+
+void DirectoryLogAppend(uint64_t parentId, const char *name, uint64_t inodeId)
+{
+    DirectoryLogLoadLastAssigned();
+    DirectoryLogClaimInflightSlot();
+
+    uint64_t lsn = DirectoryLogNextval();
+    LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_EXCLUSIVE);
+    if (lsn > pg_atomic_read_u64(&DirectoryLogShmemControl->lastAssigned))
+        pg_atomic_write_u64(&DirectoryLogShmemControl->lastAssigned, lsn);
+    LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+
+    Relation logRel = table_open(DirectoryLogRelationId(), RowExclusiveLock);
+    CatalogIndexState indexState = CatalogOpenIndexes(logRel);
+    DirectoryLogInsert(logRel, indexState, lsn, parentId, name, inodeId);
+    CatalogCloseIndexes(indexState);
+    table_close(logRel, RowExclusiveLock);
+}
+
+uint64_t DirectoryLogHorizon(void)
+{
+    DirectoryLogLoadLastAssigned();
+
+    LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_SHARED);
+    uint64_t horizon = pg_atomic_read_u64(&DirectoryLogShmemControl->lastAssigned);
+    for (int i = 0; i < DirectoryLogShmemControl->inflightSlotNum; ++i) {
+        uint64_t lowerBound = DirectoryLogShmemControl->inflight[i];
+        if (lowerBound != 0 && lowerBound - 1 < horizon)
+            horizon = lowerBound - 1;
+    }
+    LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+    return horizon;
+}
+
+void DirectoryLogAtPrePrepare(void)
+{
+    // the appended entries would only become visible once the prepared transaction is committed by someone else
+    if (DirectoryLogInflightSlot >= 0)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "transactions appending to the directory log can't be prepared.");
+}
+
+void DirectoryLogAtTransactionEnd(void)
+{
+    if (DirectoryLogInflightSlot < 0)
+        return;
+    LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_EXCLUSIVE);
+    DirectoryLogShmemControl->inflight[DirectoryLogInflightSlot] = 0;
+    LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+    DirectoryLogInflightSlot = -1;
+}
+
+void DirectoryLogWaitForAppliedOnWorkerList(List *workerIdList)
+{
+    if (list_length(workerIdList) == 0)
+        return;
+    DirectoryLogLoadLastAssigned();
+    // entries of transactions which are still in progress are waited for as well, they end shortly
+    StringInfo command = makeStringInfo();
+    appendStringInfo(command,
+                     "SELECT pg_catalog.falcon_directory_log_wait(" UINT64_PRINT_SYMBOL ");",
+                     pg_atomic_read_u64(&DirectoryLogShmemControl->lastAssigned));
+    FalconPlainCommandOnWorkerList(command->data, REMOTE_COMMAND_FLAG_NO_BEGIN, workerIdList);
+    FalconSendCommandAndWaitForResult();
+}
+
+uint64_t DirectoryLogPosition(void)
+{
+    if (GetLocalServerId() == FALCON_CN_SERVER_ID)
+        return pg_atomic_read_u64(&DirectoryLogShmemControl->lastAssigned);
+    return pg_atomic_read_u64(&DirectoryLogShmemControl->applied);
+}
+
+static void DirectoryLogRequest(uint64_t position)
+{
+    uint64_t requested = pg_atomic_read_u64(&DirectoryLogShmemControl->requested);
+    while (requested < position &&
+           !pg_atomic_compare_exchange_u64(&DirectoryLogShmemControl->requested, &requested, position)) {
+    }
+    Latch *applierLatch = DirectoryLogShmemControl->applierLatch;
+    if (applierLatch != NULL)
+        SetLatch(applierLatch);
+}
+
+static bool DirectoryLogWaitForAppliedInTime(uint64_t position)
+{
+    if (pg_atomic_read_u64(&DirectoryLogShmemControl->applied) >= position)
+        return true;
+    DirectoryLogRequest(position);
+
+    TimestampTz deadline =
+        TimestampTzPlusMilliseconds(GetCurrentTimestamp(), FalconDirectoryLogWaitTimeoutMs);
+    ConditionVariablePrepareToSleep(&DirectoryLogShmemControl->appliedCV);
+    while (pg_atomic_read_u64(&DirectoryLogShmemControl->applied) < position) {
+        if (GetCurrentTimestamp() >= deadline) {
+            ConditionVariableCancelSleep();
+            return false;
+        }
+        ConditionVariableTimedSleep(&DirectoryLogShmemControl->appliedCV,
+                                    DIRECTORY_LOG_WAIT_RETRY_INTERVAL_MS,
+                                    PG_WAIT_EXTENSION);
+    }
+    ConditionVariableCancelSleep();
+    return true;
+}
+
+void DirectoryLogWaitForApplied(uint64_t position)
+{
+    if (!DirectoryLogWaitForAppliedInTime(position))
+        FALCON_ELOG_ERROR_EXTENDED(SERVER_FAULT,
+                                   "directory log hasn't been applied up to " UINT64_PRINT_SYMBOL " in time.",
+                                   position);
+}
+
+/*
+ * Requests without a log position, or with one from before the directory was created, may miss a directory which
+ * has been created on the CN but not applied here yet. Asks the CN for its horizon and waits for it, quietly giving
+ * up after the timeout. Returns whether anything has been applied meanwhile, i.e. whether a retry may succeed.
+ */
+bool DirectoryLogCatchUpWithCN(void)
+{
+    if (GetLocalServerId() == FALCON_CN_SERVER_ID)
+        return false;
+    uint64_t applied = pg_atomic_read_u64(&DirectoryLogShmemControl->applied);
+    uint64_t horizon = DirectoryLogQueryCNPosition(DIRECTORY_LOG_HORIZON_QUERY);
+    if (horizon <= applied)
+        return false;
+    (void)DirectoryLogWaitForAppliedInTime(horizon);
+    return pg_atomic_read_u64(&DirectoryLogShmemControl->applied) > applied;
+}
+
+// threads of the connection pool can neither sleep on a condition variable nor raise errors
+bool DirectoryLogRequestLockFree(uint64_t position)
+{
+    if (DirectoryLogAppliedLockFree(position))
+        return true;
+    DirectoryLogRequest(position);
+    return false;
+}
+
+bool DirectoryLogAppliedLockFree(uint64_t position)
+{
+    return pg_atomic_read_u64(&DirectoryLogShmemControl->applied) >= position;
+}
+
+int DirectoryLogWaitTimeoutMs(void) { return FalconDirectoryLogWaitTimeoutMs; }
+
+static uint64_t DirectoryLogLoadLastApplied(void)
+{
+    uint64_t lastApplied = 0;
+    Relation rel = table_open(DirectoryLogRelationId(), AccessShareLock);
+    Relation relIndex = index_open(DirectoryLogRelationIndexId(), AccessShareLock);
+    SysScanDesc scanDesc = systable_beginscan_ordered(rel, relIndex, NULL, 0, NULL);
+    HeapTuple heapTuple = systable_getnext_ordered(scanDesc, BackwardScanDirection);
+    if (HeapTupleIsValid(heapTuple)) {
+        bool isNull;
+        lastApplied =
+            DatumGetUInt64(heap_getattr(heapTuple, Anum_falcon_directory_log_lsn, RelationGetDescr(rel), &isNull));
+    }
+    systable_endscan_ordered(scanDesc);
+    index_close(relIndex, AccessShareLock);
+    table_close(rel, AccessShareLock);
+    return lastApplied;
+}
+
+static PGresult *DirectoryLogQueryCN(const char *command)
+{
+    FalconPlainCommandOnWorkerList(command, REMOTE_COMMAND_FLAG_NO_BEGIN, list_make1_int(FALCON_CN_SERVER_ID));
+    MultipleServerRemoteCommandResult allResList = FalconSendCommandAndWaitForResult();
+    RemoteCommandResultPerServerData *data = list_nth(allResList, 0);
+    return list_nth(data->remoteCommandResult, 0);
+}
+
+static uint64_t DirectoryLogQueryCNPosition(const char *command)
+{
+    PGresult *res = DirectoryLogQueryCN(command);
+    if (PQntuples(res) != 1 || PQnfields(res) != 1)
+        FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "PGresult is corrupt.");
+    return StringToUint64(PQgetvalue(res, 0, 0));
+}
+
+/*
+ * Returns false if another directory already has the name. No lock is taken on the entry of the directory path
+ * hash: backends which found the directory missing hold theirs until their transaction ends, possibly waiting for
+ * this very entry to be applied.
+ */
+static bool DirectoryLogApplyDirectory(Relation directoryRel,
+                                       CatalogIndexState indexState,
+                                       uint64_t parentId,
+                                       const char *name,
+                                       uint64_t inodeId)
+{
+    // directories replicated before the log was introduced, or copied by the bootstrap, are already there
+    uint64_t existingInodeId;
+    SearchDirectoryTableInfo(directoryRel, parentId, name, &existingInodeId);
+    if (existingInodeId == (uint64_t)DIR_HASH_TABLE_PATH_NOT_EXIST)
+        InsertDirectoryByDirectoryHashTable(directoryRel,
+                                            indexState,
+                                            parentId,
+                                            name,
+                                            inodeId,
+                                            DEFAULT_SUBPART_NUM,
+                                            DIR_LOCK_NONE);
+    return existingInodeId == (uint64_t)DIR_HASH_TABLE_PATH_NOT_EXIST || existingInodeId == inodeId;
+}
+
+/*
+ * Applies one batch of the log of the CN and returns the new applied position. The horizon is read first, so every
+ * entry below it has been committed before the entries are read by the following statement.
+ */
+static uint64_t DirectoryLogApply(uint64_t applied)
+{
+    uint64_t horizon = DirectoryLogQueryCNPosition(DIRECTORY_LOG_HORIZON_QUERY);
+    if (horizon <= applied)
+        return applied;
+
+    StringInfo command = makeStringInfo();
+    appendStringInfo(command,
+                     "SELECT lsn, parent_id, name, inodeid FROM pg_catalog.falcon_directory_log "
+                     "WHERE lsn > " UINT64_PRINT_SYMBOL " AND lsn <= " UINT64_PRINT_SYMBOL " ORDER BY lsn LIMIT %d;",
+                     applied,
+                     horizon,
+                     DIRECTORY_LOG_APPLY_BATCH_SIZE);
+    PGresult *res = DirectoryLogQueryCN(command->data);
+    if (PQnfields(res) != Natts_falcon_directory_log)
+        FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "PGresult is corrupt.");
+    int rowCount = PQntuples(res);
+
+    // checked after reading, so entries removed before they were read are noticed, e.g. by a truncation of the CN
+    // which hasn't counted a newly added worker yet
+    if (DirectoryLogQueryCNPosition(DIRECTORY_LOG_TRUNCATED_QUERY) > applied)
+        return DirectoryLogBootstrap(applied);
+
+    Relation directoryRel = table_open(DirectoryRelationId(), RowExclusiveLock);
+    CatalogIndexState directoryIndexState = CatalogOpenIndexes(directoryRel);
+    Relation logRel = table_open(DirectoryLogRelationId(), RowExclusiveLock);
+    CatalogIndexState logIndexState = CatalogOpenIndexes(logRel);
+    uint64_t lsn = applied;
+    for (int i = 0; i < rowCount; ++i) {
+        lsn = (uint64_t)StringToInt64(PQgetvalue(res, i, Anum_falcon_directory_log_lsn - 1));
+        uint64_t parentId = (uint64_t)StringToInt64(PQgetvalue(res, i, Anum_falcon_directory_log_parent_id - 1));
+        const char *name = PQgetvalue(res, i, Anum_falcon_directory_log_name - 1);
+        uint64_t inodeId = (uint64_t)StringToInt64(PQgetvalue(res, i, Anum_falcon_directory_log_inode_id - 1));
+
+        if (!DirectoryLogApplyDirectory(directoryRel, directoryIndexState, parentId, name, inodeId))
+            FALCON_ELOG_WARNING_EXTENDED(PROGRAM_ERROR,
+                                         "directory log entry " UINT64_PRINT_SYMBOL " conflicts with an existing "
+                                         "directory, skipped.",
+                                         lsn);
+        DirectoryLogInsert(logRel, logIndexState, lsn, parentId, name, inodeId);
+    }
+    CatalogCloseIndexes(logIndexState);
+    table_close(logRel, RowExclusiveLock);
+    CatalogCloseIndexes(directoryIndexState);
+    table_close(directoryRel, RowExclusiveLock);
+    if (rowCount > 0)
+        FalconNamespaceGenerationMarkDirty();
+
+    // positions without an entry below the horizon belong to transactions which have been rolled back
+    return rowCount < DIRECTORY_LOG_APPLY_BATCH_SIZE ? horizon : lsn;
+}
+
+/*
+ * Workers behind the truncation of the log, e.g. ones added after it, copy the directory table of the CN instead of
+ * replaying the log from 0. The horizon is read first, so every entry below it has been committed before the copy
+ * is taken, and the entries above it are applied from the log afterwards. Returns the new applied position, or
+ * applied if the log has meanwhile been truncated beyond the horizon, in which case the next round tries again.
+ */
+static uint64_t DirectoryLogBootstrap(uint64_t applied)
+{
+    uint64_t horizon = DirectoryLogQueryCNPosition(DIRECTORY_LOG_HORIZON_QUERY);
+    PGresult *res = DirectoryLogQueryCN("SELECT parent_id, name, inodeid FROM pg_catalog.falcon_directory_table;");
+    if (PQnfields(res) != Natts_falcon_directory_table)
+        FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "PGresult is corrupt.");
+    if (DirectoryLogQueryCNPosition(DIRECTORY_LOG_TRUNCATED_QUERY) > horizon)
+        return applied;
+
+    int rowCount = PQntuples(res);
+    elog(LOG,
+         "DirectoryLogBootstrap: copying %d directories of the CN, up to " UINT64_PRINT_SYMBOL ".",
+         rowCount,
+         horizon);
+    Relation directoryRel = table_open(DirectoryRelationId(), RowExclusiveLock);
+    CatalogIndexState directoryIndexState = CatalogOpenIndexes(directoryRel);
+    for (int i = 0; i < rowCount; ++i) {
+        uint64_t parentId = (uint64_t)StringToInt64(PQgetvalue(res, i, Anum_falcon_directory_table_parent_id - 1));
+        const char *name = PQgetvalue(res, i, Anum_falcon_directory_table_name - 1);
+        uint64_t inodeId = (uint64_t)StringToInt64(PQgetvalue(res, i, Anum_falcon_directory_table_inode_id - 1));
+        if (!DirectoryLogApplyDirectory(directoryRel, directoryIndexState, parentId, name, inodeId))
+            FALCON_ELOG_WARNING_EXTENDED(PROGRAM_ERROR,
+                                         "directory " UINT64_PRINT_SYMBOL " of the CN conflicts with an existing "
+                                         "directory, skipped.",
+                                         inodeId);
+    }
+    CatalogCloseIndexes(directoryIndexState);
+    table_close(directoryRel, RowExclusiveLock);
+    if (rowCount > 0)
+        FalconNamespaceGenerationMarkDirty();
+    return horizon;
+}
+
+// removes the entries below the last one up to position, which is kept to tell how far the log has been truncated
+static void DirectoryLogTruncate(uint64_t position)
+{
+    Relation rel = table_open(DirectoryLogRelationId(), RowExclusiveLock);
+    Relation relIndex = index_open(DirectoryLogRelationIndexId(), AccessShareLock);
+    ScanKeyData scanKey[1];
+    ScanKeyInit(&scanKey[0],
+                Anum_falcon_directory_log_lsn,
+                BTLessEqualStrategyNumber,
+                F_INT8LE,
+                Int64GetDatum((int64_t)Min(position, (uint64_t)PG_INT64_MAX)));
+    SysScanDesc scanDesc = systable_beginscan_ordered(rel, relIndex, NULL, 1, scanKey);
+    HeapTuple heapTuple = systable_getnext_ordered(scanDesc, BackwardScanDirection);
+    if (HeapTupleIsValid(heapTuple)) {
+        while (HeapTupleIsValid(heapTuple = systable_getnext_ordered(scanDesc, BackwardScanDirection)))
+            CatalogTupleDelete(rel, &heapTuple->t_self);
+    }
+    systable_endscan_ordered(scanDesc);
+    index_close(relIndex, AccessShareLock);
+    table_close(rel, RowExclusiveLock);
+}
+
+// the log of the CN is only needed above what every worker has applied, a worker which is down holds it back
+static void DirectoryLogTruncateOnCN(void)
+{
+    uint64_t position = DirectoryLogHorizon();
+    List *workerIdList = GetAllForeignServerId(true, true);
+    if (list_length(workerIdList) > 0) {
+        FalconPlainCommandOnWorkerList("SELECT pg_catalog.falcon_directory_log_position();",
+                                       REMOTE_COMMAND_FLAG_NO_BEGIN,
+                                       workerIdList);
+        MultipleServerRemoteCommandResult allResList = FalconSendCommandAndWaitForResult();
+        for (int i = 0; i < list_length(allResList); ++i) {
+            RemoteCommandResultPerServerData *data = list_nth(allResList, i);
+            PGresult *res = list_nth(data->remoteCommandResult, 0);
+            if (PQntuples(res) != 1 || PQnfields(res) != 1)
+                FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "PGresult is corrupt.");
+            uint64_t applied = StringToUint64(PQgetvalue(res, 0, 0));
+            if (applied < position)
+                position = applied;
+        }
+    }
+    DirectoryLogTruncate(position);
+}
+
+static void DirectoryLogTruncateRound(bool isCN, uint64_t applied, MemoryContext context)
+{
+    MemoryContext oldContext = MemoryContextSwitchTo(context);
+    StartTransactionCommand();
+    PG_TRY();
+    {
+        // workers keep their copy of the log only to know where to resume after a restart
+        if (isCN)
+            DirectoryLogTruncateOnCN();
+        else
+            DirectoryLogTruncate(applied);
+        CommitTransactionCommand();
+    }
+    PG_CATCH();
+    {
+        MemoryContextSwitchTo(context);
+        EmitErrorReport();
+        FlushErrorState();
+        AbortCurrentTransaction();
+    }
+    PG_END_TRY();
+    MemoryContextSwitchTo(oldContext);
+    MemoryContextReset(context);
+}
+
+static void DirectoryLogApplierExit(int code, Datum arg)
+{
+    LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_EXCLUSIVE);
+    DirectoryLogShmemControl->applierLatch = NULL;
+    LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+}
+
+static void FalconDaemonDirectoryLogApplyProcessSigTermHandler(SIGNAL_ARGS)
+{
+    int save_errno = errno;
+
+    got_SIGTERM = true;
+    SetLatch(MyLatch);
+
+    errno = save_errno;
+}
+
+void FalconDaemonDirectoryLogApplyProcessMain(Datum main_arg)
+{
+    pqsignal(SIGTERM, FalconDaemonDirectoryLogApplyProcessSigTermHandler);
+    BackgroundWorkerUnblockSignals();
+
+    BackgroundWorkerInitializeConnection("postgres", NULL, 0);
+
+    ResourceOwner myOwner = ResourceOwnerCreate(NULL, "falcon background directory log apply");
+    MemoryContext myContext = AllocSetContextCreate(TopMemoryContext,
+                                                    "falcon background directory log apply",
+                                                    ALLOCSET_DEFAULT_MINSIZE,
+                                                    ALLOCSET_DEFAULT_INITSIZE,
+                                                    ALLOCSET_DEFAULT_MAXSIZE);
+    ResourceOwner oldOwner = CurrentResourceOwner;
+    CurrentResourceOwner = myOwner;
+    elog(LOG, "FalconDaemonDirectoryLogApplyProcessMain: wait init.");
+    bool falconHasBeenLoad = false;
+    while (true) {
+        StartTransactionCommand();
+        falconHasBeenLoad = CheckFalconHasBeenLoaded();
+        CommitTransactionCommand();
+        if (falconHasBeenLoad)
+            break;
+        sleep(1);
+    }
+    bool serviceStarted = false;
+    do {
+        sleep(1);
+        serviceStarted = CheckFalconBackgroundServiceStarted();
+    } while (!serviceStarted || RecoveryInProgress());
+    int serverId = -1;
+    while (true) {
+        StartTransactionCommand();
+        serverId = GetLocalServerId();
+        CommitTransactionCommand();
+        if (serverId != -1)
+            break;
+
+        // wait for shard table init
+        sleep(1);
+    }
+    elog(LOG, "FalconDaemonDirectoryLogApplyProcessMain: init finished.");
+
+    if (serverId == FALCON_CN_SERVER_ID) {
+        // the CN owns the log, so everything has been applied there
+        pg_atomic_write_u64(&DirectoryLogShmemControl->applied, DIRECTORY_LOG_APPLIED_ALL);
+        ConditionVariableBroadcast(&DirectoryLogShmemControl->appliedCV);
+
+        elog(LOG, "FalconDaemonDirectoryLogApplyProcessMain: Running.");
+        while (!got_SIGTERM) {
+            ResetLatch(MyLatch);
+            DirectoryLogTruncateRound(true, 0, myContext);
+            (void)WaitLatch(MyLatch,
+                            WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+                            FalconDirectoryLogTruncateIntervalMs,
+                            PG_WAIT_EXTENSION);
+            CHECK_FOR_INTERRUPTS();
+        }
+    } else {
+        StartTransactionCommand();
+        uint64_t applied = DirectoryLogLoadLastApplied();
+        CommitTransactionCommand();
+        pg_atomic_write_u64(&DirectoryLogShmemControl->applied, applied);
+        ConditionVariableBroadcast(&DirectoryLogShmemControl->appliedCV);
+
+        on_shmem_exit(DirectoryLogApplierExit, 0);
+        LWLockAcquire(&DirectoryLogShmemControl->lock.lock, LW_EXCLUSIVE);
+        DirectoryLogShmemControl->applierLatch = MyLatch;
+        LWLockRelease(&DirectoryLogShmemControl->lock.lock);
+
+        elog(LOG, "FalconDaemonDirectoryLogApplyProcessMain: Running.");
+        uint64_t lastRequested = 0;
+        TimestampTz lastRequestedAt = 0;
+        TimestampTz lastTruncatedAt = GetCurrentTimestamp();
+        while (!got_SIGTERM) {
+            ResetLatch(MyLatch);
+            TimestampTz now = GetCurrentTimestamp();
+            if (TimestampDifferenceExceeds(lastTruncatedAt, now, FalconDirectoryLogTruncateIntervalMs)) {
+                DirectoryLogTruncateRound(false, applied, myContext);
+                lastTruncatedAt = now;
+            }
+            MemoryContext oldContext = MemoryContextSwitchTo(myContext);
+
+            StartTransactionCommand();
+            uint64_t newApplied = DirectoryLogApply(applied);
+            CommitTransactionCommand();
+
+            MemoryContextSwitchTo(oldContext);
+            MemoryContextReset(myContext);
+
+            if (newApplied > applied) {
+                applied = newApplied;
+                pg_atomic_write_u64(&DirectoryLogShmemControl->applied, applied);
+                ConditionVariableBroadcast(&DirectoryLogShmemControl->appliedCV);
+                continue;
+            }
+            // waiters may depend on a transaction which hasn't ended on the CN yet, they give up after the timeout
+            uint64_t requested = pg_atomic_read_u64(&DirectoryLogShmemControl->requested);
+            if (requested != lastRequested) {
+                lastRequested = requested;
+                lastRequestedAt = GetCurrentTimestamp();
+            }
+            long timeout = FalconDirectoryLogApplyIntervalMs;
+            if (requested > applied &&
+                !TimestampDifferenceExceeds(lastRequestedAt, GetCurrentTimestamp(), FalconDirectoryLogWaitTimeoutMs))
+                timeout = DIRECTORY_LOG_APPLY_RETRY_INTERVAL_MS;
+            (void)WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH, timeout, PG_WAIT_EXTENSION);
+            CHECK_FOR_INTERRUPTS();
+        }
+    }
+
+    elog(LOG, "FalconDaemonDirectoryLogApplyProcessMain: exit.");
+    CurrentResourceOwner = oldOwner;
+    ResourceOwnerRelease(myOwner, RESOURCE_RELEASE_BEFORE_LOCKS, true, true);
+    ResourceOwnerRelease(myOwner, RESOURCE_RELEASE_LOCKS, true, true);
+    ResourceOwnerRelease(myOwner, RESOURCE_RELEASE_AFTER_LOCKS, true, true);
+    ResourceOwnerDelete(myOwner);
+    MemoryContextDelete(myContext);
+    return;
+}
@@ -10,6 +10,7 @@
 #include "access/table.h"
 #include "access/xact.h"
 #include "catalog/indexing.h"
+#include "lib/stringinfo.h"
 #include "utils/builtins.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
@@ -121,3 +122,50 @@ void DeleteFromDirectoryTable(Relation directoryRel, uint64_t parentId, const ch
     }
     systable_endscan(scanDescriptor);
 }
+
+/*
+ * Every directory of the subtree rooted at the given one, parents before their children, the root comes first.
+ * Callers are supposed to hold the root exclusively, so nothing below it changes meanwhile.
+ */
+List *SearchDirectorySubtree(Relation directoryRel, uint64_t parentId, const char *name, uint64_t inodeId)
+{
+    DirectorySubtreeNode *root = (DirectorySubtreeNode *)palloc(sizeof(DirectorySubtreeNode));
+    root->parentId = parentId;
+    root->name = pstrdup(name);
+    root->inodeId = inodeId;
+    root->path = pstrdup("");
+    List *nodeList = list_make1(root);
+
+    SetUpScanCaches();
+    TupleDesc tupleDesc = RelationGetDescr(directoryRel);
+    for (int i = 0; i < list_length(nodeList); ++i) {
+        DirectorySubtreeNode *parent = list_nth(nodeList, i);
+
+        ScanKeyData scanKey[1];
+        scanKey[0] = DirectoryTableScanKey[DIRECTORY_TABLE_PARENT_ID_EQ];
+        scanKey[0].sk_argument = UInt64GetDatum(parent->inodeId);
+        SysScanDesc scanDescriptor = systable_beginscan(directoryRel,
+                                                        DirectoryRelationIndexId(),
+                                                        true,
+                                                        GetTransactionSnapshot(),
+                                                        1,
+                                                        scanKey);
+        HeapTuple heapTuple;
+        while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+            bool isNull = false;
+            DirectorySubtreeNode *node = (DirectorySubtreeNode *)palloc(sizeof(DirectorySubtreeNode));
+            node->parentId = parent->inodeId;
+            node->name =
+                TextDatumGetCString(heap_getattr(heapTuple, Anum_falcon_directory_table_name, tupleDesc, &isNull));
+            node->inodeId =
+                DatumGetUInt64(heap_getattr(heapTuple, Anum_falcon_directory_table_inode_id, tupleDesc, &isNull));
+            StringInfoData path;
+            initStringInfo(&path);
+            appendStringInfo(&path, "%s/%s", parent->path, node->name);
+            node->path = path.data;
+            nodeList = lappend(nodeList, node);
+        }
+        systable_endscan(scanDescriptor);
+    }
+    return nodeList;
+}
@@ -0,0 +1,261 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "metadb/inode_attr_cache.h"
+
+#include "access/xact.h"
+#include "common/hashfn.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
+
+int FalconInodeAttrCacheCapacity = FALCON_INODE_ATTR_CACHE_CAPACITY_DEFAULT;
+
+typedef struct InodeAttrCacheKey
+{
+    uint64_t parentId_partId;
+    char name[FILENAMELENGTH];
+} InodeAttrCacheKey;
+
+typedef struct InodeAttrCacheEntry
+{
+    InodeAttrCacheKey key;
+    // epoch of the cache when the entry was filled, entries of former epochs are dead
+    uint64_t epoch;
+    // cleared by eviction, set by hits, entries only get evicted once unreferenced
+    pg_atomic_uint32 referenced;
+    InodeAttr attr;
+} InodeAttrCacheEntry;
+
+typedef struct InodeAttrCachePartition
+{
+    LWLockPadded lock;
+    pg_atomic_uint64 version;
+} InodeAttrCachePartition;
+
+typedef struct InodeAttrCacheControl
+{
+    int trancheId;
+    pg_atomic_uint64 epoch;
+    InodeAttrCachePartition partition[INODE_ATTR_CACHE_PARTITION_NUM];
+} InodeAttrCacheControl;
+
+static InodeAttrCacheControl *InodeAttrCacheShmemControl = NULL;
+static HTAB *InodeAttrCacheHash[INODE_ATTR_CACHE_PARTITION_NUM] = {0};
+
+// keys modified by the current transaction, invalidated again once it ends
+#define MAX_INODE_ATTR_CACHE_TO_INVALIDATE_COUNT 64
+static InodeAttrCacheKey InodeAttrCacheToInvalidate[MAX_INODE_ATTR_CACHE_TO_INVALIDATE_COUNT];
+static int InodeAttrCacheToInvalidateCount = 0;
+static bool InodeAttrCacheToInvalidateOverflow = false;
+static bool InodeAttrCacheModifiedInTransaction = false;
+
+static long InodeAttrCachePartitionCapacity(void);
+static bool InodeAttrCacheBuildKey(uint64_t parentId_partId, const char *name, InodeAttrCacheKey *key);
+static void InodeAttrCacheRemove(const InodeAttrCacheKey *key);
+static void InodeAttrCacheEvictOne(HTAB *hash, uint64_t epoch);
+
+static long InodeAttrCachePartitionCapacity(void)
+{
+    return Max(FalconInodeAttrCacheCapacity / INODE_ATTR_CACHE_PARTITION_NUM, 1);
+}
+
+size_t InodeAttrCacheShmemsize(void)
+{
+    if (FalconInodeAttrCacheCapacity == 0)
+        return 0;
+    return MAXALIGN(sizeof(InodeAttrCacheControl)) +
+           INODE_ATTR_CACHE_PARTITION_NUM *
+               hash_estimate_size(InodeAttrCachePartitionCapacity(), sizeof(InodeAttrCacheEntry));
+}
+
+void InodeAttrCacheShmemInit(void)
+{
+    if (FalconInodeAttrCacheCapacity == 0)
+        return;
+
+    bool initialized;
+    InodeAttrCacheShmemControl =
+        ShmemInitStruct("Falcon Inode Attr Cache Control", sizeof(InodeAttrCacheControl), &initialized);
+    if (!initialized) {
+        InodeAttrCacheShmemControl->trancheId = LWLockNewTrancheId();
+        pg_atomic_init_u64(&InodeAttrCacheShmemControl->epoch, 0);
+        for (int i = 0; i < INODE_ATTR_CACHE_PARTITION_NUM; ++i) {
+            LWLockInitialize(&InodeAttrCacheShmemControl->partition[i].lock.lock,
+                             InodeAttrCacheShmemControl->trancheId);
+            pg_atomic_init_u64(&InodeAttrCacheShmemControl->partition[i].version, 0);
+        }
+    }
+    LWLockRegisterTranche(InodeAttrCacheShmemControl->trancheId, "Falcon Inode Attr Cache");
+
+    HASHCTL info;
+    memset(&info, 0, sizeof(info));
+    info.keysize = sizeof(InodeAttrCacheKey);
+    info.entrysize = sizeof(InodeAttrCacheEntry);
+    char buf[64];
+    for (int i = 0; i < INODE_ATTR_CACHE_PARTITION_NUM; ++i) {
+        sprintf(buf, "Falcon inode attr cache %d", i);
+        InodeAttrCacheHash[i] = ShmemInitHash(buf,
+                                              InodeAttrCachePartitionCapacity(),
+                                              InodeAttrCachePartitionCapacity(),
+                                              &info,
+                                              HASH_ELEM | HASH_BLOBS);
+    }
+}
+
+bool InodeAttrCacheEnabled(void)
+{
+    // a transaction snapshot may predate tickets taken within the transaction
+    return InodeAttrCacheShmemControl != NULL && !InodeAttrCacheModifiedInTransaction && !IsolationUsesXactSnapshot();
+}
+
+void InodeAttrCacheTakeTicket(InodeAttrCacheTicket *ticket)
+{
+    if (InodeAttrCacheShmemControl == NULL)
+        return;
+    ticket->epoch = pg_atomic_read_u64(&InodeAttrCacheShmemControl->epoch);
+    for (int i = 0; i < INODE_ATTR_CACHE_PARTITION_NUM; ++i)
+        ticket->version[i] = pg_atomic_read_u64(&InodeAttrCacheShmemControl->partition[i].version);
+    pg_read_barrier();
+}
+
+static bool InodeAttrCacheBuildKey(uint64_t parentId_partId, const char *name, InodeAttrCacheKey *key)
+{
+    // the key is hashed as a whole, so the unused tail of the name must be zeroed
+    memset(key, 0, sizeof(InodeAttrCacheKey));
+    key->parentId_partId = parentId_partId;
+    return strlcpy(key->name, name, FILENAMELENGTH) < FILENAMELENGTH;
+}
+
+bool InodeAttrCacheLookup(uint64_t parentId_partId, const char *name, InodeAttr *attr)
+{
+    InodeAttrCacheKey key;
+    if (!InodeAttrCacheEnabled() || !InodeAttrCacheBuildKey(parentId_partId, name, &key))
+        return false;
+    uint32 hashcode = tag_hash(&key, sizeof(key));
+    int partitionIndex = hashcode % INODE_ATTR_CACHE_PARTITION_NUM;
+    LWLock *lock = &InodeAttrCacheShmemControl->partition[partitionIndex].lock.lock;
+
+    bool hit = false;
+    LWLockAcquire(lock, LW_SHARED);
+    InodeAttrCacheEntry *entry =
+        hash_search_with_hash_value(InodeAttrCacheHash[partitionIndex], &key, hashcode, HASH_FIND, NULL);
+    if (entry != NULL && entry->epoch == pg_atomic_read_u64(&InodeAttrCacheShmemControl->epoch)) {
+        *attr = entry->attr;
+        if (pg_atomic_read_u32(&entry->referenced) == 0)
+            pg_atomic_write_u32(&entry->referenced, 1);
+        hit = true;
+    }
+    LWLockRelease(lock);
+    return hit;
+}
+
+void InodeAttrCacheFill(const InodeAttrCacheTicket *ticket,
+                        uint64_t parentId_partId,
+                        const char *name,
+                        const InodeAttr *attr)
+{
+    InodeAttrCacheKey key;
+    if (!InodeAttrCacheEnabled() || !InodeAttrCacheBuildKey(parentId_partId, name, &key))
+        return;
+    uint32 hashcode = tag_hash(&key, sizeof(key));
+    int partitionIndex = hashcode % INODE_ATTR_CACHE_PARTITION_NUM;
+    InodeAttrCachePartition *partition = &InodeAttrCacheShmemControl->partition[partitionIndex];
+    HTAB *hash = InodeAttrCacheHash[partitionIndex];
+
+    LWLockAcquire(&partition->lock.lock, LW_EXCLUSIVE);
+    // the row may have been modified since it was read
+    uint64_t epoch = pg_atomic_read_u64(&InodeAttrCacheShmemControl->epoch);
+    if (ticket->version[partitionIndex] != pg_atomic_read_u64(&partition->version) || ticket->epoch != epoch) {
+        LWLockRelease(&partition->lock.lock);
+        return;
+    }
+    InodeAttrCacheEntry *entry = hash_search_with_hash_value(hash, &key, hashcode, HASH_FIND, NULL);
+    if (entry == NULL) {
+        if (hash_get_num_entries(hash) >= InodeAttrCachePartitionCapacity())
+            InodeAttrCacheEvictOne(hash, epoch);
+        entry = hash_search_with_hash_value(hash, &key, hashcode, HASH_ENTER_NULL, NULL);
+        if (entry == NULL) {
+            LWLockRelease(&partition->lock.lock);
+            return;
+        }
+        pg_atomic_init_u32(&entry->referenced, 0);
+    }
+    entry->epoch = epoch;
+    entry->attr = *attr;
+    LWLockRelease(&partition->lock.lock);
+}
+
+// clock style second chance within the partition, entries of former epochs go first
+static void InodeAttrCacheEvictOne(HTAB *hash, uint64_t epoch)
+{
+    HASH_SEQ_STATUS status;
+    InodeAttrCacheEntry *entry;
+    InodeAttrCacheEntry *victim = NULL;
+    for (int round = 0; round < 2 && victim == NULL; ++round) {
+        hash_seq_init(&status, hash);
+        while ((entry = hash_seq_search(&status)) != NULL) {
+            if (entry->epoch != epoch || pg_atomic_exchange_u32(&entry->referenced, 0) == 0) {
+                victim = entry;
+                hash_seq_term(&status);
+                break;
+            }
+        }
+    }
+    if (victim != NULL)
+        hash_search(hash, &victim->key, HASH_REMOVE, NULL);
+}
+
+static void InodeAttrCacheRemove(const InodeAttrCacheKey *key)
+{
+    uint32 hashcode = tag_hash(key, sizeof(InodeAttrCacheKey));
+    int partitionIndex = hashcode % INODE_ATTR_CACHE_PARTITION_NUM;
+    InodeAttrCachePartition *partition = &InodeAttrCacheShmemControl->partition[partitionIndex];
+
+    LWLockAcquire(&partition->lock.lock, LW_EXCLUSIVE);
+    hash_search_with_hash_value(InodeAttrCacheHash[partitionIndex], key, hashcode, HASH_REMOVE, NULL);
+    pg_atomic_fetch_add_u64(&partition->version, 1);
+    LWLockRelease(&partition->lock.lock);
+}
+
+void InodeAttrCacheInvalidate(uint64_t parentId_partId, const char *name)
+{
+    if (InodeAttrCacheShmemControl == NULL)
+        return;
+    InodeAttrCacheModifiedInTransaction = true;
+
+    InodeAttrCacheKey key;
+    if (!InodeAttrCacheBuildKey(parentId_partId, name, &key))
+        return;
+    InodeAttrCacheRemove(&key);
+
+    if (InodeAttrCacheToInvalidateCount < MAX_INODE_ATTR_CACHE_TO_INVALIDATE_COUNT)
+        InodeAttrCacheToInvalidate[InodeAttrCacheToInvalidateCount++] = key;
+    else
+        InodeAttrCacheToInvalidateOverflow = true;
+}
+
+void InodeAttrCacheInvalidateAll(void)
+{
+    if (InodeAttrCacheShmemControl == NULL)
+        return;
+    pg_atomic_fetch_add_u64(&InodeAttrCacheShmemControl->epoch, 1);
+}
+
+void InodeAttrCacheInvalidateAllAtCommit(void) { InodeAttrCacheToInvalidateOverflow = true; }
+
+void InodeAttrCacheAtTransactionEnd(void)
+{
+    if (InodeAttrCacheShmemControl != NULL) {
+        // readers may have refilled the keys with the old rows before the modifications became visible
+        for (int i = 0; i < InodeAttrCacheToInvalidateCount; ++i)
+            InodeAttrCacheRemove(&InodeAttrCacheToInvalidate[i]);
+        if (InodeAttrCacheToInvalidateOverflow)
+            InodeAttrCacheInvalidateAll();
+    }
+    InodeAttrCacheToInvalidateCount = 0;
+    InodeAttrCacheToInvalidateOverflow = false;
+    InodeAttrCacheModifiedInTransaction = false;
+}
@@ -4,12 +4,35 @@
 
 #include "metadb/inode_table.h"
 
+#include "catalog/pg_namespace_d.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+#include "utils/error_log.h"
+
 const char *InodeTableName = "falcon_inode_table";
 
+typedef struct InodeShardRelationCacheEntry
+{
+    int32_t shardId;
+    Oid relationOid;
+    Oid indexOid;
+    // collation the index orders names by, "C" for shards created since, the database default for older ones
+    Oid nameCollation;
+} InodeShardRelationCacheEntry;
+
+// backend local, shardId -> oids of the inode shard table and its index
+static HTAB *InodeShardRelationCache = NULL;
+
+static void InvalidateInodeShardRelationCacheCallback(Datum argument, Oid relationId);
+static Oid GetInodeShardRelationOid(const char *format, int shardId);
+
 void ConstructCreateInodeTableCommand(StringInfo command, const char *name)
 {
     appendStringInfo(command,
-                     "CREATE TABLE falcon.%s(name			   varchar(256),"
+                     "CREATE TABLE falcon.%s(name			   varchar(256) COLLATE \"C\","
                      "st_ino			   bigint,"
                      "parentid_partid   bigint,"
                      "st_dev			   bigint,"
@@ -27,15 +50,80 @@ void ConstructCreateInodeTableCommand(StringInfo command, const char *name)
                      "etag			   text,"
                      "update_version	   bigint,"
                      "primary_nodeid	   int,"
-                     "backup_nodeid	   int);"
-                     "CREATE UNIQUE INDEX %s_index ON falcon.%s USING btree(parentid_partid, name);"
+                     "backup_nodeid	   int) WITH (fillfactor = %d);"
+                     "CREATE UNIQUE INDEX %s_index ON falcon.%s USING btree(parentid_partid, name) INCLUDE (st_mode);"
                      "ALTER TABLE falcon.%s SET SCHEMA pg_catalog;"
                      "GRANT SELECT ON pg_catalog.%s TO public;"
                      "ALTER EXTENSION falcon ADD TABLE %s;",
                      name,
+                     INODE_TABLE_FILLFACTOR,
                      name,
                      name,
                      name,
                      name,
                      name);
 }
+
+static void InvalidateInodeShardRelationCacheCallback(Datum argument, Oid relationId)
+{
+    if (InodeShardRelationCache == NULL)
+        return;
+
+    HASH_SEQ_STATUS status;
+    InodeShardRelationCacheEntry *entry;
+    hash_seq_init(&status, InodeShardRelationCache);
+    while ((entry = hash_seq_search(&status)) != NULL) {
+        if (relationId == InvalidOid || entry->relationOid == relationId || entry->indexOid == relationId)
+            hash_search(InodeShardRelationCache, &entry->shardId, HASH_REMOVE, NULL);
+    }
+}
+
+static Oid GetInodeShardRelationOid(const char *format, int shardId)
+{
+    char relationName[NAMEDATALEN];
+    snprintf(relationName, NAMEDATALEN, format, InodeTableName, shardId);
+    Oid relationOid = get_relname_relid(relationName, PG_CATALOG_NAMESPACE);
+    if (relationOid == InvalidOid)
+        FALCON_ELOG_ERROR_EXTENDED(PROGRAM_ERROR, "cannot find relation %s.", relationName);
+    return relationOid;
+}
+
+static InodeShardRelationCacheEntry *LookupInodeShardRelationCache(int shardId)
+{
+    if (InodeShardRelationCache == NULL) {
+        if (CacheMemoryContext == NULL)
+            CreateCacheMemoryContext();
+        HASHCTL info;
+        memset(&info, 0, sizeof(info));
+        info.keysize = sizeof(int32_t);
+        info.entrysize = sizeof(InodeShardRelationCacheEntry);
+        info.hcxt = CacheMemoryContext;
+        InodeShardRelationCache =
+            hash_create("Inode Shard Relation Cache", 1024, &info, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+        CacheRegisterRelcacheCallback(InvalidateInodeShardRelationCacheCallback, (Datum)0);
+    }
+
+    int32_t key = shardId;
+    InodeShardRelationCacheEntry *entry = hash_search(InodeShardRelationCache, &key, HASH_FIND, NULL);
+    if (entry != NULL)
+        return entry;
+
+    // resolve both before entering, so that a failed lookup leaves no half filled entry
+    Oid relationOid = GetInodeShardRelationOid("%s_%d", shardId);
+    Oid indexOid = GetInodeShardRelationOid("%s_%d_index", shardId);
+    Oid nameType;
+    int32 nameTypmod;
+    Oid nameCollation;
+    get_atttypetypmodcoll(indexOid, Anum_pg_dfs_file_index_name, &nameType, &nameTypmod, &nameCollation);
+    entry = hash_search(InodeShardRelationCache, &key, HASH_ENTER, NULL);
+    entry->relationOid = relationOid;
+    entry->indexOid = indexOid;
+    entry->nameCollation = nameCollation;
+    return entry;
+}
+
+Oid InodeShardRelationId(int shardId) { return LookupInodeShardRelationCache(shardId)->relationOid; }
+
+Oid InodeShardIndexRelationId(int shardId) { return LookupInodeShardRelationCache(shardId)->indexOid; }
+
+Oid InodeShardIndexNameCollation(int shardId) { return LookupInodeShardRelationCache(shardId)->nameCollation; }
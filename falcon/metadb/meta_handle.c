@@ -11,16 +11,26 @@
 
 #include "access/genam.h"
 #include "access/htup_details.h"
+#include "access/itup.h"
+#include "access/relscan.h"
 #include "access/table.h"
+#include "access/tableam.h"
+#include "access/visibilitymap.h"
 #include "catalog/indexing.h"
+#include "executor/tuptable.h"
+#include "storage/bufmgr.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
 #include "utils/timestamp.h"
 
+#include "control/control_flag.h"
 #include "dir_path_shmem/dir_path_hash.h"
 #include "distributed_backend/remote_comm_falcon.h"
+#include "metadb/data_delete_queue.h"
+#include "metadb/directory_log.h"
+#include "metadb/inode_attr_cache.h"
 #include "metadb/meta_process_info.h"
 #include "metadb/meta_serialize_interface_helper.h"
 #include "metadb/shard_table.h"
@@ -34,16 +44,42 @@ MemoryManager PgMemoryManager = {.alloc = palloc, .free = pfree, .realloc = repa
 static inline uint16_t HashPartId(const char *fileName);
 static inline uint64_t CombineParentIdWithPartId(uint64_t parent_id, uint16_t part_id);
 
-static StringInfo GetInodeShardName(int shardId);
-static StringInfo GetInodeIndexShardName(int shardId);
 static StringInfo GetXattrShardName(int shardId);
 static StringInfo GetXattrIndexShardName(int shardId);
+static void FalconRmdirInternal(MetaProcessInfo info, bool recursive);
+static void FalconRenameOnWorker(MetaProcessInfo info);
 
-static Oid GetRelationOidByName_FALCON(const char *relationName);
-static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
-                                          Relation workerInodeRelation,
-                                          const char *workerInodeRelationIndexName,
-                                          Oid workerInodeIndexOid,
+/*
+ * Looks up the items of a batch in one inode shard through a single index scan, which is rescanned for
+ * every key. Callers sort the items by (parentid_partid, name) first, so consecutive probes descend
+ * through the same index pages while they are still hot.
+ */
+typedef struct InodeIndexProbe
+{
+    Relation heapRel;
+    Relation indexRel;
+    IndexScanDesc scan;
+    TupleTableSlot *slot;
+    Snapshot snapshot;
+    bool refreshSnapshot;
+} InodeIndexProbe;
+
+static void InodeIndexProbeBegin(InodeIndexProbe *probe, Relation workerInodeRel, int shardId, bool refreshSnapshot);
+static HeapTuple InodeIndexProbeSearch(InodeIndexProbe *probe, uint64_t parentId_partId, const char *fileName);
+static void InodeIndexProbeEnd(InodeIndexProbe *probe);
+static int InodeKeyListCmp(const ListCell *a, const ListCell *b);
+static bool InodeAttrFromTuple(HeapTuple heapTuple, TupleDesc tupleDesc, InodeAttr *attr, char **etag);
+static void FillStatInfoFromInodeAttr(MetaProcessInfo info, const InodeAttr *attr);
+static void FillOpenInfoFromInodeAttr(MetaProcessInfo info, const InodeAttr *attr);
+static int32_t ReadDirByIndexOnlyScan(Relation workerInodeRel,
+                                      int shardId,
+                                      ScanKey heapScanKey,
+                                      int scanKeyCount,
+                                      int32_t maxReadCount,
+                                      List **resultList);
+
+static bool SearchAndUpdateInodeTableInfo(int shardId,
+                                          InodeIndexProbe *probe,
                                           const uint64_t parentId_partId,
                                           const char *fileName,
                                           const bool doUpdate,
@@ -150,20 +186,11 @@ void FalconMkdirHandle(MetaProcessInfo *infoArray, int count)
     if (validInputIndexArraySize == 0)
         return;
 
-    // 2.
-    SerializedData subMkdirParam;
-    SerializedDataInit(&subMkdirParam, NULL, 0, 0, &PgMemoryManager);
-    SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(MKDIR_SUB_MKDIR,
-                                                                 infoArray,
-                                                                 validInputIndexArray,
-                                                                 validInputIndexArraySize,
-                                                                 &subMkdirParam);
-    List *foreignServerIdList = GetAllForeignServerId(true, false);
-    FalconMetaCallOnWorkerList(MKDIR_SUB_MKDIR,
-                               validInputIndexArraySize,
-                               subMkdirParam,
-                               REMOTE_COMMAND_FLAG_WRITE,
-                               foreignServerIdList);
+    // 2. workers pick the new directories up from the directory log
+    for (int i = 0; i < validInputIndexArraySize; ++i) {
+        MetaProcessInfo info = infoArray[validInputIndexArray[i]];
+        DirectoryLogAppend(info->parentId, info->name, info->inodeId);
+    }
 
     // 3.
     HASHCTL info;
@@ -229,33 +256,9 @@ void FalconMkdirHandle(MetaProcessInfo *infoArray, int count)
         RemoteCommandResultPerServerData *remoteRes = list_nth(totalRemoteRes, i);
         int64_t serverId = remoteRes->serverId;
 
-        if (list_length(remoteRes->remoteCommandResult) < 1 || list_length(remoteRes->remoteCommandResult) > 2)
+        if (list_length(remoteRes->remoteCommandResult) != 1)
             FALCON_ELOG_ERROR(PROGRAM_ERROR, "unexpected. situation");
-        PGresult *res = NULL;
-
-        // 4.1
-        res = list_nth(remoteRes->remoteCommandResult, 0);
-        if (PQntuples(res) != 1 || PQnfields(res) != 1)
-            FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "PGresult is corrupt.");
-        SerializedData subMkdirResponse;
-        SerializedDataInit(&subMkdirResponse,
-                           PQgetvalue(res, 0, 0),
-                           PQgetlength(res, 0, 0),
-                           PQgetlength(res, 0, 0),
-                           NULL);
-        if (!SerializedDataMetaResponseDecode(MKDIR_SUB_MKDIR, validInputIndexArraySize, &subMkdirResponse, resArray))
-            FALCON_ELOG_ERROR(ARGUMENT_ERROR, "serialized response is corrupt.");
-
-        for (int j = 0; j < validInputIndexArraySize; ++j)
-            if (resArray[j].errorCode != SUCCESS)
-                FALCON_ELOG_ERROR(PROGRAM_ERROR,
-                                  "MkdirSubMkdir is supposed to be successful, "
-                                  "but it failed.");
-
-        // 4.2
-        if (list_length(remoteRes->remoteCommandResult) == 1)
-            continue;
-        res = list_nth(remoteRes->remoteCommandResult, 1);
+        PGresult *res = list_nth(remoteRes->remoteCommandResult, 0);
         if (PQntuples(res) != 1 || PQnfields(res) != 1)
             FALCON_ELOG_ERROR(REMOTE_QUERY_FAILED, "PGresult is corrupt.");
         SerializedData subCreateResponse;
@@ -284,6 +287,81 @@ void FalconMkdirHandle(MetaProcessInfo *infoArray, int count)
     }
 }
 
+// mkdir -p, missing ancestors are created in the same transaction and existing targets count as success
+void FalconMkdirRecursiveHandle(MetaProcessInfo *infoArray, int count)
+{
+    if (GetLocalServerId() != FALCON_CN_SERVER_ID)
+        FALCON_ELOG_ERROR(WRONG_WORKER, "mkdir can only be called on CN.");
+
+    // 1. look targets and their ancestors up without locking, only what is missing is handed to mkdir, so that
+    // existing ancestors are not locked exclusively
+    List *toCreateList = NIL;
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
+
+        int32_t property;
+        FalconErrorCode errorCode =
+            VerifyPathValidity(info->path, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_DIRECTORY, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        char *prefix = pstrdup(info->path);
+        int length = strlen(prefix);
+        if (length > 1 && prefix[length - 1] == '/')
+            prefix[--length] = '\0';
+        info->path = pstrdup(prefix);
+
+        // walk up to the deepest existing ancestor, the root always exists
+        bool isTarget = true;
+        while (length > 1 &&
+               CheckWhetherPathExistsInDirectoryTable(directoryRel, prefix) == DIR_HASH_TABLE_PATH_NOT_EXIST) {
+            if (isTarget) {
+                toCreateList = lappend(toCreateList, info);
+                isTarget = false;
+            } else {
+                MetaProcessInfo ancestor = palloc0(sizeof(MetaProcessInfoData));
+                ancestor->path = pstrdup(prefix);
+                toCreateList = lappend(toCreateList, ancestor);
+            }
+            while (prefix[length - 1] != '/')
+                --length;
+            if (length > 1)
+                --length;
+            prefix[length] = '\0';
+        }
+    }
+    table_close(directoryRel, AccessShareLock);
+    if (toCreateList == NIL)
+        return;
+
+    // 2. ancestors shared by several targets are created once, duplicates take the result of the one kept
+    int toCreateCount = list_length(toCreateList);
+    MetaProcessInfo *toCreateArray = palloc(sizeof(MetaProcessInfo) * toCreateCount);
+    for (int i = 0; i < toCreateCount; ++i)
+        toCreateArray[i] = list_nth(toCreateList, i);
+    pg_qsort(toCreateArray, toCreateCount, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
+
+    MetaProcessInfo *uniqueArray = palloc(sizeof(MetaProcessInfo) * toCreateCount);
+    MetaProcessInfo *keptArray = palloc(sizeof(MetaProcessInfo) * toCreateCount);
+    int uniqueCount = 0;
+    for (int i = 0; i < toCreateCount; ++i) {
+        if (uniqueCount == 0 || pathcmp(uniqueArray[uniqueCount - 1]->path, toCreateArray[i]->path) != 0)
+            uniqueArray[uniqueCount++] = toCreateArray[i];
+        keptArray[i] = uniqueArray[uniqueCount - 1];
+    }
+
+    FalconMkdirHandle(uniqueArray, uniqueCount);
+
+    // 3. a directory created concurrently since it was looked up is fine as well
+    for (int i = 0; i < uniqueCount; ++i)
+        if (uniqueArray[i]->errorCode == PATH_EXISTS)
+            uniqueArray[i]->errorCode = SUCCESS;
+    for (int i = 0; i < toCreateCount; ++i)
+        toCreateArray[i]->errorCode = keptArray[i]->errorCode;
+}
+
 void FalconMkdirSubMkdirHandle(MetaProcessInfo *infoArray, int count)
 {
     //
@@ -344,8 +422,7 @@ void FalconMkdirSubCreateHandle(MetaProcessInfo *infoArray, int count)
     HASH_SEQ_STATUS status;
     hash_seq_init(&status, batchMetaProcessInfoListPerShard);
     while ((entry = hash_seq_search(&status)) != 0) {
-        Relation workerInodeRel =
-            table_open(GetRelationOidByName_FALCON(GetInodeShardName(entry->shardId)->data), RowExclusiveLock);
+        Relation workerInodeRel = table_open(InodeShardRelationId(entry->shardId), RowExclusiveLock);
         CatalogIndexState indexState = CatalogOpenIndexes(workerInodeRel);
 
         for (int i = 0; i < list_length(entry->info); ++i) {
@@ -380,6 +457,7 @@ void FalconMkdirSubCreateHandle(MetaProcessInfo *infoArray, int count)
         CatalogCloseIndexes(indexState);
         table_close(workerInodeRel, RowExclusiveLock);
     }
+    FalconNamespaceGenerationMarkDirty();
 }
 
 void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExisted)
@@ -457,10 +535,7 @@ void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
     HASH_SEQ_STATUS status;
     hash_seq_init(&status, batchMetaProcessInfoListPerShard);
     while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
-        Oid inodeIndexOid = GetRelationOidByName_FALCON(inodeIndexShardName->data);
-
+        entry->info = list_sort(entry->info, InodeKeyListCmp);
         List *toHandleMetaProcessList = NIL;
         for (int i = list_length(entry->info) - 1; i >= 0; --i) {
             MetaProcessInfo info = list_nth(entry->info, i);
@@ -473,8 +548,11 @@ void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
         MetaProcessInfo info = NULL;
         while (list_length(toHandleMetaProcessList) != 0) {
             BeginInternalSubTransaction(NULL);
-            Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), RowExclusiveLock);
+            Relation workerInodeRel = table_open(InodeShardRelationId(entry->shardId), RowExclusiveLock);
             CatalogIndexState indexState = CatalogOpenIndexes(workerInodeRel);
+            InodeIndexProbe probe;
+            // rows inserted for earlier items of the batch must be visible to the existence checks
+            InodeIndexProbeBegin(&probe, workerInodeRel, entry->shardId, true);
             PG_TRY();
             {
                 int currentGroupHandled = BATCH_OPERATION_GROUP_SIZE;
@@ -486,10 +564,8 @@ void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
                     --toHandleMetaProcessIndex;
                     if (info->errorCode != SUCCESS) {
                         if (info->errorCode == FILE_EXISTS) {
-                            SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                          NULL,
-                                                          inodeIndexShardName->data,
-                                                          inodeIndexOid,
+                            SearchAndUpdateInodeTableInfo(entry->shardId,
+                                                          &probe,
                                                           info->parentId_partId,
                                                           info->name,
                                                           false,
@@ -534,8 +610,10 @@ void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
                                          0,
                                          -1,
                                          -1);
+                    FalconNamespaceGenerationMarkDirty();
                     --currentGroupHandled;
                 }
+                InodeIndexProbeEnd(&probe);
                 CatalogCloseIndexes(indexState);
                 table_close(workerInodeRel, RowExclusiveLock);
                 ReleaseCurrentSubTransaction();
@@ -549,10 +627,8 @@ void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
 
                 //
                 if (updateExisted) {
-                    SearchAndUpdateInodeTableInfo(inodeShardName->data,
+                    SearchAndUpdateInodeTableInfo(entry->shardId,
                                                   NULL,
-                                                  inodeIndexShardName->data,
-                                                  inodeIndexOid,
                                                   info->parentId_partId,
                                                   info->name,
                                                   true,
@@ -583,6 +659,9 @@ void FalconCreateHandle(MetaProcessInfo *infoArray, int count, bool updateExiste
 
 void FalconStatHandle(MetaProcessInfo *infoArray, int count)
 {
+    InodeAttrCacheTicket ticket;
+    InodeAttrCacheTakeTicket(&ticket);
+
     for (int i = 0; i < count; ++i) {
         MetaProcessInfo info = infoArray[i];
         //
@@ -624,6 +703,13 @@ void FalconStatHandle(MetaProcessInfo *infoArray, int count)
         if (workerId != GetLocalServerId())
             CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
 
+        InodeAttr attr;
+        if (InodeAttrCacheLookup(info->parentId_partId, info->name, &attr)) {
+            FillStatInfoFromInodeAttr(info, &attr);
+            info->etag = pstrdup(attr.etag);
+            continue;
+        }
+
         bool found;
         entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
         if (!found) {
@@ -637,62 +723,38 @@ void FalconStatHandle(MetaProcessInfo *infoArray, int count)
     HASH_SEQ_STATUS status;
     hash_seq_init(&status, batchMetaProcessInfoListPerShard);
     while ((entry = hash_seq_search(&status)) != NULL) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
-        Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), AccessShareLock);
-        Oid workerInodeIndexOid = GetRelationOidByName_FALCON(inodeIndexShardName->data);
+        entry->info = list_sort(entry->info, InodeKeyListCmp);
+        Relation workerInodeRel = table_open(InodeShardRelationId(entry->shardId), AccessShareLock);
+        InodeIndexProbe probe;
+        InodeIndexProbeBegin(&probe, workerInodeRel, entry->shardId, false);
+        TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
 
         for (int i = 0; i < list_length(entry->info); ++i) {
             MetaProcessInfo info = list_nth(entry->info, i);
 
-            ScanKeyData scanKey[2];
-            int scanKeyCount = 2;
-            SysScanDesc scanDescriptor = NULL;
-            HeapTuple heapTuple;
-
-            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
-            scanKey[0].sk_argument = UInt64GetDatum(info->parentId_partId);
-            scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
-            scanKey[1].sk_argument = CStringGetTextDatum(info->name);
-
-            scanDescriptor = systable_beginscan(workerInodeRel,
-                                                workerInodeIndexOid,
-                                                true,
-                                                GetTransactionSnapshot(),
-                                                scanKeyCount,
-                                                scanKey);
-            heapTuple = systable_getnext(scanDescriptor);
-            TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
+            HeapTuple heapTuple = InodeIndexProbeSearch(&probe, info->parentId_partId, info->name);
             if (!HeapTupleIsValid(heapTuple)) {
                 info->errorCode = FILE_NOT_EXISTS;
             } else {
-                Datum datumArray[Natts_pg_dfs_inode_table];
-                bool isNullArray[Natts_pg_dfs_inode_table];
-                heap_deform_tuple(heapTuple, tupleDesc, datumArray, isNullArray);
-                info->inodeId = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_ino - 1]);
-                info->st_dev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_dev - 1]);
-                info->st_mode = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_mode - 1]);
-                info->st_nlink = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_nlink - 1]);
-                info->st_uid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_uid - 1]);
-                info->st_gid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_gid - 1]);
-                info->st_rdev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_rdev - 1]);
-                info->st_size = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_size - 1]);
-                info->st_blksize = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blksize - 1]);
-                info->st_blocks = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blocks - 1]);
-                info->st_atim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_atim - 1]);
-                info->st_mtim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_mtim - 1]);
-                info->st_ctim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_ctim - 1]);
-                info->etag = TextDatumGetCString(datumArray[Anum_pg_dfs_file_etag - 1]);
+                InodeAttr attr;
+                char *etag;
+                if (InodeAttrFromTuple(heapTuple, tupleDesc, &attr, &etag))
+                    InodeAttrCacheFill(&ticket, info->parentId_partId, info->name, &attr);
+                FillStatInfoFromInodeAttr(info, &attr);
+                info->etag = etag;
             }
-            systable_endscan(scanDescriptor);
         }
 
+        InodeIndexProbeEnd(&probe);
         table_close(workerInodeRel, AccessShareLock);
     }
 }
 
 void FalconOpenHandle(MetaProcessInfo *infoArray, int count)
 {
+    InodeAttrCacheTicket ticket;
+    InodeAttrCacheTakeTicket(&ticket);
+
     for (int i = 0; i < count; ++i) {
         MetaProcessInfo info = infoArray[i];
         info->errorCode = SUCCESS;
@@ -735,6 +797,12 @@ void FalconOpenHandle(MetaProcessInfo *infoArray, int count)
         if (workerId != GetLocalServerId())
             CHECK_ERROR_CODE_WITH_CONTINUE(WRONG_WORKER);
 
+        InodeAttr attr;
+        if (InodeAttrCacheLookup(info->parentId_partId, info->name, &attr)) {
+            FillOpenInfoFromInodeAttr(info, &attr);
+            continue;
+        }
+
         bool found;
         entry = hash_search(batchMetaProcessInfoListPerShard, &shardId, HASH_ENTER, &found);
         if (!found) {
@@ -748,8 +816,11 @@ void FalconOpenHandle(MetaProcessInfo *infoArray, int count)
     HASH_SEQ_STATUS status;
     hash_seq_init(&status, batchMetaProcessInfoListPerShard);
     while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
+        entry->info = list_sort(entry->info, InodeKeyListCmp);
+        Relation workerInodeRel = table_open(InodeShardRelationId(entry->shardId), AccessShareLock);
+        InodeIndexProbe probe;
+        InodeIndexProbeBegin(&probe, workerInodeRel, entry->shardId, false);
+        TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
 
         for (int i = 0; i < list_length(entry->info); ++i) {
             MetaProcessInfo info = list_nth(entry->info, i);
@@ -757,44 +828,19 @@ void FalconOpenHandle(MetaProcessInfo *infoArray, int count)
             if (info->errorCode != SUCCESS)
                 continue;
 
-            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                           NULL,
-                                                           inodeIndexShardName->data,
-                                                           InvalidOid,
-                                                           info->parentId_partId,
-                                                           info->name,
-                                                           false,
-                                                           &info->inodeId,
-                                                           &info->st_size,
-                                                           NULL,
-                                                           NULL,
-                                                           &info->st_nlink,
-                                                           0,
-                                                           &info->st_mode,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           NULL,
-                                                           &info->node_id,
-                                                           NULL,
-                                                           NULL);
-            info->st_dev = 0;
-            info->st_uid = 0;
-            info->st_gid = 0;
-            info->st_rdev = 0;
-            info->st_blksize = 0;
-            info->st_blocks = 0;
-            info->st_atim = 0;
-            info->st_mtim = 0;
-            info->st_ctim = 0;
-            info->etag = (char *)"";
-            if (!fileExist)
+            HeapTuple heapTuple = InodeIndexProbeSearch(&probe, info->parentId_partId, info->name);
+            if (!HeapTupleIsValid(heapTuple)) {
                 info->errorCode = FILE_NOT_EXISTS;
-            else
-                info->errorCode = SUCCESS;
+            } else {
+                InodeAttr attr;
+                char *etag;
+                if (InodeAttrFromTuple(heapTuple, tupleDesc, &attr, &etag))
+                    InodeAttrCacheFill(&ticket, info->parentId_partId, info->name, &attr);
+                FillOpenInfoFromInodeAttr(info, &attr);
+            }
         }
+        InodeIndexProbeEnd(&probe);
+        table_close(workerInodeRel, AccessShareLock);
     }
 }
 
@@ -855,8 +901,10 @@ void FalconCloseHandle(MetaProcessInfo *infoArray, int count)
     HASH_SEQ_STATUS status;
     hash_seq_init(&status, batchMetaProcessInfoListPerShard);
     while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
+        entry->info = list_sort(entry->info, InodeKeyListCmp);
+        Relation workerInodeRel = table_open(InodeShardRelationId(entry->shardId), RowExclusiveLock);
+        InodeIndexProbe probe;
+        InodeIndexProbeBegin(&probe, workerInodeRel, entry->shardId, true);
 
         for (int i = 0; i < list_length(entry->info); ++i) {
             MetaProcessInfo info = list_nth(entry->info, i);
@@ -867,10 +915,8 @@ void FalconCloseHandle(MetaProcessInfo *infoArray, int count)
             int64_t size = info->st_size;
             int64_t mtime = GetCurrentTimestamp();
             int32_t nodeId = info->node_id;
-            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                           NULL,
-                                                           inodeIndexShardName->data,
-                                                           InvalidOid,
+            bool fileExist = SearchAndUpdateInodeTableInfo(entry->shardId,
+                                                           &probe,
                                                            info->parentId_partId,
                                                            info->name,
                                                            true,
@@ -895,6 +941,8 @@ void FalconCloseHandle(MetaProcessInfo *infoArray, int count)
             else
                 info->errorCode = SUCCESS;
         }
+        InodeIndexProbeEnd(&probe);
+        table_close(workerInodeRel, RowExclusiveLock);
     }
 }
 
@@ -951,8 +999,10 @@ void FalconUnlinkHandle(MetaProcessInfo *infoArray, int count)
     HASH_SEQ_STATUS status;
     hash_seq_init(&status, batchMetaProcessInfoListPerShard);
     while ((entry = hash_seq_search(&status)) != 0) {
-        StringInfo inodeShardName = GetInodeShardName(entry->shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(entry->shardId);
+        entry->info = list_sort(entry->info, InodeKeyListCmp);
+        Relation workerInodeRel = table_open(InodeShardRelationId(entry->shardId), RowExclusiveLock);
+        InodeIndexProbe probe;
+        InodeIndexProbeBegin(&probe, workerInodeRel, entry->shardId, true);
 
         for (int i = 0; i < list_length(entry->info); ++i) {
             MetaProcessInfo info = list_nth(entry->info, i);
@@ -962,10 +1012,8 @@ void FalconUnlinkHandle(MetaProcessInfo *infoArray, int count)
 
             uint64_t nlink;
             mode_t mode;
-            bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
-                                                           NULL,
-                                                           inodeIndexShardName->data,
-                                                           InvalidOid,
+            bool fileExist = SearchAndUpdateInodeTableInfo(entry->shardId,
+                                                           &probe,
                                                            info->parentId_partId,
                                                            info->name,
                                                            true,
@@ -992,6 +1040,8 @@ void FalconUnlinkHandle(MetaProcessInfo *infoArray, int count)
             else
                 info->errorCode = SUCCESS;
         }
+        InodeIndexProbeEnd(&probe);
+        table_close(workerInodeRel, RowExclusiveLock);
     }
 }
 
@@ -1003,6 +1053,7 @@ void FalconReadDirHandle(MetaProcessInfo info)
         maxReadCount = INT32_MAX;
     int32_t lastShardIndex = info->readDirLastShardIndex;
     const char *lastFileName = info->readDirLastFileName;
+    bool plus = info->readDirPlus;
 
     int32_t property;
     VerifyPathValidity(path, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_DIRECTORY, &property);
@@ -1025,16 +1076,16 @@ void FalconReadDirHandle(MetaProcessInfo info)
     bool firstCall = lastShardIndex == -1;
 
     SetUpScanCaches();
-    List *shardTableData = GetShardTableData();
-    int shardTableCount = list_length(shardTableData);
+    int32_t shardTableCount;
+    const FormData_falcon_shard_table *shardTableData = GetShardTableArray(&shardTableCount);
 
     StreamSearchState state = firstCall ? NEW_SHARD : SAME_ID_GREATER_NAME;
     List *resultList = NIL;
     int32_t readCount = 0;
     int shardIndex = firstCall ? 0 : lastShardIndex;
     while (shardIndex < shardTableCount) {
-        int workerId = ((FormData_falcon_shard_table *)list_nth(shardTableData, shardIndex))->server_id;
-        int shardId = ((FormData_falcon_shard_table *)list_nth(shardTableData, shardIndex))->range_point;
+        int workerId = shardTableData[shardIndex].server_id;
+        int shardId = shardTableData[shardIndex].range_point;
         if (workerId != GetLocalServerId()) {
             ++shardIndex;
             continue;
@@ -1043,9 +1094,6 @@ void FalconReadDirHandle(MetaProcessInfo info)
         uint64_t lowerId = CombineParentIdWithPartId(directoryId, 0);
         uint64_t upperId = CombineParentIdWithPartId(directoryId, PART_ID_MASK);
 
-        StringInfo inodeShardName = GetInodeShardName(shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-
         ScanKeyData scanKey[2];
         int scanKeyCount = 2;
         uint16_t partId;
@@ -1060,6 +1108,7 @@ void FalconReadDirHandle(MetaProcessInfo info)
             scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
             scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_GT];
             scanKey[1].sk_argument = CStringGetTextDatum(lastFileName);
+            scanKey[1].sk_collation = InodeShardIndexNameCollation(shardId);
 
             state = GREATER_ID;
             break;
@@ -1084,38 +1133,54 @@ void FalconReadDirHandle(MetaProcessInfo info)
             FALCON_ELOG_ERROR(PROGRAM_ERROR, "wrong state in FalconReadDirHandle.");
         }
 
-        Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), AccessShareLock);
-        SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
-                                                        GetRelationOidByName_FALCON(inodeIndexShardName->data),
-                                                        true,
-                                                        GetTransactionSnapshot(),
-                                                        scanKeyCount,
-                                                        scanKey);
-        TupleDesc tupleDescriptor = RelationGetDescr(workerInodeRel);
+        Relation workerInodeRel = table_open(InodeShardRelationId(shardId), AccessShareLock);
+        if (!plus) {
+            readCount += ReadDirByIndexOnlyScan(workerInodeRel,
+                                                shardId,
+                                                scanKey,
+                                                scanKeyCount,
+                                                maxReadCount - readCount,
+                                                &resultList);
+        } else {
+            SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
+                                                            InodeShardIndexRelationId(shardId),
+                                                            true,
+                                                            GetTransactionSnapshot(),
+                                                            scanKeyCount,
+                                                            scanKey);
+            TupleDesc tupleDescriptor = RelationGetDescr(workerInodeRel);
+
+            Datum fileInfo[Natts_pg_dfs_inode_table];
+            bool fileInfoNulls[Natts_pg_dfs_inode_table];
+            HeapTuple heapTuple;
+            while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+                OneReadDirResult *result = (OneReadDirResult *)palloc0(sizeof(OneReadDirResult));
+
+                // deform once instead of fetching every attribute separately
+                heap_deform_tuple(heapTuple, tupleDescriptor, fileInfo, fileInfoNulls);
+                if (fileInfoNulls[Anum_pg_dfs_file_name - 1] || fileInfoNulls[Anum_pg_dfs_file_st_mode - 1])
+                    FALCON_ELOG_ERROR(PROGRAM_ERROR, "file name and mode cannot be NULL.");
+                result->fileName = TextDatumGetCString(fileInfo[Anum_pg_dfs_file_name - 1]);
+                result->mode = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_mode - 1]);
+                result->st_ino = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_ino - 1]);
+                result->st_nlink = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_nlink - 1]);
+                result->st_uid = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_uid - 1]);
+                result->st_gid = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_gid - 1]);
+                result->st_size = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_size - 1]);
+                result->st_blksize = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_blksize - 1]);
+                result->st_blocks = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_blocks - 1]);
+                result->st_atim = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_atim - 1]);
+                result->st_mtim = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_mtim - 1]);
+                result->st_ctim = DatumGetInt64(fileInfo[Anum_pg_dfs_file_st_ctim - 1]);
+
+                resultList = lappend(resultList, result);
+                readCount++;
+                if (readCount >= maxReadCount)
+                    break;
+            }
 
-        Datum datum;
-        bool isNull;
-        HeapTuple heapTuple;
-        while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
-            OneReadDirResult *result = (OneReadDirResult *)palloc(sizeof(OneReadDirResult));
-
-            datum = heap_getattr(heapTuple, Anum_pg_dfs_file_name, tupleDescriptor, &isNull);
-            if (isNull)
-                FALCON_ELOG_ERROR(PROGRAM_ERROR, "file name cannot be NULL.");
-            result->fileName = TextDatumGetCString(datum);
-
-            datum = heap_getattr(heapTuple, Anum_pg_dfs_file_st_mode, tupleDescriptor, &isNull);
-            if (isNull)
-                FALCON_ELOG_ERROR(PROGRAM_ERROR, "mode cannot be NULL.");
-            result->mode = DatumGetUInt32(datum);
-
-            resultList = lappend(resultList, result);
-            readCount++;
-            if (readCount >= maxReadCount)
-                break;
+            systable_endscan(scanDescriptor);
         }
-
-        systable_endscan(scanDescriptor);
         table_close(workerInodeRel, AccessShareLock);
 
         if (readCount >= maxReadCount)
@@ -1164,9 +1229,19 @@ void FalconOpenDirHandle(MetaProcessInfo info)
     info->errorCode = SUCCESS;
 }
 
-void FalconRmdirHandle(MetaProcessInfo info)
+void FalconRmdirHandle(MetaProcessInfo info) { FalconRmdirInternal(info, false); }
+
+/*
+ * Removes the directory with everything below it in one distributed transaction. Directories are dropped from the
+ * directory table on every server, inode rows are removed in bulk per shard, and the data of removed files is
+ * queued on the workers, see data_delete_queue.h.
+ */
+void FalconRmdirRecursiveHandle(MetaProcessInfo info) { FalconRmdirInternal(info, true); }
+
+static void FalconRmdirInternal(MetaProcessInfo info, bool recursive)
 {
     const char *path = info->path;
+    FalconSupportMetaService subRmdirService = recursive ? RMDIR_RECURSIVE_SUB_RMDIR : RMDIR_SUB_RMDIR;
 
     if (GetLocalServerId() != FALCON_CN_SERVER_ID)
         FALCON_ELOG_ERROR(WRONG_WORKER, "rmdir can only be called on CN.");
@@ -1190,15 +1265,28 @@ void FalconRmdirHandle(MetaProcessInfo info)
                                     &info->inodeId);
     if (errorCode != SUCCESS)
         FALCON_ELOG_ERROR(errorCode, "path parse error.");
+    if (recursive) {
+        // the target is held exclusively, so nothing below it is in use
+        List *subtree = SearchDirectorySubtree(directoryRel, info->parentId, info->name, info->inodeId);
+        for (int i = list_length(subtree) - 1; i > 0; --i) {
+            DirectorySubtreeNode *node = list_nth(subtree, i);
+            DeleteDirectoryByDirectoryHashTable(directoryRel, node->parentId, node->name, DIR_LOCK_NONE);
+        }
+        // workers build the paths of removed files on it
+        size_t pathLength = strlen(path);
+        if (path[pathLength - 1] == '/')
+            info->path = pnstrdup(path, pathLength - 1);
+    }
     DeleteDirectoryByDirectoryHashTable(directoryRel, info->parentId, info->name, DIR_LOCK_NONE);
     table_close(directoryRel, RowExclusiveLock);
 
     // 2.
+    List *foreignServerIdList = GetAllForeignServerId(true, false);
+    DirectoryLogWaitForAppliedOnWorkerList(foreignServerIdList);
     SerializedData subRmdirParam;
     SerializedDataInit(&subRmdirParam, NULL, 0, 0, &PgMemoryManager);
-    SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(RMDIR_SUB_RMDIR, &info, NULL, 1, &subRmdirParam);
-    List *foreignServerIdList = GetAllForeignServerId(true, false);
-    FalconMetaCallOnWorkerList(RMDIR_SUB_RMDIR, 1, subRmdirParam, REMOTE_COMMAND_FLAG_WRITE, foreignServerIdList);
+    SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(subRmdirService, &info, NULL, 1, &subRmdirParam);
+    FalconMetaCallOnWorkerList(subRmdirService, 1, subRmdirParam, REMOTE_COMMAND_FLAG_WRITE, foreignServerIdList);
 
     // 3.
     uint16_t partId = HashPartId(info->name);
@@ -1237,7 +1325,7 @@ void FalconRmdirHandle(MetaProcessInfo info)
                            PQgetlength(res, 0, 0),
                            PQgetlength(res, 0, 0),
                            NULL);
-        if (!SerializedDataMetaResponseDecode(RMDIR_SUB_RMDIR, 1, &subRmdirResponse, &responseInfo))
+        if (!SerializedDataMetaResponseDecode(subRmdirService, 1, &subRmdirResponse, &responseInfo))
             FALCON_ELOG_ERROR(ARGUMENT_ERROR, "serialized response is corrupt.");
 
         if (responseInfo.errorCode != SUCCESS)
@@ -1286,28 +1374,26 @@ void FalconRmdirSubRmdirHandle(MetaProcessInfo info)
 
     // 2.
     SetUpScanCaches();
-    List *shardTableData = GetShardTableData();
-    for (int i = 0; i < list_length(shardTableData); ++i) {
-        int32_t workerId = ((FormData_falcon_shard_table *)list_nth(shardTableData, i))->server_id;
-        int32_t shardId = ((FormData_falcon_shard_table *)list_nth(shardTableData, i))->range_point;
+    int32_t shardTableCount;
+    const FormData_falcon_shard_table *shardTableData = GetShardTableArray(&shardTableCount);
+    for (int i = 0; i < shardTableCount; ++i) {
+        int32_t workerId = shardTableData[i].server_id;
+        int32_t shardId = shardTableData[i].range_point;
         if (workerId != GetLocalServerId())
             continue;
 
         uint64_t lowerId = CombineParentIdWithPartId(directoryId, 0);
         uint64_t upperId = CombineParentIdWithPartId(directoryId, PART_ID_MASK);
 
-        StringInfo inodeShardName = GetInodeShardName(shardId);
-        StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-
         ScanKeyData scanKey[2];
         int scanKeyCount = 2;
         scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_GE];
         scanKey[0].sk_argument = UInt64GetDatum(lowerId);
         scanKey[1] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_LE];
         scanKey[1].sk_argument = UInt64GetDatum(upperId);
-        Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), AccessShareLock);
+        Relation workerInodeRel = table_open(InodeShardRelationId(shardId), AccessShareLock);
         SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
-                                                        GetRelationOidByName_FALCON(inodeIndexShardName->data),
+                                                        InodeShardIndexRelationId(shardId),
                                                         true,
                                                         GetTransactionSnapshot(),
                                                         scanKeyCount,
@@ -1326,6 +1412,86 @@ void FalconRmdirSubRmdirHandle(MetaProcessInfo info)
     info->errorCode = SUCCESS;
 }
 
+void FalconRmdirRecursiveSubRmdirHandle(MetaProcessInfo info)
+{
+    uint64_t parentId = info->parentId;
+    char *name = info->name;
+
+    // 1.
+    Relation rel = table_open(DirectoryRelationId(), RowExclusiveLock);
+    uint64_t directoryId = SearchDirectoryByDirectoryHashTable(rel, parentId, name, DIR_LOCK_EXCLUSIVE);
+    if (directoryId == DIR_HASH_TABLE_PATH_NOT_EXIST)
+        FALCON_ELOG_ERROR(FILE_NOT_EXISTS, "FalconRmdirRecursiveSubRmdirHandle: unexpected.");
+    List *subtree = SearchDirectorySubtree(rel, parentId, name, directoryId);
+    for (int i = list_length(subtree) - 1; i >= 0; --i) {
+        DirectorySubtreeNode *node = list_nth(subtree, i);
+        DeleteDirectoryByDirectoryHashTable(rel, node->parentId, node->name, DIR_LOCK_NONE);
+    }
+    table_close(rel, RowExclusiveLock);
+
+    // 2. children of every directory of the subtree, the inode row of the target itself is left to RmdirSubUnlink
+    Relation queueRel = table_open(DataDeleteQueueRelationId(), RowExclusiveLock);
+    CatalogIndexState queueIndexState = CatalogOpenIndexes(queueRel);
+    StringInfo filePath = makeStringInfo();
+    SetUpScanCaches();
+    int32_t shardTableCount;
+    const FormData_falcon_shard_table *shardTableData = GetShardTableArray(&shardTableCount);
+    for (int i = 0; i < shardTableCount; ++i) {
+        int32_t workerId = shardTableData[i].server_id;
+        int32_t shardId = shardTableData[i].range_point;
+        if (workerId != GetLocalServerId())
+            continue;
+
+        Relation workerInodeRel = table_open(InodeShardRelationId(shardId), RowExclusiveLock);
+        TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
+        for (int j = 0; j < list_length(subtree); ++j) {
+            DirectorySubtreeNode *node = list_nth(subtree, j);
+
+            ScanKeyData scanKey[2];
+            int scanKeyCount = 2;
+            scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_GE];
+            scanKey[0].sk_argument = UInt64GetDatum(CombineParentIdWithPartId(node->inodeId, 0));
+            scanKey[1] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_LE];
+            scanKey[1].sk_argument = UInt64GetDatum(CombineParentIdWithPartId(node->inodeId, PART_ID_MASK));
+            SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
+                                                            InodeShardIndexRelationId(shardId),
+                                                            true,
+                                                            GetTransactionSnapshot(),
+                                                            scanKeyCount,
+                                                            scanKey);
+            HeapTuple heapTuple;
+            while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+                bool isNull;
+                uint64_t parentId_partId =
+                    DatumGetUInt64(heap_getattr(heapTuple, Anum_pg_dfs_file_parentid_partid, tupleDesc, &isNull));
+                char *fileName =
+                    TextDatumGetCString(heap_getattr(heapTuple, Anum_pg_dfs_file_name, tupleDesc, &isNull));
+                mode_t mode = DatumGetUInt32(heap_getattr(heapTuple, Anum_pg_dfs_file_st_mode, tupleDesc, &isNull));
+
+                InodeAttrCacheInvalidate(parentId_partId, fileName);
+                CatalogTupleDelete(workerInodeRel, &heapTuple->t_self);
+                if (S_ISREG(mode)) {
+                    uint64_t inodeId =
+                        DatumGetUInt64(heap_getattr(heapTuple, Anum_pg_dfs_file_st_ino, tupleDesc, &isNull));
+                    int32_t nodeId =
+                        DatumGetInt32(heap_getattr(heapTuple, Anum_pg_dfs_file_primary_nodeid, tupleDesc, &isNull));
+                    resetStringInfo(filePath);
+                    appendStringInfo(filePath, "%s%s/%s", info->path, node->path, fileName);
+                    DataDeleteQueueInsert(queueRel, queueIndexState, inodeId, nodeId, filePath->data);
+                }
+                pfree(fileName);
+            }
+            systable_endscan(scanDescriptor);
+        }
+        table_close(workerInodeRel, RowExclusiveLock);
+    }
+    CatalogCloseIndexes(queueIndexState);
+    table_close(queueRel, RowExclusiveLock);
+    CommandCounterIncrement();
+
+    info->errorCode = SUCCESS;
+}
+
 void FalconRmdirSubUnlinkHandle(MetaProcessInfo info)
 {
     uint64_t parentId_partId = info->parentId_partId;
@@ -1336,13 +1502,9 @@ void FalconRmdirSubUnlinkHandle(MetaProcessInfo info)
     if (workerId != GetLocalServerId())
         FALCON_ELOG_ERROR(ARGUMENT_ERROR, "FalconRmdirSubUnlinkHandle has received invalid input.");
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
     uint64_t nlink;
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+    bool fileExist = SearchAndUpdateInodeTableInfo(shardId,
                                                    NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
                                                    parentId_partId,
                                                    name,
                                                    true,
@@ -1382,8 +1544,10 @@ void FalconRenameHandle(MetaProcessInfo info)
     VerifyPathValidity(srcPath, 0, &srcProperty);
     VerifyPathValidity(dstPath, 0, &dstProperty);
 
-    if (GetLocalServerId() != 0)
-        FALCON_ELOG_ERROR(WRONG_WORKER, "rename can only be called on CN.");
+    if (GetLocalServerId() != FALCON_CN_SERVER_ID) {
+        FalconRenameOnWorker(info);
+        return;
+    }
 
     // 1.
     Relation directoryRel = table_open(DirectoryRelationId(), RowExclusiveLock);
@@ -1462,6 +1626,12 @@ void FalconRenameHandle(MetaProcessInfo info)
     SearchShardInfoByShardValue(srcParentIdPartId, &srcShardId, &srcWorkerId);
     SearchShardInfoByShardValue(dstParentIdPartId, &dstShardId, &dstWorkerId);
 
+    List *foreignServerIdList = NIL;
+    if (renameDirectory) {
+        foreignServerIdList = GetAllForeignServerId(true, true);
+        DirectoryLogWaitForAppliedOnWorkerList(foreignServerIdList);
+    }
+
     SerializedData subRenameLocallyParam;
     // 4.1
     info->parentId_partId = srcParentIdPartId;
@@ -1478,22 +1648,23 @@ void FalconRenameHandle(MetaProcessInfo info)
                                REMOTE_COMMAND_FLAG_WRITE,
                                list_make1_int(srcWorkerId));
 
-    // 4.2
-    info->parentId_partId = 0;
-    info->dstParentIdPartId = 0;
-    SerializedDataInit(&subRenameLocallyParam, NULL, 0, 0, &PgMemoryManager);
-    SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(RENAME_SUB_RENAME_LOCALLY,
-                                                                 &info,
-                                                                 NULL,
-                                                                 1,
-                                                                 &subRenameLocallyParam);
-    List *foreignServerIdList = GetAllForeignServerId(true, true);
-    foreignServerIdList = list_delete_int(foreignServerIdList, srcWorkerId);
-    FalconMetaCallOnWorkerList(RENAME_SUB_RENAME_LOCALLY,
-                               1,
-                               subRenameLocallyParam,
-                               REMOTE_COMMAND_FLAG_WRITE,
-                               foreignServerIdList);
+    // 4.2 only directories are replicated to the other workers
+    if (renameDirectory) {
+        info->parentId_partId = 0;
+        info->dstParentIdPartId = 0;
+        SerializedDataInit(&subRenameLocallyParam, NULL, 0, 0, &PgMemoryManager);
+        SerializedDataMetaParamEncodeWithPerProcessFlatBufferBuilder(RENAME_SUB_RENAME_LOCALLY,
+                                                                     &info,
+                                                                     NULL,
+                                                                     1,
+                                                                     &subRenameLocallyParam);
+        foreignServerIdList = list_delete_int(foreignServerIdList, srcWorkerId);
+        FalconMetaCallOnWorkerList(RENAME_SUB_RENAME_LOCALLY,
+                                   1,
+                                   subRenameLocallyParam,
+                                   REMOTE_COMMAND_FLAG_WRITE,
+                                   foreignServerIdList);
+    }
 
     MultipleServerRemoteCommandResult totalRemoteRes = FalconSendCommandAndWaitForResult();
 
@@ -1575,6 +1746,75 @@ void FalconRenameHandle(MetaProcessInfo info)
     info->errorCode = SUCCESS;
 }
 
+/*
+ * Clients send renames of files whose source and destination both live on this worker here directly, which then
+ * run as a local transaction. Anything else is answered with WRONG_WORKER and the client goes through the CN.
+ *
+ * The directory table of this worker is filled asynchronously from the directory log, so a directory created just
+ * now may only be known by its inode row here. The mode of the source row is checked again before it is moved.
+ */
+static void FalconRenameOnWorker(MetaProcessInfo info)
+{
+    int32_t property;
+    FalconErrorCode errorCode =
+        VerifyPathValidity(info->path, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_FILE, &property);
+    CHECK_ERROR_CODE_WITH_RETURN(errorCode);
+    errorCode = VerifyPathValidity(info->dstPath, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_FILE, &property);
+    CHECK_ERROR_CODE_WITH_RETURN(errorCode);
+
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    if (CheckWhetherPathExistsInDirectoryTable(directoryRel, info->path) != DIR_HASH_TABLE_PATH_NOT_EXIST ||
+        CheckWhetherPathExistsInDirectoryTable(directoryRel, info->dstPath) != DIR_HASH_TABLE_PATH_NOT_EXIST) {
+        table_close(directoryRel, AccessShareLock);
+        info->errorCode = WRONG_WORKER;
+        return;
+    }
+
+    // same order as the CN takes them in
+    const char *pathArray[2] = {info->path, info->dstPath};
+    uint64_t parentId[2];
+    char *name[2];
+    int srcIndex = 0;
+    if (pathcmp(info->path, info->dstPath) > 0) {
+        pathArray[0] = info->dstPath;
+        pathArray[1] = info->path;
+        srcIndex = 1;
+    }
+    for (int i = 0; i < 2; ++i) {
+        errorCode = PathParseTreeInsert(NULL,
+                                        directoryRel,
+                                        pathArray[i],
+                                        PATH_PARSE_FLAG_NOT_ROOT,
+                                        &parentId[i],
+                                        &name[i],
+                                        NULL);
+        if (errorCode != SUCCESS) {
+            table_close(directoryRel, AccessShareLock);
+            info->errorCode = errorCode;
+            return;
+        }
+    }
+    table_close(directoryRel, AccessShareLock);
+
+    int dstIndex = 1 - srcIndex;
+    uint64_t srcParentIdPartId = CombineParentIdWithPartId(parentId[srcIndex], HashPartId(name[srcIndex]));
+    uint64_t dstParentIdPartId = CombineParentIdWithPartId(parentId[dstIndex], HashPartId(name[dstIndex]));
+    int srcShardId, srcWorkerId, dstShardId, dstWorkerId;
+    SearchShardInfoByShardValue(srcParentIdPartId, &srcShardId, &srcWorkerId);
+    SearchShardInfoByShardValue(dstParentIdPartId, &dstShardId, &dstWorkerId);
+    if (srcWorkerId != GetLocalServerId() || dstWorkerId != GetLocalServerId())
+        CHECK_ERROR_CODE_WITH_RETURN(WRONG_WORKER);
+
+    info->targetIsDirectory = false;
+    info->parentId = parentId[srcIndex];
+    info->name = name[srcIndex];
+    info->parentId_partId = srcParentIdPartId;
+    info->dstParentId = parentId[dstIndex];
+    info->dstName = name[dstIndex];
+    info->dstParentIdPartId = dstParentIdPartId;
+    FalconRenameSubRenameLocallyHandle(info);
+}
+
 void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
 {
     // 1.
@@ -1599,6 +1839,7 @@ void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
         }
         CatalogCloseIndexes(indexState);
         table_close(directoryRel, RowExclusiveLock);
+        FalconNamespaceGenerationMarkDirty();
     }
 
     if (info->parentId_partId == 0) {
@@ -1615,18 +1856,16 @@ void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
     if (srcWorkerId != GetLocalServerId())
         FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
 
-    StringInfo srcInodeShardName = GetInodeShardName(srcShardId);
-    StringInfo srcInodeIndexShardName = GetInodeIndexShardName(srcShardId);
-
     SetUpScanCaches();
     ScanKeyData scanKey[2];
     scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
     scanKey[0].sk_argument = UInt64GetDatum(info->parentId_partId);
     scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
     scanKey[1].sk_argument = CStringGetTextDatum(info->name);
-    Relation srcInodeRel = table_open(GetRelationOidByName_FALCON(srcInodeShardName->data), RowExclusiveLock);
+    scanKey[1].sk_collation = InodeShardIndexNameCollation(srcShardId);
+    Relation srcInodeRel = table_open(InodeShardRelationId(srcShardId), RowExclusiveLock);
     SysScanDesc scanDescriptor = systable_beginscan(srcInodeRel,
-                                                    GetRelationOidByName_FALCON(srcInodeIndexShardName->data),
+                                                    InodeShardIndexRelationId(srcShardId),
                                                     true,
                                                     GetTransactionSnapshot(),
                                                     2,
@@ -1638,8 +1877,17 @@ void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
         FALCON_ELOG_ERROR(FILE_NOT_EXISTS, "unexpected.");
 
     heap_deform_tuple(heapTuple, tupleDesc, fileInfo, fileInfoNulls);
+    if (!info->targetIsDirectory && S_ISDIR(DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_mode - 1]))) {
+        // a directory whose entry has not reached the directory table of this worker yet, see
+        // FalconRenameOnWorker. nothing is changed so far, the client retries through the CN
+        systable_endscan(scanDescriptor);
+        table_close(srcInodeRel, RowExclusiveLock);
+        info->errorCode = WRONG_WORKER;
+        return;
+    }
     CatalogTupleDelete(srcInodeRel, &heapTuple->t_self);
     CommandCounterIncrement();
+    InodeAttrCacheInvalidate(info->parentId_partId, info->name);
 
     systable_endscan(scanDescriptor);
     table_close(srcInodeRel, RowExclusiveLock);
@@ -1651,8 +1899,7 @@ void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
         if (dstWorkerId != GetLocalServerId())
             FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
 
-        StringInfo dstInodeShardName = GetInodeShardName(dstShardId);
-        Relation dstInodeRel = table_open(GetRelationOidByName_FALCON(dstInodeShardName->data), RowExclusiveLock);
+        Relation dstInodeRel = table_open(InodeShardRelationId(dstShardId), RowExclusiveLock);
 
         fileInfo[Anum_pg_dfs_file_parentid_partid - 1] = UInt64GetDatum(info->dstParentIdPartId);
         fileInfo[Anum_pg_dfs_file_name - 1] = CStringGetTextDatum(info->dstName);
@@ -1661,6 +1908,8 @@ void FalconRenameSubRenameLocallyHandle(MetaProcessInfo info)
         CatalogTupleInsert(dstInodeRel, heapTuple);
         heap_freetuple(heapTuple);
         CommandCounterIncrement();
+        InodeAttrCacheInvalidate(info->dstParentIdPartId, info->dstName);
+        FalconNamespaceGenerationMarkDirty();
 
         table_close(dstInodeRel, RowExclusiveLock);
     } else {
@@ -1690,9 +1939,7 @@ void FalconRenameSubCreateHandle(MetaProcessInfo info)
     if (workerId != GetLocalServerId())
         FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-
-    Relation workerInodeRel = table_open(GetRelationOidByName_FALCON(inodeShardName->data), RowExclusiveLock);
+    Relation workerInodeRel = table_open(InodeShardRelationId(shardId), RowExclusiveLock);
     InsertIntoInodeTable(workerInodeRel,
                          NULL,
                          info->inodeId,
@@ -1715,6 +1962,7 @@ void FalconRenameSubCreateHandle(MetaProcessInfo info)
                          info->node_id,
                          -1);
     table_close(workerInodeRel, RowExclusiveLock);
+    FalconNamespaceGenerationMarkDirty();
 
     info->errorCode = SUCCESS;
 }
@@ -1757,12 +2005,8 @@ void FalconUtimeNsHandle(MetaProcessInfo info)
     if (workerId != GetLocalServerId())
         FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+    bool fileExist = SearchAndUpdateInodeTableInfo(shardId,
                                                    NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
                                                    parentId_partId,
                                                    fileName,
                                                    true,
@@ -1816,12 +2060,8 @@ void FalconChownHandle(MetaProcessInfo info)
     if (workerId != GetLocalServerId())
         FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+    bool fileExist = SearchAndUpdateInodeTableInfo(shardId,
                                                    NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
                                                    parentId_partId,
                                                    fileName,
                                                    true,
@@ -1877,12 +2117,8 @@ void FalconChmodHandle(MetaProcessInfo info)
     if (workerId != GetLocalServerId())
         FALCON_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
 
-    StringInfo inodeShardName = GetInodeShardName(shardId);
-    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
-    bool fileExist = SearchAndUpdateInodeTableInfo(inodeShardName->data,
+    bool fileExist = SearchAndUpdateInodeTableInfo(shardId,
                                                    NULL,
-                                                   inodeIndexShardName->data,
-                                                   InvalidOid,
                                                    parentId_partId,
                                                    fileName,
                                                    true,
@@ -1922,20 +2158,6 @@ static inline uint64_t CombineParentIdWithPartId(uint64_t parent_id, uint16_t pa
     return (parent_id << PART_ID_BIT_COUNT) | part_id;
 }
 
-static StringInfo GetInodeShardName(int shardId)
-{
-    StringInfo inodeShardName = makeStringInfo();
-    appendStringInfo(inodeShardName, "%s_%d", InodeTableName, shardId);
-    return inodeShardName;
-}
-
-static StringInfo GetInodeIndexShardName(int shardId)
-{
-    StringInfo inodeIndexShardName = makeStringInfo();
-    appendStringInfo(inodeIndexShardName, "%s_%d_%s", InodeTableName, shardId, "index");
-    return inodeIndexShardName;
-}
-
 static StringInfo __attribute__((unused)) GetXattrShardName(int shardId)
 {
     StringInfo xattrShardName = makeStringInfo();
@@ -1950,20 +2172,8 @@ static StringInfo __attribute__((unused)) GetXattrIndexShardName(int shardId)
     return xattrIndexShardName;
 }
 
-static Oid GetRelationOidByName_FALCON(const char *relationName)
-{
-    Oid res = InvalidOid;
-    res = get_relname_relid(relationName, PG_CATALOG_NAMESPACE);
-    if (res == InvalidOid) {
-        FALCON_ELOG_ERROR_EXTENDED(PROGRAM_ERROR, "cannot find relation %s.", relationName);
-    }
-    return res;
-}
-
-static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
-                                          Relation workerInodeRelation,
-                                          const char *workerInodeRelationIndexName,
-                                          Oid workerInodeIndexOid,
+static bool SearchAndUpdateInodeTableInfo(int shardId,
+                                          InodeIndexProbe *probe,
                                           const uint64_t parentId_partId,
                                           const char *fileName,
                                           const bool doUpdate,
@@ -1984,41 +2194,48 @@ static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
                                           int32_t *newPrimaryNodeId,
                                           int32_t *backupNodeId)
 {
-    ScanKeyData scanKey[2];
-    int scanKeyCount = 2;
     SysScanDesc scanDescriptor = NULL;
     HeapTuple heapTuple;
     TupleDesc tupleDesc;
-    Relation workerInodeRel = workerInodeRelation;
+    Relation workerInodeRel;
 
     SetUpScanCaches();
 
-    // set scan arguments
-    scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
-    scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
-    scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
-    scanKey[1].sk_argument = CStringGetTextDatum(fileName);
-
     bool needCatalogTupleUpdate = false;
-    if (!workerInodeRelation) {
-        workerInodeRel = table_open(GetRelationOidByName_FALCON(workerInodeRelationName),
-                                    doUpdate ? RowExclusiveLock : AccessShareLock);
-    }
+    if (probe) {
+        workerInodeRel = probe->heapRel;
+        heapTuple = InodeIndexProbeSearch(probe, parentId_partId, fileName);
+    } else {
+        ScanKeyData scanKey[2];
+        int scanKeyCount = 2;
 
-    if (workerInodeIndexOid == InvalidOid)
-        workerInodeIndexOid = GetRelationOidByName_FALCON(workerInodeRelationIndexName);
-    scanDescriptor =
-        systable_beginscan(workerInodeRel, workerInodeIndexOid, true, GetTransactionSnapshot(), scanKeyCount, scanKey);
-    heapTuple = systable_getnext(scanDescriptor);
+        // set scan arguments
+        scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
+        scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+        scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
+        scanKey[1].sk_argument = CStringGetTextDatum(fileName);
+        scanKey[1].sk_collation = InodeShardIndexNameCollation(shardId);
+
+        workerInodeRel = table_open(InodeShardRelationId(shardId), doUpdate ? RowExclusiveLock : AccessShareLock);
+        scanDescriptor = systable_beginscan(workerInodeRel,
+                                            InodeShardIndexRelationId(shardId),
+                                            true,
+                                            GetTransactionSnapshot(),
+                                            scanKeyCount,
+                                            scanKey);
+        heapTuple = systable_getnext(scanDescriptor);
+    }
     tupleDesc = RelationGetDescr(workerInodeRel);
 
     if (!HeapTupleIsValid(heapTuple)) {
-        systable_endscan(scanDescriptor);
-        if (!workerInodeRelation) {
+        if (!probe) {
+            systable_endscan(scanDescriptor);
             table_close(workerInodeRel, doUpdate ? RowExclusiveLock : AccessShareLock);
         }
         return false;
     }
+    if (doUpdate)
+        InodeAttrCacheInvalidate(parentId_partId, fileName);
 
     Datum updateDatumArray[Natts_pg_dfs_inode_table];
     bool isNullArray[Natts_pg_dfs_inode_table];
@@ -2122,13 +2339,132 @@ static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
         CommandCounterIncrement();
     }
 
-    systable_endscan(scanDescriptor);
-    if (!workerInodeRelation) {
+    if (!probe) {
+        systable_endscan(scanDescriptor);
         table_close(workerInodeRel, doUpdate ? RowExclusiveLock : AccessShareLock);
     }
     return true;
 }
 
+static void InodeIndexProbeBegin(InodeIndexProbe *probe, Relation workerInodeRel, int shardId, bool refreshSnapshot)
+{
+    SetUpScanCaches();
+    probe->heapRel = workerInodeRel;
+    probe->indexRel = index_open(InodeShardIndexRelationId(shardId), AccessShareLock);
+    probe->snapshot = RegisterSnapshot(GetTransactionSnapshot());
+    probe->refreshSnapshot = refreshSnapshot;
+    probe->scan = index_beginscan(workerInodeRel, probe->indexRel, probe->snapshot, 2, 0);
+    probe->slot = table_slot_create(workerInodeRel, NULL);
+}
+
+// the returned tuple stays valid until the next search or the end of the probe
+static HeapTuple InodeIndexProbeSearch(InodeIndexProbe *probe, uint64_t parentId_partId, const char *fileName)
+{
+    ScanKeyData scanKey[2];
+    scanKey[0] = InodeTableIndexParentIdPartIdNameScanKey[INODE_TABLE_INDEX_PARENT_ID_PART_ID_EQ];
+    scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+    scanKey[1] = InodeTableIndexParentIdPartIdNameScanKey[INODE_TABLE_INDEX_NAME_EQ];
+    scanKey[1].sk_argument = CStringGetTextDatum(fileName);
+    scanKey[1].sk_collation = probe->indexRel->rd_indcollation[Anum_pg_dfs_file_index_name - 1];
+
+    if (probe->refreshSnapshot) {
+        // rows updated for earlier items, by us or by others, have to be seen before they are updated again
+        UnregisterSnapshot(probe->snapshot);
+        probe->snapshot = RegisterSnapshot(GetTransactionSnapshot());
+        probe->scan->xs_snapshot = probe->snapshot;
+    }
+    index_rescan(probe->scan, scanKey, 2, NULL, 0);
+    if (!index_getnext_slot(probe->scan, ForwardScanDirection, probe->slot))
+        return NULL;
+    bool shouldFree;
+    return ExecFetchSlotHeapTuple(probe->slot, false, &shouldFree);
+}
+
+static void InodeIndexProbeEnd(InodeIndexProbe *probe)
+{
+    ExecDropSingleTupleTableSlot(probe->slot);
+    index_endscan(probe->scan);
+    UnregisterSnapshot(probe->snapshot);
+    index_close(probe->indexRel, AccessShareLock);
+}
+
+/*
+ * Index order of inode shards whose names use the "C" collation. Shards created before keep the database default,
+ * see InodeShardIndexNameCollation(), and are only probed in a less local order. Every batch sorts the same way
+ * either way, so rows are still locked in one consistent order.
+ */
+static int InodeKeyListCmp(const ListCell *a, const ListCell *b)
+{
+    MetaProcessInfo infoA = lfirst(a);
+    MetaProcessInfo infoB = lfirst(b);
+    if (infoA->parentId_partId != infoB->parentId_partId)
+        return infoA->parentId_partId < infoB->parentId_partId ? -1 : 1;
+    return strcmp(infoA->name, infoB->name);
+}
+
+// the attribute is only cacheable if the etag fits into it, the whole etag is returned either way
+static bool InodeAttrFromTuple(HeapTuple heapTuple, TupleDesc tupleDesc, InodeAttr *attr, char **etag)
+{
+    Datum datumArray[Natts_pg_dfs_inode_table];
+    bool isNullArray[Natts_pg_dfs_inode_table];
+    heap_deform_tuple(heapTuple, tupleDesc, datumArray, isNullArray);
+    attr->st_ino = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_ino - 1]);
+    attr->st_dev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_dev - 1]);
+    attr->st_mode = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_mode - 1]);
+    attr->st_nlink = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_nlink - 1]);
+    attr->st_uid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_uid - 1]);
+    attr->st_gid = DatumGetUInt32(datumArray[Anum_pg_dfs_file_st_gid - 1]);
+    attr->st_rdev = DatumGetUInt64(datumArray[Anum_pg_dfs_file_st_rdev - 1]);
+    attr->st_size = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_size - 1]);
+    attr->st_blksize = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blksize - 1]);
+    attr->st_blocks = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_blocks - 1]);
+    attr->st_atim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_atim - 1]);
+    attr->st_mtim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_mtim - 1]);
+    attr->st_ctim = DatumGetInt64(datumArray[Anum_pg_dfs_file_st_ctim - 1]);
+    attr->primaryNodeId = DatumGetInt32(datumArray[Anum_pg_dfs_file_primary_nodeid - 1]);
+    *etag = TextDatumGetCString(datumArray[Anum_pg_dfs_file_etag - 1]);
+    return strlcpy(attr->etag, *etag, sizeof(attr->etag)) < sizeof(attr->etag);
+}
+
+static void FillStatInfoFromInodeAttr(MetaProcessInfo info, const InodeAttr *attr)
+{
+    info->inodeId = attr->st_ino;
+    info->st_dev = attr->st_dev;
+    info->st_mode = attr->st_mode;
+    info->st_nlink = attr->st_nlink;
+    info->st_uid = attr->st_uid;
+    info->st_gid = attr->st_gid;
+    info->st_rdev = attr->st_rdev;
+    info->st_size = attr->st_size;
+    info->st_blksize = attr->st_blksize;
+    info->st_blocks = attr->st_blocks;
+    info->st_atim = attr->st_atim;
+    info->st_mtim = attr->st_mtim;
+    info->st_ctim = attr->st_ctim;
+    // lets the client open the file without another round trip
+    info->node_id = attr->primaryNodeId;
+}
+
+// open only replies what the client needs to access the file data
+static void FillOpenInfoFromInodeAttr(MetaProcessInfo info, const InodeAttr *attr)
+{
+    info->inodeId = attr->st_ino;
+    info->st_size = attr->st_size;
+    info->st_nlink = attr->st_nlink;
+    info->st_mode = attr->st_mode;
+    info->node_id = attr->primaryNodeId;
+    info->st_dev = 0;
+    info->st_uid = 0;
+    info->st_gid = 0;
+    info->st_rdev = 0;
+    info->st_blksize = 0;
+    info->st_blocks = 0;
+    info->st_atim = 0;
+    info->st_mtim = 0;
+    info->st_ctim = 0;
+    info->etag = (char *)"";
+}
+
 static bool InsertIntoInodeTable(Relation relation,
                                  CatalogIndexState indexState,
                                  uint64_t st_ino,
@@ -2186,5 +2522,70 @@ static bool InsertIntoInodeTable(Relation relation,
         CatalogTupleInsertWithInfo(relation, heapTuple, indexState);
     heap_freetuple(heapTuple);
     CommandCounterIncrement();
+    InodeAttrCacheInvalidate(parentid_partid, name);
     return true;
 }
+
+/*
+ * Readdir without plus only needs name and mode, which the inode shard index covers. Entries on heap pages that
+ * are all visible are answered from the index tuple, like an index only scan, the others from the heap.
+ */
+static int32_t ReadDirByIndexOnlyScan(Relation workerInodeRel,
+                                      int shardId,
+                                      ScanKey heapScanKey,
+                                      int scanKeyCount,
+                                      int32_t maxReadCount,
+                                      List **resultList)
+{
+    ScanKeyData scanKey[2];
+    for (int i = 0; i < scanKeyCount; ++i) {
+        scanKey[i] = heapScanKey[i];
+        // scan keys of the heap refer to heap attributes, the index scan needs index attributes
+        if (heapScanKey[i].sk_attno == Anum_pg_dfs_file_name)
+            scanKey[i].sk_attno = Anum_pg_dfs_file_index_name;
+        else
+            scanKey[i].sk_attno = Anum_pg_dfs_file_index_parentid_partid;
+    }
+
+    Relation indexRel = index_open(InodeShardIndexRelationId(shardId), AccessShareLock);
+    Snapshot snapshot = RegisterSnapshot(GetTransactionSnapshot());
+    IndexScanDesc scan = index_beginscan(workerInodeRel, indexRel, snapshot, scanKeyCount, 0);
+    scan->xs_want_itup = true;
+    index_rescan(scan, scanKey, scanKeyCount, NULL, 0);
+    TupleTableSlot *slot = table_slot_create(workerInodeRel, NULL);
+    Buffer vmBuffer = InvalidBuffer;
+
+    int32_t readCount = 0;
+    ItemPointer tid;
+    while (readCount < maxReadCount && (tid = index_getnext_tid(scan, ForwardScanDirection)) != NULL) {
+        Datum name;
+        Datum mode;
+        bool nameIsNull;
+        bool modeIsNull;
+        if (VM_ALL_VISIBLE(workerInodeRel, ItemPointerGetBlockNumber(tid), &vmBuffer)) {
+            name = index_getattr(scan->xs_itup, Anum_pg_dfs_file_index_name, scan->xs_itupdesc, &nameIsNull);
+            mode = index_getattr(scan->xs_itup, Anum_pg_dfs_file_index_st_mode, scan->xs_itupdesc, &modeIsNull);
+        } else {
+            if (!index_fetch_heap(scan, slot))
+                continue;
+            name = slot_getattr(slot, Anum_pg_dfs_file_name, &nameIsNull);
+            mode = slot_getattr(slot, Anum_pg_dfs_file_st_mode, &modeIsNull);
+        }
+        if (nameIsNull || modeIsNull)
+            FALCON_ELOG_ERROR(PROGRAM_ERROR, "file name and mode cannot be NULL.");
+
+        OneReadDirResult *result = (OneReadDirResult *)palloc0(sizeof(OneReadDirResult));
+        result->fileName = TextDatumGetCString(name);
+        result->mode = DatumGetUInt32(mode);
+        *resultList = lappend(*resultList, result);
+        readCount++;
+    }
+
+    if (vmBuffer != InvalidBuffer)
+        ReleaseBuffer(vmBuffer);
+    ExecDropSingleTupleTableSlot(slot);
+    index_endscan(scan);
+    UnregisterSnapshot(snapshot);
+    index_close(indexRel, AccessShareLock);
+    return readCount;
+}
@@ -81,6 +81,7 @@ Datum falcon_plain_readdir(PG_FUNCTION_ARGS)
     info->readDirMaxReadCount = -1;
     info->readDirLastShardIndex = -1;
     info->readDirLastFileName = "";
+    info->readDirPlus = false;
 
     FalconReadDirHandle(info);
 
@@ -5,22 +5,28 @@
 #include "postgres.h"
 
 #include "fmgr.h"
+#include "miscadmin.h"
 #include "utils/palloc.h"
 
 #include <unistd.h>
 
 #include "connection_pool/connection_pool.h"
+#include "control/control_flag.h"
+#include "metadb/directory_log.h"
 #include "metadb/meta_serialize_interface_helper.h"
 #include "utils/error_log.h"
 
+#define SHMEM_REPLY_ALLOC_RETRY_COUNT 1000
+#define SHMEM_REPLY_ALLOC_RETRY_INTERVAL_US 1000
+
 PG_FUNCTION_INFO_V1(falcon_meta_call_by_serialized_shmem_internal);
 PG_FUNCTION_INFO_V1(falcon_meta_call_by_serialized_data);
 
 static SerializedData MetaProcess(FalconSupportMetaService metaService, int count, char *paramBuffer)
 {
     if (count != 1 && !(metaService == MKDIR || metaService == MKDIR_SUB_MKDIR || metaService == MKDIR_SUB_CREATE ||
-                        metaService == CREATE || metaService == STAT || metaService == OPEN || metaService == CLOSE ||
-                        metaService == UNLINK))
+                        metaService == MKDIR_RECURSIVE || metaService == CREATE || metaService == STAT ||
+                        metaService == OPEN || metaService == CLOSE || metaService == UNLINK))
         FALCON_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "metaService %d doesn't support batch operation.", metaService);
 
     SerializedData param;
@@ -40,6 +46,9 @@ static SerializedData MetaProcess(FalconSupportMetaService metaService, int coun
     case MKDIR:
         FalconMkdirHandle(infoArray, count);
         break;
+    case MKDIR_RECURSIVE:
+        FalconMkdirRecursiveHandle(infoArray, count);
+        break;
     case MKDIR_SUB_MKDIR:
         FalconMkdirSubMkdirHandle(infoArray, count);
         break;
@@ -76,6 +85,12 @@ static SerializedData MetaProcess(FalconSupportMetaService metaService, int coun
     case RMDIR_SUB_UNLINK:
         FalconRmdirSubUnlinkHandle(infoArray[0]);
         break;
+    case RMDIR_RECURSIVE:
+        FalconRmdirRecursiveHandle(infoArray[0]);
+        break;
+    case RMDIR_RECURSIVE_SUB_RMDIR:
+        FalconRmdirRecursiveSubRmdirHandle(infoArray[0]);
+        break;
     case RENAME:
         FalconRenameHandle(infoArray[0]);
         break;
@@ -100,7 +115,14 @@ static SerializedData MetaProcess(FalconSupportMetaService metaService, int coun
 
     SerializedData response;
     SerializedDataInit(&response, NULL, 0, 0, &PgMemoryManager);
-    if (!SerializedDataMetaResponseEncodeWithPerProcessFlatBufferBuilder(metaService, count, infoDataArray, &response))
+    // read after handling so that a miss is never reported under a generation older than the one it observed
+    uint64_t generation = GetFalconNamespaceGeneration();
+    if (!SerializedDataMetaResponseEncodeWithPerProcessFlatBufferBuilder(metaService,
+                                                                         count,
+                                                                         infoDataArray,
+                                                                         generation,
+                                                                         DirectoryLogPosition(),
+                                                                         &response))
         FALCON_ELOG_ERROR(ARGUMENT_ERROR, "failed when serializing response.");
 
     return response;
@@ -122,7 +144,16 @@ Datum falcon_meta_call_by_serialized_shmem_internal(PG_FUNCTION_ARGS)
 
     SerializedData response = MetaProcess(metaService, count, paramBuffer);
 
+    // replies are freed by the pool once sent, so shortage is usually transient. wait a little before failing
     uint64_t responseShmemShift = FalconShmemAllocatorMalloc(allocator, response.size);
+    if (responseShmemShift == 0 && FalconShmemAllocatorCanFit(allocator, response.size)) {
+        FalconShmemAllocatorCount(allocator, FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_WAIT);
+        for (int retry = 0; responseShmemShift == 0 && retry < SHMEM_REPLY_ALLOC_RETRY_COUNT; ++retry) {
+            CHECK_FOR_INTERRUPTS();
+            pg_usleep(SHMEM_REPLY_ALLOC_RETRY_INTERVAL_US);
+            responseShmemShift = FalconShmemAllocatorMalloc(allocator, response.size);
+        }
+    }
     if (responseShmemShift == 0)
         FALCON_ELOG_ERROR_EXTENDED(PROGRAM_ERROR, "FalconShmemAllocMalloc failed. Size: %u.", response.size);
     char *responseBuffer = FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, responseShmemShift);
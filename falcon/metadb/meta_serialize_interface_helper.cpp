@@ -53,6 +53,12 @@ FalconSupportMetaService MetaServiceTypeDecode(int32_t type)
         return FalconSupportMetaService::CHOWN;
     case falcon::meta_proto::MetaServiceType::CHMOD:
         return FalconSupportMetaService::CHMOD;
+    case falcon::meta_proto::MetaServiceType::MKDIR_RECURSIVE:
+        return FalconSupportMetaService::MKDIR_RECURSIVE;
+    case falcon::meta_proto::MetaServiceType::RMDIR_RECURSIVE:
+        return FalconSupportMetaService::RMDIR_RECURSIVE;
+    case falcon::meta_proto::MetaServiceType::RMDIR_RECURSIVE_SUB_RMDIR:
+        return FalconSupportMetaService::RMDIR_RECURSIVE_SUB_RMDIR;
     default:
         return FalconSupportMetaService::NOT_SUPPORTED;
     }
@@ -99,6 +105,12 @@ int32_t MetaServiceTypeEncode(FalconSupportMetaService metaService)
         return falcon::meta_proto::MetaServiceType::CHOWN;
     case FalconSupportMetaService::CHMOD:
         return falcon::meta_proto::MetaServiceType::CHMOD;
+    case FalconSupportMetaService::MKDIR_RECURSIVE:
+        return falcon::meta_proto::MetaServiceType::MKDIR_RECURSIVE;
+    case FalconSupportMetaService::RMDIR_RECURSIVE:
+        return falcon::meta_proto::MetaServiceType::RMDIR_RECURSIVE;
+    case FalconSupportMetaService::RMDIR_RECURSIVE_SUB_RMDIR:
+        return falcon::meta_proto::MetaServiceType::RMDIR_RECURSIVE_SUB_RMDIR;
     default:
         return -1;
     }
@@ -130,12 +142,14 @@ bool SerializedDataMetaParamDecode(FalconSupportMetaService metaService,
         MetaProcessInfo info = infoArray + i;
         switch (metaService) {
         case FalconSupportMetaService::MKDIR:
+        case FalconSupportMetaService::MKDIR_RECURSIVE:
         case FalconSupportMetaService::CREATE:
         case FalconSupportMetaService::STAT:
         case FalconSupportMetaService::OPEN:
         case FalconSupportMetaService::UNLINK:
         case FalconSupportMetaService::OPENDIR:
-        case FalconSupportMetaService::RMDIR: {
+        case FalconSupportMetaService::RMDIR:
+        case FalconSupportMetaService::RMDIR_RECURSIVE: {
             // path only param
             if (metaParam->param_type() != falcon::meta_fbs::AnyMetaParam::AnyMetaParam_PathOnlyParam) {
                 printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
@@ -191,6 +205,7 @@ bool SerializedDataMetaParamDecode(FalconSupportMetaService metaService,
             info->readDirMaxReadCount = readDirParam->max_read_count();
             info->readDirLastShardIndex = readDirParam->last_shard_index();
             info->readDirLastFileName = readDirParam->last_file_name()->c_str();
+            info->readDirPlus = readDirParam->plus();
             break;
         }
         case FalconSupportMetaService::RMDIR_SUB_RMDIR: {
@@ -213,6 +228,17 @@ bool SerializedDataMetaParamDecode(FalconSupportMetaService metaService,
             info->name = const_cast<char *>(rmdirSubUnlinkParam->name()->c_str());
             break;
         }
+        case FalconSupportMetaService::RMDIR_RECURSIVE_SUB_RMDIR: {
+            if (metaParam->param_type() != falcon::meta_fbs::AnyMetaParam::AnyMetaParam_RmdirRecursiveSubRmdirParam) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            auto rmdirRecursiveSubRmdirParam = metaParam->param_as_RmdirRecursiveSubRmdirParam();
+            info->parentId = rmdirRecursiveSubRmdirParam->parent_id();
+            info->name = const_cast<char *>(rmdirRecursiveSubRmdirParam->name()->c_str());
+            info->path = rmdirRecursiveSubRmdirParam->path()->c_str();
+            break;
+        }
         case FalconSupportMetaService::RENAME: {
             if (metaParam->param_type() != falcon::meta_fbs::AnyMetaParam::AnyMetaParam_RenameParam) {
                 printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
@@ -357,6 +383,16 @@ bool SerializedDataMetaParamEncode(FalconSupportMetaService metaService,
                                                           rmdirSubUnlinkParam.Union());
             break;
         }
+        case FalconSupportMetaService::RMDIR_RECURSIVE_SUB_RMDIR: {
+            auto rmdirRecursiveSubRmdirParam = falcon::meta_fbs::CreateRmdirRecursiveSubRmdirParamDirect(builder,
+                                                                                                         info->parentId,
+                                                                                                         info->name,
+                                                                                                         info->path);
+            metaParam = falcon::meta_fbs::CreateMetaParam(builder,
+                                                          falcon::meta_fbs::AnyMetaParam_RmdirRecursiveSubRmdirParam,
+                                                          rmdirRecursiveSubRmdirParam.Union());
+            break;
+        }
         case FalconSupportMetaService::RENAME_SUB_RENAME_LOCALLY: {
             auto renameSubRenameLocallyParam =
                 falcon::meta_fbs::CreateRenameSubRenameLocallyParamDirect(builder,
@@ -443,6 +479,7 @@ bool SerializedDataMetaResponseDecode(FalconSupportMetaService metaService,
         case FalconSupportMetaService::MKDIR_SUB_CREATE:
         case FalconSupportMetaService::RMDIR_SUB_RMDIR:
         case FalconSupportMetaService::RMDIR_SUB_UNLINK:
+        case FalconSupportMetaService::RMDIR_RECURSIVE_SUB_RMDIR:
         case FalconSupportMetaService::RENAME_SUB_CREATE: {
             // Error code only. Do nothing.
             break;
@@ -484,107 +521,101 @@ bool SerializedDataMetaResponseDecode(FalconSupportMetaService metaService,
 static bool SerializedDataMetaResponseEncode(FalconSupportMetaService metaService,
                                              int count,
                                              MetaProcessInfoData *infoArray,
+                                             uint64_t generation,
+                                             uint64_t directoryLogPosition,
                                              flatbuffers::FlatBufferBuilder &builder,
                                              SerializedData *response)
 {
     for (int i = 0; i < count; ++i) {
         builder.Clear();
         MetaProcessInfo info = infoArray + i;
-        flatbuffers::Offset<falcon::meta_fbs::MetaResponse> metaResponse;
-        if (info->errorCode != SUCCESS && info->errorCode != FILE_EXISTS) {
-            //
-            metaResponse = falcon::meta_fbs::CreateMetaResponse(builder, info->errorCode);
-        } else {
+        falcon::meta_fbs::AnyMetaResponse responseType = falcon::meta_fbs::AnyMetaResponse_NONE;
+        flatbuffers::Offset<void> responseData = 0;
+        if (info->errorCode == SUCCESS || info->errorCode == FILE_EXISTS) {
             switch (metaService) {
             case FalconSupportMetaService::MKDIR:
+            case FalconSupportMetaService::MKDIR_RECURSIVE:
             case FalconSupportMetaService::MKDIR_SUB_MKDIR:
             case FalconSupportMetaService::MKDIR_SUB_CREATE:
             case FalconSupportMetaService::CLOSE:
             case FalconSupportMetaService::RMDIR:
             case FalconSupportMetaService::RMDIR_SUB_RMDIR:
             case FalconSupportMetaService::RMDIR_SUB_UNLINK:
+            case FalconSupportMetaService::RMDIR_RECURSIVE:
+            case FalconSupportMetaService::RMDIR_RECURSIVE_SUB_RMDIR:
             case FalconSupportMetaService::RENAME:
             case FalconSupportMetaService::RENAME_SUB_CREATE:
             case FalconSupportMetaService::UTIMENS:
             case FalconSupportMetaService::CHOWN:
             case FalconSupportMetaService::CHMOD: {
                 // error code only response
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder, info->errorCode);
                 break;
             }
             case FalconSupportMetaService::CREATE: {
-                // auto createResponse = falcon::meta_fbs::CreateCreateResponse(builder, info->inodeId);
-                auto createResponse = falcon::meta_fbs::CreateCreateResponse(builder,
-                                                                             info->inodeId,
-                                                                             info->node_id,
-                                                                             info->st_dev,
-                                                                             info->st_mode,
-                                                                             info->st_nlink,
-                                                                             info->st_uid,
-                                                                             info->st_gid,
-                                                                             info->st_rdev,
-                                                                             info->st_size,
-                                                                             info->st_blksize,
-                                                                             info->st_blocks,
-                                                                             info->st_atim,
-                                                                             info->st_mtim,
-                                                                             info->st_ctim);
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
-                                                                    info->errorCode,
-                                                                    falcon::meta_fbs::AnyMetaResponse_CreateResponse,
-                                                                    createResponse.Union());
+                responseType = falcon::meta_fbs::AnyMetaResponse_CreateResponse;
+                responseData = falcon::meta_fbs::CreateCreateResponse(builder,
+                                                                      info->inodeId,
+                                                                      info->node_id,
+                                                                      info->st_dev,
+                                                                      info->st_mode,
+                                                                      info->st_nlink,
+                                                                      info->st_uid,
+                                                                      info->st_gid,
+                                                                      info->st_rdev,
+                                                                      info->st_size,
+                                                                      info->st_blksize,
+                                                                      info->st_blocks,
+                                                                      info->st_atim,
+                                                                      info->st_mtim,
+                                                                      info->st_ctim)
+                                   .Union();
                 break;
             }
             case FalconSupportMetaService::STAT: {
-                auto statResponse = falcon::meta_fbs::CreateStatResponse(builder,
-                                                                         info->inodeId,
-                                                                         info->st_dev,
-                                                                         info->st_mode,
-                                                                         info->st_nlink,
-                                                                         info->st_uid,
-                                                                         info->st_gid,
-                                                                         info->st_rdev,
-                                                                         info->st_size,
-                                                                         info->st_blksize,
-                                                                         info->st_blocks,
-                                                                         info->st_atim,
-                                                                         info->st_mtim,
-                                                                         info->st_ctim);
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
-                                                                    info->errorCode,
-                                                                    falcon::meta_fbs::AnyMetaResponse_StatResponse,
-                                                                    statResponse.Union());
+                responseType = falcon::meta_fbs::AnyMetaResponse_StatResponse;
+                responseData = falcon::meta_fbs::CreateStatResponse(builder,
+                                                                    info->inodeId,
+                                                                    info->st_dev,
+                                                                    info->st_mode,
+                                                                    info->st_nlink,
+                                                                    info->st_uid,
+                                                                    info->st_gid,
+                                                                    info->st_rdev,
+                                                                    info->st_size,
+                                                                    info->st_blksize,
+                                                                    info->st_blocks,
+                                                                    info->st_atim,
+                                                                    info->st_mtim,
+                                                                    info->st_ctim,
+                                                                    info->node_id)
+                                   .Union();
                 break;
             }
             case FalconSupportMetaService::OPEN: {
-                auto openResponse = falcon::meta_fbs::CreateOpenResponse(builder,
-                                                                         info->inodeId,
-                                                                         info->node_id,
-                                                                         info->st_dev,
-                                                                         info->st_mode,
-                                                                         info->st_nlink,
-                                                                         info->st_uid,
-                                                                         info->st_gid,
-                                                                         info->st_rdev,
-                                                                         info->st_size,
-                                                                         info->st_blksize,
-                                                                         info->st_blocks,
-                                                                         info->st_atim,
-                                                                         info->st_mtim,
-                                                                         info->st_ctim);
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
-                                                                    info->errorCode,
-                                                                    falcon::meta_fbs::AnyMetaResponse_OpenResponse,
-                                                                    openResponse.Union());
+                responseType = falcon::meta_fbs::AnyMetaResponse_OpenResponse;
+                responseData = falcon::meta_fbs::CreateOpenResponse(builder,
+                                                                    info->inodeId,
+                                                                    info->node_id,
+                                                                    info->st_dev,
+                                                                    info->st_mode,
+                                                                    info->st_nlink,
+                                                                    info->st_uid,
+                                                                    info->st_gid,
+                                                                    info->st_rdev,
+                                                                    info->st_size,
+                                                                    info->st_blksize,
+                                                                    info->st_blocks,
+                                                                    info->st_atim,
+                                                                    info->st_mtim,
+                                                                    info->st_ctim)
+                                   .Union();
                 break;
             }
             case FalconSupportMetaService::UNLINK: {
-                auto unlinkResponse =
-                    falcon::meta_fbs::CreateUnlinkResponse(builder, info->inodeId, info->st_size, info->node_id);
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
-                                                                    info->errorCode,
-                                                                    falcon::meta_fbs::AnyMetaResponse_UnlinkResponse,
-                                                                    unlinkResponse.Union());
+                responseType = falcon::meta_fbs::AnyMetaResponse_UnlinkResponse;
+                responseData =
+                    falcon::meta_fbs::CreateUnlinkResponse(builder, info->inodeId, info->st_size, info->node_id)
+                        .Union();
                 break;
             }
             case FalconSupportMetaService::READDIR: {
@@ -593,50 +624,49 @@ static bool SerializedDataMetaResponseEncode(FalconSupportMetaService metaServic
                     readDirResultList.push_back(
                         falcon::meta_fbs::CreateOneReadDirResponseDirect(builder,
                                                                          info->readDirResultList[j]->fileName,
-                                                                         info->readDirResultList[j]->mode));
-                auto readDirResponse = falcon::meta_fbs::CreateReadDirResponseDirect(builder,
-                                                                                     info->readDirLastShardIndex,
-                                                                                     info->readDirLastFileName,
-                                                                                     &readDirResultList);
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
-                                                                    info->errorCode,
-                                                                    falcon::meta_fbs::AnyMetaResponse_ReadDirResponse,
-                                                                    readDirResponse.Union());
+                                                                         info->readDirResultList[j]->mode,
+                                                                         info->readDirResultList[j]->st_ino,
+                                                                         info->readDirResultList[j]->st_nlink,
+                                                                         info->readDirResultList[j]->st_uid,
+                                                                         info->readDirResultList[j]->st_gid,
+                                                                         info->readDirResultList[j]->st_size,
+                                                                         info->readDirResultList[j]->st_blksize,
+                                                                         info->readDirResultList[j]->st_blocks,
+                                                                         info->readDirResultList[j]->st_atim,
+                                                                         info->readDirResultList[j]->st_mtim,
+                                                                         info->readDirResultList[j]->st_ctim));
+                responseType = falcon::meta_fbs::AnyMetaResponse_ReadDirResponse;
+                responseData = falcon::meta_fbs::CreateReadDirResponseDirect(builder,
+                                                                             info->readDirLastShardIndex,
+                                                                             info->readDirLastFileName,
+                                                                             &readDirResultList)
+                                   .Union();
                 break;
             }
             case FalconSupportMetaService::OPENDIR: {
-                auto openDirResponse = falcon::meta_fbs::CreateOpenDirResponse(builder, info->inodeId);
-                metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
-                                                                    info->errorCode,
-                                                                    falcon::meta_fbs::AnyMetaResponse_OpenDirResponse,
-                                                                    openDirResponse.Union());
+                responseType = falcon::meta_fbs::AnyMetaResponse_OpenDirResponse;
+                responseData = falcon::meta_fbs::CreateOpenDirResponse(builder, info->inodeId).Union();
                 break;
             }
             case FalconSupportMetaService::RENAME_SUB_RENAME_LOCALLY: {
                 if (info->parentId_partId != 0 && info->dstParentIdPartId == 0) {
-                    auto renameSubRenameLocallyResponse =
-                        falcon::meta_fbs::CreateRenameSubRenameLocallyResponse(builder,
-                                                                               info->inodeId,
-                                                                               info->st_dev,
-                                                                               info->st_mode,
-                                                                               info->st_nlink,
-                                                                               info->st_uid,
-                                                                               info->st_gid,
-                                                                               info->st_rdev,
-                                                                               info->st_size,
-                                                                               info->st_blksize,
-                                                                               info->st_blocks,
-                                                                               info->st_atim,
-                                                                               info->st_mtim,
-                                                                               info->st_ctim,
-                                                                               info->node_id);
-                    metaResponse = falcon::meta_fbs::CreateMetaResponse(
-                        builder,
-                        info->errorCode,
-                        falcon::meta_fbs::AnyMetaResponse_RenameSubRenameLocallyResponse,
-                        renameSubRenameLocallyResponse.Union());
-                } else {
-                    metaResponse = falcon::meta_fbs::CreateMetaResponse(builder, info->errorCode);
+                    responseType = falcon::meta_fbs::AnyMetaResponse_RenameSubRenameLocallyResponse;
+                    responseData = falcon::meta_fbs::CreateRenameSubRenameLocallyResponse(builder,
+                                                                                          info->inodeId,
+                                                                                          info->st_dev,
+                                                                                          info->st_mode,
+                                                                                          info->st_nlink,
+                                                                                          info->st_uid,
+                                                                                          info->st_gid,
+                                                                                          info->st_rdev,
+                                                                                          info->st_size,
+                                                                                          info->st_blksize,
+                                                                                          info->st_blocks,
+                                                                                          info->st_atim,
+                                                                                          info->st_mtim,
+                                                                                          info->st_ctim,
+                                                                                          info->node_id)
+                                       .Union();
                 }
                 break;
             }
@@ -644,6 +674,12 @@ static bool SerializedDataMetaResponseEncode(FalconSupportMetaService metaServic
                 return false;
             }
         }
+        auto metaResponse = falcon::meta_fbs::CreateMetaResponse(builder,
+                                                                 info->errorCode,
+                                                                 responseType,
+                                                                 responseData,
+                                                                 generation,
+                                                                 directoryLogPosition);
         builder.Finish(metaResponse);
 
         char *buffer = SerializedDataApplyForSegment(response, builder.GetSize());
@@ -655,7 +691,15 @@ static bool SerializedDataMetaResponseEncode(FalconSupportMetaService metaServic
 bool SerializedDataMetaResponseEncodeWithPerProcessFlatBufferBuilder(FalconSupportMetaService metaService,
                                                                      int count,
                                                                      MetaProcessInfoData *infoArray,
+                                                                     uint64_t generation,
+                                                                     uint64_t directoryLogPosition,
                                                                      SerializedData *response)
 {
-    return SerializedDataMetaResponseEncode(metaService, count, infoArray, FlatBufferBuilderPerProcess, response);
+    return SerializedDataMetaResponseEncode(metaService,
+                                            count,
+                                            infoArray,
+                                            generation,
+                                            directoryLogPosition,
+                                            FlatBufferBuilderPerProcess,
+                                            response);
 }
@@ -28,15 +28,29 @@
 #include "utils/snapmgr.h"
 
 #include "metadb/foreign_server.h"
+#include "metadb/shard_table_standalone.h"
+#include "remote_connection_utils/shard_table_epoch.h"
 #include "utils/error_log.h"
 #include "utils/shmem_control.h"
 #include "utils/utils.h"
 
+#define SHARD_TABLE_LOCK_FREE_COPY_RETRY 100
+#define SHARD_TABLE_LOCK_FREE_COPY_RETRY_INTERVAL_US 1000
+
 static ShmemControlData *ShardTableShmemControl = NULL;
+// advanced by every reload, backends only copy the shard table again once it has moved
+static pg_atomic_uint64 *ShardTableShmemCacheVersion = NULL;
+static pg_atomic_uint64 *ShardTableShmemCacheEpoch = NULL;
 static FormData_falcon_shard_table *ShardTableShmemCache = NULL;
 static int32_t *ShardTableShmemCacheCount = NULL;
 static pg_atomic_uint32 *ShardTableShmemCacheInvalid = NULL;
 
+static FormData_falcon_shard_table *ShardTableLocalCache = NULL;
+static int32_t ShardTableLocalCacheCount = 0;
+static uint64_t ShardTableLocalCacheVersion = 0;
+
+static void RefreshShardTableLocalCache(void);
+
 PG_FUNCTION_INFO_V1(falcon_build_shard_table);
 PG_FUNCTION_INFO_V1(falcon_update_shard_table);
 PG_FUNCTION_INFO_V1(falcon_reload_shard_table_cache);
@@ -237,65 +251,84 @@ Oid ShardRelationIndexId(void)
     return CachedRelationOid[CACHED_RELATION_SHARD_TABLE_INDEX];
 }
 
-void SearchShardInfoByShardValue(uint64_t shardColValue, int32_t *rangePoint, int32_t *serverId)
+/*
+ * Lookups search a backend local copy of the shard table without any lock, the copy is only taken again under
+ * the shard table lock once a reload has advanced the version.
+ */
+static void RefreshShardTableLocalCache(void)
 {
-    // Block shard map read only when transfer operations acquire AccessExclusiveLock
-    int32 hashvalue = HashShard(shardColValue);
     while (pg_atomic_read_u32(ShardTableShmemCacheInvalid)) {
         ReloadShardTableShmemCache();
     }
+    if (pg_atomic_read_u64(ShardTableShmemCacheVersion) == ShardTableLocalCacheVersion)
+        return;
+
     LWLockAcquire(&ShardTableShmemControl->lock, LW_SHARED);
+    int32_t count = *ShardTableShmemCacheCount;
+    FormData_falcon_shard_table *localCache =
+        MemoryContextAlloc(TopMemoryContext, sizeof(FormData_falcon_shard_table) * Max(count, 1));
+    memcpy(localCache, ShardTableShmemCache, sizeof(FormData_falcon_shard_table) * count);
+    uint64_t version = pg_atomic_read_u64(ShardTableShmemCacheVersion);
+    LWLockRelease(&ShardTableShmemControl->lock);
+
+    if (ShardTableLocalCache != NULL)
+        pfree(ShardTableLocalCache);
+    ShardTableLocalCache = localCache;
+    ShardTableLocalCacheCount = count;
+    ShardTableLocalCacheVersion = version;
+}
+
+void SearchShardInfoByShardValue(uint64_t shardColValue, int32_t *rangePoint, int32_t *serverId)
+{
+    int32 hashvalue = HashShard(shardColValue);
+    RefreshShardTableLocalCache();
     int l = 0;
-    int r = *ShardTableShmemCacheCount;
+    int r = ShardTableLocalCacheCount;
     while (l < r) {
         int mid = (l + r) / 2;
-        if (ShardTableShmemCache[mid].range_point < hashvalue)
+        if (ShardTableLocalCache[mid].range_point < hashvalue)
             l = mid + 1;
         else
             r = mid;
     }
-    if (l == *ShardTableShmemCacheCount) {
+    if (l == ShardTableLocalCacheCount) {
         FALCON_ELOG_ERROR_EXTENDED(PROGRAM_ERROR,
                                    "shard value %d out of range, max support %d",
                                    hashvalue,
-                                   ShardTableShmemCache[*ShardTableShmemCacheCount - 1].range_point);
+                                   ShardTableLocalCacheCount > 0
+                                       ? ShardTableLocalCache[ShardTableLocalCacheCount - 1].range_point
+                                       : -1);
     }
-    *rangePoint = ShardTableShmemCache[l].range_point;
-    *serverId = ShardTableShmemCache[l].server_id;
-    LWLockRelease(&ShardTableShmemControl->lock);
+    *rangePoint = ShardTableLocalCache[l].range_point;
+    *serverId = ShardTableLocalCache[l].server_id;
 }
 
 List *GetShardTableData()
 {
-    while (pg_atomic_read_u32(ShardTableShmemCacheInvalid)) {
-        ReloadShardTableShmemCache();
-    }
-    LWLockAcquire(&ShardTableShmemControl->lock, AccessShareLock);
+    RefreshShardTableLocalCache();
 
     List *result = NIL;
-    for (int i = 0; i < *ShardTableShmemCacheCount; i++) {
-        FormData_falcon_shard_table *shardTableRow = ShardTableShmemCache + i;
-
+    for (int i = 0; i < ShardTableLocalCacheCount; i++) {
         FormData_falcon_shard_table *data = palloc(sizeof(FormData_falcon_shard_table));
-        data->range_point = shardTableRow->range_point;
-        data->server_id = shardTableRow->server_id;
+        *data = ShardTableLocalCache[i];
         result = lappend(result, data);
     }
-    LWLockRelease(&ShardTableShmemControl->lock);
     return result;
 }
 
-int32_t GetShardTableSize()
+const FormData_falcon_shard_table *GetShardTableArray(int32_t *count)
 {
-    while (pg_atomic_read_u32(ShardTableShmemCacheInvalid)) {
-        ReloadShardTableShmemCache();
-    }
-    LWLockAcquire(&ShardTableShmemControl->lock, AccessShareLock);
+    RefreshShardTableLocalCache();
+
+    *count = ShardTableLocalCacheCount;
+    return ShardTableLocalCache;
+}
 
-    int32_t result = *ShardTableShmemCacheCount;
+int32_t GetShardTableSize()
+{
+    RefreshShardTableLocalCache();
 
-    LWLockRelease(&ShardTableShmemControl->lock);
-    return result;
+    return ShardTableLocalCacheCount;
 }
 
 void InvalidateShardTableShmemCacheCallback(Datum argument, Oid relationId)
@@ -307,14 +340,17 @@ void InvalidateShardTableShmemCacheCallback(Datum argument, Oid relationId)
 
 size_t ShardTableShmemsize()
 {
-    return sizeof(ShmemControlData) + sizeof(int32_t) + sizeof(pg_atomic_uint32) +
-           sizeof(FormData_falcon_shard_table) * SHARD_COUNT_MAX;
+    return MAXALIGN(sizeof(ShmemControlData)) + sizeof(pg_atomic_uint64) * 2 + sizeof(int32_t) +
+           sizeof(pg_atomic_uint32) + sizeof(FormData_falcon_shard_table) * SHARD_COUNT_MAX;
 }
 void ShardTableShmemInit()
 {
     bool initialized;
     ShardTableShmemControl = ShmemInitStruct("Shard Table Control", ShardTableShmemsize(), &initialized);
-    ShardTableShmemCacheCount = (int32_t *)(ShardTableShmemControl + 1);
+    ShardTableShmemCacheVersion =
+        (pg_atomic_uint64 *)((char *)ShardTableShmemControl + MAXALIGN(sizeof(ShmemControlData)));
+    ShardTableShmemCacheEpoch = ShardTableShmemCacheVersion + 1;
+    ShardTableShmemCacheCount = (int32_t *)(ShardTableShmemCacheEpoch + 1);
     ShardTableShmemCacheInvalid = (pg_atomic_uint32 *)(ShardTableShmemCacheCount + 1);
     ShardTableShmemCache = (FormData_falcon_shard_table *)(ShardTableShmemCacheInvalid + 1);
     if (!initialized) {
@@ -323,6 +359,8 @@ void ShardTableShmemInit()
         LWLockRegisterTranche(ShardTableShmemControl->trancheId, ShardTableShmemControl->lockTrancheName);
         LWLockInitialize(&ShardTableShmemControl->lock, ShardTableShmemControl->trancheId);
 
+        pg_atomic_init_u64(ShardTableShmemCacheVersion, 2);
+        pg_atomic_init_u64(ShardTableShmemCacheEpoch, SHARD_TABLE_EPOCH_UNKNOWN);
         *ShardTableShmemCacheCount = 0;
         pg_atomic_init_u32(ShardTableShmemCacheInvalid, 1);
     }
@@ -338,34 +376,57 @@ void ReloadShardTableShmemCache()
         return;
     }
 
-    *ShardTableShmemCacheCount = 0;
+    // the version is odd while the rows are rewritten, which lock free readers retry on
+    pg_atomic_fetch_add_u64(ShardTableShmemCacheVersion, 1);
+    pg_write_barrier();
+
     bool exceedMaxNumOfShardTable = false;
-    Relation rel = table_open(ShardRelationId(), AccessShareLock);
-    Relation relIndex = index_open(ShardRelationIndexId(), AccessShareLock);
-    SysScanDesc scanDesc = systable_beginscan_ordered(rel, relIndex, NULL, 0, NULL);
-    TupleDesc tupleDesc = RelationGetDescr(rel);
+    PG_TRY();
+    {
+        *ShardTableShmemCacheCount = 0;
+        Relation rel = table_open(ShardRelationId(), AccessShareLock);
+        Relation relIndex = index_open(ShardRelationIndexId(), AccessShareLock);
+        SysScanDesc scanDesc = systable_beginscan_ordered(rel, relIndex, NULL, 0, NULL);
+        TupleDesc tupleDesc = RelationGetDescr(rel);
 
-    Datum datumArray[Natts_falcon_shard_table];
-    bool isNullArray[Natts_falcon_shard_table];
-    HeapTuple heapTuple;
-    while (HeapTupleIsValid(heapTuple = systable_getnext(scanDesc))) {
-        if (*ShardTableShmemCacheCount >= SHARD_COUNT_MAX) {
-            exceedMaxNumOfShardTable = true;
-            break;
-        }
+        Datum datumArray[Natts_falcon_shard_table];
+        bool isNullArray[Natts_falcon_shard_table];
+        HeapTuple heapTuple;
+        while (HeapTupleIsValid(heapTuple = systable_getnext(scanDesc))) {
+            if (*ShardTableShmemCacheCount >= SHARD_COUNT_MAX) {
+                exceedMaxNumOfShardTable = true;
+                break;
+            }
 
-        heap_deform_tuple(heapTuple, tupleDesc, datumArray, isNullArray);
+            heap_deform_tuple(heapTuple, tupleDesc, datumArray, isNullArray);
 
-        ShardTableShmemCache[*ShardTableShmemCacheCount].range_point =
-            DatumGetInt32(datumArray[Anum_falcon_shard_table_range_point - 1]);
-        ShardTableShmemCache[*ShardTableShmemCacheCount].server_id =
-            DatumGetInt32(datumArray[Anum_falcon_shard_table_server_id - 1]);
+            ShardTableShmemCache[*ShardTableShmemCacheCount].range_point =
+                DatumGetInt32(datumArray[Anum_falcon_shard_table_range_point - 1]);
+            ShardTableShmemCache[*ShardTableShmemCacheCount].server_id =
+                DatumGetInt32(datumArray[Anum_falcon_shard_table_server_id - 1]);
 
-        ++*ShardTableShmemCacheCount;
+            ++*ShardTableShmemCacheCount;
+        }
+        systable_endscan_ordered(scanDesc);
+        index_close(relIndex, AccessShareLock);
+        table_close(rel, AccessShareLock);
+    }
+    PG_CATCH();
+    {
+        // the rows may be incomplete, the next lookup has to load them again
+        InvalidateShardTableShmemCache();
+        pg_write_barrier();
+        pg_atomic_fetch_add_u64(ShardTableShmemCacheVersion, 1);
+        PG_RE_THROW();
     }
-    systable_endscan_ordered(scanDesc);
-    index_close(relIndex, AccessShareLock);
-    table_close(rel, AccessShareLock);
+    PG_END_TRY();
+
+    uint64_t epoch = SHARD_TABLE_EPOCH_INIT;
+    for (int i = 0; i < *ShardTableShmemCacheCount; ++i)
+        epoch = ShardTableEpochAddRow(epoch, ShardTableShmemCache[i].range_point, ShardTableShmemCache[i].server_id);
+    pg_atomic_write_u64(ShardTableShmemCacheEpoch, ShardTableEpochFinish(epoch));
+    pg_write_barrier();
+    pg_atomic_fetch_add_u64(ShardTableShmemCacheVersion, 1);
 
     if (exceedMaxNumOfShardTable) {
         InvalidateShardTableShmemCache();
@@ -378,3 +439,38 @@ void ReloadShardTableShmemCache()
 
     LWLockRelease(&ShardTableShmemControl->lock);
 }
+
+uint64_t GetShardTableEpoch()
+{
+    uint64_t version = pg_atomic_read_u64(ShardTableShmemCacheVersion);
+    if ((version & 1) != 0 || pg_atomic_read_u32(ShardTableShmemCacheInvalid))
+        return SHARD_TABLE_EPOCH_UNKNOWN;
+    pg_read_barrier();
+    uint64_t epoch = pg_atomic_read_u64(ShardTableShmemCacheEpoch);
+    pg_read_barrier();
+    return pg_atomic_read_u64(ShardTableShmemCacheVersion) == version ? epoch : SHARD_TABLE_EPOCH_UNKNOWN;
+}
+
+int32_t ShardTableCopyLockFree(int32_t *rangePoints, int32_t *serverIds, int32_t capacity, uint64_t *epoch)
+{
+    for (int retry = 0; retry < SHARD_TABLE_LOCK_FREE_COPY_RETRY; ++retry) {
+        uint64_t version = pg_atomic_read_u64(ShardTableShmemCacheVersion);
+        if (pg_atomic_read_u32(ShardTableShmemCacheInvalid))
+            return -1;
+        if ((version & 1) != 0) {
+            pg_usleep(SHARD_TABLE_LOCK_FREE_COPY_RETRY_INTERVAL_US);
+            continue;
+        }
+        pg_read_barrier();
+        int32_t count = *(volatile int32_t *)ShardTableShmemCacheCount;
+        *epoch = pg_atomic_read_u64(ShardTableShmemCacheEpoch);
+        for (int32_t i = 0; i < count && count <= capacity; ++i) {
+            rangePoints[i] = ShardTableShmemCache[i].range_point;
+            serverIds[i] = ShardTableShmemCache[i].server_id;
+        }
+        pg_read_barrier();
+        if (pg_atomic_read_u64(ShardTableShmemCacheVersion) == version)
+            return count;
+    }
+    return -1;
+}
@@ -19,7 +19,9 @@
 #include "dir_path_shmem/dir_path_hash.h"
 #include "distributed_backend/remote_comm.h"
 #include "distributed_backend/remote_comm_falcon.h"
+#include "metadb/directory_log.h"
 #include "metadb/foreign_server.h"
+#include "metadb/inode_attr_cache.h"
 #include "transaction/transaction_cleanup.h"
 #include "utils/error_log.h"
 #include "utils/path_parse.h"
@@ -120,6 +122,7 @@ extern void FalconExplicitTransactionCommitPrepared(const char *gid)
         FALCON_ELOG_ERROR(PROGRAM_ERROR, "incorrect transaction state.");
 
     PreventInTransactionBlock(true, "COMMIT PREPARED");
+    InodeAttrCacheInvalidateAllAtCommit();
     FinishPreparedTransaction(gid, true);
     CommitTransactionCommand();
 
@@ -151,16 +154,22 @@ static void FalconTransactionCallback(XactEvent event, void *args)
 
         TransactionLevelPathParseReset();
         CommitForDirPathHash();
+        DirectoryLogAtTransactionEnd();
         RWLockReleaseAll(false);
         ClearRemoteTransactionGid();
         ClearRemoteConnectionCommand();
+        FalconNamespaceGenerationAdvanceIfDirty();
+        InodeAttrCacheAtTransactionEnd();
         break;
     }
     case XACT_EVENT_ABORT: {
         FalconEnterAbortProgress();
+        FalconNamespaceGenerationResetDirty();
 
         TransactionLevelPathParseReset();
         AbortForDirPathHash();
+        InodeAttrCacheAtTransactionEnd();
+        DirectoryLogAtTransactionEnd();
         RWLockReleaseAll(true);
         if (!FalconRemoteCommandAbort())
             FALCON_ELOG_WARNING(PROGRAM_ERROR, "Abort failed on some servers.");
@@ -173,10 +182,14 @@ static void FalconTransactionCallback(XactEvent event, void *args)
         break;
     }
     case XACT_EVENT_PRE_PREPARE: {
+        DirectoryLogAtPrePrepare();
         break;
     }
     case XACT_EVENT_PREPARE: {
         TransactionLevelPathParseReset();
+        // generation will be advanced by whoever commits the prepared transaction
+        FalconNamespaceGenerationResetDirty();
+        InodeAttrCacheAtTransactionEnd();
         break;
     }
     case XACT_EVENT_PARALLEL_COMMIT:
@@ -26,6 +26,7 @@
 #include "utils/snapmgr.h"
 
 #include "control/control_flag.h"
+#include "dir_path_shmem/dir_path_hash.h"
 #include "distributed_backend/remote_comm.h"
 #include "distributed_backend/remote_comm_falcon.h"
 #include "metadb/foreign_server.h"
@@ -90,6 +91,10 @@ void FalconDaemon2PCFailureCleanupProcessMain(Datum main_arg)
         }
         sleep(1);
     }
+    // warm up path resolution before requests are served
+    StartTransactionCommand();
+    PreloadDirPathHash();
+    CommitTransactionCommand();
     bool serviceStarted = false;
     do {
         sleep(1);
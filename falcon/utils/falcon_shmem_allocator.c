@@ -10,7 +10,7 @@
 
 int FalconShmemAllocatorInit(FalconShmemAllocator *allocator, char *shmem, uint64_t size)
 {
-    uint32_t pageCount = (size - sizeof(PaddedAtomic64) * (1 + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT)) /
+    uint32_t pageCount = (size - sizeof(PaddedAtomic64) * FALCON_SHMEM_ALLOCATOR_HEADER_COUNT) /
                          (sizeof(PaddedAtomic64) + FALCON_SHMEM_ALLOCATOR_PAGE_SIZE);
     if (pageCount == 0)
         return -1;
@@ -21,7 +21,8 @@ int FalconShmemAllocatorInit(FalconShmemAllocator *allocator, char *shmem, uint6
 
     allocator->signatureCounter = (PaddedAtomic64 *)shmem;
     allocator->freeListHint = allocator->signatureCounter + 1;
-    allocator->pageCntlArray = allocator->freeListHint + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->counter = allocator->freeListHint + FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->pageCntlArray = allocator->counter + FALCON_SHMEM_ALLOCATOR_COUNTER_COUNT;
     allocator->allocatableSpaceBase = (char *)(allocator->pageCntlArray + pageCount);
     return 0;
 }
@@ -57,9 +58,59 @@ static uint64_t LevelBlockOccupyBitMap[FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT] =
                                                                                   0x0000000000000003,
                                                                                   0x0000000000000001};
 
+// collapse the bitmap of a page so that the bits of level tell which blocks of that level are (partly) used
+static inline uint64_t GetLevelBitmap(uint64_t bitmap, int level)
+{
+    int shift = 1;
+    for (int j = FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT - 1; j > level; --j) {
+        bitmap = ((bitmap >> shift) | bitmap) & LevelBlockMask[j - 1];
+        shift <<= 1;
+    }
+    return bitmap;
+}
+
+// take pageNeeded contiguous empty pages, a page taken by a block allocation meanwhile makes us roll back and
+// continue behind it
+static uint64_t FalconShmemAllocatorMallocPages(FalconShmemAllocator *allocator, uint64_t size)
+{
+    uint64_t requiredSize = size + sizeof(MemoryHdr);
+    uint32_t pageNeeded = (requiredSize + FALCON_SHMEM_ALLOCATOR_PAGE_SIZE - 1) / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+
+    uint32_t pageNo = 0;
+    while (pageNo + pageNeeded <= allocator->pageCount) {
+        uint32_t claimed = 0;
+        while (claimed < pageNeeded) {
+            uint64_t expected = 0;
+            if (!atomic_compare_exchange_strong_explicit(&allocator->pageCntlArray[pageNo + claimed].data,
+                                                         &expected,
+                                                         ~(uint64_t)0,
+                                                         memory_order_relaxed,
+                                                         memory_order_relaxed))
+                break;
+            ++claimed;
+        }
+        if (claimed == pageNeeded) {
+            uint64_t allocatedShift = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * (uint64_t)pageNo;
+            MemoryHdr *hdr = (MemoryHdr *)FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, allocatedShift);
+            hdr->size = size;
+            hdr->capacity = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * (uint64_t)pageNeeded;
+            hdr->signature = 0;
+            FalconShmemAllocatorCount(allocator, FALCON_SHMEM_ALLOCATOR_COUNTER_MULTI_PAGE_ALLOC);
+            return allocatedShift + sizeof(MemoryHdr);
+        }
+        for (uint32_t i = 0; i < claimed; ++i)
+            atomic_store_explicit(&allocator->pageCntlArray[pageNo + i].data, 0, memory_order_relaxed);
+        pageNo += claimed + 1;
+    }
+    FalconShmemAllocatorCount(allocator, FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_FAIL);
+    return 0;
+}
+
 uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t size)
 {
     if (size > FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE - sizeof(MemoryHdr)) {
+        if (FalconShmemAllocatorCanFit(allocator, size))
+            return FalconShmemAllocatorMallocPages(allocator, size);
         printf("asked size exceed limit, size: %" PRIu64 ".", size);
         fflush(stdout);
         return 0; // valid shift of allocated buffer cannot be zero, since there must be a memory head before it
@@ -102,11 +153,7 @@ uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t si
                     expected = bitmap;
 
                     // Shift several time to get the bitmap of corresponding level
-                    int shift = 1;
-                    for (int j = FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT - 1; j > level; --j) {
-                        bitmap = ((bitmap >> shift) | bitmap) & LevelBlockMask[j - 1];
-                        shift <<= 1;
-                    }
+                    bitmap = GetLevelBitmap(bitmap, level);
 
                     if (bitmap == LevelBlockMask[level]) // all of the blocks in this level is used
                         break;
@@ -173,8 +220,8 @@ uint64_t FalconShmemAllocatorMalloc(FalconShmemAllocator *allocator, uint64_t si
             }
         }
     }
-    printf("FalconShmemAllocatorMalloc: Cannot find a segment.");
-    fflush(stdout);
+    // callers decide whether to wait or fail, the counter tells how often this happens
+    FalconShmemAllocatorCount(allocator, FALCON_SHMEM_ALLOCATOR_COUNTER_ALLOC_FAIL);
     return 0;
 }
 
@@ -183,8 +230,27 @@ void FalconShmemAllocatorFree(FalconShmemAllocator *allocator, uint64_t shift)
     shift -= sizeof(MemoryHdr);
     MemoryHdr *hdr = (MemoryHdr *)FALCON_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift);
     uint64_t capacity = hdr->capacity;
-    if (capacity < FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE ||
-        capacity > FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE)
+    if (capacity > FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE) {
+        if (capacity % FALCON_SHMEM_ALLOCATOR_PAGE_SIZE != 0 || shift % FALCON_SHMEM_ALLOCATOR_PAGE_SIZE != 0)
+            return;
+        uint64_t firstPageNo = shift / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+        uint64_t pageCount = capacity / FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+        for (uint64_t pageNo = firstPageNo; pageNo < firstPageNo + pageCount; ++pageNo)
+            atomic_store_explicit(&allocator->pageCntlArray[pageNo].data, 0, memory_order_relaxed);
+        uint64_t freeHint = atomic_load_explicit(&allocator->freeListHint[0].data, memory_order_relaxed);
+        while (true) {
+            if (freeHint <= firstPageNo)
+                break;
+            if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[0].data,
+                                                      &freeHint,
+                                                      firstPageNo,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        return;
+    }
+    if (capacity < FALCON_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE)
         return;
     int level = __builtin_ctzll(FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE) - __builtin_ctzll(capacity);
     if (capacity != (FALCON_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE >> level))
@@ -209,3 +275,49 @@ void FalconShmemAllocatorFree(FalconShmemAllocator *allocator, uint64_t shift)
             break;
     }
 }
+
+bool FalconShmemAllocatorCanFit(FalconShmemAllocator *allocator, uint64_t size)
+{
+    return size + sizeof(MemoryHdr) <= FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * (uint64_t)allocator->pageCount;
+}
+
+void FalconShmemAllocatorCount(FalconShmemAllocator *allocator, FalconShmemAllocatorCounterType type)
+{
+    atomic_fetch_add_explicit(&allocator->counter[type].data, 1, memory_order_relaxed);
+}
+
+void FalconShmemAllocatorGetStats(FalconShmemAllocator *allocator, FalconShmemAllocatorStats *stats)
+{
+    stats->totalSize = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE * (uint64_t)allocator->pageCount;
+    stats->usedSize = 0;
+    stats->freePageCount = 0;
+    stats->largestFreeBlock = 0;
+
+    uint64_t freePageRun = 0;
+    for (uint32_t pageNo = 0; pageNo < allocator->pageCount; ++pageNo) {
+        uint64_t bitmap = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_relaxed);
+        stats->usedSize += (uint64_t)__builtin_popcountll(bitmap) * FALCON_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE;
+        if (bitmap == 0) {
+            ++stats->freePageCount;
+            ++freePageRun;
+            if (freePageRun * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE > stats->largestFreeBlock)
+                stats->largestFreeBlock = freePageRun * FALCON_SHMEM_ALLOCATOR_PAGE_SIZE;
+            continue;
+        }
+        freePageRun = 0;
+        // the lowest level with a free block gives the largest block left in this page
+        for (int level = 1; level < FALCON_SHMEM_ALLOCATOR_FREE_LIST_COUNT; ++level) {
+            if (GetLevelBitmap(bitmap, level) != LevelBlockMask[level]) {
+                uint64_t blockSize = FALCON_SHMEM_ALLOCATOR_PAGE_SIZE >> level;
+                if (blockSize > stats->largestFreeBlock)
+                    stats->largestFreeBlock = blockSize;
+                break;
+            }
+        }
+    }
+    if (stats->largestFreeBlock >= sizeof(MemoryHdr))
+        stats->largestFreeBlock -= sizeof(MemoryHdr);
+
+    for (int i = 0; i < FALCON_SHMEM_ALLOCATOR_COUNTER_COUNT; ++i)
+        stats->counter[i] = atomic_load_explicit(&allocator->counter[i].data, memory_order_relaxed);
+}
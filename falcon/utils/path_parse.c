@@ -8,6 +8,7 @@
 
 #include "catalog/namespace.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/palloc.h"
 #include "utils/syscache.h"
@@ -15,6 +16,7 @@
 
 #include "dir_path_shmem/dir_path_hash.h"
 #include "distributed_backend/remote_comm.h"
+#include "metadb/directory_log.h"
 #include "utils/error_log.h"
 #include "utils/utils.h"
 
@@ -23,6 +25,28 @@ static MemoryContext PathParseContext = NULL;
 // TBD: maybe we need only reset TransactionLevelPathParseRoot while top transaction is commited or prepared.
 //      this can be done by additional check in transaction.c
 static PathParseTree TransactionLevelPathParseRoot = NULL;
+// workers catch up with the directory log of the CN at most once per transaction on a missing directory
+static bool TransactionLevelDirectoryLogCaughtUp = false;
+
+/*
+ * Backend level cache from a directory path prefix, ending with '/', to the refs of all directories along it. A
+ * ref stays usable until its directory is renamed, removed or evicted from the directory path hash, so the
+ * deepest cached ancestor of a path can be locked without resolving it level by level.
+ */
+#define PATH_PREFIX_CACHE_CAPACITY 1024
+#define PATH_PREFIX_CACHE_MAX_LENGTH 512
+#define PATH_PREFIX_CACHE_MAX_DEPTH 64
+typedef struct PathPrefixCacheEntry
+{
+    char prefix[PATH_PREFIX_CACHE_MAX_LENGTH];
+    int depth;
+    DirPathHashRef *levels;
+} PathPrefixCacheEntry;
+static MemoryContext PathPrefixCacheContext = NULL;
+static HTAB *PathPrefixCache = NULL;
+
+static int PathPrefixCacheLookup(const char *path, int prefixLength, PathPrefixCacheEntry **entry);
+static void PathPrefixCacheInsert(const char *path, int prefixLength, PathParseRBTreeNode **chain, int depth);
 
 static int PathParseRBT_cmp(const RBTNode *a, const RBTNode *b, void *arg)
 {
@@ -55,6 +79,7 @@ void PathParseTreeInit(PathParseRBTreeNode *root)
     root->inodeId = 0;
     root->name = NULL;
     root->children = NULL;
+    root->ref.item = NULL;
 }
 
 uint64_t CheckWhetherPathExistsInDirectoryTable(Relation directoryRel, const char *path)
@@ -97,14 +122,92 @@ void PathParseMemoryContextInit()
                                              ALLOCSET_DEFAULT_MINSIZE,
                                              ALLOCSET_DEFAULT_INITSIZE,
                                              ALLOCSET_DEFAULT_MAXSIZE);
+    PathPrefixCacheContext = AllocSetContextCreate(TopMemoryContext,
+                                                   "falcon path prefix cache memory context",
+                                                   ALLOCSET_DEFAULT_MINSIZE,
+                                                   ALLOCSET_DEFAULT_INITSIZE,
+                                                   ALLOCSET_DEFAULT_MAXSIZE);
+}
+
+// returns the depth of the deepest cached prefix of path[0, prefixLength), 0 if there is none
+static int PathPrefixCacheLookup(const char *path, int prefixLength, PathPrefixCacheEntry **entry)
+{
+    if (PathPrefixCache == NULL)
+        return 0;
+
+    char prefix[PATH_PREFIX_CACHE_MAX_LENGTH];
+    while (prefixLength > 0) {
+        if (prefixLength < PATH_PREFIX_CACHE_MAX_LENGTH) {
+            memcpy(prefix, path, prefixLength);
+            prefix[prefixLength] = '\0';
+            *entry = (PathPrefixCacheEntry *)hash_search(PathPrefixCache, prefix, HASH_FIND, NULL);
+            if (*entry != NULL)
+                return (*entry)->depth;
+        }
+        // step back to the prefix of the parent
+        --prefixLength;
+        while (prefixLength > 0 && path[prefixLength - 1] != '/')
+            --prefixLength;
+    }
+    return 0;
+}
+
+static void PathPrefixCacheInsert(const char *path, int prefixLength, PathParseRBTreeNode **chain, int depth)
+{
+    if (prefixLength >= PATH_PREFIX_CACHE_MAX_LENGTH || depth == 0 || depth > PATH_PREFIX_CACHE_MAX_DEPTH)
+        return;
+    // directories created or locked exclusively by this transaction may not be committed
+    for (int i = 0; i < depth; ++i) {
+        if (chain[i]->lockAcquired != PP_SHARED || chain[i]->ref.item == NULL)
+            return;
+    }
+
+    if (PathPrefixCache != NULL && hash_get_num_entries(PathPrefixCache) >= PATH_PREFIX_CACHE_CAPACITY) {
+        MemoryContextReset(PathPrefixCacheContext);
+        PathPrefixCache = NULL;
+    }
+    if (PathPrefixCache == NULL) {
+        HASHCTL info;
+        memset(&info, 0, sizeof(info));
+        info.keysize = PATH_PREFIX_CACHE_MAX_LENGTH;
+        info.entrysize = sizeof(PathPrefixCacheEntry);
+        info.hcxt = PathPrefixCacheContext;
+        PathPrefixCache = hash_create("Falcon Path Prefix Cache",
+                                      PATH_PREFIX_CACHE_CAPACITY,
+                                      &info,
+                                      HASH_ELEM | HASH_STRINGS | HASH_CONTEXT);
+    }
+
+    char prefix[PATH_PREFIX_CACHE_MAX_LENGTH];
+    memcpy(prefix, path, prefixLength);
+    prefix[prefixLength] = '\0';
+    bool found;
+    PathPrefixCacheEntry *entry = (PathPrefixCacheEntry *)hash_search(PathPrefixCache, prefix, HASH_ENTER, &found);
+    if (!found || entry->depth != depth) {
+        if (found)
+            pfree(entry->levels);
+        entry->levels = MemoryContextAlloc(PathPrefixCacheContext, sizeof(DirPathHashRef) * depth);
+        entry->depth = depth;
+    }
+    for (int i = 0; i < depth; ++i)
+        entry->levels[i] = chain[i]->ref;
 }
 
 void TransactionLevelPathParseReset()
 {
     TransactionLevelPathParseRoot = NULL;
+    TransactionLevelDirectoryLogCaughtUp = false;
     MemoryContextReset(PathParseContext);
 }
 
+static FalconErrorCode PathParseTreeInsertOnce(PathParseTree root,
+                                               Relation directoryRel,
+                                               const char *path,
+                                               uint16_t flag,
+                                               uint64_t *parentId,
+                                               char **fileName,
+                                               uint64_t *inodeId);
+
 FalconErrorCode PathParseTreeInsert(PathParseTree root,
                                     Relation directoryRel,
                                     const char *path,
@@ -112,6 +215,24 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
                                     uint64_t *parentId,
                                     char **fileName,
                                     uint64_t *inodeId)
+{
+    FalconErrorCode errorCode = PathParseTreeInsertOnce(root, directoryRel, path, flag, parentId, fileName, inodeId);
+    // the directory may have been created on the CN but not applied here yet, nothing is left in the tree for it
+    if ((errorCode == PATH_IS_INVALID || errorCode == PATH_NOT_EXISTS) && !TransactionLevelDirectoryLogCaughtUp) {
+        TransactionLevelDirectoryLogCaughtUp = true;
+        if (DirectoryLogCatchUpWithCN())
+            errorCode = PathParseTreeInsertOnce(root, directoryRel, path, flag, parentId, fileName, inodeId);
+    }
+    return errorCode;
+}
+
+static FalconErrorCode PathParseTreeInsertOnce(PathParseTree root,
+                                               Relation directoryRel,
+                                               const char *path,
+                                               uint16_t flag,
+                                               uint64_t *parentId,
+                                               char **fileName,
+                                               uint64_t *inodeId)
 {
     if (path[0] == '/' && path[1] == '\0' && (flag & PATH_PARSE_FLAG_NOT_ROOT)) {
         return PATH_IS_ROOT;
@@ -125,6 +246,13 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
         root = TransactionLevelPathParseRoot;
     }
 
+    const char *lastSlash = strrchr(path, '/');
+    PathPrefixCacheEntry *prefixEntry = NULL;
+    int cachedDepth = lastSlash ? PathPrefixCacheLookup(path, lastSlash - path + 1, &prefixEntry) : 0;
+    bool prefixCacheMiss = false;
+    PathParseRBTreeNode *chain[PATH_PREFIX_CACHE_MAX_DEPTH];
+    int depth = 0;
+
     int currentFileNameStartPos = 0;
     int currentFileNameLength = 1;
     PathParseRBTreeNode *currentNode = root;
@@ -143,10 +271,23 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
                 return PATH_LOCK_CONFLICT;
         }
         if (node == NULL) {
-            uint64_t currentDirectoryId =
-                SearchDirectoryByDirectoryHashTable(directoryRel, currentNode->inodeId, target.name, DIR_LOCK_SHARED);
-            if (currentDirectoryId == -1)
-                return PATH_IS_INVALID;
+            uint64_t currentDirectoryId;
+            if (depth < cachedDepth &&
+                AcquireDirectoryByDirPathHashRef(&prefixEntry->levels[depth], DIR_LOCK_SHARED)) {
+                currentDirectoryId = prefixEntry->levels[depth].inodeId;
+                target.ref = prefixEntry->levels[depth];
+            } else {
+                // deeper cached levels may belong to a former directory of the same path
+                cachedDepth = 0;
+                prefixCacheMiss = true;
+                currentDirectoryId = SearchDirectoryByDirectoryHashTable(directoryRel,
+                                                                         currentNode->inodeId,
+                                                                         target.name,
+                                                                         DIR_LOCK_SHARED);
+                if (currentDirectoryId == -1)
+                    return PATH_IS_INVALID;
+                DirPathHashGetLastAcquiredRef(&target.ref);
+            }
 
             if (!currentNode->children) {
                 MemoryContext oldContext = MemoryContextSwitchTo(PathParseContext);
@@ -165,8 +306,14 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             node = (PathParseRBTreeNode *)rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
         } else if (node->lockAcquired == PP_NONE) {
             SearchDirectoryByDirectoryHashTable(directoryRel, node->inodeId, node->name, DIR_LOCK_SHARED);
+            DirPathHashGetLastAcquiredRef(&node->ref);
             node->lockAcquired = PP_SHARED;
         }
+        if (depth < cachedDepth && node->inodeId != prefixEntry->levels[depth].inodeId)
+            cachedDepth = 0;
+        if (depth < PATH_PREFIX_CACHE_MAX_DEPTH)
+            chain[depth] = node;
+        ++depth;
 
         if (currentFileNameStartPos == 0)
             currentFileNameStartPos = 1;
@@ -178,6 +325,8 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             ++currentFileNameLength;
         currentNode = node;
     }
+    if (prefixCacheMiss)
+        PathPrefixCacheInsert(path, currentFileNameStartPos, chain, depth);
     if (parentId != NULL)
         *parentId = currentNode->inodeId;
     if (fileName != NULL) {
@@ -223,6 +372,7 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
             }
             target.inodeId = *inodeId;
             target.children = NULL;
+            target.ref.item = NULL;
             if (flag & PATH_PARSE_FLAG_ALLOW_OPERATION_UNDER_CREATED_DIRECTORY)
                 target.lockAcquired = PP_EXCLUSIVE_FOR_CREATE;
             else
@@ -280,6 +430,7 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
         } else {
             target.inodeId = *inodeId;
             target.children = NULL;
+            target.ref.item = NULL;
             target.lockAcquired = PP_EXCLUSIVE;
             bool isNew;
             rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
@@ -316,16 +467,19 @@ FalconErrorCode PathParseTreeInsert(PathParseTree root,
 
             target.inodeId = currentDirectoryId;
             target.children = NULL;
+            target.ref.item = NULL;
             if (currentDirectoryId == DIR_HASH_TABLE_PATH_NOT_EXIST) {
                 RWLockRelease(DirectoryHashTableLastAcquiredLock);
                 target.lockAcquired = PP_NONE;
             } else {
+                DirPathHashGetLastAcquiredRef(&target.ref);
                 target.lockAcquired = PP_SHARED;
             }
             bool isNew;
             node = (PathParseRBTreeNode *)rbt_insert(currentNode->children, (RBTNode *)&target, &isNew);
         } else if (node->inodeId != DIR_HASH_TABLE_PATH_NOT_EXIST && node->lockAcquired == PP_NONE) {
             SearchDirectoryByDirectoryHashTable(directoryRel, node->inodeId, node->name, DIR_LOCK_SHARED);
+            DirPathHashGetLastAcquiredRef(&node->ref);
             node->lockAcquired = PP_SHARED;
         }
 
@@ -343,6 +497,13 @@ FalconErrorCode VerifyPathValidity(const char *path, int32_t requirement, int32_
         return PATH_IS_INVALID;
 
     int pathLen = strlen(path);
+    // components are keys of the directory path hash, which can't hold longer names
+    int componentLen = 0;
+    for (int i = 1; i < pathLen; ++i) {
+        componentLen = path[i] == '/' ? 0 : componentLen + 1;
+        if (componentLen >= MAX_DIRECTORY_PATH_HASH_SIZE)
+            return NAME_TOO_LONG;
+    }
     if (path[pathLen - 1] == '/') // path ends with '/'
     {
         *property |= VERIFY_PATH_VALIDITY_PROPERTY_CAN_BE_DIRECTORY;
@@ -6,6 +6,8 @@
 
 #include "miscadmin.h"
 #include "storage/s_lock.h"
+#include "storage/shmem.h"
+#include "utils/timestamp.h"
 
 #include "utils/error_log.h"
 
@@ -24,10 +26,22 @@
 #define RW_SHARED_MASK ((uint64_t)((1ULL << BIT_COUNT_FOR_SHARED) - 1))
 #define RW_REF_COUNT_MASK (((uint64_t)((1ULL << (BIT_COUNT_FOR_SHARED * 2 + 2)) - 1)) & ~RW_LOCK_MASK)
 
+#define RW_BIAS_OFF 0
+#define RW_BIAS_ON 1
+// revoked without waiting, readers which took the lock while it was biased may still hold it
+#define RW_BIAS_REVOKED 2
+
+#define RW_VISIBLE_READERS_BITS 12
+#define RW_VISIBLE_READERS_SIZE (1 << RW_VISIBLE_READERS_BITS)
+// the bias stays inhibited for this multiple of the time its revocation took
+#define RW_BIAS_INHIBIT_MULTIPLIER 9
+
 typedef struct RWLockHandle
 {
     RWLock *lock;
     RWLockMode mode;
+    // slot of the visible readers table, -1 if the lock was acquired through its state
+    int slot;
 } RWLockHandle;
 
 #define MAX_SIMUL_RWLOCKS 8196
@@ -35,9 +49,105 @@ typedef struct RWLockHandle
 static int num_held_rwlocks = 0;
 static RWLockHandle held_rwlocks[MAX_SIMUL_RWLOCKS];
 
+static pg_atomic_uint64 *RWLockVisibleReaders = NULL;
+
 static int8_t RWLockAttemptLock(RWLock *lock, RWLockMode mode);
+static int RWLockVisibleReaderSlot(RWLock *lock);
+static bool RWLockVisibleReadersContain(RWLock *lock, bool wait);
+static void RWLockRevokeBias(RWLock *lock);
+static void RWLockMakeBiased(RWLock *lock);
+
+size_t RWLockShmemsize(void) { return sizeof(pg_atomic_uint64) * RW_VISIBLE_READERS_SIZE; }
+
+void RWLockShmemInit(void)
+{
+    bool initialized;
+    RWLockVisibleReaders = (pg_atomic_uint64 *)ShmemInitStruct("Falcon RWLock visible readers",
+                                                               sizeof(pg_atomic_uint64) * RW_VISIBLE_READERS_SIZE,
+                                                               &initialized);
+    if (!initialized) {
+        for (int i = 0; i < RW_VISIBLE_READERS_SIZE; ++i)
+            pg_atomic_init_u64(&RWLockVisibleReaders[i], 0);
+    }
+}
+
+void RWLockInitialize(RWLock *lock)
+{
+    pg_atomic_init_u64(&lock->state, 0);
+    pg_atomic_init_u32(&lock->readerBias, RW_BIAS_OFF);
+    pg_atomic_init_u64(&lock->biasInhibitUntil, 0);
+}
+
+static int RWLockVisibleReaderSlot(RWLock *lock)
+{
+    uint64_t hash = ((uint64_t)(uintptr_t)lock ^ ((uint64_t)MyProcPid << 40)) * UINT64CONST(0x9E3779B97F4A7C15);
+    return (int)(hash >> (64 - RW_VISIBLE_READERS_BITS));
+}
+
+static bool RWLockVisibleReadersContain(RWLock *lock, bool wait)
+{
+    uint64_t value = (uint64_t)(uintptr_t)lock;
+    for (int i = 0; i < RW_VISIBLE_READERS_SIZE; ++i) {
+        if (pg_atomic_read_u64(&RWLockVisibleReaders[i]) != value)
+            continue;
+        if (!wait)
+            return true;
+        SpinDelayStatus delayStatus;
+        init_local_spin_delay(&delayStatus);
+        while (pg_atomic_read_u64(&RWLockVisibleReaders[i]) == value)
+            perform_spin_delay(&delayStatus);
+        finish_spin_delay(&delayStatus);
+    }
+    return false;
+}
 
-void RWLockInitialize(RWLock *lock) { pg_atomic_init_u64(&lock->state, 0); }
+/* the lock must be held exclusively */
+static void RWLockRevokeBias(RWLock *lock)
+{
+    if (pg_atomic_read_u32(&lock->readerBias) == RW_BIAS_OFF)
+        return;
+    TimestampTz start = GetCurrentTimestamp();
+    pg_atomic_write_u32(&lock->readerBias, RW_BIAS_OFF);
+    // pairs with the barrier between publishing a visible reader and checking the bias
+    pg_memory_barrier();
+    RWLockVisibleReadersContain(lock, true);
+    TimestampTz end = GetCurrentTimestamp();
+    pg_atomic_write_u64(&lock->biasInhibitUntil, end + (end - start) * RW_BIAS_INHIBIT_MULTIPLIER);
+}
+
+/* the lock must be held in shared mode through its state */
+static void RWLockMakeBiased(RWLock *lock)
+{
+    if (RWLockVisibleReaders == NULL || pg_atomic_read_u32(&lock->readerBias) == RW_BIAS_ON)
+        return;
+    uint64_t inhibitUntil = pg_atomic_read_u64(&lock->biasInhibitUntil);
+    if (inhibitUntil != 0 && GetCurrentTimestamp() < (TimestampTz)inhibitUntil)
+        return;
+    pg_atomic_write_u32(&lock->readerBias, RW_BIAS_ON);
+}
+
+bool RWLockAcquireBiased(RWLock *lock)
+{
+    if (RWLockVisibleReaders == NULL || pg_atomic_read_u32(&lock->readerBias) != RW_BIAS_ON)
+        return false;
+    if (num_held_rwlocks >= MAX_SIMUL_RWLOCKS)
+        FALCON_ELOG_ERROR(PROGRAM_ERROR, "too many RWLocks taken");
+
+    int slot = RWLockVisibleReaderSlot(lock);
+    uint64_t expected = 0;
+    if (!pg_atomic_compare_exchange_u64(&RWLockVisibleReaders[slot], &expected, (uint64_t)(uintptr_t)lock))
+        return false;
+    if (pg_atomic_read_u32(&lock->readerBias) != RW_BIAS_ON) {
+        pg_atomic_write_u64(&RWLockVisibleReaders[slot], 0);
+        return false;
+    }
+    HOLD_INTERRUPTS();
+
+    held_rwlocks[num_held_rwlocks].lock = lock;
+    held_rwlocks[num_held_rwlocks].slot = slot;
+    held_rwlocks[num_held_rwlocks++].mode = RW_SHARED;
+    return true;
+}
 
 /*
  * return value:
@@ -93,6 +203,7 @@ void RWLockDeclare(RWLock *lock)
     pg_atomic_fetch_add_u64(&lock->state, RW_VAL_REF_COUNT);
 
     held_rwlocks[num_held_rwlocks].lock = lock;
+    held_rwlocks[num_held_rwlocks].slot = -1;
     held_rwlocks[num_held_rwlocks++].mode = RW_DECLARE;
 }
 
@@ -119,10 +230,25 @@ void RWLockUndeclare(RWLock *lock)
     RESUME_INTERRUPTS();
 }
 
+/*
+ * Readers holding the lock through its bias hold no reference. A biased lock is revoked and reported in use
+ * once, so that only locks which weren't taken since pay for looking through the visible readers.
+ */
 bool RWLockCheckDestroyable(RWLock *lock)
 {
     uint64_t state = pg_atomic_read_u64(&lock->state);
-    return (state & RW_REF_COUNT_MASK) == 0;
+    if ((state & RW_REF_COUNT_MASK) != 0)
+        return false;
+
+    uint32 bias = RW_BIAS_ON;
+    if (pg_atomic_compare_exchange_u32(&lock->readerBias, &bias, RW_BIAS_REVOKED))
+        return false;
+    if (bias == RW_BIAS_OFF)
+        return true;
+    pg_memory_barrier();
+    if (RWLockVisibleReadersContain(lock, false))
+        return false;
+    return pg_atomic_compare_exchange_u32(&lock->readerBias, &bias, RW_BIAS_OFF);
 }
 
 void RWLockAcquire(RWLock *lock, RWLockMode mode)
@@ -131,6 +257,8 @@ void RWLockAcquire(RWLock *lock, RWLockMode mode)
         FALCON_ELOG_ERROR(PROGRAM_ERROR, "not supported mode");
     if (num_held_rwlocks >= MAX_SIMUL_RWLOCKS)
         FALCON_ELOG_ERROR(PROGRAM_ERROR, "too many RWLocks taken");
+    if (mode == RW_SHARED && RWLockAcquireBiased(lock))
+        return;
     HOLD_INTERRUPTS();
 
     pg_atomic_fetch_add_u64(&lock->state, RW_VAL_REF_COUNT);
@@ -148,13 +276,20 @@ void RWLockAcquire(RWLock *lock, RWLockMode mode)
     }
     finish_spin_delay(&delayStatus);
 
+    if (mode == RW_EXCLUSIVE)
+        RWLockRevokeBias(lock);
+    else
+        RWLockMakeBiased(lock);
+
     held_rwlocks[num_held_rwlocks].lock = lock;
+    held_rwlocks[num_held_rwlocks].slot = -1;
     held_rwlocks[num_held_rwlocks++].mode = mode;
 }
 
 void RWLockRelease(RWLock *lock)
 {
     RWLockMode mode;
+    int slot;
     int i;
     /*
      * Remove lock from list of locks held, Usually, but not always, it will
@@ -166,10 +301,18 @@ void RWLockRelease(RWLock *lock)
     if (i < 0)
         FALCON_ELOG_ERROR(PROGRAM_ERROR, "lock is not held");
     mode = held_rwlocks[i].mode;
+    slot = held_rwlocks[i].slot;
     num_held_rwlocks--;
     for (; i < num_held_rwlocks; i++)
         held_rwlocks[i] = held_rwlocks[i + 1];
 
+    if (slot >= 0) {
+        // reads made under the lock must not move past the slot being cleared
+        pg_memory_barrier();
+        pg_atomic_write_u64(&RWLockVisibleReaders[slot], 0);
+        RESUME_INTERRUPTS();
+        return;
+    }
     if (mode == RW_EXCLUSIVE)
         pg_atomic_fetch_sub_u64(&lock->state, RW_VAL_EXCLUSIVE);
     else
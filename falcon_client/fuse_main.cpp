@@ -9,11 +9,17 @@
 #include <string.h>
 #include <unistd.h>
 #include <atomic>
+#include <cstddef>
 #include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <optional>
 #include <print>
+#include <string_view>
 #include <thread>
+#include <vector>
 
-#include <fuse/fuse.h>
+#include <fuse/fuse_lowlevel.h>
 #include <gflags/gflags.h>
 
 #include "brpc/brpc_server.h"
@@ -21,7 +27,12 @@
 #include "error_code.h"
 #include "falcon_code.h"
 #include "falcon_meta.h"
+#include "fuse_inode_table.h"
 #include "init/falcon_init.h"
+#include "attr_cache.h"
+#include "lookup_open_token.h"
+#include "negative_cache.h"
+#include "prefetch_hint.h"
 #include "stats/falcon_stats.h"
 #include "connection/falcon_io_client.h"
 #include "buffer/dir_open_instance.h"
@@ -31,192 +42,365 @@
 
 static bool g_persist = false;
 
-int DoGetAttr(const char *path, struct stat *stbuf)
+struct FalconMountOptions
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    double entryTimeout = 1.0;
+    double attrTimeout = 1.0;
+    int directIo = 0;
+};
+static FalconMountOptions g_mountOptions;
+
+/* options of the former high-level daemon, consumed here since the low-level session doesn't know them */
+static const struct fuse_opt falconMountOpts[] = {
+    {"entry_timeout=%lf", offsetof(FalconMountOptions, entryTimeout), 0},
+    {"attr_timeout=%lf", offsetof(FalconMountOptions, attrTimeout), 0},
+    {"direct_io", offsetof(FalconMountOptions, directIo), 1},
+    FUSE_OPT_END,
+};
+
+static int ToErrno(int ret) { return ret > 0 ? ErrorCodeToErrno(ret) : -ret; }
+
+static bool GetPathOrReply(fuse_req_t req, fuse_ino_t ino, std::string &path)
+{
+    if (!FuseInodeTable::GetInstance().GetPath(ino, path)) {
+        fuse_reply_err(req, ESTALE);
+        return false;
     }
+    return true;
+}
 
-    const char *lastSlash = strrchr(path, '/');
-    if (lastSlash != nullptr && *(lastSlash + 1) == 1) {
-        char middle_component_flag = *(lastSlash + 2);
+static bool GetChildPathOrReply(fuse_req_t req, fuse_ino_t parent, const char *name, std::string &path)
+{
+    if (name == nullptr || strlen(name) == 0) {
+        fuse_reply_err(req, EINVAL);
+        return false;
+    }
+    if (!GetPathOrReply(req, parent, path)) {
+        return false;
+    }
+    if (!path.ends_with('/')) {
+        path += '/';
+    }
+    path += name;
+    return true;
+}
 
-        FalconStats::GetInstance().stats[META_LOOKUP].fetch_add(1);
-        errno_t err = memmove_s((char *)(lastSlash + 1),
-                                strlen(lastSlash + 1) + 1,
-                                (char *)(lastSlash + 3),
-                                strlen(lastSlash + 3) + 1);
+/* hand the entry to the kernel, the attributes must already be fetched */
+static void ReplyEntry(fuse_req_t req, fuse_ino_t parent, const char *name, const struct stat &st,
+                       const LookupReply *openToken = nullptr)
+{
+    struct fuse_entry_param e;
+    errno_t err = memset_s(&e, sizeof(e), 0, sizeof(e));
+    if (err != 0) {
+        fuse_reply_err(req, err);
+        return;
+    }
+    e.ino = FuseInodeTable::GetInstance().Acquire(parent, name);
+    if (e.ino == 0) {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    e.attr = st;
+    e.attr_timeout = g_mountOptions.attrTimeout;
+    e.entry_timeout = g_mountOptions.entryTimeout;
+    if (openToken != nullptr) {
+        // before replying, the open may arrive as soon as the kernel has the entry
+        LookupOpenToken::GetInstance().Grant(fuse_req_ctx(req)->pid, e.ino, *openToken);
+    }
+    if (fuse_reply_entry(req, &e) != 0) {
+        // the kernel did not take the reference
+        FuseInodeTable::GetInstance().Forget(e.ino, 1);
+    }
+}
+
+static int GetAttr(const std::string &path, struct stat *stbuf, std::optional<int32_t> *nodeId = nullptr)
+{
+    errno_t err = memset_s(stbuf, sizeof(struct stat), 0, sizeof(struct stat));
+    if (err != 0) {
+        return -err;
+    }
+    int ret = FalconGetStat(path, stbuf, nodeId);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
+void DoLookup(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    std::string path;
+    if (!GetChildPathOrReply(req, parent, name, path)) {
+        return;
+    }
+    FalconStats::GetInstance().stats[META_LOOKUP].fetch_add(1);
+    StatFuseTimer t(META_LAT, META_STAT_LAT);
+    // the token of an earlier lookup of this thread must not outlive it
+    LookupOpenToken::GetInstance().Drop(fuse_req_ctx(req)->pid);
+    struct stat st;
+    std::optional<int32_t> nodeId;
+    int ret = GetAttr(path, &st, &nodeId);
+    if (ret == -ENOENT) {
+        // a negative entry lets the kernel answer repeated lookups of the missing name until it expires
+        struct fuse_entry_param e;
+        errno_t err = memset_s(&e, sizeof(e), 0, sizeof(e));
         if (err != 0) {
-            return -err;
-        }
-        if (middle_component_flag == '1') {
-            stbuf->st_mode = 040777;
-            return 0;
+            fuse_reply_err(req, err);
+            return;
         }
-    } else {
-        FalconStats::GetInstance().stats[META_STAT].fetch_add(1);
+        e.entry_timeout = g_mountOptions.entryTimeout;
+        fuse_reply_entry(req, &e);
+        return;
+    }
+    if (ret != 0) {
+        fuse_reply_err(req, -ret);
+        return;
     }
+    if (!nodeId.has_value() || !S_ISREG(st.st_mode)) {
+        ReplyEntry(req, parent, name, st);
+        return;
+    }
+    // the reply is fresh from the server, an open right behind this lookup can use it instead of sending OPEN
+    LookupReply openToken{st, *nodeId};
+    ReplyEntry(req, parent, name, st, &openToken);
+}
+
+void DoForget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
+{
+    FuseInodeTable::GetInstance().Forget(ino, nlookup);
+    fuse_reply_none(req);
+}
 
+void DoGetAttr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info * /*fi*/)
+{
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
+    }
+    FalconStats::GetInstance().stats[META_STAT].fetch_add(1);
     StatFuseTimer t(META_LAT, META_STAT_LAT);
-    int ret = FalconGetStat(path, stbuf);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    struct stat st;
+    int ret = GetAttr(path, &st);
+    if (ret != 0) {
+        fuse_reply_err(req, -ret);
+        return;
+    }
+    fuse_reply_attr(req, &st, g_mountOptions.attrTimeout);
 }
 
-int DoMkDir(const char *path, mode_t /*mode*/)
+void DoMkDir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t /*mode*/)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetChildPathOrReply(req, parent, name, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_MKDIR].fetch_add(1);
     StatFuseTimer t(META_LAT);
     int ret = FalconMkdir(path);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    struct stat st;
+    if (ret == SUCCESS) {
+        ret = GetAttr(path, &st);
+    }
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
+    }
+    ReplyEntry(req, parent, name, st);
 }
 
-int DoOpen(const char *path, struct fuse_file_info *fi)
+void DoOpen(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_OPEN].fetch_add(1);
     StatFuseTimer t(META_LAT, META_OPEN_LAT);
-    int oflags = fi->flags;
     uint64_t fd = -1;
     struct stat st;
     errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
     if (err != 0) {
-        return -err;
+        fuse_reply_err(req, err);
+        return;
+    }
+    LookupReply lookup;
+    bool fromLookup = LookupOpenToken::GetInstance().Take(fuse_req_ctx(req)->pid, ino, lookup);
+    int ret = FalconOpen(path, fi->flags, fd, &st, fromLookup ? &lookup : nullptr);
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
     }
-    int ret = FalconOpen(path, oflags, fd, &st);
     fi->fh = fd;
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    fi->direct_io = g_mountOptions.directIo;
+    if (fuse_reply_open(req, fi) != 0) {
+        FalconClose(path, fd);
+    }
 }
 
-int DoOpenAtomic(const char *path, struct stat *stbuf, mode_t /*mode*/, struct fuse_file_info *fi)
+void DoCreate(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t /*mode*/, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetChildPathOrReply(req, parent, name, path)) {
+        return;
     }
-
-    FalconStats::GetInstance().stats[META_OPEN_ATOMIC].fetch_add(1);
-    StatFuseTimer t(META_LAT);
-    uint64_t fd = -1;
-    int oflags = fi->flags;
-    int ret = 0;
-    if (oflags & O_CREAT) {
-        ret = FalconCreate(path, fd, oflags, stbuf);
-        if (ret == FILE_EXISTS && !(oflags & O_EXCL)) {
-            ret = SUCCESS;
-        }
-    } else {
-        ret = FalconOpen(path, oflags, fd, stbuf);
+    FalconStats::GetInstance().stats[META_CREATE].fetch_add(1);
+    StatFuseTimer t(META_LAT, META_CREATE_LAT);
+    uint64_t fd = 0;
+    struct stat st;
+    errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
+    if (err != 0) {
+        fuse_reply_err(req, err);
+        return;
+    }
+    int ret = FalconCreate(path, fd, fi->flags, &st);
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
     }
 
+    struct fuse_entry_param e;
+    err = memset_s(&e, sizeof(e), 0, sizeof(e));
+    if (err != 0) {
+        FalconClose(path, fd);
+        fuse_reply_err(req, err);
+        return;
+    }
+    e.ino = FuseInodeTable::GetInstance().Acquire(parent, name);
+    if (e.ino == 0) {
+        FalconClose(path, fd);
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    e.attr = st;
+    e.attr_timeout = g_mountOptions.attrTimeout;
+    e.entry_timeout = g_mountOptions.entryTimeout;
     fi->fh = fd;
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    fi->direct_io = g_mountOptions.directIo;
+    if (fuse_reply_create(req, &e, fi) != 0) {
+        FuseInodeTable::GetInstance().Forget(e.ino, 1);
+        FalconClose(path, fd);
+    }
 }
 
-int DoOpenDir(const char *path, struct fuse_file_info *fi)
+void DoOpenDir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_OPENDIR].fetch_add(1);
     StatFuseTimer t(META_LAT);
     auto *ti = (struct FalconFuseInfo *)fi;
     int ret = FalconOpenDir(path, ti);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
+    }
+    if (fuse_reply_open(req, fi) != 0) {
+        FalconCloseDir(fi->fh);
+    }
 }
 
-int DoReadDir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi)
+/* collects the entries produced by FalconReadDir into one reply buffer */
+struct ReadDirBuffer
 {
-    if (path == nullptr || buf == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
-    FalconStats::GetInstance().stats[META_READDIR].fetch_add(1);
-    StatFuseTimer t(META_LAT);
-    auto *ti = (struct FalconFuseInfo *)fi;
-    int ret = 0;
+    fuse_req_t req;
+    std::vector<char> data;
+    size_t used;
+};
 
-    ret = FalconReadDir(path, buf, (FalconFuseFiller)filler, offset, ti);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+static int ReadDirFiller(void *buf, const char *name, const struct stat *stbuf, off_t offset)
+{
+    auto *dirBuffer = (ReadDirBuffer *)buf;
+    struct stat st;
+    if (stbuf == nullptr) {
+        // "." and ".."
+        errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
+        if (err != 0) {
+            return 1;
+        }
+        st.st_mode = S_IFDIR;
+        stbuf = &st;
+    }
+    size_t remain = dirBuffer->data.size() - dirBuffer->used;
+    size_t entrySize = fuse_add_direntry(dirBuffer->req, nullptr, 0, name, nullptr, 0);
+    if (entrySize > remain) {
+        return 1;
+    }
+    fuse_add_direntry(dirBuffer->req, dirBuffer->data.data() + dirBuffer->used, remain, name, stbuf, offset);
+    dirBuffer->used += entrySize;
+    return 0;
 }
 
-int DoCreate(const char *path, mode_t /*mode*/, struct fuse_file_info *fi)
+void DoReadDir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
-    FalconStats::GetInstance().stats[META_CREATE].fetch_add(1);
-    StatFuseTimer t(META_LAT, META_CREATE_LAT);
-    uint64_t fd = 0;
-    int oflags = fi->flags;
-    struct stat st;
-    errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
-    if (err != 0) {
-        return -err;
+    FalconStats::GetInstance().stats[META_READDIR].fetch_add(1);
+    StatFuseTimer t(META_LAT);
+    auto *ti = (struct FalconFuseInfo *)fi;
+    ReadDirBuffer dirBuffer{req, std::vector<char>(size), 0};
+    int ret = FalconReadDir(path, &dirBuffer, ReadDirFiller, offset, ti);
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
     }
-    int ret = FalconCreate(path, fd, oflags, &st);
-    fi->fh = fd;
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    fuse_reply_buf(req, dirBuffer.data.data(), dirBuffer.used);
 }
 
-int DoAccess(const char *path, int /*mask*/)
+void DoAccess(fuse_req_t req, fuse_ino_t /*ino*/, int /*mask*/)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
     FalconStats::GetInstance().stats[META_ACCESS].fetch_add(1);
     StatFuseTimer t(META_LAT);
-    return 0;
+    fuse_reply_err(req, 0);
 }
 
-int DoRelease(const char *path, struct fuse_file_info *fi)
+void DoRelease(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_RELEASE].fetch_add(1);
     StatFuseTimer t(META_LAT, META_RELEASE_LAT);
-    uint64_t fd = fi->fh;
-    int ret = FalconClose(path, fd);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    int ret = FalconClose(path, fi->fh);
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoReleaseDir(const char *path, struct fuse_file_info *fi)
+void DoReleaseDir(fuse_req_t req, fuse_ino_t /*ino*/, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
     FalconStats::GetInstance().stats[META_RELEASEDIR].fetch_add(1);
     StatFuseTimer t(META_LAT);
-    uint64_t fd = fi->fh;
-    int ret = FalconCloseDir(fd);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    int ret = FalconCloseDir(fi->fh);
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoUnlink(const char *path)
+void DoUnlink(fuse_req_t req, fuse_ino_t parent, const char *name)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetChildPathOrReply(req, parent, name, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_UNLINK].fetch_add(1);
     StatFuseTimer t;
-    int ret;
-    ret = FalconUnlink(path);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    int ret = FalconUnlink(path);
+    if (ret == SUCCESS) {
+        FuseInodeTable::GetInstance().Remove(parent, name);
+    }
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoRmDir(const char *path)
+void DoRmDir(fuse_req_t req, fuse_ino_t parent, const char *name)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetChildPathOrReply(req, parent, name, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_RMDIR].fetch_add(1);
     StatFuseTimer t(META_LAT);
-    int ret;
-    ret = FalconRmDir(path);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    int ret = FalconRmDir(path);
+    if (ret == SUCCESS) {
+        FuseInodeTable::GetInstance().Remove(parent, name);
+    }
+    fuse_reply_err(req, ToErrno(ret));
 }
 
 void DoDestroy(void * /*userdata*/)
@@ -225,83 +409,166 @@ void DoDestroy(void * /*userdata*/)
     FalconDestroy();
 }
 
-int DoWrite(const char *path, const char *buffer, size_t size, off_t offset, struct fuse_file_info *fi)
+void DoWrite(fuse_req_t req, fuse_ino_t /*ino*/, const char *buffer, size_t size, off_t offset, struct fuse_file_info *fi)
 {
-    if (path == nullptr || buffer == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
     FalconStats::GetInstance().stats[FUSE_WRITE_OPS].fetch_add(1);
     StatFuseTimer t(FUSE_LAT, FUSE_WRITE_LAT);
-    uint ret;
-    int64_t fd = fi->fh;
-    ret = FalconWrite(fd, path, buffer, size, offset);
+    int ret = FalconWrite(fi->fh, "", buffer, size, offset);
     if (ret != 0) {
-        return ret;
+        fuse_reply_err(req, ToErrno(ret));
+        return;
     }
     FalconStats::GetInstance().stats[FUSE_WRITE] += size;
-    return size;
+    fuse_reply_write(req, size);
 }
 
-int DoRead(const char *path, char *buffer, size_t size, off_t offset, struct fuse_file_info *fi)
+/* O_DIRECT reads of the local cache go straight into this buffer */
+constexpr size_t READ_BUFFER_ALIGN = 4096;
+
+void DoRead(fuse_req_t req, fuse_ino_t /*ino*/, size_t size, off_t offset, struct fuse_file_info *fi)
 {
-    if (path == nullptr || buffer == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
     FalconStats::GetInstance().stats[FUSE_READ_OPS].fetch_add(1);
     StatFuseTimer t(FUSE_LAT, FUSE_READ_LAT);
-    uint64_t fd = fi->fh;
-    int retSize = FalconRead(path, fd, buffer, size, offset);
-    FalconStats::GetInstance().stats[FUSE_READ] += retSize >= 0 ? retSize : 0;
-    return retSize;
+    size_t alignedSize = (size + READ_BUFFER_ALIGN - 1) / READ_BUFFER_ALIGN * READ_BUFFER_ALIGN;
+    std::unique_ptr<char, decltype(&free)> buffer((char *)aligned_alloc(READ_BUFFER_ALIGN, alignedSize), free);
+    if (buffer == nullptr) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+    int retSize = FalconRead("", fi->fh, buffer.get(), size, offset);
+    if (retSize < 0) {
+        fuse_reply_err(req, -retSize);
+        return;
+    }
+    FalconStats::GetInstance().stats[FUSE_READ] += retSize;
+    fuse_reply_buf(req, buffer.get(), retSize);
 }
 
-int DoSetXAttr(const char *path, const char * /*key*/, const char *value, size_t /*size*/, int /*offset*/)
+/*
+ * Setting PREFETCH_HINT_XATTR on any path announces files which are going to be opened, one path per line.
+ * Setting MKDIR_XATTR creates the directories listed the same way, like mkdir -p and in one round trip, e.g. for the
+ * class folders of a dataset before it is extracted.
+ * Setting RMTREE_XATTR removes the directories listed the same way with everything below them, like rm -r but on
+ * the servers, instead of walking the tree from here.
+ * Relative paths are resolved against the path the attribute is set on, an empty prefetch hint drops all hints.
+ */
+constexpr const char *PREFETCH_HINT_XATTR = "user.falcon.prefetch";
+constexpr const char *MKDIR_XATTR = "user.falcon.mkdir";
+constexpr const char *RMTREE_XATTR = "user.falcon.rmtree";
+
+void DoSetXAttr(fuse_req_t req, fuse_ino_t ino, const char *key, const char *value, size_t size, int /*flags*/)
 {
-    if (path == nullptr || value == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
     StatFuseTimer t(META_LAT);
-    return 0;
+    bool isMkdir = key != nullptr && strcmp(key, MKDIR_XATTR) == 0;
+    bool isRmtree = key != nullptr && strcmp(key, RMTREE_XATTR) == 0;
+    if (!isMkdir && !isRmtree && (key == nullptr || strcmp(key, PREFETCH_HINT_XATTR) != 0)) {
+        fuse_reply_err(req, 0);
+        return;
+    }
+
+    std::string base = path;
+    if (!base.ends_with('/')) {
+        base += '/';
+    }
+    std::vector<std::string> paths;
+    std::string_view hints(value, value == nullptr ? 0 : size);
+    while (!hints.empty()) {
+        size_t end = hints.find('\n');
+        std::string_view line = hints.substr(0, end);
+        hints = end == std::string_view::npos ? std::string_view() : hints.substr(end + 1);
+        if (line.empty()) {
+            continue;
+        }
+        paths.emplace_back(line.starts_with('/') ? std::string(line) : base + std::string(line));
+    }
+    int ret = SUCCESS;
+    if (isRmtree) {
+        for (size_t i = 0; i < paths.size() && ret == SUCCESS; ++i) {
+            ret = FalconRmDirRecursive(paths[i]);
+        }
+    } else {
+        ret = isMkdir ? FalconMkdirRecursive(paths) : FalconPrefetchHint(paths);
+    }
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoTruncate(const char *path, off_t size)
+/* chmod, chown, truncate and utimens all arrive here */
+void DoSetAttr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int toSet, struct fuse_file_info * /*fi*/)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
+    }
+    // the truncate of open(O_TRUNC) comes between its lookup and its open
+    LookupOpenToken::GetInstance().Revoke(ino);
+    int ret = 0;
+    if (toSet & FUSE_SET_ATTR_MODE) {
+        ret = FalconChmod(path, attr->st_mode);
+    }
+    if (ret == 0 && (toSet & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID))) {
+        uid_t uid = attr->st_uid;
+        gid_t gid = attr->st_gid;
+        if ((toSet & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)) != (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)) {
+            // only one of them changes, keep the other
+            struct stat st;
+            ret = GetAttr(path, &st);
+            uid = (toSet & FUSE_SET_ATTR_UID) ? uid : st.st_uid;
+            gid = (toSet & FUSE_SET_ATTR_GID) ? gid : st.st_gid;
+        }
+        if (ret == 0) {
+            ret = FalconChown(path, uid, gid);
+        }
+    }
+    if (ret == 0 && (toSet & FUSE_SET_ATTR_SIZE)) {
+        FalconStats::GetInstance().stats[META_TRUNCATE].fetch_add(1);
+        StatFuseTimer t;
+        ret = FalconTruncate(path, attr->st_size);
+    }
+    if (ret == 0 && (toSet & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME))) {
+        if (toSet & (FUSE_SET_ATTR_ATIME_NOW | FUSE_SET_ATTR_MTIME_NOW)) {
+            ret = FalconUtimens(path);
+        } else {
+            ret = FalconUtimens(path,
+                                (toSet & FUSE_SET_ATTR_ATIME) ? attr->st_atim.tv_sec : -1,
+                                (toSet & FUSE_SET_ATTR_MTIME) ? attr->st_mtim.tv_sec : -1);
+        }
+    }
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
     }
-    FalconStats::GetInstance().stats[META_TRUNCATE].fetch_add(1);
-    StatFuseTimer t;
-    int ret = FalconTruncate(std::string(path), size);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
-}
 
-int DoFtruncate(const char *path, off_t size, struct fuse_file_info * /*fi*/)
-{
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    struct stat st;
+    ret = GetAttr(path, &st);
+    if (ret != 0) {
+        fuse_reply_err(req, -ret);
+        return;
     }
-    FalconStats::GetInstance().stats[META_TRUNCATE].fetch_add(1);
-    StatFuseTimer t;
-    int ret = FalconTruncate(std::string(path), size);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    fuse_reply_attr(req, &st, g_mountOptions.attrTimeout);
 }
 
-int DoFlush(const char *path, struct fuse_file_info *fi)
+void DoFlush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_FLUSH].fetch_add(1);
     StatFuseTimer t;
-    int64_t fd = fi->fh;
-    int ret = FalconClose(path, fd, true);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    int ret = FalconClose(path, fi->fh, true);
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoRename(const char *srcPath, const char *dstPath)
+void DoRename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newParent, const char *newName)
 {
-    if (srcPath == nullptr || dstPath == nullptr || strlen(srcPath) == 0 || strlen(dstPath) == 0) {
-        return -EINVAL;
+    std::string srcPath;
+    std::string dstPath;
+    if (!GetChildPathOrReply(req, parent, name, srcPath) || !GetChildPathOrReply(req, newParent, newName, dstPath)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_RENAME].fetch_add(1);
     StatFuseTimer t(META_LAT);
@@ -311,67 +578,44 @@ int DoRename(const char *srcPath, const char *dstPath)
     } else {
         ret = FalconRename(srcPath, dstPath);
     }
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    if (ret == SUCCESS) {
+        FuseInodeTable::GetInstance().Rename(parent, name, newParent, newName);
+    }
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoFsync(const char *path, int datasync, struct fuse_file_info *fi)
+void DoFsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info *fi)
 {
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    std::string path;
+    if (!GetPathOrReply(req, ino, path)) {
+        return;
     }
     FalconStats::GetInstance().stats[META_FSYNC].fetch_add(1);
     StatFuseTimer t;
-    uint64_t fd = fi->fh;
-    int ret = FalconFsync(path, fd, datasync);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    int ret = FalconFsync(path, fi->fh, datasync);
+    fuse_reply_err(req, ToErrno(ret));
 }
 
-int DoStatfs(const char *path, struct statvfs *vfsBuf)
+void DoStatfs(fuse_req_t req, fuse_ino_t /*ino*/)
 {
-    if (path == nullptr || vfsBuf == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
     StatFuseTimer t(META_LAT);
-    int ret = FalconStatFS(vfsBuf);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
-}
-
-int DoUtimens(const char *path, const struct timespec tv[2])
-{
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
-    int ret = 0;
-    if (!tv || tv[0].tv_nsec == UTIME_NOW) {
-        ret = FalconUtimens(path);
-    } else {
-        ret = FalconUtimens(path, tv[0].tv_sec, tv[1].tv_sec);
-    }
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
-}
-
-int DoChmod(const char *path, mode_t mode)
-{
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
-    }
-    int ret = FalconChmod(path, mode);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
-}
-
-int DoChown(const char *path, uid_t uid, gid_t gid)
-{
-    if (path == nullptr || strlen(path) == 0) {
-        return -EINVAL;
+    struct statvfs vfsBuf;
+    int ret = FalconStatFS(&vfsBuf);
+    if (ret != 0) {
+        fuse_reply_err(req, ToErrno(ret));
+        return;
     }
-    int ret = FalconChown(path, uid, gid);
-    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    fuse_reply_statfs(req, &vfsBuf);
 }
 
-static struct fuse_operations falconOperations = {
+static struct fuse_lowlevel_ops falconOperations = {
+    .init = nullptr,
+    .destroy = DoDestroy,
+    .lookup = DoLookup,
+    .forget = DoForget,
     .getattr = DoGetAttr,
+    .setattr = DoSetAttr,
     .readlink = nullptr,
-    .getdir = nullptr,
     .mknod = nullptr,
     .mkdir = DoMkDir,
     .unlink = DoUnlink,
@@ -379,52 +623,61 @@ static struct fuse_operations falconOperations = {
     .symlink = nullptr,
     .rename = DoRename,
     .link = nullptr,
-    .chmod = DoChmod,
-    .chown = DoChown,
-    .truncate = DoTruncate,
-    .utime = nullptr,
     .open = DoOpen,
     .read = DoRead,
     .write = DoWrite,
-    .statfs = DoStatfs,
     .flush = DoFlush,
     .release = DoRelease,
     .fsync = DoFsync,
-    .setxattr = DoSetXAttr,
-    .getxattr = nullptr,
-    .listxattr = nullptr,
-    .removexattr = nullptr,
     .opendir = DoOpenDir,
     .readdir = DoReadDir,
     .releasedir = DoReleaseDir,
-
     .fsyncdir = nullptr,
-    .init = nullptr,
-    .destroy = DoDestroy,
+    .statfs = DoStatfs,
+    .setxattr = DoSetXAttr,
+    .getxattr = nullptr,
+    .listxattr = nullptr,
+    .removexattr = nullptr,
     .access = DoAccess,
     .create = DoCreate,
-    .ftruncate = DoFtruncate,
-    .fgetattr = nullptr,
-    .lock = nullptr,
-    .utimens = DoUtimens,
-    .bmap = nullptr,
-    .flag_nullpath_ok = 1,
-    .flag_nopath = 0,
-    .flag_utime_omit_ok = 1,
-    .flag_reserved = 0,
-    .ioctl = nullptr,
-    .poll = nullptr,
-    .write_buf = nullptr,
-    .read_buf = nullptr,
-    .flock = nullptr,
-    .fallocate = nullptr,
-#ifdef WITH_FUSE_OPT
-#if WITH_FUSE_OPT
-    .open_atomic = DoOpenAtomic,
-#endif
-#endif
 };
 
+/* mount and serve the low-level session, multi-threaded unless -s is given */
+static int RunFuseSession(struct fuse_args *args)
+{
+    if (fuse_opt_parse(args, &g_mountOptions, falconMountOpts, nullptr) == -1) {
+        return 1;
+    }
+    char *mountPoint = nullptr;
+    int multiThreaded = 0;
+    int foreground = 0;
+    if (fuse_parse_cmdline(args, &mountPoint, &multiThreaded, &foreground) == -1 || mountPoint == nullptr) {
+        std::println(stderr, "Parse fuse command line failed");
+        return 1;
+    }
+    int ret = 1;
+    struct fuse_chan *chan = fuse_mount(mountPoint, args);
+    if (chan == nullptr) {
+        std::println(stderr, "Mount {} failed", mountPoint);
+        free(mountPoint);
+        return ret;
+    }
+    struct fuse_session *session = fuse_lowlevel_new(args, &falconOperations, sizeof(falconOperations), nullptr);
+    if (session != nullptr) {
+        if (fuse_set_signal_handlers(session) == 0) {
+            fuse_session_add_chan(session, chan);
+            fuse_daemonize(foreground);
+            ret = multiThreaded ? fuse_session_loop_mt(session) : fuse_session_loop(session);
+            fuse_remove_signal_handlers(session);
+            fuse_session_remove_chan(chan);
+        }
+        fuse_session_destroy(session);
+    }
+    fuse_unmount(mountPoint, chan);
+    free(mountPoint);
+    return ret;
+}
+
 DEFINE_string(rpc_endpoint, "0.0.0.0:56039", "endpoint of rpc server");
 DEFINE_string(f, "", "fuse ops, unneeded");
 DEFINE_string(o, "", "fuse ops, unneeded");
@@ -512,6 +765,11 @@ int main(int argc, char *argv[])
     g_persist = config->GetBool(FalconPropertyKey::FALCON_PERSIST);
     uint32_t maxOpenNum = config->GetUint32(FalconPropertyKey::FALCON_MAX_OPEN_NUM);
     SetMaxOpenInstanceNum(maxOpenNum);
+    NegativeCache::GetInstance().SetTimeout(config->GetUint32(FalconPropertyKey::FALCON_NEGATIVE_CACHE_TIMEOUT_MS));
+    AttrCache::GetInstance().SetTimeout(config->GetUint32(FalconPropertyKey::FALCON_ATTR_CACHE_TIMEOUT_MS));
+    PrefetchHint::GetInstance().SetLimit(
+        config->GetUint32(FalconPropertyKey::FALCON_PREFETCH_HINT_WINDOW),
+        (uint64_t)config->GetUint32(FalconPropertyKey::FALCON_PREFETCH_HINT_MEMORY_MB) * 1024 * 1024);
 #ifdef ZK_INIT
     std::println("Initialize with ZK");
     const char *zkEndPoint = std::getenv("zk_endpoint");
@@ -565,7 +823,7 @@ int main(int argc, char *argv[])
 #endif
 
     std::println("{}", ret);
-    ret = fuse_main(args.argc, args.argv, &falconOperations, nullptr);
+    ret = RunFuseSession(&args);
     fuse_opt_free_args(&args);
     return ret;
 }
@@ -0,0 +1,72 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "attr_cache.h"
+
+AttrCache &AttrCache::GetInstance()
+{
+    static AttrCache instance;
+    return instance;
+}
+
+void AttrCache::SetTimeout(uint32_t timeoutMs)
+{
+    timeout = std::chrono::milliseconds(timeoutMs);
+}
+
+bool AttrCache::Lookup(const std::string &path, struct stat *stbuf)
+{
+    if (!Enabled() || stbuf == nullptr) {
+        return false;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    if (it->second.expireTime < std::chrono::steady_clock::now()) {
+        shard.entries.erase(it);
+        return false;
+    }
+    *stbuf = it->second.stbuf;
+    return true;
+}
+
+void AttrCache::Insert(const std::string &path, const struct stat &stbuf)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.size() >= MAX_ENTRIES_PER_SHARD) {
+        shard.entries.erase(shard.entries.begin());
+    }
+    shard.entries.insert_or_assign(path, Entry{stbuf, std::chrono::steady_clock::now() + timeout});
+}
+
+void AttrCache::Invalidate(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(path);
+}
+
+void AttrCache::InvalidateTree(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    std::string prefix = path.ends_with('/') ? path : path + '/';
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::erase_if(shard.entries, [&](const auto &item) {
+            return item.first == path || item.first.starts_with(prefix);
+        });
+    }
+}
@@ -21,6 +21,10 @@
 
 #define ALLOW_BATCH_WITH_OTHERS true
 
+#define REQUEST_TIMEOUT_MS 10000
+// removes a whole subtree in one transaction, which takes a while for large ones
+#define RMDIR_RECURSIVE_TIMEOUT_MS 600000
+
 static void BrpcDummyDeleter(void *) {}
 
 inline falcon::meta_fbs::AnyMetaParam ToFlatBuffersType(falcon::meta_proto::MetaServiceType type)
@@ -29,12 +33,14 @@ inline falcon::meta_fbs::AnyMetaParam ToFlatBuffersType(falcon::meta_proto::Meta
     case falcon::meta_proto::PLAIN_COMMAND:
         return falcon::meta_fbs::AnyMetaParam_PlainCommandParam;
     case falcon::meta_proto::MKDIR:
+    case falcon::meta_proto::MKDIR_RECURSIVE:
     case falcon::meta_proto::CREATE:
     case falcon::meta_proto::STAT:
     case falcon::meta_proto::OPEN:
     case falcon::meta_proto::UNLINK:
     case falcon::meta_proto::OPENDIR:
     case falcon::meta_proto::RMDIR:
+    case falcon::meta_proto::RMDIR_RECURSIVE:
         return falcon::meta_fbs::AnyMetaParam_PathOnlyParam;
     case falcon::meta_proto::CLOSE:
         return falcon::meta_fbs::AnyMetaParam_CloseParam;
@@ -53,6 +59,46 @@ inline falcon::meta_fbs::AnyMetaParam ToFlatBuffersType(falcon::meta_proto::Meta
     }
 }
 
+void Connection::UpdateNamespaceGeneration(uint64_t generation)
+{
+    uint64_t current = namespaceGeneration.load(std::memory_order_relaxed);
+    while (generation > current &&
+           !namespaceGeneration.compare_exchange_weak(current, generation, std::memory_order_acq_rel)) {
+    }
+}
+
+void Connection::UpdateDirectoryLogPosition(uint64_t position)
+{
+    uint64_t current = directoryLogPosition.load(std::memory_order_relaxed);
+    while (position > current &&
+           !directoryLogPosition.compare_exchange_weak(current, position, std::memory_order_acq_rel)) {
+    }
+}
+
+void Connection::KeepObsoleteShardTable(const falcon::meta_fbs::ShardTableResponse *response)
+{
+    if (response == nullptr || response->range_point() == nullptr || response->server_id() == nullptr ||
+        response->range_point()->size() != response->server_id()->size()) {
+        return;
+    }
+    ShardTable table{response->epoch(),
+                     std::vector<int32_t>(response->range_point()->begin(), response->range_point()->end()),
+                     std::vector<int32_t>(response->server_id()->begin(), response->server_id()->end())};
+    std::lock_guard<std::mutex> lock(obsoleteShardTableMutex);
+    obsoleteShardTable = std::move(table);
+}
+
+bool Connection::TakeObsoleteShardTable(ShardTable &table)
+{
+    std::lock_guard<std::mutex> lock(obsoleteShardTableMutex);
+    if (!obsoleteShardTable.has_value()) {
+        return false;
+    }
+    table = std::move(*obsoleteShardTable);
+    obsoleteShardTable.reset();
+    return true;
+}
+
 template <typename ParamBuilder, typename ResponseHandler, typename ResultType>
 FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType proto_type,
                                            const ParamBuilder &paramBuilder,
@@ -83,8 +129,18 @@ FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType p
         proto_type == falcon::meta_proto::CLOSE || proto_type == falcon::meta_proto::UNLINK) {
         request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
     }
+    // operations routed to the server by the shard table
+    if (proto_type == falcon::meta_proto::CREATE || proto_type == falcon::meta_proto::STAT ||
+        proto_type == falcon::meta_proto::OPEN || proto_type == falcon::meta_proto::CLOSE ||
+        proto_type == falcon::meta_proto::UNLINK || proto_type == falcon::meta_proto::UTIMENS ||
+        proto_type == falcon::meta_proto::CHOWN || proto_type == falcon::meta_proto::CHMOD) {
+        request.set_shard_table_epoch(shardTableEpoch.load(std::memory_order_relaxed));
+    }
+    // directories created before may not have been applied on the server yet
+    request.set_directory_log_position(directoryLogPosition.load(std::memory_order_acquire));
     brpc::Controller cntl;
-    cntl.set_timeout_ms(10000);
+    cntl.set_timeout_ms(proto_type == falcon::meta_proto::RMDIR_RECURSIVE ? RMDIR_RECURSIVE_TIMEOUT_MS
+                                                                          : REQUEST_TIMEOUT_MS);
     cntl.request_attachment().append_user_data(cache->serializedDataBuffer.buffer,
                                                cache->serializedDataBuffer.size,
                                                BrpcDummyDeleter);
@@ -136,6 +192,11 @@ FalconErrorCode Connection::ProcessRequest(falcon::meta_proto::MetaServiceType p
     }
 
     auto metaResponse = falcon::meta_fbs::GetMetaResponse((uint8_t *)response.buffer + SERIALIZED_DATA_ALIGNMENT);
+    UpdateNamespaceGeneration(metaResponse->generation());
+    UpdateDirectoryLogPosition(metaResponse->directory_log_position());
+    if (metaResponse->error_code() == OBSOLETE_SHARD) {
+        KeepObsoleteShardTable(metaResponse->response_as_ShardTableResponse());
+    }
     if (metaResponse->error_code() != SUCCESS) {
         if (metaResponse->error_code() < LAST_FALCON_ERROR_CODE)
             return (FalconErrorCode)metaResponse->error_code();
@@ -185,6 +246,93 @@ FalconErrorCode Connection::Mkdir(const char *path, ConnectionCache *cache)
     return ProcessRequest(falcon::meta_proto::MKDIR, paramBuilder, responseHandler, cache);
 }
 
+FalconErrorCode Connection::MkdirRecursive(const std::vector<std::string> &paths,
+                                           std::vector<FalconErrorCode> &errorCodes,
+                                           ConnectionCache *cache)
+{
+    errorCodes.assign(paths.size(), SUCCESS);
+    if (paths.empty())
+        return SUCCESS;
+    if (!cache)
+        cache = &ThreadLocalConnectionCache;
+
+    // 1. one param per path, the server handles all of them in one transaction
+    SerializedDataClear(&cache->serializedDataBuffer);
+    falcon::meta_proto::MetaRequest request;
+    for (const std::string &path : paths) {
+        cache->flatBufferBuilder.Clear();
+        auto param = falcon::meta_fbs::CreatePathOnlyParamDirect(cache->flatBufferBuilder, path.c_str());
+        auto metaParam = falcon::meta_fbs::CreateMetaParam(cache->flatBufferBuilder,
+                                                           falcon::meta_fbs::AnyMetaParam_PathOnlyParam,
+                                                           param.Union());
+        cache->flatBufferBuilder.Finish(metaParam);
+        char *p = SerializedDataApplyForSegment(&cache->serializedDataBuffer, cache->flatBufferBuilder.GetSize());
+        memcpy(p, cache->flatBufferBuilder.GetBufferPointer(), cache->flatBufferBuilder.GetSize());
+        request.add_type(falcon::meta_proto::MKDIR_RECURSIVE);
+    }
+    request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
+    request.set_directory_log_position(directoryLogPosition.load(std::memory_order_acquire));
+
+    // 2. send request
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(REQUEST_TIMEOUT_MS);
+    cntl.request_attachment().append_user_data(cache->serializedDataBuffer.buffer,
+                                               cache->serializedDataBuffer.size,
+                                               BrpcDummyDeleter);
+    falcon::meta_proto::Empty dummyResponse;
+    stub.MetaCall(&cntl, &request, &dummyResponse, nullptr);
+    if (cntl.Failed()) {
+        FALCON_LOG(LOG_ERROR) << std::format("{}: Send request failed, error code = {}, error text = {}",
+                                             __func__,
+                                             cntl.ErrorCode(),
+                                             cntl.ErrorText());
+
+        if (cntl.ErrorCode() == brpc::ELOGOFF || cntl.ErrorCode() == EHOSTDOWN) {
+            return SERVER_FAULT;
+        } else {
+            return REMOTE_QUERY_FAILED;
+        }
+    }
+
+    // 3. parse responses, a failed transaction is replied with a single one for all paths
+    size_t responseBufferSize = cntl.response_attachment().size();
+    std::unique_ptr<char[]> tempBuffer = std::make_unique<char[]>(responseBufferSize);
+    cntl.response_attachment().cutn(tempBuffer.get(), responseBufferSize);
+    SerializedData response;
+    SerializedDataInit(&response, tempBuffer.get(), responseBufferSize, responseBufferSize, nullptr);
+
+    FalconErrorCode errorCode = SUCCESS;
+    sd_size_t p = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (p == response.size && errorCode != SUCCESS) {
+            errorCodes[i] = errorCode;
+            continue;
+        }
+        sd_size_t responseSize = SerializedDataNextSeveralItemSize(&response, p, 1);
+        if (responseSize == (sd_size_t)-1) {
+            FALCON_LOG(LOG_ERROR) << "returned data is corrupt.";
+            return REMOTE_QUERY_FAILED;
+        }
+        flatbuffers::Verifier verifier((uint8_t *)response.buffer + p + SERIALIZED_DATA_ALIGNMENT,
+                                       responseSize - SERIALIZED_DATA_ALIGNMENT);
+        if (!verifier.VerifyBuffer<falcon::meta_fbs::MetaResponse>()) {
+            FALCON_LOG(LOG_ERROR) << "Meta response is corrupt.";
+            return REMOTE_QUERY_FAILED;
+        }
+        auto metaResponse =
+            falcon::meta_fbs::GetMetaResponse((uint8_t *)response.buffer + p + SERIALIZED_DATA_ALIGNMENT);
+        UpdateNamespaceGeneration(metaResponse->generation());
+        UpdateDirectoryLogPosition(metaResponse->directory_log_position());
+        errorCodes[i] = metaResponse->error_code() < LAST_FALCON_ERROR_CODE
+                            ? (FalconErrorCode)metaResponse->error_code()
+                            : PROGRAM_ERROR;
+        if (errorCodes[i] != SUCCESS)
+            errorCode = errorCodes[i];
+        p += responseSize;
+    }
+    return errorCode;
+}
+
 FalconErrorCode
 Connection::Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct stat *stbuf, ConnectionCache *cache)
 {
@@ -223,13 +371,14 @@ Connection::Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct
     return ProcessRequest(falcon::meta_proto::CREATE, paramBuilder, responseHandler, cache);
 }
 
-FalconErrorCode Connection::Stat(const char *path, struct stat *stbuf, ConnectionCache *cache)
+FalconErrorCode
+Connection::Stat(const char *path, struct stat *stbuf, std::optional<int32_t> *nodeId, ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
         return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, path);
     };
 
-    auto responseHandler = [stbuf](const falcon::meta_fbs::MetaResponse *metaResponse, void *) {
+    auto responseHandler = [stbuf, nodeId](const falcon::meta_fbs::MetaResponse *metaResponse, void *) {
         if (metaResponse->response_type() != falcon::meta_fbs::AnyMetaResponse_StatResponse) {
             return PROGRAM_ERROR;
         }
@@ -250,6 +399,9 @@ FalconErrorCode Connection::Stat(const char *path, struct stat *stbuf, Connectio
             stbuf->st_mtim = ConvertTimestampFromPGToUnix(statResponse->st_mtim());
             stbuf->st_ctim = ConvertTimestampFromPGToUnix(statResponse->st_ctim());
         }
+        if (nodeId && statResponse->node_id().has_value()) {
+            *nodeId = (int32_t)statResponse->node_id().value();
+        }
         return (FalconErrorCode)metaResponse->error_code();
     };
 
@@ -344,10 +496,16 @@ FalconErrorCode Connection::ReadDir(const char *path,
                                     int32_t maxReadCount,
                                     int32_t lastShardIndex,
                                     const char *lastFileName,
+                                    bool plus,
                                     ConnectionCache *cache)
 {
     auto paramBuilder = [=](flatbuffers::FlatBufferBuilder &builder) {
-        return falcon::meta_fbs::CreateReadDirParamDirect(builder, path, maxReadCount, lastShardIndex, lastFileName);
+        return falcon::meta_fbs::CreateReadDirParamDirect(builder,
+                                                          path,
+                                                          maxReadCount,
+                                                          lastShardIndex,
+                                                          lastFileName,
+                                                          plus);
     };
 
     auto responseHandler = [](const falcon::meta_fbs::MetaResponse *metaResponse, ReadDirResponse *result) {
@@ -361,6 +519,21 @@ FalconErrorCode Connection::ReadDir(const char *path,
     return ProcessRequest(falcon::meta_proto::READDIR, paramBuilder, responseHandler, cache, &readDirResponse);
 }
 
+void Connection::ReadDirEntryToStat(const falcon::meta_fbs::OneReadDirResponse *entry, struct stat *stbuf)
+{
+    stbuf->st_ino = entry->st_ino();
+    stbuf->st_mode = entry->st_mode();
+    stbuf->st_nlink = entry->st_nlink();
+    stbuf->st_uid = entry->st_uid();
+    stbuf->st_gid = entry->st_gid();
+    stbuf->st_size = entry->st_size();
+    stbuf->st_blksize = ST_BLKSIZE;
+    stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
+    stbuf->st_atim = ConvertTimestampFromPGToUnix(entry->st_atim());
+    stbuf->st_mtim = ConvertTimestampFromPGToUnix(entry->st_mtim());
+    stbuf->st_ctim = ConvertTimestampFromPGToUnix(entry->st_ctim());
+}
+
 FalconErrorCode Connection::OpenDir(const char *path, uint64_t &inodeId, ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
@@ -394,6 +567,21 @@ FalconErrorCode Connection::Rmdir(const char *path, ConnectionCache *cache)
     return ProcessRequest(falcon::meta_proto::RMDIR, paramBuilder, responseHandler, cache);
 }
 
+FalconErrorCode Connection::RmdirRecursive(const char *path, ConnectionCache *cache)
+{
+    auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
+        return falcon::meta_fbs::CreatePathOnlyParamDirect(builder, path);
+    };
+
+    auto responseHandler = [](const falcon::meta_fbs::MetaResponse *metaResponse, void *) {
+        return metaResponse->error_code() < LAST_FALCON_ERROR_CODE
+                   ? static_cast<FalconErrorCode>(metaResponse->error_code())
+                   : PROGRAM_ERROR;
+    };
+
+    return ProcessRequest(falcon::meta_proto::RMDIR_RECURSIVE, paramBuilder, responseHandler, cache);
+}
+
 FalconErrorCode Connection::Rename(const char *src, const char *dst, ConnectionCache *cache)
 {
     auto paramBuilder = [src, dst](flatbuffers::FlatBufferBuilder &builder) {
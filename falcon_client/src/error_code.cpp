@@ -96,6 +96,9 @@ int ErrorCodeToErrno(int errorCode)
     case PATH_NOT_EXISTS:
         ret = ENOENT;
         break;
+    case NAME_TOO_LONG:
+        ret = ENAMETOOLONG;
+        break;
     default:
         ret = EIO;
         break;
@@ -4,29 +4,58 @@
 
 #include "falcon_meta.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#include "attr_cache.h"
 #include "buffer/dir_open_instance.h"
 #include "cm/falcon_cm.h"
 #include "falcon_store/falcon_store.h"
 #include "inner_falcon_meta.h"
+#include "negative_cache.h"
+#include "prefetch_hint.h"
 #include "router.h"
+#include "thread_pool/thread_pool.h"
 #include "utils.h"
 
 constexpr int FILE_NUMBER_PER_EPOCH = 1048576;
 constexpr int FILE_NUMBER_PER_WORKER = 4096;
+constexpr uint32_t READDIR_THREAD_NUM = 32;
+constexpr uint64_t READDIR_MAX_TASK_NUM = 65536;
+constexpr size_t MKDIR_RECURSIVE_MAX_BATCH_PATHS = 1024;
+constexpr int DATA_DELETE_QUEUE_TAKE_COUNT = 1024;
+constexpr int DATA_DELETE_QUEUE_LEASE_MS = 60000;
 
 std::shared_ptr<Router> router;
 
+// servers reply OBSOLETE_SHARD with their shard table to operations routed by another one, retried right away
+template <typename Operation>
+static int CallRoutedByPath(const std::string &path, std::shared_ptr<Connection> &conn, Operation &&operation)
+{
+    int errorCode = operation(conn.get());
+    for (int cnt = 0; cnt < RETRY_CNT && errorCode == OBSOLETE_SHARD; ++cnt) {
+        router->ApplyObsoleteShardTable(conn);
+        std::shared_ptr<Connection> newConn = router->GetWorkerConnByPath(path);
+        if (!newConn) {
+            break;
+        }
+        conn = newConn;
+        errorCode = operation(conn.get());
+    }
+    return errorCode;
+}
+
 int FalconInit(std::string &coordinatorIp, int coordinatorPort)
 {
     int ret = FalconStore::GetInstance()->GetInitStatus();
@@ -88,6 +117,53 @@ int FalconMkdir(const std::string &path)
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconMkdir failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
+    if (errorCode == SUCCESS || errorCode == PATH_EXISTS) {
+        NegativeCache::GetInstance().Invalidate(path);
+    }
+    AttrCache::GetInstance().Invalidate(path);
+    return errorCode;
+}
+
+int FalconMkdirRecursive(const std::vector<std::string> &paths)
+{
+    std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
+    if (!conn) {
+        FALCON_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    // each batch is one request and one transaction on the CN, which keeps both of bounded size
+    int errorCode = SUCCESS;
+    for (size_t begin = 0; begin < paths.size(); begin += MKDIR_RECURSIVE_MAX_BATCH_PATHS) {
+        std::vector<std::string> batch(paths.begin() + begin,
+                                       paths.begin() + std::min(paths.size(), begin + MKDIR_RECURSIVE_MAX_BATCH_PATHS));
+        std::vector<FalconErrorCode> errorCodes;
+        int batchErrorCode = conn->MkdirRecursive(batch, errorCodes);
+#ifdef ZK_INIT
+        int cnt = 0;
+        while (cnt < RETRY_CNT && batchErrorCode == SERVER_FAULT) {
+            ++cnt;
+            sleep(SLEEPTIME);
+            conn = router->TryToUpdateCNConn(conn);
+            batchErrorCode = conn->MkdirRecursive(batch, errorCodes);
+        }
+#endif
+        if (errorCode == SUCCESS)
+            errorCode = batchErrorCode;
+        // missing ancestors may have been created as well
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (errorCodes[i] != SUCCESS) {
+                FALCON_LOG(LOG_ERROR) << "FalconMkdirRecursive failed for path: " << batch[i]
+                                      << ", error code: " << errorCodes[i];
+            }
+            for (size_t end = batch[i].find('/', 1); end != std::string::npos; end = batch[i].find('/', end + 1)) {
+                NegativeCache::GetInstance().Invalidate(batch[i].substr(0, end));
+                AttrCache::GetInstance().Invalidate(batch[i].substr(0, end));
+            }
+            NegativeCache::GetInstance().Invalidate(batch[i]);
+            AttrCache::GetInstance().Invalidate(batch[i]);
+        }
+    }
     return errorCode;
 }
 
@@ -100,7 +176,8 @@ int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
     }
     uint64_t inodeId;
     int32_t nodeId;
-    int errorCode = conn->Create(path.c_str(), inodeId, nodeId, stbuf);
+    int errorCode =
+        CallRoutedByPath(path, conn, [&](Connection *c) { return c->Create(path.c_str(), inodeId, nodeId, stbuf); });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
@@ -110,6 +187,11 @@ int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
         errorCode = conn->Create(path.c_str(), inodeId, nodeId, stbuf);
     }
 #endif
+    if (errorCode == SUCCESS || errorCode == FILE_EXISTS) {
+        NegativeCache::GetInstance().Invalidate(path);
+    }
+    AttrCache::GetInstance().Invalidate(path);
+    PrefetchHint::GetInstance().Invalidate(path);
     /* Handle the case of not exclusively created file */
     if (errorCode == FILE_EXISTS && !(oflags & O_EXCL)) {
         errorCode = SUCCESS;
@@ -127,55 +209,108 @@ int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat
     return SUCCESS;
 }
 
-int FalconGetStat(const std::string &path, struct stat *stbuf)
+int FalconGetStat(const std::string &path, struct stat *stbuf, std::optional<int32_t> *nodeId)
 {
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
         return PROGRAM_ERROR;
     }
-    int errorCode = conn->Stat(path.c_str(), stbuf);
+    if (NegativeCache::GetInstance().Lookup(path, conn.get())) {
+        return FILE_NOT_EXISTS;
+    }
+    if (AttrCache::GetInstance().Lookup(path, stbuf)) {
+        return SUCCESS;
+    }
+    uint64_t generation = conn->GetNamespaceGeneration();
+    int errorCode =
+        CallRoutedByPath(path, conn, [&](Connection *c) { return c->Stat(path.c_str(), stbuf, nodeId); });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
         ++cnt;
         sleep(SLEEPTIME);
         conn = router->TryToUpdateWorkerConn(conn);
-        errorCode = conn->Stat(path.c_str(), stbuf);
+        errorCode = conn->Stat(path.c_str(), stbuf, nodeId);
     }
 #endif
+    if (errorCode == FILE_NOT_EXISTS) {
+        NegativeCache::GetInstance().Insert(path, conn.get(), generation);
+    }
     if (errorCode != SUCCESS && errorCode != FILE_NOT_EXISTS) {
         FALCON_LOG(LOG_ERROR) << "FalconGetStat failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
     return errorCode;
 }
 
-int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf)
+int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf, const LookupReply *lookup)
 {
     std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
         return PROGRAM_ERROR;
     }
+    if (NegativeCache::GetInstance().Lookup(path, conn.get())) {
+        return FILE_NOT_EXISTS;
+    }
 
     std::shared_ptr<OpenInstance> openInstance = FalconFd::GetInstance()->WaitGetNewOpenInstance();
     if (openInstance == nullptr) {
         FALCON_LOG(LOG_ERROR) << "new openInstance failed";
         return -EMFILE;
     }
+
+    /* the file was hinted and loaded in advance */
+    PrefetchedFile prefetched;
+    if ((oflags & O_ACCMODE) == O_RDONLY && PrefetchHint::GetInstance().Take(path, prefetched)) {
+        openInstance->inodeId = prefetched.inodeId;
+        openInstance->originalSize = prefetched.size;
+        openInstance->currentSize = prefetched.size;
+        openInstance->nodeId = prefetched.nodeId;
+        openInstance->nodeFail = prefetched.nodeFail;
+        openInstance->path = path;
+        openInstance->oflags = oflags;
+        if (prefetched.buffer != nullptr) {
+            openInstance->readBuffer = prefetched.buffer;
+            openInstance->readBufferSize = prefetched.size;
+        }
+        if (stbuf) {
+            *stbuf = prefetched.stbuf;
+        }
+        fd = FalconFd::GetInstance()->AttachFd(path, openInstance);
+        return SUCCESS;
+    }
     uint64_t inodeId = 0;
     int64_t size = 0;
     int32_t nodeId = 0;
-    int errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
+    int errorCode = SUCCESS;
+    /* the lookup of this open already fetched what OPEN replies, writers still go to the server */
+    if (lookup != nullptr && S_ISREG(lookup->stbuf.st_mode) && (oflags & O_ACCMODE) == O_RDONLY &&
+        !(oflags & O_TRUNC)) {
+        inodeId = lookup->stbuf.st_ino;
+        size = lookup->stbuf.st_size;
+        nodeId = lookup->nodeId;
+        if (stbuf) {
+            *stbuf = lookup->stbuf;
+        }
+    } else {
+        uint64_t generation = conn->GetNamespaceGeneration();
+        errorCode = CallRoutedByPath(path, conn, [&](Connection *c) {
+            return c->Open(path.c_str(), inodeId, size, nodeId, stbuf);
+        });
 #ifdef ZK_INIT
-    int cnt = 0;
-    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
-        ++cnt;
-        sleep(SLEEPTIME);
-        conn = router->TryToUpdateWorkerConn(conn);
-        errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
-    }
+        int cnt = 0;
+        while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+            ++cnt;
+            sleep(SLEEPTIME);
+            conn = router->TryToUpdateWorkerConn(conn);
+            errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
+        }
 #endif
+        if (errorCode == FILE_NOT_EXISTS) {
+            NegativeCache::GetInstance().Insert(path, conn.get(), generation);
+        }
+    }
     if (errorCode != SUCCESS) {
         FalconFd::GetInstance()->ReleaseOpenInstance();
         FALCON_LOG(LOG_ERROR) << "FalconOpen failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
@@ -257,7 +392,9 @@ int FalconClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
         return PROGRAM_ERROR;
     }
 
-    int errorCode = conn->Close(path.c_str(), size, 0, openInstance->nodeId);
+    int errorCode = CallRoutedByPath(path, conn, [&](Connection *c) {
+        return c->Close(path.c_str(), size, 0, openInstance->nodeId);
+    });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
@@ -267,6 +404,8 @@ int FalconClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
         errorCode = conn->Close(path.c_str(), size, 0, openInstance->nodeId);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
+    PrefetchHint::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconClose failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -288,7 +427,8 @@ int FalconUnlink(const std::string &path)
     uint64_t inodeId = 0;
     int64_t size = 0;
     int32_t nodeId = 0;
-    int errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId);
+    int errorCode =
+        CallRoutedByPath(path, conn, [&](Connection *c) { return c->Unlink(path.c_str(), inodeId, size, nodeId); });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
@@ -298,6 +438,8 @@ int FalconUnlink(const std::string &path)
         errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
+    PrefetchHint::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconUnlink failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -313,6 +455,73 @@ int FalconUnlink(const std::string &path)
     return errorCode;
 }
 
+static ThreadPool *GetReadDirThreadPool()
+{
+    static std::unique_ptr<ThreadPool> readDirThreadPool = []() {
+        auto pool = ThreadPool::CreateThreadPool(READDIR_THREAD_NUM, READDIR_MAX_TASK_NUM, "readdir thread pool");
+        if (pool != nullptr && pool->Start() != 0) {
+            pool = nullptr;
+        }
+        return pool;
+    }();
+    return readDirThreadPool.get();
+}
+
+/* Fetch the next batch of one worker in background, the result is delivered through dirOpenInstance->fetchQueue */
+static void IssueReadDirFetch(const std::string &path, DirOpenInstance *dirOpenInstance, const std::string &ipPort)
+{
+    std::shared_ptr<ReadDirFetchQueue> fetchQueue = dirOpenInstance->fetchQueue;
+    std::shared_ptr<Connection> conn = dirOpenInstance->workingWorkers[ipPort];
+    int32_t maxReadCount = dirOpenInstance->fileNumberPerWorker;
+    int32_t lastShardIndex = dirOpenInstance->lastShardIndexes[ipPort];
+    std::string lastFileName = dirOpenInstance->lastFileNames[ipPort];
+
+    auto fetch = [path, fetchQueue, conn, maxReadCount, lastShardIndex, lastFileName, ipPort]() mutable {
+        ReadDirFetchResult result;
+        result.ipPort = ipPort;
+        result.ret = conn->ReadDir(path.c_str(),
+                                   result.readDirResponse,
+                                   maxReadCount,
+                                   lastShardIndex,
+                                   lastFileName.empty() ? nullptr : lastFileName.c_str(),
+                                   true);
+#ifdef ZK_INIT
+        int cnt = 0;
+        while (cnt < RETRY_CNT && result.ret == SERVER_FAULT) {
+            ++cnt;
+            sleep(SLEEPTIME);
+            conn = router->TryToUpdateWorkerConn(conn);
+            result.ret = conn->ReadDir(path.c_str(),
+                                       result.readDirResponse,
+                                       maxReadCount,
+                                       lastShardIndex,
+                                       lastFileName.empty() ? nullptr : lastFileName.c_str(),
+                                       true);
+        }
+#endif
+        result.conn = conn;
+        fetchQueue->Push(std::move(result));
+    };
+
+    ++dirOpenInstance->inflightFetches;
+    ThreadPool *pool = GetReadDirThreadPool();
+    if (pool == nullptr) {
+        fetch();
+        return;
+    }
+    pool->Submit(ThreadTask{"readdir", fetch});
+}
+
+int FalconPrefetchHint(const std::vector<std::string> &paths)
+{
+    if (paths.empty()) {
+        PrefetchHint::GetInstance().Clear();
+        return SUCCESS;
+    }
+    PrefetchHint::GetInstance().Submit(paths);
+    return SUCCESS;
+}
+
 int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, off_t offset, struct FalconFuseInfo *fi)
 {
     uint64_t fd = fi->fh;
@@ -334,81 +543,84 @@ int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, o
             FALCON_LOG(LOG_ERROR) << "FalconReadDir failed for path: " << path << ", GET_ALL_WORKER_CONN_FAILED";
             return GET_ALL_WORKER_CONN_FAILED;
         }
+        dirOpenInstance->ResetDirOpenInstance();
         dirOpenInstance->SetAllWorkerInfo(workerInfo);
         idx = 1;
         filler(buf, ".", nullptr, idx++);
         filler(buf, "..", nullptr, idx++);
+
+        /* request the first batch of every worker at once, batches are merged in arrival order below */
+        if (!workerInfo.empty()) {
+            dirOpenInstance->fileNumberPerWorker =
+                std::min(FILE_NUMBER_PER_EPOCH / (int)workerInfo.size(), FILE_NUMBER_PER_WORKER);
+        }
+        for (auto &worker : workerInfo) {
+            IssueReadDirFetch(path, dirOpenInstance, worker.first);
+        }
     }
 
-    int workerNotFinished = dirOpenInstance->workingWorkers.size();
-    if (dirOpenInstance->offset >= dirOpenInstance->partialEntryVec.size() && workerNotFinished != 0) {
-        uint32_t fileNumberPerWorker = std::min(FILE_NUMBER_PER_EPOCH / workerNotFinished, FILE_NUMBER_PER_WORKER);
-        dirOpenInstance->workers.clear();
-        dirOpenInstance->workers = dirOpenInstance->workingWorkers;
-        dirOpenInstance->workingWorkers.clear();
+    while (true) {
+        for (size_t i = dirOpenInstance->offset; i < dirOpenInstance->partialEntryVec.size(); i++) {
+            if (filler(buf, dirOpenInstance->partialEntryVec[i].c_str(), &dirOpenInstance->fileStats[i], idx++)) {
+                dirOpenInstance->offset = i;
+                return 0;
+            }
+        }
         dirOpenInstance->partialEntryVec.clear();
+        dirOpenInstance->fileStats.clear();
         dirOpenInstance->offset = 0;
-        for (auto it = dirOpenInstance->workers.begin(); it != dirOpenInstance->workers.end(); ++it) {
-            std::string ipPort = it->first;
-            std::shared_ptr<Connection> conn = it->second;
-            Connection::ReadDirResponse readDirResponse;
-            ret = conn->ReadDir(path.c_str(),
-                                readDirResponse,
-                                fileNumberPerWorker,
-                                dirOpenInstance->lastShardIndexes[ipPort],
-                                dirOpenInstance->lastFileNames[ipPort].empty()
-                                    ? nullptr
-                                    : dirOpenInstance->lastFileNames[ipPort].c_str());
-#ifdef ZK_INIT
-            int cnt = 0;
-            while (cnt < RETRY_CNT && ret == SERVER_FAULT) {
-                ++cnt;
-                sleep(SLEEPTIME);
-                conn = router->TryToUpdateWorkerConn(conn);
-                ret = conn->ReadDir(path.c_str(),
-                                    readDirResponse,
-                                    fileNumberPerWorker,
-                                    dirOpenInstance->lastShardIndexes[ipPort],
-                                    dirOpenInstance->lastFileNames[ipPort].empty()
-                                        ? nullptr
-                                        : dirOpenInstance->lastFileNames[ipPort].c_str());
-            }
-#endif
-            dirOpenInstance->lastShardIndexes[ipPort] = readDirResponse.response->last_shard_index();
-            if (readDirResponse.response->last_file_name() == nullptr)
-                dirOpenInstance->lastFileNames[ipPort] = "";
-            else
-                dirOpenInstance->lastFileNames[ipPort] = readDirResponse.response->last_file_name()->str();
-            auto result_list = readDirResponse.response->result_list();
-
-            // fill the fuse readdir buffer using metadata
-            for (unsigned i = 0; i < result_list->size(); i++) {
-                dirOpenInstance->partialEntryVec.push_back(result_list->Get(i)->file_name()->c_str());
-                dirOpenInstance->fileModes.push_back(result_list->Get(i)->st_mode());
-            }
-            if (result_list->size() < fileNumberPerWorker && ret == SUCCESS) {
-                dirOpenInstance->lastFileNames.erase(ipPort);
-            } else {
-                dirOpenInstance->workingWorkers.emplace(ipPort, conn);
-            }
+
+        // a failed fetch fails the listing, in this and any later call, instead of silently ending it short
+        if (dirOpenInstance->fetchError != SUCCESS) {
+            return dirOpenInstance->fetchError;
         }
-    }
-    for (size_t i = dirOpenInstance->offset; i < dirOpenInstance->partialEntryVec.size(); i++) {
-        struct stat st;
-        errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
-        if (err != 0) {
-            FALCON_LOG(LOG_ERROR) << "Secure func failed: " << err;
-            return PROGRAM_ERROR;
+        if (dirOpenInstance->inflightFetches == 0) {
+            return SUCCESS;
         }
 
-        st.st_mode = static_cast<mode_t>(dirOpenInstance->fileModes[i]);
-        if (filler(buf, dirOpenInstance->partialEntryVec[i].c_str(), &st, idx++)) {
-            dirOpenInstance->offset = i;
-            return 0;
+        ReadDirFetchResult result = dirOpenInstance->fetchQueue->Pop();
+        --dirOpenInstance->inflightFetches;
+        const std::string &ipPort = result.ipPort;
+        if (result.ret != SUCCESS || result.readDirResponse.response == nullptr) {
+            FALCON_LOG(LOG_ERROR) << "FalconReadDir failed for path: " << path << ", DN: " << result.conn->server.id
+                                  << ", ip: " << result.conn->server.ip << ", error code: " << result.ret;
+            dirOpenInstance->workingWorkers.erase(ipPort);
+            dirOpenInstance->fetchError = result.ret != SUCCESS ? result.ret : PROGRAM_ERROR;
+            continue;
+        }
+
+        auto response = result.readDirResponse.response;
+        dirOpenInstance->lastShardIndexes[ipPort] = response->last_shard_index();
+        if (response->last_file_name() == nullptr)
+            dirOpenInstance->lastFileNames[ipPort] = "";
+        else
+            dirOpenInstance->lastFileNames[ipPort] = response->last_file_name()->str();
+        auto result_list = response->result_list();
+
+        // fill the fuse readdir buffer using metadata, and keep the attributes for the getattr calls which follow
+        std::string prefix = path.ends_with('/') ? path : path + '/';
+        for (unsigned i = 0; i < result_list->size(); i++) {
+            auto entry = result_list->Get(i);
+            struct stat st;
+            errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
+            if (err != 0) {
+                FALCON_LOG(LOG_ERROR) << "Secure func failed: " << err;
+                return PROGRAM_ERROR;
+            }
+            Connection::ReadDirEntryToStat(entry, &st);
+            AttrCache::GetInstance().Insert(prefix + entry->file_name()->str(), st);
+            dirOpenInstance->partialEntryVec.push_back(entry->file_name()->c_str());
+            dirOpenInstance->fileStats.push_back(st);
+        }
+        if (result_list->size() < dirOpenInstance->fileNumberPerWorker) {
+            dirOpenInstance->lastFileNames.erase(ipPort);
+            dirOpenInstance->workingWorkers.erase(ipPort);
+        } else {
+            /* prefetch the next batch of this worker while the current one is handed to fuse */
+            dirOpenInstance->workingWorkers[ipPort] = result.conn;
+            IssueReadDirFetch(path, dirOpenInstance, ipPort);
         }
     }
-    dirOpenInstance->offset = dirOpenInstance->partialEntryVec.size();
-    return ret;
 }
 
 int FalconOpenDir(const std::string &path, struct FalconFuseInfo *fi)
@@ -476,12 +688,129 @@ int FalconRmDir(const std::string &path)
         errorCode = conn->Rmdir(path.c_str());
     }
 #endif
+    AttrCache::GetInstance().InvalidateTree(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconRmDir failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
     return errorCode;
 }
 
+/*
+ * Deletes the data queued on the workers by FalconRmDirRecursive. Taken entries are leased, entries of a client
+ * failing in between are left to the next reclaim of any client.
+ */
+static void ReclaimDeletedData()
+{
+    std::unordered_map<std::string, std::shared_ptr<Connection>> workerInfo;
+    if (router->GetAllWorkerConnection(workerInfo) != SUCCESS) {
+        FALCON_LOG(LOG_ERROR) << "ReclaimDeletedData failed, GET_ALL_WORKER_CONN_FAILED";
+        return;
+    }
+    const std::string takeCommand = "select * from falcon_data_delete_queue_take(" +
+                                    std::to_string(DATA_DELETE_QUEUE_TAKE_COUNT) + ", " +
+                                    std::to_string(DATA_DELETE_QUEUE_LEASE_MS) + ");";
+    for (auto &worker : workerInfo) {
+        std::shared_ptr<Connection> conn = worker.second;
+        for (;;) {
+            Connection::PlainCommandResult res;
+            int errorCode = conn->PlainCommand(takeCommand.c_str(), res);
+            if (errorCode != SUCCESS) {
+                FALCON_LOG(LOG_WARNING) << "ReclaimDeletedData failed to take from " << worker.first
+                                        << ", error code: " << errorCode;
+                break;
+            }
+            const auto response = res.response;
+            const int rowCount = response->row();
+            const int col = response->col();
+            std::string removeCommand;
+            for (int i = 0; i < rowCount; ++i) {
+                uint64_t inodeId = StringToUint64(response->data()->Get(i * col + 0)->c_str());
+                int32_t nodeId = StringToInt32(response->data()->Get(i * col + 1)->c_str());
+                std::string path = response->data()->Get(i * col + 2)->str();
+                // files never written have no data
+                int ret = InnerFalconUnlink(inodeId, nodeId, path);
+                if (ret != 0 && ret != -ENOENT) {
+                    FALCON_LOG(LOG_WARNING) << "ReclaimDeletedData failed to delete " << path << ", ret: " << ret;
+                    continue;
+                }
+                removeCommand += (removeCommand.empty() ? "" : ",") + std::to_string(inodeId);
+            }
+            // the leased entries left are not handed out again for a while, so this ends as well
+            if (removeCommand.empty()) {
+                break;
+            }
+            removeCommand = "select falcon_data_delete_queue_remove('{" + removeCommand + "}');";
+            Connection::PlainCommandResult removeRes;
+            errorCode = conn->PlainCommand(removeCommand.c_str(), removeRes);
+            if (errorCode != SUCCESS) {
+                FALCON_LOG(LOG_WARNING) << "ReclaimDeletedData failed to remove from " << worker.first
+                                        << ", error code: " << errorCode;
+                break;
+            }
+        }
+    }
+}
+
+static std::atomic<bool> dataReclaimRequested{false};
+static std::atomic<bool> dataReclaimRunning{false};
+
+// at most one reclaim runs at a time, requests arriving meanwhile are served by another round of it
+static void ScheduleDataReclaim()
+{
+    static std::unique_ptr<ThreadPool> reclaimThreadPool = []() {
+        auto pool = ThreadPool::CreateThreadPool(1, 1, "data reclaim thread pool");
+        if (pool != nullptr && pool->Start() != 0) {
+            pool = nullptr;
+        }
+        return pool;
+    }();
+
+    dataReclaimRequested.store(true);
+    if (dataReclaimRunning.exchange(true)) {
+        return;
+    }
+    auto reclaim = []() {
+        do {
+            while (dataReclaimRequested.exchange(false)) {
+                ReclaimDeletedData();
+            }
+            dataReclaimRunning.store(false);
+        } while (dataReclaimRequested.load() && !dataReclaimRunning.exchange(true));
+    };
+    if (reclaimThreadPool == nullptr || reclaimThreadPool->Submit(ThreadTask{"data reclaim", reclaim}) != 0) {
+        dataReclaimRunning.store(false);
+        FALCON_LOG(LOG_WARNING) << "ScheduleDataReclaim failed, deleted data is left to the next reclaim";
+    }
+}
+
+int FalconRmDirRecursive(const std::string &path)
+{
+    std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
+    if (!conn) {
+        FALCON_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+    int errorCode = conn->RmdirRecursive(path.c_str());
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateCNConn(conn);
+        errorCode = conn->RmdirRecursive(path.c_str());
+    }
+#endif
+    AttrCache::GetInstance().InvalidateTree(path);
+    PrefetchHint::GetInstance().InvalidateTree(path);
+    if (errorCode != SUCCESS) {
+        FALCON_LOG(LOG_ERROR) << "FalconRmDirRecursive failed for path: " << path << ", DN: " << conn->server.id
+                              << ", ip: " << conn->server.ip << ", error code: " << errorCode;
+        return errorCode;
+    }
+    ScheduleDataReclaim();
+    return errorCode;
+}
+
 int FalconWrite(uint64_t fd, const std::string & /*path*/, const char *buffer, size_t size, off_t offset)
 {
     std::shared_ptr<OpenInstance> openInstance = FalconFd::GetInstance()->GetOpenInstanceByFd(fd);
@@ -510,9 +839,21 @@ int FalconRead(const std::string & /*path*/, uint64_t fd, char *buffer, size_t s
     return ret;
 }
 
-int FalconRename(const std::string &srcName, const std::string &dstName)
+// files whose source and destination are owned by one worker are renamed there in a local transaction, the worker
+// answers WRONG_WORKER to anything it can't rename alone (directories, stale routing), which goes through the CN
+static int CallRename(const std::string &srcName, const std::string &dstName, std::shared_ptr<Connection> &conn)
 {
-    std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
+    std::shared_ptr<Connection> srcConn = router->GetWorkerConnByPath(srcName);
+    std::shared_ptr<Connection> dstConn = router->GetWorkerConnByPath(dstName);
+    if (srcConn && dstConn && srcConn->server.id == dstConn->server.id) {
+        conn = srcConn;
+        int errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
+        if (errorCode != WRONG_WORKER) {
+            return errorCode;
+        }
+    }
+
+    conn = router->GetCoordinatorConn();
     if (!conn) {
         FALCON_LOG(LOG_ERROR) << "route error";
         return PROGRAM_ERROR;
@@ -527,8 +868,24 @@ int FalconRename(const std::string &srcName, const std::string &dstName)
         errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
     }
 #endif
+    return errorCode;
+}
+
+int FalconRename(const std::string &srcName, const std::string &dstName)
+{
+    std::shared_ptr<Connection> conn;
+    int errorCode = CallRename(srcName, dstName, conn);
+    if (!conn) {
+        return errorCode;
+    }
+    AttrCache::GetInstance().InvalidateTree(srcName);
+    AttrCache::GetInstance().InvalidateTree(dstName);
+    PrefetchHint::GetInstance().InvalidateTree(srcName);
+    PrefetchHint::GetInstance().InvalidateTree(dstName);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconRename failed for srcName: " << srcName << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
+    } else {
+        NegativeCache::GetInstance().InvalidateTree(dstName);
     }
     return errorCode;
 }
@@ -557,25 +914,20 @@ int FalconRenamePersist(const std::string &srcName, const std::string &dstName)
         return ret;
     }
     // update the metadata for rename
-    std::shared_ptr<Connection> conn = router->GetCoordinatorConn();
+    std::shared_ptr<Connection> conn;
+    int errorCode = CallRename(srcName, dstName, conn);
     if (!conn) {
-        FALCON_LOG(LOG_ERROR) << "route error";
-        return PROGRAM_ERROR;
-    }
-    int errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
-#ifdef ZK_INIT
-    int cnt = 0;
-    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
-        ++cnt;
-        sleep(SLEEPTIME);
-        conn = router->TryToUpdateCNConn(conn);
-        errorCode = conn->Rename(srcName.c_str(), dstName.c_str());
+        return errorCode;
     }
-#endif
+    AttrCache::GetInstance().InvalidateTree(srcName);
+    AttrCache::GetInstance().InvalidateTree(dstName);
+    PrefetchHint::GetInstance().InvalidateTree(srcName);
+    PrefetchHint::GetInstance().InvalidateTree(dstName);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconRenamePersist failed for srcName: " << srcName << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
     if (errorCode == SUCCESS) {
+        NegativeCache::GetInstance().InvalidateTree(dstName);
         // delete src object
         InnerFalconDeleteDataAfterRename(srcName);
     } else {
@@ -604,7 +956,8 @@ int FalconUtimens(const std::string &path, int64_t accessTime, int64_t modifyTim
         return PROGRAM_ERROR;
     }
 
-    int errorCode = conn->UtimeNs(path.c_str(), accessTime, modifyTime);
+    int errorCode =
+        CallRoutedByPath(path, conn, [&](Connection *c) { return c->UtimeNs(path.c_str(), accessTime, modifyTime); });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
@@ -614,6 +967,7 @@ int FalconUtimens(const std::string &path, int64_t accessTime, int64_t modifyTim
         errorCode = conn->UtimeNs(path.c_str(), accessTime, modifyTime);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconUtimens failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -628,7 +982,7 @@ int FalconChown(const std::string &path, uid_t uid, gid_t gid)
         return PROGRAM_ERROR;
     }
 
-    int errorCode = conn->Chown(path.c_str(), uid, gid);
+    int errorCode = CallRoutedByPath(path, conn, [&](Connection *c) { return c->Chown(path.c_str(), uid, gid); });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
@@ -638,6 +992,7 @@ int FalconChown(const std::string &path, uid_t uid, gid_t gid)
         errorCode = conn->Chown(path.c_str(), uid, gid);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconChown failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -652,7 +1007,7 @@ int FalconChmod(const std::string &path, mode_t mode)
         return PROGRAM_ERROR;
     }
 
-    int errorCode = conn->Chmod(path.c_str(), mode);
+    int errorCode = CallRoutedByPath(path, conn, [&](Connection *c) { return c->Chmod(path.c_str(), mode); });
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
@@ -662,6 +1017,7 @@ int FalconChmod(const std::string &path, mode_t mode)
         errorCode = conn->Chmod(path.c_str(), mode);
     }
 #endif
+    AttrCache::GetInstance().Invalidate(path);
     if (errorCode != SUCCESS) {
         FALCON_LOG(LOG_ERROR) << "FalconChmod failed for path: " << path << ", DN: " << conn->server.id << ", ip: " << conn->server.ip << ", error code: " << errorCode;
     }
@@ -0,0 +1,138 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "fuse_inode_table.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+FuseInodeTable &FuseInodeTable::GetInstance()
+{
+    static FuseInodeTable instance;
+    return instance;
+}
+
+FuseInodeTable::FuseInodeTable()
+{
+    // the root is never forgotten
+    nodes.emplace(ROOT_INO, Node{ROOT_INO, "", 1, true});
+}
+
+bool FuseInodeTable::GetPath(uint64_t ino, std::string &path)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (ino == ROOT_INO) {
+        path = "/";
+        return true;
+    }
+    std::vector<const std::string *> names;
+    while (ino != ROOT_INO) {
+        auto it = nodes.find(ino);
+        if (it == nodes.end()) {
+            return false;
+        }
+        names.push_back(&it->second.name);
+        ino = it->second.parent;
+    }
+    path.clear();
+    for (auto name = names.rbegin(); name != names.rend(); ++name) {
+        path += '/';
+        path += **name;
+    }
+    return true;
+}
+
+uint64_t FuseInodeTable::Acquire(uint64_t parent, const std::string &name)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!nodes.contains(parent)) {
+        return 0;
+    }
+    auto it = children.find({parent, name});
+    if (it != children.end()) {
+        ++nodes[it->second].nlookup;
+        return it->second;
+    }
+    uint64_t ino = nextIno++;
+    nodes.emplace(ino, Node{parent, name, 1, true});
+    children.emplace(std::make_pair(parent, name), ino);
+    ++nodes[parent].childCount;
+    return ino;
+}
+
+void FuseInodeTable::Forget(uint64_t ino, uint64_t nlookup)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = nodes.find(ino);
+    if (ino == ROOT_INO || it == nodes.end()) {
+        return;
+    }
+    Node &node = it->second;
+    node.nlookup -= std::min(node.nlookup, nlookup);
+    ReleaseIfUnused(ino);
+}
+
+void FuseInodeTable::Remove(uint64_t parent, const std::string &name)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = children.find({parent, name});
+    if (it != children.end()) {
+        Detach(it);
+    }
+}
+
+void FuseInodeTable::Rename(uint64_t parent, const std::string &name, uint64_t newParent, const std::string &newName)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // the replaced target stays reachable for the files still open through it
+    auto dst = children.find({newParent, newName});
+    if (dst != children.end()) {
+        Detach(dst);
+    }
+    auto src = children.find({parent, name});
+    if (src == children.end()) {
+        return;
+    }
+    auto newParentNode = nodes.find(newParent);
+    if (newParentNode == nodes.end()) {
+        Detach(src);
+        return;
+    }
+    uint64_t ino = src->second;
+    children.erase(src);
+    Node &node = nodes[ino];
+    uint64_t oldParent = node.parent;
+    node.parent = newParent;
+    node.name = newName;
+    children.emplace(std::make_pair(newParent, newName), ino);
+    if (oldParent != newParent) {
+        ++newParentNode->second.childCount;
+        --nodes[oldParent].childCount;
+        ReleaseIfUnused(oldParent);
+    }
+}
+
+void FuseInodeTable::Detach(std::map<std::pair<uint64_t, std::string>, uint64_t>::iterator it)
+{
+    nodes[it->second].linked = false;
+    children.erase(it);
+}
+
+void FuseInodeTable::ReleaseIfUnused(uint64_t ino)
+{
+    while (ino != ROOT_INO) {
+        auto it = nodes.find(ino);
+        if (it == nodes.end() || it->second.nlookup != 0 || it->second.childCount != 0) {
+            return;
+        }
+        uint64_t parent = it->second.parent;
+        if (it->second.linked) {
+            children.erase({parent, it->second.name});
+        }
+        nodes.erase(it);
+        --nodes[parent].childCount;
+        ino = parent;
+    }
+}
@@ -0,0 +1,56 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+/*
+ * Short-lived attributes of entries returned by readdirplus, so that the getattr which follows every entry of
+ * `ls -l`, `find` or `du` is answered locally instead of costing one STAT round trip per file.
+ *
+ * Entries are only trusted until their timeout expires. Every local operation which changes the attributes or
+ * the name of an entry drops it immediately, changes made by other clients become visible after the timeout.
+ */
+class AttrCache {
+  public:
+    static AttrCache &GetInstance();
+
+    // 0 disables the cache
+    void SetTimeout(uint32_t timeoutMs);
+    bool Enabled() const { return timeout.count() != 0; }
+
+    bool Lookup(const std::string &path, struct stat *stbuf);
+    void Insert(const std::string &path, const struct stat &stbuf);
+    void Invalidate(const std::string &path);
+    // invalidate path and everything below it, used when a directory is renamed or removed
+    void InvalidateTree(const std::string &path);
+
+  private:
+    struct Entry
+    {
+        struct stat stbuf;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    static constexpr size_t SHARD_NUM = 64;
+    static constexpr size_t MAX_ENTRIES_PER_SHARD = 4096;
+
+    AttrCache() = default;
+    Shard &GetShard(const std::string &path) { return shards[std::hash<std::string>()(path) % SHARD_NUM]; }
+
+    std::chrono::milliseconds timeout{0};
+    std::array<Shard, SHARD_NUM> shards;
+};
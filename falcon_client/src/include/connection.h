@@ -4,9 +4,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <sys/stat.h>
 
@@ -60,9 +64,27 @@ class ConnectionCache {
 static thread_local ConnectionCache ThreadLocalConnectionCache;
 
 class Connection {
+  public:
+    struct ShardTable
+    {
+        uint64_t epoch;
+        std::vector<int32_t> rangePoints;
+        std::vector<int32_t> serverIds;
+    };
+
   private:
     brpc::Channel channel;
     falcon::meta_proto::MetaService_Stub stub;
+    std::atomic<uint64_t> namespaceGeneration{0};
+    void UpdateNamespaceGeneration(uint64_t generation);
+    // highest directory log position seen from any server, sent along with every request
+    static inline std::atomic<uint64_t> directoryLogPosition{0};
+    static void UpdateDirectoryLogPosition(uint64_t position);
+    // epoch of the shard table operations routed by path are tagged with, 0 if this is no worker connection
+    std::atomic<uint64_t> shardTableEpoch{0};
+    std::mutex obsoleteShardTableMutex;
+    std::optional<ShardTable> obsoleteShardTable;
+    void KeepObsoleteShardTable(const falcon::meta_fbs::ShardTableResponse *response);
     template <typename ParamBuilder, typename ResponseHandler, typename ResultType = void>
     FalconErrorCode ProcessRequest(falcon::meta_proto::MetaServiceType type,
                                    const ParamBuilder &paramBuilder,
@@ -83,6 +105,13 @@ class Connection {
     }
     ~Connection() = default;
 
+    // latest namespace generation seen from this server, 0 if the server doesn't report one
+    uint64_t GetNamespaceGeneration() const { return namespaceGeneration.load(std::memory_order_acquire); }
+
+    void SetShardTableEpoch(uint64_t epoch) { shardTableEpoch.store(epoch, std::memory_order_relaxed); }
+    // the shard table of the server, if an operation was replied OBSOLETE_SHARD since the last call
+    bool TakeObsoleteShardTable(ShardTable &table);
+
     class PlainCommandResult {
         friend Connection;
 
@@ -100,9 +129,17 @@ class Connection {
     };
     FalconErrorCode PlainCommand(const char *command, PlainCommandResult &result, ConnectionCache *cache = nullptr);
     FalconErrorCode Mkdir(const char *path, ConnectionCache *cache = nullptr);
+    // mkdir -p of all paths in one request, errorCodes receives the result of each path
+    FalconErrorCode MkdirRecursive(const std::vector<std::string> &paths,
+                                   std::vector<FalconErrorCode> &errorCodes,
+                                   ConnectionCache *cache = nullptr);
     FalconErrorCode
     Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct stat *stbuf, ConnectionCache *cache = nullptr);
-    FalconErrorCode Stat(const char *path, struct stat *stbuf, ConnectionCache *cache = nullptr);
+    // nodeId, if given, receives the node of the file data when the server replies it
+    FalconErrorCode Stat(const char *path,
+                         struct stat *stbuf,
+                         std::optional<int32_t> *nodeId = nullptr,
+                         ConnectionCache *cache = nullptr);
     FalconErrorCode Open(const char *path,
                          uint64_t &inodeId,
                          int64_t &size,
@@ -120,7 +157,7 @@ class Connection {
         std::unique_ptr<char[]> buffer;
 
       public:
-        const falcon::meta_fbs::ReadDirResponse *response;
+        const falcon::meta_fbs::ReadDirResponse *response = nullptr;
         friend class Connection;
     };
     FalconErrorCode ReadDir(const char *path,
@@ -128,10 +165,15 @@ class Connection {
                             int32_t maxReadCount = -1,
                             int32_t lastShardIndex = -1,
                             const char *lastFileName = nullptr,
+                            bool plus = false,
                             ConnectionCache *cache = nullptr);
+    // convert one entry of a readdirplus response into the same stat layout returned by Stat
+    static void ReadDirEntryToStat(const falcon::meta_fbs::OneReadDirResponse *entry, struct stat *stbuf);
 
     FalconErrorCode OpenDir(const char *path, uint64_t &inodeId, ConnectionCache *cache = nullptr);
     FalconErrorCode Rmdir(const char *path, ConnectionCache *cache = nullptr);
+    // rm -r on the server, data of the removed files is left in the delete queue of the workers
+    FalconErrorCode RmdirRecursive(const char *path, ConnectionCache *cache = nullptr);
     FalconErrorCode Rename(const char *src, const char *dst, ConnectionCache *cache = nullptr);
     FalconErrorCode UtimeNs(const char *path, int64_t atime = -1, int64_t mtime = -1, ConnectionCache *cache = nullptr);
     FalconErrorCode Chown(const char *path, uint32_t uid, uint32_t gid, ConnectionCache *cache = nullptr);
@@ -6,7 +6,10 @@
 
 #include <stdint.h>
 #include <memory>
+#include <optional>
+#include <vector>
 
+#include "lookup_open_token.h"
 #include "router.h"
 
 extern std::shared_ptr<Router> router;
@@ -40,19 +43,38 @@ using FalconFuseFiller = int (*)(void *, const char *, const struct stat *, off_
 
 int FalconMkdir(const std::string &path);
 
+/*
+ * mkdir -p of all paths, missing ancestors are created as well and existing directories count as success. Paths
+ * are sent to the CN in batches of at most 1024, each created in one round trip and one transaction, so a failure
+ * leaves the batches before it created. Returns the first error of a failed path, if any.
+ */
+int FalconMkdirRecursive(const std::vector<std::string> &paths);
+
 int FalconCreate(const std::string &path, uint64_t &fd, int oflags, struct stat *stbuf);
 
-int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf);
+/*
+ * lookup, if given, is the STAT reply of the lookup which resolved path for this very open. Read-only opens take
+ * it instead of sending OPEN, opens for writing or with O_TRUNC always ask the server.
+ */
+int FalconOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *stbuf,
+               const LookupReply *lookup = nullptr);
 
 int FalconUnlink(const std::string &path);
 
+/*
+ * Announce the paths which are going to be opened read-only, in this order. They are loaded in background and
+ * the following FalconOpen calls are served from memory. An empty list drops everything announced so far.
+ */
+int FalconPrefetchHint(const std::vector<std::string> &paths);
+
 int FalconOpenDir(const std::string &path, struct FalconFuseInfo *fi);
 
 int FalconReadDir(const std::string &path, void *buf, FalconFuseFiller filler, off_t offset, struct FalconFuseInfo *fi);
 
 int FalconClose(const std::string &path, uint64_t fd, bool isFlush = false, int datasync = -1);
 
-int FalconGetStat(const std::string &path, struct stat *stbuf);
+// nodeId, if given, is set to the data node of a regular file when the reply came from the server
+int FalconGetStat(const std::string &path, struct stat *stbuf, std::optional<int32_t> *nodeId = nullptr);
 
 int FalconCloseDir(uint64_t fd);
 
@@ -64,6 +86,12 @@ int FalconDestroy();
 
 int FalconRmDir(const std::string &path);
 
+/*
+ * rm -r of the directory, executed on the servers in one transaction. The data of the removed files is deleted
+ * in background afterwards.
+ */
+int FalconRmDirRecursive(const std::string &path);
+
 int FalconWrite(uint64_t fd, const std::string &path, const char *buffer, size_t size, off_t offset);
 
 int FalconRead(const std::string &path, uint64_t fd, char *buffer, size_t size, off_t offset);
@@ -0,0 +1,56 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/*
+ * Node ids handed to the kernel by the low-level FUSE daemon. The kernel resolves paths itself and refers to
+ * files by node id, while FalconFS is addressed by path, so every node remembers its parent and name and the
+ * path is rebuilt from them. Renaming a directory therefore moves its whole subtree at once.
+ *
+ * A node lives as long as the kernel holds lookup references to it or a live node names it as parent, since the
+ * path of a child is built through all of its ancestors. Unlinked or replaced nodes are detached from the name
+ * index but keep their last path, which is still used to release files opened through them.
+ */
+class FuseInodeTable {
+  public:
+    static constexpr uint64_t ROOT_INO = 1;
+
+    static FuseInodeTable &GetInstance();
+
+    // false if ino is unknown
+    bool GetPath(uint64_t ino, std::string &path);
+    // node id of name in parent, taking one lookup reference, 0 if parent is unknown
+    uint64_t Acquire(uint64_t parent, const std::string &name);
+    void Forget(uint64_t ino, uint64_t nlookup);
+    void Remove(uint64_t parent, const std::string &name);
+    void Rename(uint64_t parent, const std::string &name, uint64_t newParent, const std::string &newName);
+
+  private:
+    struct Node
+    {
+        uint64_t parent;
+        std::string name;
+        uint64_t nlookup;
+        bool linked;
+        // live nodes whose parent this is
+        uint64_t childCount = 0;
+    };
+
+    FuseInodeTable();
+    void Detach(std::map<std::pair<uint64_t, std::string>, uint64_t>::iterator it);
+    // drop ino, and then its ancestors, as long as neither the kernel nor a child refers to them
+    void ReleaseIfUnused(uint64_t ino);
+
+    std::shared_mutex mutex;
+    std::unordered_map<uint64_t, Node> nodes;
+    std::map<std::pair<uint64_t, std::string>, uint64_t> children;
+    uint64_t nextIno = ROOT_INO + 1;
+};
@@ -0,0 +1,57 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/* STAT reply of a lookup, which carries everything OPEN replies for a regular file */
+struct LookupReply
+{
+    struct stat stbuf{};
+    int32_t nodeId = -1;
+};
+
+/*
+ * Single-use hand-over of a lookup reply to the open following it within the same open(2). The kernel resolves
+ * the last component with a lookup and sends the open right after it from the same thread, so a reply fetched
+ * from the server by that lookup is as fresh as the reply of an OPEN.
+ *
+ * A token is granted to the requesting thread for one node. It is handed out only to the next open of that
+ * thread, only for the same node and only within a few milliseconds. The next lookup of the thread replaces it,
+ * a local setattr of the node drops it. Replies served from a cache never become a token.
+ */
+class LookupOpenToken {
+  public:
+    static LookupOpenToken &GetInstance();
+
+    void Grant(pid_t tid, uint64_t ino, const LookupReply &reply);
+    // reply granted to tid for ino, the token of tid is dropped in any case
+    bool Take(pid_t tid, uint64_t ino, LookupReply &reply);
+    void Drop(pid_t tid);
+    // drop the tokens of ino, its attributes changed
+    void Revoke(uint64_t ino);
+
+  private:
+    struct Token
+    {
+        uint64_t ino;
+        LookupReply reply;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+
+    static constexpr std::chrono::milliseconds LIFETIME{5};
+    static constexpr size_t MAX_TOKENS = 4096;
+
+    LookupOpenToken() = default;
+
+    std::mutex mutex;
+    std::unordered_map<pid_t, Token> tokens;
+};
@@ -0,0 +1,71 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "connection.h"
+
+/*
+ * Remembers paths the server reported as FILE_NOT_EXISTS, so that repeated lookups of missing files (optional
+ * sidecar files, import probing, ...) don't cost a round trip each.
+ *
+ * An entry is only trusted while the namespace generation of the owning server is unchanged and its timeout
+ * has not expired. Servers advance the generation whenever an entry is created there, and report it on every
+ * response, so entries become stale as soon as the client talks to that server again. Local CREATE/MKDIR/RENAME
+ * results invalidate the affected paths immediately.
+ */
+class NegativeCache {
+  public:
+    static constexpr size_t SHARD_NUM = 64;
+    static constexpr size_t MAX_ENTRIES_PER_SHARD = 16384;
+
+    static NegativeCache &GetInstance();
+
+    // 0 disables the cache
+    void SetTimeout(uint32_t timeoutMs);
+    bool Enabled() const { return timeout.count() != 0; }
+
+    bool Lookup(const std::string &path, const Connection *conn)
+    {
+        return conn != nullptr && Lookup(path, conn->server.id, conn->GetNamespaceGeneration());
+    }
+    // generation should be fetched from conn before the request which reported the miss was sent
+    void Insert(const std::string &path, const Connection *conn, uint64_t generation)
+    {
+        if (conn != nullptr) {
+            Insert(path, conn->server.id, generation);
+        }
+    }
+    // same as above for the server serverId, whose current generation is given to Lookup
+    bool Lookup(const std::string &path, int serverId, uint64_t currentGeneration);
+    void Insert(const std::string &path, int serverId, uint64_t generation);
+    void Invalidate(const std::string &path);
+    // invalidate path and everything below it, used when a directory appears at path
+    void InvalidateTree(const std::string &path);
+
+  private:
+    struct Entry
+    {
+        int serverId;
+        uint64_t generation;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    NegativeCache() = default;
+    Shard &GetShard(const std::string &path) { return shards[std::hash<std::string>()(path) % SHARD_NUM]; }
+
+    std::chrono::milliseconds timeout{0};
+    std::array<Shard, SHARD_NUM> shards;
+};
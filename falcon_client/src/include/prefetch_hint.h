@@ -0,0 +1,78 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+/* metadata, and for small files the whole content, of a hinted file */
+struct PrefetchedFile
+{
+    uint64_t inodeId = 0;
+    int64_t size = 0;
+    int32_t nodeId = -1;
+    bool nodeFail = false;
+    struct stat stbuf{};
+    // content of small files, nullptr for empty and large files
+    std::shared_ptr<char> buffer = nullptr;
+};
+
+/*
+ * Staging area for files the application announced it will open, e.g. the shuffled file list of the next
+ * training epoch. Hinted paths are loaded in background, in hint order, at most `window` files ahead of
+ * consumption and while staged content stays below the memory limit. FalconOpen takes the staged result
+ * instead of issuing OPEN and reading the small file itself.
+ *
+ * The hint is a promise from the application that the files are not modified meanwhile by other clients.
+ * Local operations on a staged path drop it.
+ */
+class PrefetchHint {
+  public:
+    static PrefetchHint &GetInstance();
+
+    // window == 0 disables prefetching
+    void SetLimit(uint32_t window, uint64_t memoryLimit);
+    bool Enabled() const { return window != 0; }
+
+    // append paths in the order they are going to be opened
+    void Submit(std::vector<std::string> paths);
+    // drop all pending and staged files
+    void Clear();
+    // hand over the staged file of path, waiting for it if it is still loading
+    bool Take(const std::string &path, PrefetchedFile &file);
+    void Invalidate(const std::string &path);
+    void InvalidateTree(const std::string &path);
+
+  private:
+    enum class EntryState { LOADING, READY, FAILED };
+    struct Entry
+    {
+        uint64_t seq;
+        EntryState state;
+        PrefetchedFile file;
+    };
+
+    PrefetchHint() = default;
+    // start loading pending paths while below the limits, must be called with mutex held
+    void Pump();
+    void Load(const std::string &path, uint64_t seq);
+    void EraseEntry(std::unordered_map<std::string, Entry>::iterator it);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<uint64_t, std::string>> pending;
+    std::unordered_map<std::string, Entry> staged;
+    uint64_t nextSeq = 0;
+    uint64_t stagedBytes = 0;
+    uint32_t window = 0;
+    uint64_t memoryLimit = 0;
+};
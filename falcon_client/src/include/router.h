@@ -4,11 +4,13 @@
 
 #pragma once
 
-#include <map>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <shared_mutex>
+#include <vector>
 
 #include "connection.h"
 
@@ -35,19 +37,39 @@ struct InodeIdentifierHash
     }
 };
 
+/*
+ * Flat routing array of one shard table: shard i covers the hash values up to rangePoints[i] and is served by
+ * connections[i]. A published table is never modified, lookups read it without any lock.
+ */
+struct RoutingTable
+{
+    uint64_t epoch;
+    std::vector<int32_t> rangePoints;
+    // nullptr for the values below the first range
+    std::vector<std::shared_ptr<Connection>> connections;
+};
+
 class Router {
   private:
     std::shared_ptr<Connection> coordinatorConn;
-    std::map<int, ServerIdentifier> shardTable;
+    std::atomic<const RoutingTable *> routingTable{nullptr};
+    // every table published so far, lookups may still read replaced ones so they are only freed with the router
+    std::vector<std::unique_ptr<const RoutingTable>> publishedRoutingTables;
     std::unordered_map<ServerIdentifier, std::shared_ptr<Connection>, ServerIdentifierHash> routeMap;
     std::shared_mutex coordinatorMtx;
     std::shared_mutex mapMtx;
 
+    // mapMtx must be held exclusively
+    void PublishRoutingTable(std::unique_ptr<RoutingTable> table);
+
   public:
     Router(const ServerIdentifier &coordinator);
 
     int FetchShardTable(std::shared_ptr<Connection> conn);
 
+    // adopt the shard table conn replied along with OBSOLETE_SHARD
+    int ApplyObsoleteShardTable(std::shared_ptr<Connection> conn);
+
     std::shared_ptr<Connection> GetCoordinatorConn();
 
     std::shared_ptr<Connection> GetWorkerConnByPath(std::string_view path);
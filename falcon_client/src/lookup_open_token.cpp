@@ -0,0 +1,52 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "lookup_open_token.h"
+
+LookupOpenToken &LookupOpenToken::GetInstance()
+{
+    static LookupOpenToken instance;
+    return instance;
+}
+
+void LookupOpenToken::Grant(pid_t tid, uint64_t ino, const LookupReply &reply)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tokens.size() >= MAX_TOKENS) {
+        // lookups which were never followed by an open
+        std::erase_if(tokens, [&](const auto &item) { return item.second.expireTime < now; });
+        if (tokens.size() >= MAX_TOKENS && !tokens.contains(tid)) {
+            return;
+        }
+    }
+    tokens.insert_or_assign(tid, Token{ino, reply, now + LIFETIME});
+}
+
+bool LookupOpenToken::Take(pid_t tid, uint64_t ino, LookupReply &reply)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tokens.find(tid);
+    if (it == tokens.end()) {
+        return false;
+    }
+    bool valid = it->second.ino == ino && it->second.expireTime >= std::chrono::steady_clock::now();
+    if (valid) {
+        reply = it->second.reply;
+    }
+    tokens.erase(it);
+    return valid;
+}
+
+void LookupOpenToken::Drop(pid_t tid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    tokens.erase(tid);
+}
+
+void LookupOpenToken::Revoke(uint64_t ino)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(tokens, [&](const auto &item) { return item.second.ino == ino; });
+}
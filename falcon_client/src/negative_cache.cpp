@@ -0,0 +1,74 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "negative_cache.h"
+
+NegativeCache &NegativeCache::GetInstance()
+{
+    static NegativeCache instance;
+    return instance;
+}
+
+void NegativeCache::SetTimeout(uint32_t timeoutMs)
+{
+    timeout = std::chrono::milliseconds(timeoutMs);
+}
+
+bool NegativeCache::Lookup(const std::string &path, int serverId, uint64_t currentGeneration)
+{
+    if (!Enabled()) {
+        return false;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    const Entry &entry = it->second;
+    if (entry.serverId != serverId || entry.generation != currentGeneration ||
+        entry.expireTime < std::chrono::steady_clock::now()) {
+        shard.entries.erase(it);
+        return false;
+    }
+    return true;
+}
+
+void NegativeCache::Insert(const std::string &path, int serverId, uint64_t generation)
+{
+    // servers which don't report a generation can't be validated against
+    if (!Enabled() || generation == 0) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.size() >= MAX_ENTRIES_PER_SHARD) {
+        shard.entries.erase(shard.entries.begin());
+    }
+    shard.entries.insert_or_assign(path, Entry{serverId, generation, std::chrono::steady_clock::now() + timeout});
+}
+
+void NegativeCache::Invalidate(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(path);
+}
+
+void NegativeCache::InvalidateTree(const std::string &path)
+{
+    if (!Enabled()) {
+        return;
+    }
+    std::string prefix = path.ends_with('/') ? path : path + '/';
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::erase_if(shard.entries, [&](const auto &item) {
+            return item.first == path || item.first.starts_with(prefix);
+        });
+    }
+}
@@ -0,0 +1,233 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "prefetch_hint.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "falcon_meta.h"
+#include "inner_falcon_meta.h"
+#include "log/logging.h"
+#include "thread_pool/thread_pool.h"
+#include "util/utils.h"
+
+constexpr uint32_t PREFETCH_THREAD_NUM = 32;
+constexpr uint64_t PREFETCH_MAX_TASK_NUM = 65536;
+constexpr size_t PREFETCH_BUFFER_ALIGN = 512;
+
+static ThreadPool *GetPrefetchThreadPool()
+{
+    static std::unique_ptr<ThreadPool> prefetchThreadPool = []() {
+        auto pool = ThreadPool::CreateThreadPool(PREFETCH_THREAD_NUM, PREFETCH_MAX_TASK_NUM, "prefetch thread pool");
+        if (pool != nullptr && pool->Start() != 0) {
+            pool = nullptr;
+        }
+        return pool;
+    }();
+    return prefetchThreadPool.get();
+}
+
+PrefetchHint &PrefetchHint::GetInstance()
+{
+    static PrefetchHint instance;
+    return instance;
+}
+
+void PrefetchHint::SetLimit(uint32_t window, uint64_t memoryLimit)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->window = window;
+    this->memoryLimit = memoryLimit;
+}
+
+void PrefetchHint::Submit(std::vector<std::string> paths)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!Enabled()) {
+        return;
+    }
+    for (auto &path : paths) {
+        pending.emplace_back(nextSeq++, std::move(path));
+    }
+    Pump();
+}
+
+void PrefetchHint::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    // loads in flight find their entry gone and drop the result
+    staged.clear();
+    stagedBytes = 0;
+    cv.notify_all();
+}
+
+bool PrefetchHint::Take(const std::string &path, PrefetchedFile &file)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!Enabled()) {
+        return false;
+    }
+    auto it = staged.find(path);
+    if (it == staged.end()) {
+        return false;
+    }
+    uint64_t seq = it->second.seq;
+    cv.wait(lock, [&]() {
+        it = staged.find(path);
+        return it == staged.end() || it->second.seq != seq || it->second.state != EntryState::LOADING;
+    });
+    if (it == staged.end() || it->second.seq != seq) {
+        return false;
+    }
+    bool ready = it->second.state == EntryState::READY;
+    if (ready) {
+        file = std::move(it->second.file);
+    }
+    EraseEntry(it);
+
+    // entries far behind the consumer were skipped by the application, release their window slots
+    std::erase_if(staged, [&](const auto &item) {
+        if (item.second.seq + window >= seq) {
+            return false;
+        }
+        if (item.second.state == EntryState::READY && item.second.file.buffer != nullptr) {
+            stagedBytes -= item.second.file.size;
+        }
+        return true;
+    });
+    Pump();
+    return ready;
+}
+
+void PrefetchHint::Invalidate(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = staged.find(path);
+    if (it == staged.end()) {
+        return;
+    }
+    EraseEntry(it);
+    cv.notify_all();
+    Pump();
+}
+
+void PrefetchHint::InvalidateTree(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string prefix = path.ends_with('/') ? path : path + '/';
+    for (auto it = staged.begin(); it != staged.end();) {
+        auto next = std::next(it);
+        if (it->first == path || it->first.starts_with(prefix)) {
+            EraseEntry(it);
+        }
+        it = next;
+    }
+    cv.notify_all();
+    Pump();
+}
+
+void PrefetchHint::EraseEntry(std::unordered_map<std::string, Entry>::iterator it)
+{
+    if (it->second.state == EntryState::READY && it->second.file.buffer != nullptr) {
+        stagedBytes -= it->second.file.size;
+    }
+    staged.erase(it);
+}
+
+/*
+ * Loads in flight are not charged against the memory limit since their size is unknown, so staged content may
+ * exceed it by at most window * READ_BIGFILE_SIZE.
+ */
+void PrefetchHint::Pump()
+{
+    ThreadPool *pool = GetPrefetchThreadPool();
+    if (pool == nullptr) {
+        return;
+    }
+    while (!pending.empty() && staged.size() < window && stagedBytes < memoryLimit) {
+        auto [seq, path] = std::move(pending.front());
+        pending.pop_front();
+        // a path hinted twice is loaded once, the later open goes to the server
+        if (staged.contains(path)) {
+            continue;
+        }
+        staged.emplace(path, Entry{seq, EntryState::LOADING, PrefetchedFile{}});
+        if (pool->Submit(ThreadTask{"prefetch", [this, path, seq]() { Load(path, seq); }}) != 0) {
+            staged.erase(path);
+            break;
+        }
+    }
+}
+
+void PrefetchHint::Load(const std::string &path, uint64_t seq)
+{
+    PrefetchedFile file;
+    int errorCode = PROGRAM_ERROR;
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (conn) {
+        errorCode = conn->Open(path.c_str(), file.inodeId, file.size, file.nodeId, &file.stbuf);
+#ifdef ZK_INIT
+        int cnt = 0;
+        while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+            ++cnt;
+            sleep(SLEEPTIME);
+            conn = router->TryToUpdateWorkerConn(conn);
+            errorCode = conn->Open(path.c_str(), file.inodeId, file.size, file.nodeId, &file.stbuf);
+        }
+#endif
+        // the hint is dropped, but the shard table the server replied is still worth taking
+        if (errorCode == OBSOLETE_SHARD) {
+            router->ApplyObsoleteShardTable(conn);
+        }
+    }
+
+    if (errorCode == SUCCESS && file.size > 0 && file.size < READ_BIGFILE_SIZE) {
+        size_t alignedSize = (file.size + PREFETCH_BUFFER_ALIGN - 1) / PREFETCH_BUFFER_ALIGN * PREFETCH_BUFFER_ALIGN;
+        // aligned so that the buffer also serves O_DIRECT opens
+        std::shared_ptr<char> buffer((char *)aligned_alloc(PREFETCH_BUFFER_ALIGN, alignedSize), free);
+        if (buffer == nullptr) {
+            errorCode = PROGRAM_ERROR;
+        } else {
+            OpenInstance openInstance;
+            openInstance.inodeId = file.inodeId;
+            openInstance.originalSize = file.size;
+            openInstance.currentSize = file.size;
+            openInstance.nodeId = file.nodeId;
+            openInstance.path = path;
+            openInstance.oflags = O_RDONLY;
+            openInstance.readBuffer = buffer;
+            openInstance.readBufferSize = file.size;
+            if (InnerFalconReadSmallFiles(&openInstance) == 0) {
+                file.nodeId = openInstance.nodeId;
+                file.nodeFail = openInstance.nodeFail;
+                file.buffer = buffer;
+            } else {
+                errorCode = PROGRAM_ERROR;
+            }
+        }
+    }
+    if (errorCode != SUCCESS) {
+        FALCON_LOG(LOG_WARNING) << "prefetch failed for path: " << path << ", error code: " << errorCode;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = staged.find(path);
+    if (it == staged.end() || it->second.seq != seq) {
+        return;
+    }
+    if (errorCode == SUCCESS) {
+        it->second.state = EntryState::READY;
+        it->second.file = std::move(file);
+        if (it->second.file.buffer != nullptr) {
+            stagedBytes += it->second.file.size;
+        }
+    } else {
+        // keep the failed entry until it is taken, the open then goes to the server and reports the error
+        it->second.state = EntryState::FAILED;
+    }
+    cv.notify_all();
+    Pump();
+}
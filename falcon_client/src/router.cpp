@@ -4,11 +4,13 @@
 
 #include "router.h"
 
+#include <algorithm>
 #include <format>
 #include <ranges>
 
 #include "cm/falcon_cm.h"
 #include "log/logging.h"
+#include "remote_connection_utils/shard_table_epoch.h"
 #include "utils.h"
 
 Router::Router(const ServerIdentifier &coordinator)
@@ -17,6 +19,17 @@ Router::Router(const ServerIdentifier &coordinator)
     FetchShardTable(coordinatorConn);
 }
 
+void Router::PublishRoutingTable(std::unique_ptr<RoutingTable> table)
+{
+    for (const auto &conn : table->connections) {
+        if (conn != nullptr) {
+            conn->SetShardTableEpoch(table->epoch);
+        }
+    }
+    routingTable.store(table.get(), std::memory_order_release);
+    publishedRoutingTables.push_back(std::move(table));
+}
+
 int Router::FetchShardTable(std::shared_ptr<Connection> conn)
 {
     // Init shard table
@@ -32,8 +45,9 @@ int Router::FetchShardTable(std::shared_ptr<Connection> conn)
 
     std::unique_lock<std::shared_mutex> lock(mapMtx);
     auto tmpRouteMap = routeMap;
-    shardTable.clear();
     routeMap.clear();
+    auto table = std::make_unique<RoutingTable>();
+    uint64_t epoch = SHARD_TABLE_EPOCH_INIT;
     for (const auto i : std::views::iota(0, shardCount)) {
         const int shardMinValue = StringToInt32(response->data()->Get(i * col + 0)->c_str());
         const int shardMaxValue = StringToInt32(response->data()->Get(i * col + 1)->c_str());
@@ -48,24 +62,81 @@ int Router::FetchShardTable(std::shared_ptr<Connection> conn)
         }
 
         if (lastShardMaxValue == INT32_MIN && shardMinValue != INT32_MIN) {
-            shardTable.emplace(shardMinValue - 1, ServerIdentifier("", 0, -1));
+            table->rangePoints.push_back(shardMinValue - 1);
+            table->connections.push_back(nullptr);
         }
 
-        shardTable.emplace(shardMaxValue, server);
         if (!tmpRouteMap.empty() && tmpRouteMap.contains(server)) {
             routeMap.try_emplace(server, tmpRouteMap[server]);
         } else {
             routeMap.try_emplace(server, std::make_shared<Connection>(server));
         }
+        table->rangePoints.push_back(shardMaxValue);
+        table->connections.push_back(routeMap[server]);
+        epoch = ShardTableEpochAddRow(epoch, shardMaxValue, server.id);
         lastShardMaxValue = shardMaxValue;
     }
 
     if (lastShardMaxValue != INT32_MAX) {
         throw std::runtime_error("shard table is corrupt");
     }
+    table->epoch = ShardTableEpochFinish(epoch);
+    PublishRoutingTable(std::move(table));
     return 0;
 }
 
+int Router::ApplyObsoleteShardTable(std::shared_ptr<Connection> conn)
+{
+    Connection::ShardTable replied;
+    if (!conn->TakeObsoleteShardTable(replied)) {
+        return 0;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mapMtx);
+        const RoutingTable *current = routingTable.load(std::memory_order_acquire);
+        if (current != nullptr && current->epoch == replied.epoch) {
+            return 0;
+        }
+        std::unordered_map<int, std::shared_ptr<Connection>> serverConns;
+        for (const auto &[server, serverConn] : routeMap) {
+            serverConns.emplace(server.id, serverConn);
+        }
+
+        // only the servers are replied by id, the addresses of known ones are reused
+        auto table = std::make_unique<RoutingTable>();
+        table->epoch = replied.epoch;
+        bool complete = !replied.rangePoints.empty() && replied.rangePoints.back() == INT32_MAX;
+        for (size_t i = 0; complete && i < replied.rangePoints.size(); ++i) {
+            // the first shard starts at 0, as rows of falcon_renew_shard_table do
+            if (i == 0) {
+                table->rangePoints.push_back(-1);
+                table->connections.push_back(nullptr);
+            }
+            auto it = serverConns.find(replied.serverIds[i]);
+            if (it == serverConns.end()) {
+                complete = false;
+                break;
+            }
+            table->rangePoints.push_back(replied.rangePoints[i]);
+            table->connections.push_back(it->second);
+        }
+        if (complete) {
+            PublishRoutingTable(std::move(table));
+            return 0;
+        }
+    }
+
+    // a server joined, its address has to come from the coordinator
+    std::shared_ptr<Connection> coordinatorConn = GetCoordinatorConn();
+    int ret = FetchShardTable(coordinatorConn);
+    if (ret == SERVER_FAULT) {
+        coordinatorConn = TryToUpdateCNConn(coordinatorConn);
+        ret = FetchShardTable(coordinatorConn);
+    }
+    return ret;
+}
+
 std::shared_ptr<Connection> Router::GetCoordinatorConn()
 {
     std::shared_lock<std::shared_mutex> lock(coordinatorMtx);
@@ -92,16 +163,20 @@ std::shared_ptr<Connection> Router::GetWorkerConnByPath(std::string_view path)
     }
 
     // Find shard
-    std::shared_lock<std::shared_mutex> lock(mapMtx);
+    const RoutingTable *table = routingTable.load(std::memory_order_acquire);
+    if (table == nullptr) {
+        throw std::runtime_error("shard table is corrupt.");
+    }
     uint16_t partId = HashPartId(filename.data());
-    auto shardIt = shardTable.lower_bound(HashInt8(partId));
-    if (shardIt == shardTable.end()) {
+    int32_t hashValue = static_cast<int32_t>(HashInt8(partId));
+    auto shardIt = std::lower_bound(table->rangePoints.begin(), table->rangePoints.end(), hashValue);
+    if (shardIt == table->rangePoints.end()) {
         throw std::runtime_error("shard table is corrupt.");
     }
 
     // Return connection
-    if (auto connIt = routeMap.find(shardIt->second); connIt != routeMap.end()) {
-        return connIt->second;
+    if (auto conn = table->connections[shardIt - table->rangePoints.begin()]; conn != nullptr) {
+        return conn;
     }
 
     throw std::runtime_error("no such server.");
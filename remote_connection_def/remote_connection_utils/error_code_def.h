@@ -37,6 +37,7 @@
     FALCON_ERROR_CODE(GET_ALL_WORKER_CONN_FAILED) \
     FALCON_ERROR_CODE(IO_ERROR)                   \
     FALCON_ERROR_CODE(READDIR_RENEW_CONN)         \
+    FALCON_ERROR_CODE(NAME_TOO_LONG)              \
     FALCON_ERROR_CODE(LAST_FALCON_ERROR_CODE)
 
 #undef FALCON_ERROR_CODE
@@ -0,0 +1,41 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef FALCON_REMOTE_CONNECTION_DEF_SHARD_TABLE_EPOCH_H
+#define FALCON_REMOTE_CONNECTION_DEF_SHARD_TABLE_EPOCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Epoch of a shard table, a hash of its (range_point, server_id) rows in range_point order. Servers and clients
+ * compute it alike, so a request tagged with the epoch of the table it was routed by can be checked against the
+ * table of the server. 0 is never an epoch, it stands for an unknown one.
+ */
+#define SHARD_TABLE_EPOCH_UNKNOWN 0
+#define SHARD_TABLE_EPOCH_INIT UINT64_C(0xcbf29ce484222325)
+
+static inline uint64_t ShardTableEpochAddRow(uint64_t epoch, int32_t rangePoint, int32_t serverId)
+{
+    uint64_t row = ((uint64_t)(uint32_t)rangePoint << 32) | (uint32_t)serverId;
+    for (int i = 0; i < 8; ++i) {
+        epoch ^= (row >> (i * 8)) & 0xff;
+        epoch *= UINT64_C(0x100000001b3);
+    }
+    return epoch;
+}
+
+static inline uint64_t ShardTableEpochFinish(uint64_t epoch)
+{
+    return epoch == SHARD_TABLE_EPOCH_UNKNOWN ? 1 : epoch;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "connection_pool/adaptive_batch_controller.h"
+
+using std::chrono::microseconds;
+using Clock = AdaptiveBatchController::Clock;
+
+static const Clock::time_point START_TIME = Clock::now();
+
+// feeds 100 jobs over 1ms and one batch taking 1025us, i.e. an arrival rate of 0.2 * 0.1 jobs/us after the first
+// sample and an expected 20.5 jobs per batch
+static void Warm(AdaptiveBatchController &controller)
+{
+    controller.RecordExecution(10, microseconds(1025));
+    controller.RecordArrival(100);
+}
+
+TEST(AdaptiveBatchControllerUT, SendsImmediatelyWithoutHistory)
+{
+    AdaptiveBatchController controller(64, microseconds(500), START_TIME);
+    size_t targetSize = 0;
+    EXPECT_EQ(controller.GetBatchWait(1, 0, 0, targetSize, START_TIME + microseconds(5000)), microseconds(0));
+    EXPECT_EQ(targetSize, 1u);
+}
+
+TEST(AdaptiveBatchControllerUT, WaitsUntilTargetBoundedByMaxWait)
+{
+    AdaptiveBatchController controller(64, microseconds(10000), START_TIME);
+    Warm(controller);
+    size_t targetSize = 0;
+    // (20 - 5) jobs at 0.02 jobs/us
+    auto wait = controller.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(1000));
+    EXPECT_EQ(targetSize, 20u);
+    EXPECT_NEAR(wait.count(), 750, 1);
+
+    AdaptiveBatchController bounded(64, microseconds(500), START_TIME);
+    Warm(bounded);
+    EXPECT_EQ(bounded.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(1000)), microseconds(500));
+    EXPECT_EQ(targetSize, 20u);
+}
+
+TEST(AdaptiveBatchControllerUT, SendsImmediatelyWhenOthersCanRun)
+{
+    AdaptiveBatchController controller(64, microseconds(10000), START_TIME);
+    Warm(controller);
+    size_t targetSize = 0;
+    auto now = START_TIME + microseconds(1000);
+    // an idle backend is left
+    EXPECT_EQ(controller.GetBatchWait(5, 1, 0, targetSize, now), microseconds(0));
+    EXPECT_EQ(targetSize, 20u);
+    // other tasks are queued
+    EXPECT_EQ(controller.GetBatchWait(5, 0, 1, targetSize, now), microseconds(0));
+    // the batch already reached its target
+    EXPECT_EQ(controller.GetBatchWait(20, 0, 0, targetSize, now), microseconds(0));
+    EXPECT_EQ(controller.GetBatchWait(30, 0, 0, targetSize, now), microseconds(0));
+}
+
+TEST(AdaptiveBatchControllerUT, ZeroMaxWaitNeverWaits)
+{
+    AdaptiveBatchController controller(64, microseconds(0), START_TIME);
+    Warm(controller);
+    size_t targetSize = 0;
+    EXPECT_EQ(controller.GetBatchWait(1, 0, 0, targetSize, START_TIME + microseconds(1000)), microseconds(0));
+    EXPECT_EQ(targetSize, 20u);
+}
+
+TEST(AdaptiveBatchControllerUT, TargetClampedToMaxBatchSize)
+{
+    AdaptiveBatchController controller(8, microseconds(10000), START_TIME);
+    Warm(controller);
+    size_t targetSize = 0;
+    // (8 - 2) jobs at 0.02 jobs/us
+    auto wait = controller.GetBatchWait(2, 0, 0, targetSize, START_TIME + microseconds(1000));
+    EXPECT_EQ(targetSize, 8u);
+    EXPECT_NEAR(wait.count(), 300, 1);
+}
+
+TEST(AdaptiveBatchControllerUT, ArrivalRateSampledOncePerInterval)
+{
+    AdaptiveBatchController controller(64, microseconds(10000), START_TIME);
+    Warm(controller);
+    size_t targetSize = 0;
+    // too early for a sample, the rate is still unknown
+    EXPECT_EQ(controller.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(500)), microseconds(0));
+    EXPECT_EQ(targetSize, 1u);
+
+    EXPECT_GT(controller.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(1000)), microseconds(0));
+    EXPECT_EQ(targetSize, 20u);
+    // arrivals within the interval do not change the rate before the next sample
+    controller.RecordArrival(1000);
+    controller.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(1500));
+    EXPECT_EQ(targetSize, 20u);
+}
+
+TEST(AdaptiveBatchControllerUT, TargetFollowsLoadDown)
+{
+    AdaptiveBatchController controller(64, microseconds(10000), START_TIME);
+    Warm(controller);
+    size_t targetSize = 0;
+    controller.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(1000));
+    EXPECT_EQ(targetSize, 20u);
+
+    // each idle sample decays the rate by 0.8: 16.4, 13.12, 10.5, ... jobs per batch
+    size_t previous = targetSize;
+    for (int i = 2; i <= 40; ++i) {
+        controller.GetBatchWait(5, 0, 0, targetSize, START_TIME + microseconds(1000 * i));
+        EXPECT_LE(targetSize, previous);
+        previous = targetSize;
+    }
+    EXPECT_EQ(targetSize, 1u);
+    EXPECT_EQ(controller.GetBatchWait(1, 0, 0, targetSize, START_TIME + microseconds(41000)), microseconds(0));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "connection_pool/mpmc_queue.h"
+
+TEST(MpmcQueueUT, CapacityRoundedUp)
+{
+    for (auto [capacity, expected] : std::vector<std::pair<size_t, size_t>>{{0, 2}, {1, 2}, {3, 4}, {8, 8}, {9, 16}}) {
+        MpmcQueue<int> queue(capacity);
+        size_t pushed = 0;
+        while (queue.TryPush((int)pushed)) {
+            ++pushed;
+        }
+        EXPECT_EQ(pushed, expected) << "capacity " << capacity;
+    }
+}
+
+TEST(MpmcQueueUT, FullAndEmptyAcrossWraparound)
+{
+    constexpr int capacity = 4;
+    MpmcQueue<int> queue(capacity);
+    int value;
+    EXPECT_FALSE(queue.TryPop(value));
+
+    // every round reuses the cells with sequence numbers one lap further
+    int next = 0;
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < capacity; ++i) {
+            EXPECT_TRUE(queue.TryPush(next + i));
+        }
+        EXPECT_FALSE(queue.TryPush(-1));
+        EXPECT_EQ(queue.SizeApprox(), (size_t)capacity);
+        for (int i = 0; i < capacity; ++i) {
+            ASSERT_TRUE(queue.TryPop(value));
+            EXPECT_EQ(value, next + i);
+        }
+        EXPECT_FALSE(queue.TryPop(value));
+        EXPECT_EQ(queue.SizeApprox(), 0u);
+        next += capacity;
+    }
+
+    // interleaved push and pop keep the queue partly filled while the positions wrap
+    EXPECT_TRUE(queue.TryPush(next));
+    for (int i = 1; i < 1000; ++i) {
+        EXPECT_TRUE(queue.TryPush(next + i));
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, next + i - 1);
+    }
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, next + 999);
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(MpmcQueueUT, ConcurrentNoLossNoDuplication)
+{
+    constexpr uint64_t producerCount = 4;
+    constexpr uint64_t consumerCount = 4;
+    constexpr uint64_t itemsPerProducer = 200000;
+    // small enough for producers to find it full and consumers to find it empty all the time
+    MpmcQueue<uint64_t> queue(64);
+
+    std::atomic<bool> start{false};
+    std::atomic<uint64_t> consumed{0};
+    std::vector<std::vector<uint64_t>> received(consumerCount);
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producerCount; ++p) {
+        threads.emplace_back([&, p]() {
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            for (uint64_t i = 0; i < itemsPerProducer; ++i) {
+                while (!queue.TryPush(p << 32 | i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (uint64_t c = 0; c < consumerCount; ++c) {
+        threads.emplace_back([&, c]() {
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            uint64_t value;
+            while (consumed.load() < producerCount * itemsPerProducer) {
+                if (queue.TryPop(value)) {
+                    received[c].push_back(value);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    start.store(true);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    uint64_t value;
+    EXPECT_FALSE(queue.TryPop(value));
+    std::vector<std::vector<uint8_t>> seen(producerCount, std::vector<uint8_t>(itemsPerProducer, 0));
+    for (auto &values : received) {
+        // a single consumer sees the items of one producer in the order they were pushed
+        std::vector<int64_t> last(producerCount, -1);
+        for (uint64_t v : values) {
+            uint64_t p = v >> 32;
+            uint64_t i = v & 0xFFFFFFFF;
+            ASSERT_LT(p, producerCount);
+            ASSERT_LT(i, itemsPerProducer);
+            EXPECT_GT((int64_t)i, last[p]);
+            last[p] = (int64_t)i;
+            ++seen[p][i];
+        }
+    }
+    for (uint64_t p = 0; p < producerCount; ++p) {
+        for (uint64_t i = 0; i < itemsPerProducer; ++i) {
+            ASSERT_EQ(seen[p][i], 1) << "producer " << p << " item " << i;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
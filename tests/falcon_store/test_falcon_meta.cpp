@@ -0,0 +1,244 @@
+#include "test_falcon_meta.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include "attr_cache.h"
+#include "connection/node.h"
+#include "disk_cache/disk_cache.h"
+
+std::shared_ptr<FalconConfig> FalconStoreUT::config = nullptr;
+std::shared_ptr<OpenInstance> FalconStoreUT::openInstance = nullptr;
+char *FalconStoreUT::writeBuf = nullptr;
+size_t FalconStoreUT::size = 0;
+char *FalconStoreUT::readBuf = nullptr;
+size_t FalconStoreUT::readSize = 0;
+char *FalconStoreUT::readBuf2 = nullptr;
+
+// more directories than a transaction used to be able to track for the directory path hash
+static constexpr int LARGE_TREE_DIRECTORY_NUM = 5000;
+
+static std::vector<std::string> LargeTreePaths(const std::string &root)
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < LARGE_TREE_DIRECTORY_NUM; ++i) {
+        paths.push_back(root + "/d" + std::to_string(i / 100) + "/d" + std::to_string(i));
+    }
+    return paths;
+}
+
+TEST_F(FalconMetaUT, RmDirRecursiveLargeTree)
+{
+    std::string root = "/meta_ut_rmdir_large";
+    std::vector<std::string> paths = LargeTreePaths(root);
+    ASSERT_EQ(FalconMkdirRecursive(paths), SUCCESS);
+    for (int i = 0; i < LARGE_TREE_DIRECTORY_NUM; i += 100) {
+        uint64_t fd = 0;
+        struct stat stbuf{};
+        ASSERT_EQ(FalconCreate(paths[i] + "/file", fd, O_CREAT | O_WRONLY, &stbuf), SUCCESS);
+        ASSERT_EQ(FalconClose(paths[i] + "/file", fd), SUCCESS);
+    }
+
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+    struct stat stbuf{};
+    EXPECT_NE(FalconGetStat(root, &stbuf), SUCCESS);
+    EXPECT_NE(FalconGetStat(paths.back(), &stbuf), SUCCESS);
+
+    // the tree can be created again under the same names
+    EXPECT_EQ(FalconMkdirRecursive(paths), SUCCESS);
+    EXPECT_EQ(FalconGetStat(paths.back(), &stbuf), SUCCESS);
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+}
+
+TEST_F(FalconMetaUT, RmDirRecursiveDeletesData)
+{
+    std::string root = "/meta_ut_rmdir_data";
+    ASSERT_EQ(FalconMkdirRecursive({root + "/a", root + "/b/c"}), SUCCESS);
+    std::vector<uint64_t> localInodes;
+    std::string inodeList;
+    for (const std::string &dir : {root, root + "/a", root + "/b/c"}) {
+        std::string path = dir + "/file";
+        uint64_t fd = 0;
+        struct stat stbuf{};
+        ASSERT_EQ(FalconCreate(path, fd, O_CREAT | O_WRONLY, &stbuf), SUCCESS);
+        ASSERT_EQ(FalconWrite(fd, path, "data", 4, 0), 0);
+        ASSERT_EQ(FalconClose(path, fd), SUCCESS);
+        std::optional<int32_t> nodeId;
+        ASSERT_EQ(FalconGetStat(path, &stbuf, &nodeId), SUCCESS);
+        inodeList += (inodeList.empty() ? "" : ",") + std::to_string(stbuf.st_ino);
+        if (nodeId.has_value() && StoreNode::GetInstance()->IsLocal(*nodeId)) {
+            EXPECT_TRUE(DiskCache::GetInstance().Find(stbuf.st_ino, false));
+            localInodes.push_back(stbuf.st_ino);
+        }
+    }
+
+    ASSERT_EQ(FalconRmDirRecursive(root), SUCCESS);
+    // the workers queued the removed files, the client deletes their data in background
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto dataLeft = [&]() {
+        return std::ranges::any_of(localInodes, [](uint64_t ino) { return DiskCache::GetInstance().Find(ino, false); });
+    };
+    while (dataLeft() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    for (uint64_t ino : localInodes) {
+        EXPECT_FALSE(DiskCache::GetInstance().Find(ino, false)) << "data of inode " << ino << " left";
+    }
+
+    // and removed the queue entries once the data was gone
+    std::unordered_map<std::string, std::shared_ptr<Connection>> workerInfo;
+    ASSERT_EQ(router->GetAllWorkerConnection(workerInfo), SUCCESS);
+    std::string command = "select count(*) from falcon_data_delete_queue where inodeid in (" + inodeList + ");";
+    for (auto &worker : workerInfo) {
+        std::string queued;
+        do {
+            Connection::PlainCommandResult res;
+            ASSERT_EQ(worker.second->PlainCommand(command.c_str(), res), SUCCESS);
+            queued = res.response->data()->Get(0)->str();
+            if (queued != "0") {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        } while (queued != "0" && std::chrono::steady_clock::now() < deadline);
+        EXPECT_EQ(queued, "0") << "entries left on " << worker.first;
+    }
+}
+
+TEST_F(FalconMetaUT, RmDirNonEmptyFails)
+{
+    std::string root = "/meta_ut_rmdir_nonempty";
+    ASSERT_EQ(FalconMkdirRecursive({root + "/with_file", root + "/with_dir/sub"}), SUCCESS);
+    uint64_t fd = 0;
+    struct stat stbuf{};
+    ASSERT_EQ(FalconCreate(root + "/with_file/file", fd, O_CREAT | O_WRONLY, &stbuf), SUCCESS);
+    ASSERT_EQ(FalconClose(root + "/with_file/file", fd), SUCCESS);
+
+    // only rmdir -r removes what is below
+    EXPECT_NE(FalconRmDir(root + "/with_file"), SUCCESS);
+    EXPECT_NE(FalconRmDir(root + "/with_dir"), SUCCESS);
+    EXPECT_NE(FalconRmDir(root), SUCCESS);
+    EXPECT_EQ(FalconGetStat(root + "/with_file/file", &stbuf), SUCCESS);
+    EXPECT_EQ(FalconGetStat(root + "/with_dir/sub", &stbuf), SUCCESS);
+
+    EXPECT_EQ(FalconRmDir(root + "/with_dir/sub"), SUCCESS);
+    EXPECT_EQ(FalconRmDir(root + "/with_dir"), SUCCESS);
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+}
+
+TEST_F(FalconMetaUT, MkdirRecursiveDeepBatch)
+{
+    // fits in one batch, but with the missing ancestors the CN creates 5000 directories in one transaction
+    std::string root = "/meta_ut_mkdir_deep";
+    std::vector<std::string> paths;
+    for (int i = 0; i < LARGE_TREE_DIRECTORY_NUM / 5; ++i) {
+        std::string path = root + "/d" + std::to_string(i);
+        paths.push_back(path + "/a/b/c/d");
+    }
+    ASSERT_EQ(FalconMkdirRecursive(paths), SUCCESS);
+    struct stat stbuf{};
+    for (const std::string &path : paths) {
+        EXPECT_EQ(FalconGetStat(path, &stbuf), SUCCESS);
+    }
+    // existing directories count as success
+    EXPECT_EQ(FalconMkdirRecursive(paths), SUCCESS);
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+}
+
+TEST_F(FalconMetaUT, OverlongNameRejected)
+{
+    std::string root = "/meta_ut_long_name";
+    ASSERT_EQ(FalconMkdir(root), SUCCESS);
+    // NAME_MAX still fits
+    std::string longest(255, 'n');
+    EXPECT_EQ(FalconMkdir(root + "/" + longest), SUCCESS);
+    EXPECT_EQ(FalconMkdir(root + "/" + longest + "/sub"), SUCCESS);
+
+    std::string overlong(256, 'n');
+    EXPECT_EQ(FalconMkdir(root + "/" + overlong), NAME_TOO_LONG);
+    EXPECT_EQ(FalconMkdir(root + "/" + overlong + "/sub"), NAME_TOO_LONG);
+    struct stat stbuf{};
+    EXPECT_EQ(FalconGetStat(root + "/" + overlong, &stbuf), NAME_TOO_LONG);
+
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+}
+
+TEST_F(FalconMetaUT, RenameDirectoryNotReplicatedYet)
+{
+    // renaming right after mkdir races the directory log, the owning worker may only know the inode row yet
+    std::string root = "/meta_ut_rename_fresh";
+    ASSERT_EQ(FalconMkdir(root), SUCCESS);
+    for (int i = 0; i < 200; ++i) {
+        std::string src = root + "/src" + std::to_string(i);
+        std::string dst = root + "/dst" + std::to_string(i);
+        ASSERT_EQ(FalconMkdir(src), SUCCESS);
+        ASSERT_EQ(FalconRename(src, dst), SUCCESS);
+
+        // the directory moved everywhere, not only its inode row
+        struct stat stbuf{};
+        EXPECT_NE(FalconGetStat(src, &stbuf), SUCCESS);
+        ASSERT_EQ(FalconGetStat(dst, &stbuf), SUCCESS);
+        EXPECT_TRUE(S_ISDIR(stbuf.st_mode));
+        uint64_t fd = 0;
+        ASSERT_EQ(FalconCreate(dst + "/file", fd, O_CREAT | O_WRONLY, &stbuf), SUCCESS);
+        ASSERT_EQ(FalconClose(dst + "/file", fd), SUCCESS);
+        EXPECT_NE(FalconMkdir(src + "/sub"), SUCCESS);
+    }
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+}
+
+TEST_F(FalconMetaUT, ReopenSeesWriteOfOtherClient)
+{
+    std::string root = "/meta_ut_reopen";
+    std::string path = root + "/file";
+    ASSERT_EQ(FalconMkdir(root), SUCCESS);
+    uint64_t fd = 0;
+    struct stat stbuf{};
+    ASSERT_EQ(FalconCreate(path, fd, O_CREAT | O_WRONLY, &stbuf), SUCCESS);
+    ASSERT_EQ(FalconWrite(fd, path, "old", 3, 0), 0);
+    ASSERT_EQ(FalconClose(path, fd), SUCCESS);
+
+    // the reader looked the file up before the writer wrote it
+    std::optional<int32_t> nodeId;
+    ASSERT_EQ(FalconGetStat(path, &stbuf, &nodeId), SUCCESS);
+    ASSERT_TRUE(nodeId.has_value());
+    LookupReply staleLookup{stbuf, *nodeId};
+    ASSERT_EQ(staleLookup.stbuf.st_size, 3);
+
+    std::string content = "written by another client";
+    ASSERT_EQ(FalconOpen(path, O_WRONLY, fd, &stbuf), SUCCESS);
+    ASSERT_EQ(FalconWrite(fd, path, content.data(), content.size(), 0), 0);
+    ASSERT_EQ(FalconClose(path, fd), SUCCESS);
+
+    // the reader still holds the attributes of its listing, a reopen asks the server anyway
+    AttrCache::GetInstance().SetTimeout(60000);
+    AttrCache::GetInstance().Insert(path, staleLookup.stbuf);
+    ASSERT_EQ(FalconOpen(path, O_RDONLY, fd, &stbuf), SUCCESS);
+    EXPECT_EQ(stbuf.st_size, (off_t)content.size());
+    std::string buffer(content.size(), '\0');
+    EXPECT_EQ(FalconRead(path, fd, buffer.data(), buffer.size(), 0), (int)content.size());
+    EXPECT_EQ(buffer, content);
+    EXPECT_EQ(FalconClose(path, fd), SUCCESS);
+    AttrCache::GetInstance().InvalidateTree(root);
+    AttrCache::GetInstance().SetTimeout(0);
+
+    // a lookup reply never serves an open for writing
+    ASSERT_EQ(FalconOpen(path, O_RDWR, fd, &stbuf, &staleLookup), SUCCESS);
+    EXPECT_EQ(stbuf.st_size, (off_t)content.size());
+    EXPECT_EQ(FalconClose(path, fd), SUCCESS);
+    ASSERT_EQ(FalconOpen(path, O_RDONLY | O_TRUNC, fd, &stbuf, &staleLookup), SUCCESS);
+    EXPECT_EQ(stbuf.st_size, (off_t)content.size());
+    EXPECT_EQ(FalconClose(path, fd), SUCCESS);
+
+    EXPECT_EQ(FalconRmDirRecursive(root), SUCCESS);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
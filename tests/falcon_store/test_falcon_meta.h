@@ -0,0 +1,27 @@
+#pragma once
+
+#include <print>
+#include <string>
+
+#include "falcon_meta.h"
+#include "test_falcon_store.h"
+
+/* the FalconStoreUT environment, plus a client of the metadata cluster */
+class FalconMetaUT : public FalconStoreUT {
+  public:
+    static void SetUpTestSuite()
+    {
+        FalconStoreUT::SetUpTestSuite();
+        std::string serverIp = config->GetString(FalconPropertyKey::FALCON_SERVER_IP);
+        std::string serverPort = config->GetString(FalconPropertyKey::FALCON_SERVER_PORT);
+        if (FalconInit(serverIp, std::stoi(serverPort)) != SUCCESS) {
+            std::println(std::cerr, "Falcon cluster init failed");
+            exit(1);
+        }
+    }
+    static void TearDownTestSuite()
+    {
+        FalconDestroy();
+        FalconStoreUT::TearDownTestSuite();
+    }
+};
@@ -0,0 +1,134 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "fuse_inode_table.h"
+
+static constexpr uint64_t ROOT = FuseInodeTable::ROOT_INO;
+
+static std::string PathOf(uint64_t ino)
+{
+    std::string path;
+    return FuseInodeTable::GetInstance().GetPath(ino, path) ? path : "<unknown>";
+}
+
+TEST(FuseInodeTableUT, AcquireSharesNodeOfName)
+{
+    auto &table = FuseInodeTable::GetInstance();
+    EXPECT_EQ(PathOf(ROOT), "/");
+    uint64_t dir = table.Acquire(ROOT, "share");
+    ASSERT_NE(dir, 0u);
+    EXPECT_EQ(table.Acquire(ROOT, "share"), dir);
+    uint64_t file = table.Acquire(dir, "file");
+    EXPECT_EQ(PathOf(file), "/share/file");
+    EXPECT_EQ(table.Acquire(12345678, "orphan"), 0u);
+
+    // two lookups of dir, one forget keeps it
+    table.Forget(dir, 1);
+    EXPECT_EQ(PathOf(dir), "/share");
+    table.Forget(file, 1);
+    EXPECT_EQ(PathOf(file), "<unknown>");
+    table.Forget(dir, 1);
+    EXPECT_EQ(PathOf(dir), "<unknown>");
+}
+
+TEST(FuseInodeTableUT, ForgottenParentKeptForReferencedChildren)
+{
+    auto &table = FuseInodeTable::GetInstance();
+    uint64_t dir = table.Acquire(ROOT, "forget");
+    uint64_t sub = table.Acquire(dir, "sub");
+    uint64_t file = table.Acquire(sub, "file");
+
+    // the kernel dropped its references to the directories first
+    table.Forget(dir, 1);
+    table.Forget(sub, 1);
+    EXPECT_EQ(PathOf(file), "/forget/sub/file");
+    EXPECT_EQ(PathOf(sub), "/forget/sub");
+
+    // a new lookup finds the kept nodes again
+    EXPECT_EQ(table.Acquire(ROOT, "forget"), dir);
+    table.Forget(dir, 1);
+
+    // releasing the last child releases the unreferenced ancestors
+    table.Forget(file, 1);
+    EXPECT_EQ(PathOf(file), "<unknown>");
+    EXPECT_EQ(PathOf(sub), "<unknown>");
+    EXPECT_EQ(PathOf(dir), "<unknown>");
+    EXPECT_NE(table.Acquire(ROOT, "forget"), dir);
+}
+
+TEST(FuseInodeTableUT, RenamedDirectoryMovesDescendants)
+{
+    auto &table = FuseInodeTable::GetInstance();
+    uint64_t src = table.Acquire(ROOT, "rename_src");
+    uint64_t dst = table.Acquire(ROOT, "rename_dst");
+    uint64_t dir = table.Acquire(src, "dir");
+    uint64_t sub = table.Acquire(dir, "sub");
+    uint64_t file = table.Acquire(sub, "file");
+
+    table.Rename(src, "dir", dst, "moved");
+    EXPECT_EQ(PathOf(dir), "/rename_dst/moved");
+    EXPECT_EQ(PathOf(file), "/rename_dst/moved/sub/file");
+    EXPECT_EQ(table.Acquire(dst, "moved"), dir);
+    table.Forget(dir, 1);
+    uint64_t fresh = table.Acquire(src, "dir");
+    EXPECT_NE(fresh, dir);
+    table.Forget(fresh, 1);
+
+    // the old parent no longer holds the moved subtree
+    table.Forget(src, 1);
+    EXPECT_EQ(PathOf(src), "<unknown>");
+    EXPECT_EQ(PathOf(file), "/rename_dst/moved/sub/file");
+
+    // renaming over an existing name detaches the replaced node, which keeps its last path
+    uint64_t victim = table.Acquire(dst, "victim");
+    table.Rename(dst, "moved", dst, "victim");
+    EXPECT_EQ(PathOf(file), "/rename_dst/victim/sub/file");
+    EXPECT_EQ(PathOf(victim), "/rename_dst/victim");
+    EXPECT_EQ(table.Acquire(dst, "victim"), dir);
+    table.Forget(dir, 1);
+    table.Forget(victim, 1);
+    EXPECT_EQ(PathOf(victim), "<unknown>");
+    EXPECT_EQ(table.Acquire(dst, "victim"), dir);
+    table.Forget(dir, 1);
+
+    table.Forget(file, 1);
+    table.Forget(sub, 1);
+    table.Forget(dir, 1);
+    table.Forget(dst, 1);
+    EXPECT_EQ(PathOf(dir), "<unknown>");
+    EXPECT_EQ(PathOf(dst), "<unknown>");
+}
+
+TEST(FuseInodeTableUT, RemovedNameLooksUpNewNode)
+{
+    auto &table = FuseInodeTable::GetInstance();
+    uint64_t dir = table.Acquire(ROOT, "remove");
+    uint64_t oldFile = table.Acquire(dir, "file");
+
+    table.Remove(dir, "file");
+    // still open through the old node
+    EXPECT_EQ(PathOf(oldFile), "/remove/file");
+    uint64_t newFile = table.Acquire(dir, "file");
+    EXPECT_NE(newFile, oldFile);
+    EXPECT_EQ(PathOf(newFile), "/remove/file");
+
+    // forgetting the old node leaves the new one reachable by name
+    table.Forget(oldFile, 1);
+    EXPECT_EQ(PathOf(oldFile), "<unknown>");
+    EXPECT_EQ(table.Acquire(dir, "file"), newFile);
+    table.Forget(newFile, 2);
+    EXPECT_EQ(PathOf(newFile), "<unknown>");
+
+    // removing an unknown name changes nothing
+    table.Remove(dir, "missing");
+    EXPECT_EQ(PathOf(dir), "/remove");
+    table.Forget(dir, 1);
+    EXPECT_EQ(PathOf(dir), "<unknown>");
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
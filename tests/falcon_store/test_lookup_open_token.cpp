@@ -0,0 +1,86 @@
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "lookup_open_token.h"
+
+static constexpr pid_t TID = 100;
+static constexpr uint64_t INO = 42;
+static constexpr int32_t NODE_ID = 3;
+
+static LookupReply Reply(off_t size)
+{
+    LookupReply reply;
+    reply.stbuf.st_mode = S_IFREG | 0644;
+    reply.stbuf.st_size = size;
+    reply.nodeId = NODE_ID;
+    return reply;
+}
+
+class LookupOpenTokenUT : public testing::Test {
+  public:
+    void TearDown() override
+    {
+        LookupOpenToken::GetInstance().Drop(TID);
+        LookupOpenToken::GetInstance().Drop(TID + 1);
+    }
+};
+
+TEST_F(LookupOpenTokenUT, TakenOnce)
+{
+    auto &tokens = LookupOpenToken::GetInstance();
+    tokens.Grant(TID, INO, Reply(10));
+    LookupReply reply;
+    ASSERT_TRUE(tokens.Take(TID, INO, reply));
+    EXPECT_EQ(reply.stbuf.st_size, 10);
+    EXPECT_EQ(reply.nodeId, NODE_ID);
+    // a second open of the file asks the server again
+    EXPECT_FALSE(tokens.Take(TID, INO, reply));
+}
+
+TEST_F(LookupOpenTokenUT, OnlyForTheLookingUpThreadAndNode)
+{
+    auto &tokens = LookupOpenToken::GetInstance();
+    LookupReply reply;
+    tokens.Grant(TID, INO, Reply(10));
+    EXPECT_FALSE(tokens.Take(TID + 1, INO, reply));
+    // an open of another node drops the token as well
+    EXPECT_FALSE(tokens.Take(TID, INO + 1, reply));
+    EXPECT_FALSE(tokens.Take(TID, INO, reply));
+
+    // the next lookup of the thread replaces the token
+    tokens.Grant(TID, INO, Reply(10));
+    tokens.Grant(TID, INO + 1, Reply(20));
+    EXPECT_FALSE(tokens.Take(TID, INO, reply));
+    tokens.Grant(TID, INO, Reply(10));
+    tokens.Drop(TID);
+    EXPECT_FALSE(tokens.Take(TID, INO, reply));
+}
+
+TEST_F(LookupOpenTokenUT, RevokedBySetAttr)
+{
+    auto &tokens = LookupOpenToken::GetInstance();
+    LookupReply reply;
+    tokens.Grant(TID, INO, Reply(10));
+    tokens.Grant(TID + 1, INO + 1, Reply(20));
+    tokens.Revoke(INO);
+    EXPECT_FALSE(tokens.Take(TID, INO, reply));
+    EXPECT_TRUE(tokens.Take(TID + 1, INO + 1, reply));
+}
+
+TEST_F(LookupOpenTokenUT, Expires)
+{
+    auto &tokens = LookupOpenToken::GetInstance();
+    LookupReply reply;
+    tokens.Grant(TID, INO, Reply(10));
+    // far beyond the time between the lookup and the open of one open(2), much shorter than the attr timeout
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(tokens.Take(TID, INO, reply));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "negative_cache.h"
+
+static constexpr int SERVER_ID = 3;
+static constexpr uint64_t GENERATION = 7;
+
+class NegativeCacheUT : public testing::Test {
+  public:
+    void SetUp() override { NegativeCache::GetInstance().SetTimeout(60000); }
+    void TearDown() override
+    {
+        NegativeCache::GetInstance().InvalidateTree("/");
+        NegativeCache::GetInstance().SetTimeout(0);
+    }
+};
+
+TEST_F(NegativeCacheUT, HitUntilInvalidated)
+{
+    auto &cache = NegativeCache::GetInstance();
+    EXPECT_FALSE(cache.Lookup("/hit/file", SERVER_ID, GENERATION));
+    cache.Insert("/hit/file", SERVER_ID, GENERATION);
+    cache.Insert("/hit/dir/file", SERVER_ID, GENERATION);
+    EXPECT_TRUE(cache.Lookup("/hit/file", SERVER_ID, GENERATION));
+    EXPECT_TRUE(cache.Lookup("/hit/file", SERVER_ID, GENERATION));
+
+    cache.Invalidate("/hit/file");
+    EXPECT_FALSE(cache.Lookup("/hit/file", SERVER_ID, GENERATION));
+    EXPECT_TRUE(cache.Lookup("/hit/dir/file", SERVER_ID, GENERATION));
+    cache.InvalidateTree("/hit/dir");
+    EXPECT_FALSE(cache.Lookup("/hit/dir/file", SERVER_ID, GENERATION));
+}
+
+TEST_F(NegativeCacheUT, ServerOrGenerationMismatchInvalidates)
+{
+    auto &cache = NegativeCache::GetInstance();
+    // the path moved to another server, e.g. after a shard migration
+    cache.Insert("/mismatch/server", SERVER_ID, GENERATION);
+    EXPECT_FALSE(cache.Lookup("/mismatch/server", SERVER_ID + 1, GENERATION));
+    // the entry is dropped, not only skipped
+    EXPECT_FALSE(cache.Lookup("/mismatch/server", SERVER_ID, GENERATION));
+
+    // the server created something since the miss was reported
+    cache.Insert("/mismatch/generation", SERVER_ID, GENERATION);
+    EXPECT_FALSE(cache.Lookup("/mismatch/generation", SERVER_ID, GENERATION + 1));
+    EXPECT_FALSE(cache.Lookup("/mismatch/generation", SERVER_ID, GENERATION));
+
+    // servers not reporting a generation are never cached
+    cache.Insert("/mismatch/none", SERVER_ID, 0);
+    EXPECT_FALSE(cache.Lookup("/mismatch/none", SERVER_ID, 0));
+}
+
+TEST_F(NegativeCacheUT, EntriesExpire)
+{
+    auto &cache = NegativeCache::GetInstance();
+    cache.SetTimeout(50);
+    cache.Insert("/expire/file", SERVER_ID, GENERATION);
+    EXPECT_TRUE(cache.Lookup("/expire/file", SERVER_ID, GENERATION));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(cache.Lookup("/expire/file", SERVER_ID, GENERATION));
+}
+
+TEST_F(NegativeCacheUT, DisabledCachesNothing)
+{
+    auto &cache = NegativeCache::GetInstance();
+    cache.SetTimeout(0);
+    EXPECT_FALSE(cache.Enabled());
+    cache.Insert("/disabled/file", SERVER_ID, GENERATION);
+    cache.SetTimeout(60000);
+    EXPECT_FALSE(cache.Lookup("/disabled/file", SERVER_ID, GENERATION));
+}
+
+TEST_F(NegativeCacheUT, ShardCapped)
+{
+    auto &cache = NegativeCache::GetInstance();
+    // paths all falling into the same shard
+    constexpr size_t overflow = 100;
+    std::vector<std::string> paths;
+    size_t shard = std::hash<std::string>()("/cap/0") % NegativeCache::SHARD_NUM;
+    for (size_t i = 0; paths.size() < NegativeCache::MAX_ENTRIES_PER_SHARD + overflow; ++i) {
+        std::string path = "/cap/" + std::to_string(i);
+        if (std::hash<std::string>()(path) % NegativeCache::SHARD_NUM == shard) {
+            paths.push_back(path);
+        }
+    }
+    for (const auto &path : paths) {
+        cache.Insert(path, SERVER_ID, GENERATION);
+    }
+
+    size_t hits = 0;
+    for (const auto &path : paths) {
+        hits += cache.Lookup(path, SERVER_ID, GENERATION) ? 1 : 0;
+    }
+    EXPECT_EQ(hits, NegativeCache::MAX_ENTRIES_PER_SHARD);
+    // the latest insert always makes it in
+    EXPECT_TRUE(cache.Lookup(paths.back(), SERVER_ID, GENERATION));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}